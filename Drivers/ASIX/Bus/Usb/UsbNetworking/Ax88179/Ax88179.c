@@ -934,13 +934,28 @@ Ax88179GetLinkStatus (
 
 }
 
+/**
+  Read one bulk-in transfer from the adapter into the next free entry
+  of the receive ring.
+
+  The caller must make sure the ring is not full.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+  @param [in] Timeout         Timeout of each USB transfer in milliseconds
+
+  @retval EFI_SUCCESS         A transfer was added to the receive ring
+  @retval EFI_NOT_READY       No packets were received
+**/
 EFI_STATUS
 Ax88179BulkIn(
-  IN NIC_DEVICE *NicDevice
+  IN NIC_DEVICE *NicDevice,
+  IN UINTN      Timeout
 )
 {
   int i;
   UINT16  Val;
+  UINT8               *Buffer;
+  RX_RING_ENTRY       *Entry;
   UINTN               LengthInBytes = 0;
   UINTN               TmpLen = AX88179_MAX_BULKIN_SIZE;
   UINTN               CURBufSize = AX88179_MAX_BULKIN_SIZE;
@@ -950,6 +965,8 @@ Ax88179BulkIn(
   UINT32 TransferStatus;
 
   NicDevice->SkipRXCnt = 0;
+  Entry = &NicDevice->RxRing[NicDevice->RxRingHead];
+  Buffer = Entry->Buffer;
 
   UsbIo = NicDevice->UsbIo;
   for (i = 0 ; i < (AX88179_MAX_BULKIN_SIZE / 512) && UsbIo != NULL; i++) {
@@ -968,14 +985,14 @@ Ax88179BulkIn(
       }
       NicDevice->SetZeroLen = FALSE;
     }
-    TmpAddr = (VOID*) &NicDevice->BulkInbuf[LengthInBytes];
+    TmpAddr = (VOID*) &Buffer[LengthInBytes];
 
     Status =  EFI_NOT_READY;
     Status = UsbIo->UsbBulkTransfer (UsbIo,
                           USB_ENDPOINT_DIR_IN | BULK_IN_ENDPOINT,
                           TmpAddr,
                           &TmpLen,
-                          BULKIN_TIMEOUT,
+                          Timeout,
                           &TransferStatus);
 
     if ((!EFI_ERROR (Status)) && (!EFI_ERROR (TransferStatus)) && TmpLen != 0) {
@@ -1021,15 +1038,17 @@ done:
     UINT16 tmplen = 0;
     UINT16 TmpPktCnt = 0;
 
-    TmpPktCnt = *((UINT16 *) (NicDevice->BulkInbuf + LengthInBytes - 4));
-    tmplen =  *((UINT16*) (NicDevice->BulkInbuf + LengthInBytes - 2));
-
-    if (((UINTN)(((TmpPktCnt * 4 + 4 + 7) & 0xfff8) + tmplen)) == LengthInBytes) {
-      NicDevice->PktCnt = TmpPktCnt;
-      NicDevice->CurPktHdrOff = NicDevice->BulkInbuf + tmplen;
-      NicDevice->CurPktOff = NicDevice->BulkInbuf;
-      *((UINT16 *) (NicDevice->BulkInbuf + LengthInBytes - 4)) = 0;
-      *((UINT16*) (NicDevice->BulkInbuf + LengthInBytes - 2)) = 0;
+    TmpPktCnt = *((UINT16 *) (Buffer + LengthInBytes - 4));
+    tmplen =  *((UINT16*) (Buffer + LengthInBytes - 2));
+
+    if ((TmpPktCnt != 0) &&
+        (((UINTN)(((TmpPktCnt * 4 + 4 + 7) & 0xfff8) + tmplen)) == LengthInBytes)) {
+      Entry->PktCnt = TmpPktCnt;
+      Entry->PktHdrOff = Buffer + tmplen;
+      *((UINT16 *) (Buffer + LengthInBytes - 4)) = 0;
+      *((UINT16*) (Buffer + LengthInBytes - 2)) = 0;
+      NicDevice->RxRingHead = (NicDevice->RxRingHead + 1) % RX_RING_SIZE;
+      NicDevice->RxRingCount++;
       Status = EFI_SUCCESS;
     } else {
       Status = EFI_NOT_READY;
@@ -1040,3 +1059,176 @@ done:
 no_pkt:
    return Status;
 }
+
+/**
+  Move the receive cursor to the next bulk-in transfer of the receive ring.
+
+  An empty ring is refilled from the adapter first.  A transfer holding
+  more than one packet shows that frames are queued up in the adapter, so
+  the following transfers are read straight away with a short timeout,
+  until the adapter runs dry or the ring is full.  This empties the adapter
+  in a single poll instead of one transfer per call to SN_Receive.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+
+  @retval EFI_SUCCESS         The receive cursor points at a new transfer
+  @retval EFI_NOT_READY       No packets were received
+**/
+EFI_STATUS
+Ax88179RxRingNext (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  RX_RING_ENTRY       *Entry;
+  UINTN               Timeout;
+  BOOLEAN             Backlog;
+  EFI_STATUS          Status;
+
+  if (NicDevice->RxRingCount == 0) {
+    Timeout = BULKIN_TIMEOUT;
+    Backlog = FALSE;
+    do {
+      Status = Ax88179BulkIn (NicDevice, Timeout);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      Entry = &NicDevice->RxRing[(NicDevice->RxRingHead + RX_RING_SIZE - 1) % RX_RING_SIZE];
+      Backlog = (BOOLEAN) (Entry->PktCnt > 1);
+      Timeout = RX_RING_DRAIN_TIMEOUT;
+    } while (Backlog && (NicDevice->RxRingCount < RX_RING_SIZE));
+
+    if (NicDevice->RxRingCount == 0) {
+      return EFI_NOT_READY;
+    }
+
+    if ((NicDevice->RxRingCount == RX_RING_SIZE) && Backlog) {
+      NicDevice->RxRingOverflows++;
+    }
+  }
+
+  Entry = &NicDevice->RxRing[(NicDevice->RxRingHead + RX_RING_SIZE - NicDevice->RxRingCount) % RX_RING_SIZE];
+  NicDevice->RxRingCount--;
+
+  NicDevice->PktCnt = Entry->PktCnt;
+  NicDevice->CurPktHdrOff = Entry->PktHdrOff;
+  NicDevice->CurPktOff = Entry->Buffer;
+  return EFI_SUCCESS;
+}
+
+/**
+  Drop the packets waiting in the receive ring, so that SN_Receive does
+  not return frames received before a reset or a change of the receive
+  filters.  They are counted as dropped frames.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+**/
+VOID
+Ax88179RxRingFlush (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  UINT64              Dropped;
+
+  Dropped = NicDevice->PktCnt;
+  while (NicDevice->RxRingCount != 0) {
+    Dropped += NicDevice->RxRing[(NicDevice->RxRingHead + RX_RING_SIZE - NicDevice->RxRingCount) % RX_RING_SIZE].PktCnt;
+    NicDevice->RxRingCount--;
+  }
+
+  NicDevice->Statistics.RxTotalFrames += Dropped;
+  NicDevice->Statistics.RxDroppedFrames += Dropped;
+  NicDevice->PktCnt = 0;
+  NicDevice->RxRingHead = 0;
+}
+
+/**
+  Send the frames queued by SN_Transmit in a single bulk-out transfer.
+
+  The buffers of the frames move to the list of sent buffers that
+  SN_GetStatus hands back to the caller.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+
+  @retval EFI_SUCCESS         The frames were sent, or none were queued
+  @retval EFI_NOT_READY       The adapter did not take the frames, they stay queued
+  @retval EFI_DEVICE_ERROR    The transfer failed and the frames were dropped
+**/
+EFI_STATUS
+Ax88179TxFlush (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  EFI_USB_IO_PROTOCOL *UsbIo;
+  TX_PACKET           *Packet;
+  UINTN               TransferLength;
+  UINT32              TransferStatus;
+  EFI_STATUS          Status;
+
+  if (NicDevice->TxQueuePending == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  //  A transfer that is a multiple of the maximum packet size needs a zero
+  //  length packet to end it, which UsbIo can't send.  Mark the last frame
+  //  as padded and add the padding byte instead.
+  //
+  TransferLength = NicDevice->TxBatchLength;
+  if ((TransferLength % NicDevice->UsbMaxPktSize) == 0) {
+    Packet = (TX_PACKET *) &NicDevice->TxBatch[NicDevice->TxBatchLast];
+    Packet->TxHdr2 |= TXHDR2_PADDING;
+    NicDevice->TxBatch[TransferLength] = 0;
+    TransferLength++;
+  }
+
+  //
+  //  Work around USB bus driver bug where a timeout set by receive
+  //  succeeds but the timeout expires immediately after, causing the
+  //  transmit operation to timeout.
+  //
+  UsbIo = NicDevice->UsbIo;
+  Status = UsbIo->UsbBulkTransfer (UsbIo,
+                                     BULK_OUT_ENDPOINT,
+                                     NicDevice->TxBatch,
+                                     &TransferLength,
+                                     0xfffffffe,
+                                     &TransferStatus);
+
+  if (EFI_TIMEOUT == Status && EFI_USB_ERR_TIMEOUT == TransferStatus) {
+    return EFI_NOT_READY;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Ax88179: %Ld transmit frames dropped, %r\n",
+            (UINT64) NicDevice->TxQueuePending, Status));
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  NicDevice->TxQueueSent += NicDevice->TxQueuePending;
+  NicDevice->TxQueuePending = 0;
+  NicDevice->TxBatchLength = 0;
+  return Status;
+}
+
+/**
+  Send the frames queued by SN_Transmit, dropping them if the adapter
+  does not take them.
+
+  Either way the buffers of the frames move to the list of sent buffers
+  that SN_GetStatus hands back to the caller.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+**/
+VOID
+Ax88179TxDrop (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  if (Ax88179TxFlush (NicDevice) == EFI_NOT_READY) {
+    DEBUG ((DEBUG_ERROR, "Ax88179: %Ld transmit frames dropped\n",
+            (UINT64) NicDevice->TxQueuePending));
+    NicDevice->TxQueueSent += NicDevice->TxQueuePending;
+    NicDevice->TxQueuePending = 0;
+    NicDevice->TxBatchLength = 0;
+  }
+}
@@ -76,6 +76,9 @@
 #define HC_DEBUG        0
 #define ADD_MACPATHNOD  1
 #define BULKIN_TIMEOUT  3 //5000
+#define RX_RING_SIZE            8   ///<  Number of bulk-in transfers the receive ring holds
+#define RX_RING_DRAIN_TIMEOUT   1   ///<  Timeout in milliseconds of the bulk-in transfers that drain a backlog
+#define TX_QUEUE_SIZE           8   ///<  Number of transmit buffers queued or waiting to be recycled
 #define TX_RETRY        0
 #define AUTONEG_DELAY   1000000
 
@@ -195,6 +198,7 @@
 //  ANAR and ANLPAR Registers 4, 5
 #define RXHDR_DROP 0x8000
 #define RXHDR_CRCERR 0x2000
+#define TXHDR2_PADDING 0x80008000  ///<  A padding byte follows the frame
 
 
 //------------------------------------------------------------------------------
@@ -225,6 +229,15 @@ typedef struct _TX_PACKET {
 } TX_PACKET;
 #pragma pack()
 
+/**
+  Receive ring entry, one completed bulk-in transfer
+**/
+typedef struct {
+  UINT8   *Buffer;        ///<  Bulk-in transfer data
+  UINT16  PktCnt;         ///<  Number of packets in the transfer
+  UINT8   *PktHdrOff;     ///<  First packet header
+} RX_RING_ENTRY;
+
 #pragma pack(1)
 typedef struct _RX_PACKET {
   struct _RX_PACKET *Next;
@@ -279,14 +292,25 @@ typedef struct {
   UINT8                     *CurPktHdrOff;
   UINT8                     *CurPktOff;
 
-  TX_PACKET                 *TxTest;
+  RX_RING_ENTRY             RxRing[RX_RING_SIZE]; ///<  Bulk-in transfers not yet passed to SN_Receive
+  UINTN                     RxRingHead;         ///<  Next entry to fill
+  UINTN                     RxRingCount;        ///<  Number of filled entries
+  UINT64                    RxRingOverflows;    ///<  Debug - number of times the ring filled up with a backlog left in the adapter, SNP has no statistic for it
+  EFI_NETWORK_STATISTICS    Statistics;         ///<  Receive statistics
+
+  UINT8                     *TxBatch;           ///<  Frames waiting for the next bulk-out transfer
+  UINTN                     TxBatchLength;      ///<  Length in bytes of the waiting frames
+  UINTN                     TxBatchLast;        ///<  Offset in TxBatch of the last waiting frame
+  VOID                      *TxQueue[TX_QUEUE_SIZE]; ///<  Transmit buffers, the sent ones first
+  UINTN                     TxQueueHead;        ///<  Oldest transmit buffer
+  UINTN                     TxQueueSent;        ///<  Number of sent buffers waiting for SN_GetStatus
+  UINTN                     TxQueuePending;     ///<  Number of buffers with a frame in TxBatch
 
   INT8                      MulticastHash[8];
   EFI_MAC_ADDRESS           MAC;
 
   UINT16                    CurMediumStatus;
   UINT16                    CurRxControl;
-  VOID *                    TxBuffer;
 
   EFI_DEVICE_PATH_PROTOCOL  *MyDevPath;
   BOOLEAN                   Grub_f;
@@ -1046,8 +1070,29 @@ Ax88179GetLinkStatus (
 
 EFI_STATUS
 Ax88179BulkIn(
-  IN NIC_DEVICE *NicDevice
+  IN NIC_DEVICE *NicDevice,
+  IN UINTN      Timeout
 );
 
+EFI_STATUS
+Ax88179RxRingNext (
+  IN NIC_DEVICE *NicDevice
+  );
+
+VOID
+Ax88179RxRingFlush (
+  IN NIC_DEVICE *NicDevice
+  );
+
+EFI_STATUS
+Ax88179TxFlush (
+  IN NIC_DEVICE *NicDevice
+  );
+
+VOID
+Ax88179TxDrop (
+  IN NIC_DEVICE *NicDevice
+  );
+
 
 #endif  //  AX88179_H_
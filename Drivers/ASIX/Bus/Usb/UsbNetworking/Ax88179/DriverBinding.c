@@ -277,8 +277,8 @@ ERR:
     gBS->FreePool (NicDevice->BulkInbuf);
   }
 
-  if (NicDevice->TxTest != NULL) {
-    gBS->FreePool (NicDevice->TxTest);
+  if (NicDevice->TxBatch != NULL) {
+    gBS->FreePool (NicDevice->TxBatch);
   }
 
   if (NicDevice->MyDevPath != NULL) {
@@ -441,8 +441,8 @@ DriverStop (
         gBS->FreePool (NicDevice->BulkInbuf);
       }
 
-      if (NicDevice->TxTest != NULL) {
-        gBS->FreePool (NicDevice->TxTest);
+      if (NicDevice->TxBatch != NULL) {
+        gBS->FreePool (NicDevice->TxBatch);
       }
 
       if (NicDevice->MyDevPath != NULL) {
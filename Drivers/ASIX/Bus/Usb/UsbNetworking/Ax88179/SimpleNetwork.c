@@ -10,6 +10,75 @@
 
 #include "Ax88179.h"
 
+/**
+  This function clears the receive statistics.
+
+  The statistics the driver does not collect are set to all ones, which
+  EFI_NETWORK_STATISTICS defines as not available.
+
+  @param [in] NicDevice        Pointer to the NIC_DEVICE structure
+
+**/
+STATIC
+VOID
+RxStatisticsReset (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  EFI_NETWORK_STATISTICS  *Statistics;
+
+  Statistics = &NicDevice->Statistics;
+  SetMem (Statistics, sizeof (*Statistics), 0xff);
+  Statistics->RxTotalFrames = 0;
+  Statistics->RxGoodFrames = 0;
+  Statistics->RxUndersizeFrames = 0;
+  Statistics->RxOversizeFrames = 0;
+  Statistics->RxDroppedFrames = 0;
+  Statistics->RxUnicastFrames = 0;
+  Statistics->RxBroadcastFrames = 0;
+  Statistics->RxMulticastFrames = 0;
+  Statistics->RxCrcErrorFrames = 0;
+  Statistics->RxTotalBytes = 0;
+  NicDevice->RxRingOverflows = 0;
+}
+
+/**
+  This function counts a received frame in the receive statistics.
+
+  @param [in] NicDevice        Pointer to the NIC_DEVICE structure
+  @param [in] Frame            Frame, starting with the media header
+  @param [in] Length           Length of the frame in bytes
+
+**/
+STATIC
+VOID
+RxStatisticsUpdate (
+  IN NIC_DEVICE *NicDevice,
+  IN UINT8      *Frame,
+  IN UINTN      Length
+  )
+{
+  EFI_NETWORK_STATISTICS  *Statistics;
+  UINTN                   Index;
+
+  Statistics = &NicDevice->Statistics;
+  Statistics->RxTotalFrames++;
+  Statistics->RxGoodFrames++;
+  Statistics->RxTotalBytes += Length;
+
+  if ((Frame[0] & 1) == 0) {
+    Statistics->RxUnicastFrames++;
+  } else {
+    for (Index = 0; (Index < PXE_HWADDR_LEN_ETHER) && (Frame[Index] == 0xff); Index++) {
+    }
+    if (Index == PXE_HWADDR_LEN_ETHER) {
+      Statistics->RxBroadcastFrames++;
+    } else {
+      Statistics->RxMulticastFrames++;
+    }
+  }
+}
+
 /**
   This function updates the filtering on the receiver.
 
@@ -132,13 +201,26 @@ SN_GetStatus (
     // Return the transmit buffer
     //
     NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
+    Mode = SimpleNetwork->Mode;
 
-    if ((TxBuf != NULL) && (NicDevice->TxBuffer != NULL)) {
-      *TxBuf = NicDevice->TxBuffer;
-      NicDevice->TxBuffer = NULL;
+    //
+    // Send the frames queued by SN_Transmit, then return the oldest
+    // sent buffer
+    //
+    if (EfiSimpleNetworkInitialized == Mode->State) {
+      Ax88179TxFlush (NicDevice);
+    }
+
+    if (TxBuf != NULL) {
+      if (NicDevice->TxQueueSent != 0) {
+        *TxBuf = NicDevice->TxQueue[NicDevice->TxQueueHead];
+        NicDevice->TxQueueHead = (NicDevice->TxQueueHead + 1) % TX_QUEUE_SIZE;
+        NicDevice->TxQueueSent--;
+      } else {
+        *TxBuf = NULL;
+      }
     }
 
-    Mode = SimpleNetwork->Mode;
     if (EfiSimpleNetworkInitialized == Mode->State) {
       if ((TxBuf == NULL) && (InterruptStatus == NULL)) {
         Status = EFI_INVALID_PARAMETER;
@@ -553,6 +635,11 @@ SN_Receive (
       NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
 
       if (NicDevice->LinkUp && NicDevice->Complete) {
+        //
+        //  Send the frames queued by SN_Transmit before looking for replies
+        //
+        Ax88179TxFlush (NicDevice);
+
         if ((HeaderSize != NULL) && (*HeaderSize == 7720)) {
           NicDevice->Grub_f = TRUE;
         }
@@ -563,14 +650,17 @@ SN_Receive (
         }
 
         //
-        //  Attempt to do bulk in
+        //  Move on to the next transfer of the receive ring
         //
         if (NicDevice->PktCnt == 0) {
-          Status = Ax88179BulkIn(NicDevice);
+          Status = Ax88179RxRingNext (NicDevice);
           if (EFI_ERROR(Status))
             goto  no_pkt;
         }
         CurrentPktLen = *((UINT16*) (NicDevice->CurPktHdrOff + 2));
+        if (CurrentPktLen & RXHDR_CRCERR) {
+          NicDevice->Statistics.RxCrcErrorFrames++;
+        }
         if (CurrentPktLen & (RXHDR_DROP | RXHDR_CRCERR))
           Valid = FALSE;
         CurrentPktLen &=  0x1fff;
@@ -585,6 +675,7 @@ SN_Receive (
           }
           *BufferSize = CurrentPktLen;
           CopyMem (Buffer, NicDevice->CurPktOff + 2, CurrentPktLen);
+          RxStatisticsUpdate (NicDevice, Buffer, CurrentPktLen);
 
           Header = (ETHERNET_HEADER *) NicDevice->CurPktOff + 2;
 
@@ -608,6 +699,16 @@ SN_Receive (
           NicDevice->CurPktOff += (CurrentPktLen + 2 + 7) & 0xfff8;
           Status = EFI_SUCCESS;
         } else {
+          if (Valid && (CurrentPktLen < 60)) {
+            NicDevice->Statistics.RxUndersizeFrames++;
+          } else if (Valid && ((CurrentPktLen - 14) > MAX_ETHERNET_PKT_SIZE)) {
+            NicDevice->Statistics.RxOversizeFrames++;
+          }
+          //
+          //  This frame and the rest of the transfer are discarded
+          //
+          NicDevice->Statistics.RxTotalFrames += NicDevice->PktCnt;
+          NicDevice->Statistics.RxDroppedFrames += NicDevice->PktCnt;
           NicDevice->PktCnt = 0;
           Status = EFI_NOT_READY;
         }
@@ -808,6 +909,7 @@ SN_ReceiveFilters (
   Mode->ReceiveFilterSetting &= ~Disable;
 
   Status = ReceiveFilterUpdate (SimpleNetwork);
+  Ax88179RxRingFlush (DEV_FROM_SIMPLE_NETWORK (SimpleNetwork));
 
   gBS->RestoreTPL(TplPrevious);
 
@@ -864,6 +966,13 @@ SN_Reset (
       //
       NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
 
+      //
+      //  Don't leave frames queued by SN_Transmit across the reset,
+      //  their buffers are handed back by SN_GetStatus
+      //
+      Ax88179TxDrop (NicDevice);
+      Ax88179RxRingFlush (NicDevice);
+
       //
       //  Reset the device
       //
@@ -911,6 +1020,7 @@ SN_Setup (
   EFI_SIMPLE_NETWORK_MODE     *Mode;
   EFI_SIMPLE_NETWORK_PROTOCOL *SimpleNetwork;
   EFI_STATUS                  Status;
+  UINTN                       Index;
 
   //
   // Initialize the simple network protocol
@@ -953,7 +1063,7 @@ SN_Setup (
            0xff);
   Mode->IfType = NET_IFTYPE_ETHERNET;
   Mode->MacAddressChangeable = TRUE;
-  Mode->MultipleTxSupported = FALSE;
+  Mode->MultipleTxSupported = TRUE;
   Mode->MediaPresentSupported = TRUE;
   Mode->MediaPresent = FALSE;
   //
@@ -968,6 +1078,13 @@ SN_Setup (
   NicDevice->Grub_f = FALSE;
   NicDevice->FirstRst = TRUE;
   NicDevice->PktCnt = 0;
+  NicDevice->RxRingHead = 0;
+  NicDevice->RxRingCount = 0;
+  RxStatisticsReset (NicDevice);
+  NicDevice->TxBatchLength = 0;
+  NicDevice->TxQueueHead = 0;
+  NicDevice->TxQueueSent = 0;
+  NicDevice->TxQueuePending = 0;
   NicDevice->SkipRXCnt = 0;
   NicDevice->UsbMaxPktSize = 512;
   NicDevice->SetZeroLen = TRUE;
@@ -990,16 +1107,23 @@ SN_Setup (
             PXE_HWADDR_LEN_ETHER);
 
   Status = gBS->AllocatePool (EfiBootServicesData,
-                               AX88179_MAX_BULKIN_SIZE,
+                               AX88179_MAX_BULKIN_SIZE * RX_RING_SIZE,
                                (VOID **) &NicDevice->BulkInbuf);
 
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  for (Index = 0; Index < RX_RING_SIZE; Index++) {
+    NicDevice->RxRing[Index].Buffer = NicDevice->BulkInbuf + Index * AX88179_MAX_BULKIN_SIZE;
+  }
+
+  //
+  //  One more byte for the padding that ::Ax88179TxFlush may add
+  //
   Status = gBS->AllocatePool (EfiBootServicesData,
-                               sizeof (TX_PACKET),
-                               (VOID **) &NicDevice->TxTest);
+                               sizeof (TX_PACKET) * TX_QUEUE_SIZE + 1,
+                               (VOID **) &NicDevice->TxBatch);
   if (EFI_ERROR (Status)) {
     gBS->FreePool (NicDevice->BulkInbuf);
   }
@@ -1071,7 +1195,7 @@ SN_Start (
       SetMem(&Mode->BroadcastAddress, PXE_HWADDR_LEN_ETHER, 0xff);
       Mode->IfType = NET_IFTYPE_ETHERNET;
       Mode->MacAddressChangeable = TRUE;
-      Mode->MultipleTxSupported = FALSE;
+      Mode->MultipleTxSupported = TRUE;
       Mode->MediaPresentSupported = TRUE;
       Mode->MediaPresent = FALSE;
 
@@ -1217,20 +1341,40 @@ SN_Statistics (
   EFI_STATUS              Status;
   EFI_TPL                 TplPrevious;
   EFI_SIMPLE_NETWORK_MODE *Mode;
+  NIC_DEVICE              *NicDevice;
 
   TplPrevious = gBS->RaiseTPL(TPL_CALLBACK);
   Mode = SimpleNetwork->Mode;
 
   if (EfiSimpleNetworkInitialized == Mode->State) {
-    if ((StatisticsSize != NULL) && (*StatisticsSize == 0)) {
-      Status = EFI_BUFFER_TOO_SMALL;
+    if ((StatisticsSize == NULL) && !Reset) {
+      Status = EFI_INVALID_PARAMETER;
       goto EXIT;
     }
 
-    if(Reset) {
-      Status = EFI_SUCCESS;
-    } else {
-      Status = EFI_SUCCESS;
+    NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
+
+    Status = EFI_SUCCESS;
+    if (StatisticsSize != NULL) {
+      if ((StatisticsTable == NULL) && (*StatisticsSize != 0)) {
+        Status = EFI_INVALID_PARAMETER;
+        goto EXIT;
+      }
+
+      if (*StatisticsSize < sizeof (NicDevice->Statistics)) {
+        Status = EFI_BUFFER_TOO_SMALL;
+      }
+
+      if (StatisticsTable != NULL) {
+        CopyMem (StatisticsTable,
+                 &NicDevice->Statistics,
+                 MIN (*StatisticsSize, sizeof (NicDevice->Statistics)));
+      }
+      *StatisticsSize = sizeof (NicDevice->Statistics);
+    }
+
+    if (Reset) {
+      RxStatisticsReset (NicDevice);
     }
   } else {
     if (EfiSimpleNetworkStarted == Mode->State) {
@@ -1240,7 +1384,6 @@ SN_Statistics (
     }
   }
 
-  Status = EFI_UNSUPPORTED;
 EXIT:
   gBS->RestoreTPL(TplPrevious);
   return Status;
@@ -1340,6 +1483,14 @@ SN_Shutdown (
       //
       NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
 
+      //
+      //  Don't leave frames queued by SN_Transmit, their buffers are
+      //  handed back by SN_GetStatus once the interface is initialized
+      //  again
+      //
+      Ax88179TxDrop (NicDevice);
+      Ax88179RxRingFlush (NicDevice);
+
       Status = Ax88179MacAddressGet (NicDevice, &Mode->PermanentAddress.Addr[0]);
       if (!EFI_ERROR (Status)) {
         //
@@ -1373,9 +1524,11 @@ SN_Shutdown (
   operation.  When the transmit is complete, the buffer is returned
   via the GetStatus() call.
 
-  This routine calls ::Ax88179Rx to empty the network adapter of
-  receive packets.  The routine then passes the transmit packet
-  to the network adapter.
+  The packet is added, with its transmit header, to a batch of packets
+  that ::Ax88179TxFlush sends to the network adapter in one bulk-out
+  transfer.  The batch is sent only when it is full, and from GetStatus()
+  and Receive(), so packets submitted back to back share a transfer and
+  a packet does not leave the adapter until the caller calls one of them.
 
   @param [in] SimpleNetwork    Protocol instance pointer
   @param [in] HeaderSize        The size, in bytes, of the media header to be filled in by
@@ -1423,10 +1576,8 @@ SN_Transmit (
   ETHERNET_HEADER         *Header;
   EFI_SIMPLE_NETWORK_MODE *Mode;
   NIC_DEVICE              *NicDevice;
-  EFI_USB_IO_PROTOCOL     *UsbIo;
+  TX_PACKET               *Packet;
   EFI_STATUS              Status;
-  UINTN                   TransferLength;
-  UINT32                  TransferStatus;
   UINT16                  Type = 0;
   EFI_TPL                 TplPrevious;
 
@@ -1466,17 +1617,33 @@ SN_Transmit (
           Status = EFI_INVALID_PARAMETER;
           goto EXIT;
         }
+        if (BufferSize > AX88179_MAX_PKT_SIZE) {
+          Status = EFI_INVALID_PARAMETER;
+          goto EXIT;
+        }
+
         //
-        //  Copy the packet into the USB buffer
+        //  Send the batch when it is full.  The buffers stay in the queue
+        //  until GetStatus() returns them, so the caller has to recycle
+        //  some before the next packet fits.
         //
-        // Buffer starting with 14 bytes 0
-        CopyMem (&NicDevice->TxTest->Data[0], Buffer, BufferSize);
-        NicDevice->TxTest->TxHdr1 = (UINT32) BufferSize;
-        NicDevice->TxTest->TxHdr2 = 0;
+        if ((NicDevice->TxQueueSent + NicDevice->TxQueuePending) == TX_QUEUE_SIZE) {
+          Status = Ax88179TxFlush (NicDevice);
+          if (!EFI_ERROR (Status)) {
+            Status = EFI_NOT_READY;
+          }
+          goto EXIT;
+        }
+
         //
-        //  Transmit the packet
+        //  Copy the packet into the batch, right after the previous one
         //
-        Header = (ETHERNET_HEADER *) &NicDevice->TxTest->Data[0];
+        NicDevice->TxBatchLast = NicDevice->TxBatchLength;
+        Packet = (TX_PACKET *) &NicDevice->TxBatch[NicDevice->TxBatchLength];
+        CopyMem (&Packet->Data[0], Buffer, BufferSize);
+        Packet->TxHdr1 = (UINT32) BufferSize;
+        Packet->TxHdr2 = 0;
+        Header = (ETHERNET_HEADER *) &Packet->Data[0];
         if (HeaderSize != 0) {
           if (DestAddr != NULL) {
             CopyMem (&Header->DestAddr, DestAddr, PXE_HWADDR_LEN_ETHER);
@@ -1495,36 +1662,20 @@ SN_Transmit (
           Header->Type = Type;
         }
 
-        if (NicDevice->TxTest->TxHdr1 < MIN_ETHERNET_PKT_SIZE) {
-          NicDevice->TxTest->TxHdr1 = MIN_ETHERNET_PKT_SIZE;
-          ZeroMem (&NicDevice->TxTest->Data[BufferSize],
+        if (Packet->TxHdr1 < MIN_ETHERNET_PKT_SIZE) {
+          Packet->TxHdr1 = MIN_ETHERNET_PKT_SIZE;
+          ZeroMem (&Packet->Data[BufferSize],
                     MIN_ETHERNET_PKT_SIZE - BufferSize);
         }
 
-        TransferLength = sizeof (NicDevice->TxTest->TxHdr1)
-                       + sizeof (NicDevice->TxTest->TxHdr2)
-                       + NicDevice->TxTest->TxHdr1;
-        //
-        //  Work around USB bus driver bug where a timeout set by receive
-        //  succeeds but the timeout expires immediately after, causing the
-        //  transmit operation to timeout.
-        //
-        UsbIo = NicDevice->UsbIo;
-        Status = UsbIo->UsbBulkTransfer (UsbIo,
-                                           BULK_OUT_ENDPOINT,
-                                           &NicDevice->TxTest->TxHdr1,
-                                           &TransferLength,
-                                           0xfffffffe,
-                                           &TransferStatus);
-
-        if (!EFI_ERROR(Status) && !EFI_ERROR(Status)) {
-          NicDevice->TxBuffer = Buffer;
-          Status = EFI_SUCCESS;
-        } else if (EFI_TIMEOUT == Status && EFI_USB_ERR_TIMEOUT == TransferStatus) {
-          Status = EFI_NOT_READY;
-        } else {
-          Status = EFI_DEVICE_ERROR;
-        }
+        NicDevice->TxBatchLength += sizeof (Packet->TxHdr1)
+                                  + sizeof (Packet->TxHdr2)
+                                  + Packet->TxHdr1;
+        NicDevice->TxQueue[(NicDevice->TxQueueHead
+                            + NicDevice->TxQueueSent
+                            + NicDevice->TxQueuePending) % TX_QUEUE_SIZE] = Buffer;
+        NicDevice->TxQueuePending++;
+        Status = EFI_SUCCESS;
       } else {
         //
         // No packets available.
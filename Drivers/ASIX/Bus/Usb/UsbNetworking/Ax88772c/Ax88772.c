@@ -1065,11 +1065,27 @@ Ax88772GetLinkStatus (
 }
 
 #if RXTHOU
+/**
+  Read one bulk-in transfer from the adapter into the next free entry
+  of the receive ring.
+
+  The caller must make sure the ring is not full.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+  @param [in] Timeout         Timeout of each USB transfer in milliseconds
+
+  @retval EFI_SUCCESS         A transfer was added to the receive ring
+  @retval EFI_NOT_READY       No packets were received
+  @retval EFI_DEVICE_ERROR    The bulk-in transfer failed
+**/
 EFI_STATUS
 Ax88772BulkIn(
-  IN NIC_DEVICE * NicDevice
+  IN NIC_DEVICE * NicDevice,
+  IN UINTN        Timeout
 )
 {
+  RX_RING_ENTRY       *Entry = &NicDevice->RxRing[NicDevice->RxRingHead];
+  UINT8               *Buffer = Entry->Buffer;
   UINTN               Index;
   UINTN               LengthInBytes = 0;
   UINTN               TmpLen = AX88772_MAX_BULKIN_SIZE;
@@ -1082,7 +1098,7 @@ Ax88772BulkIn(
   EFI_USB_IO_PROTOCOL *UsbIo;
   UINT32              TransferStatus = 0;
   UINT16              TmpPktCnt = 0;
-  UINT16              *TmpHdr = (UINT16 *)NicDevice->BulkInbuf;
+  UINT16              *TmpHdr = (UINT16 *)Buffer;
   USB_DEVICE_REQUEST  SetupMsg;
 
   UsbIo = NicDevice->UsbIo;
@@ -1090,13 +1106,13 @@ Ax88772BulkIn(
     VOID* TmpAddr = 0;
 
     TmpPktCnt = 0;
-    TmpAddr = (VOID*) &NicDevice->BulkInbuf[LengthInBytes];
+    TmpAddr = (VOID*) &Buffer[LengthInBytes];
     OrigTmpLen = TmpLen;
     Status = UsbIo->UsbBulkTransfer (UsbIo,
                           USB_ENDPOINT_DIR_IN | BULK_IN_ENDPOINT,
                           TmpAddr,
                           &TmpLen,
-                          BULKIN_TIMEOUT,
+                          Timeout,
                           &TransferStatus);
 
     if (OrigTmpLen == TmpLen) {
@@ -1186,9 +1202,10 @@ done:
   }
 
   if (TmpPktCnt != 0) {
-    NicDevice->PktCnt = TmpPktCnt;
-    NicDevice->CurPktHdrOff = NicDevice->BulkInbuf;
-    NicDevice->CurPktOff = NicDevice->BulkInbuf + 4;
+    Entry->PktCnt = TmpPktCnt;
+    Entry->PktHdrOff = Buffer;
+    NicDevice->RxRingHead = (NicDevice->RxRingHead + 1) % RX_RING_SIZE;
+    NicDevice->RxRingCount++;
     Status = EFI_SUCCESS;
   }
 
@@ -1196,11 +1213,27 @@ no_pkt:
   return Status;
 }
 #else
+/**
+  Read one bulk-in transfer from the adapter into the next free entry
+  of the receive ring.
+
+  The caller must make sure the ring is not full.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+  @param [in] Timeout         Timeout of each USB transfer in milliseconds
+
+  @retval EFI_SUCCESS         A transfer was added to the receive ring
+  @retval EFI_NOT_READY       No packets were received
+  @retval EFI_DEVICE_ERROR    The bulk-in transfer failed
+**/
 EFI_STATUS
 Ax88772BulkIn(
-  IN NIC_DEVICE *NicDevice
+  IN NIC_DEVICE *NicDevice,
+  IN UINTN      Timeout
 )
 {
+  RX_RING_ENTRY       *Entry = &NicDevice->RxRing[NicDevice->RxRingHead];
+  UINT8               *Buffer = Entry->Buffer;
   UINTN               Index;
   UINTN               LengthInBytes = 0;
   UINTN               TmpLen = AX88772_MAX_BULKIN_SIZE;
@@ -1213,20 +1246,20 @@ Ax88772BulkIn(
   EFI_USB_IO_PROTOCOL *UsbIo;
   UINT32              TransferStatus = 0;
   UINT16              TmpPktCnt = 0;
-  UINT16              *TmpHdr = (UINT16 *)NicDevice->BulkInbuf;
+  UINT16              *TmpHdr = (UINT16 *)Buffer;
 
   UsbIo = NicDevice->UsbIo;
   for (Index = 0 ; Index < (AX88772_MAX_BULKIN_SIZE / 512) && UsbIo != NULL; Index++) {
     VOID *TmpAddr = 0;
 
     TmpPktCnt = 0;
-    TmpAddr = (VOID*) &NicDevice->BulkInbuf[LengthInBytes];
+    TmpAddr = (VOID*) &Buffer[LengthInBytes];
     OrigTmpLen = TmpLen;
     Status = UsbIo->UsbBulkTransfer (UsbIo,
                           USB_ENDPOINT_DIR_IN | BULK_IN_ENDPOINT,
                           TmpAddr,
                           &TmpLen,
-                          BULKIN_TIMEOUT,
+                          Timeout,
                           &TransferStatus);
 
     if (OrigTmpLen == TmpLen) {
@@ -1291,10 +1324,98 @@ Ax88772BulkIn(
     }
   }
 done:
-  NicDevice->PktCnt = TmpPktCnt;
-  NicDevice->CurPktHdrOff = NicDevice->BulkInbuf;
-  NicDevice->CurPktOff = NicDevice->BulkInbuf + 4;
+  if (TmpPktCnt != 0) {
+    Entry->PktCnt = TmpPktCnt;
+    Entry->PktHdrOff = Buffer;
+    NicDevice->RxRingHead = (NicDevice->RxRingHead + 1) % RX_RING_SIZE;
+    NicDevice->RxRingCount++;
+  } else if (!EFI_ERROR (Status)) {
+    Status = EFI_NOT_READY;
+  }
 no_pkt:
   return Status;
 }
 #endif
+
+/**
+  Move the receive cursor to the next bulk-in transfer of the receive ring.
+
+  An empty ring is refilled from the adapter first.  A transfer holding
+  more than one packet shows that frames are queued up in the adapter, so
+  the following transfers are read straight away with a short timeout,
+  until the adapter runs dry or the ring is full.  This empties the adapter
+  in a single poll instead of one transfer per call to SN_Receive.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+
+  @retval EFI_SUCCESS         The receive cursor points at a new transfer
+  @retval EFI_NOT_READY       No packets were received
+  @retval EFI_DEVICE_ERROR    The bulk-in transfer failed
+**/
+EFI_STATUS
+Ax88772RxRingNext (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  RX_RING_ENTRY       *Entry;
+  UINTN               Timeout;
+  BOOLEAN             Backlog;
+  EFI_STATUS          Status;
+
+  Status = EFI_SUCCESS;
+  if (NicDevice->RxRingCount == 0) {
+    Timeout = BULKIN_TIMEOUT;
+    Backlog = FALSE;
+    do {
+      Status = Ax88772BulkIn (NicDevice, Timeout);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      Entry = &NicDevice->RxRing[(NicDevice->RxRingHead + RX_RING_SIZE - 1) % RX_RING_SIZE];
+      Backlog = (BOOLEAN) (Entry->PktCnt > 1);
+      Timeout = RX_RING_DRAIN_TIMEOUT;
+    } while (Backlog && (NicDevice->RxRingCount < RX_RING_SIZE));
+
+    if (NicDevice->RxRingCount == 0) {
+      return Status;
+    }
+
+    if ((NicDevice->RxRingCount == RX_RING_SIZE) && Backlog) {
+      NicDevice->RxRingOverflows++;
+    }
+  }
+
+  Entry = &NicDevice->RxRing[(NicDevice->RxRingHead + RX_RING_SIZE - NicDevice->RxRingCount) % RX_RING_SIZE];
+  NicDevice->RxRingCount--;
+
+  NicDevice->PktCnt = Entry->PktCnt;
+  NicDevice->CurPktHdrOff = Entry->PktHdrOff;
+  NicDevice->CurPktOff = Entry->PktHdrOff + 4;
+  return EFI_SUCCESS;
+}
+
+/**
+  Drop the packets waiting in the receive ring, so that SN_Receive does
+  not return frames received before a reset or a change of the receive
+  filters.  They are counted as dropped frames.
+
+  @param [in] NicDevice       Pointer to the NIC_DEVICE structure
+**/
+VOID
+Ax88772RxRingFlush (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  UINT64              Dropped;
+
+  Dropped = NicDevice->PktCnt;
+  while (NicDevice->RxRingCount != 0) {
+    Dropped += NicDevice->RxRing[(NicDevice->RxRingHead + RX_RING_SIZE - NicDevice->RxRingCount) % RX_RING_SIZE].PktCnt;
+    NicDevice->RxRingCount--;
+  }
+
+  NicDevice->Statistics.RxTotalFrames += Dropped;
+  NicDevice->Statistics.RxDroppedFrames += Dropped;
+  NicDevice->PktCnt = 0;
+  NicDevice->RxRingHead = 0;
+}
@@ -87,6 +87,9 @@
 #define BULKIN_TIMEOUT  3000
 #endif
 
+#define RX_RING_SIZE            8   ///<  Number of bulk-in transfers the receive ring holds
+#define RX_RING_DRAIN_TIMEOUT   1   ///<  Timeout in milliseconds of the bulk-in transfers that drain a backlog
+
 #define AUTONEG_DELAY   2000000
 #define AUTONEG_POLL_CNT    5
 
@@ -310,6 +313,15 @@ typedef struct {
 /**
   Receive and Transmit packet structure
 **/
+/**
+  Receive ring entry, one completed bulk-in transfer
+**/
+typedef struct {
+  UINT8   *Buffer;        ///<  Bulk-in transfer data
+  UINT16  PktCnt;         ///<  Number of packets in the transfer
+  UINT8   *PktHdrOff;     ///<  First packet header
+} RX_RING_ENTRY;
+
 #pragma pack(1)
 typedef struct _RX_TX_PACKET {
   struct _RX_TX_PACKET * Next;        ///<  Next receive packet
@@ -364,6 +376,12 @@ typedef struct {
   UINT8                     *CurPktOff;
   UINT16                    PktCnt;
 
+  RX_RING_ENTRY             RxRing[RX_RING_SIZE]; ///<  Bulk-in transfers not yet passed to SN_Receive
+  UINTN                     RxRingHead;         ///<  Next entry to fill
+  UINTN                     RxRingCount;        ///<  Number of filled entries
+  UINT64                    RxRingOverflows;    ///<  Debug - number of times the ring filled up with a backlog left in the adapter, SNP has no statistic for it
+  EFI_NETWORK_STATISTICS    Statistics;         ///<  Receive statistics
+
   RX_TX_PACKET              *TxTest;
 
   UINT8                     MulticastHash[8];
@@ -1033,9 +1051,20 @@ GetControllerName (
 
 EFI_STATUS
 Ax88772BulkIn(
-  IN NIC_DEVICE *NicDevice
+  IN NIC_DEVICE *NicDevice,
+  IN UINTN      Timeout
 );
 
+EFI_STATUS
+Ax88772RxRingNext (
+  IN NIC_DEVICE *NicDevice
+  );
+
+VOID
+Ax88772RxRingFlush (
+  IN NIC_DEVICE *NicDevice
+  );
+
 //------------------------------------------------------------------------------
 
 #endif  //  AX88772_H_
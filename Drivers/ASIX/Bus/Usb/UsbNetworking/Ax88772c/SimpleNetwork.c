@@ -10,6 +10,75 @@
 
 #include "Ax88772.h"
 
+/**
+  This function clears the receive statistics.
+
+  The statistics the driver does not collect are set to all ones, which
+  EFI_NETWORK_STATISTICS defines as not available.
+
+  @param [in] NicDevice        Pointer to the NIC_DEVICE structure
+
+**/
+STATIC
+VOID
+RxStatisticsReset (
+  IN NIC_DEVICE *NicDevice
+  )
+{
+  EFI_NETWORK_STATISTICS  *Statistics;
+
+  Statistics = &NicDevice->Statistics;
+  SetMem (Statistics, sizeof (*Statistics), 0xff);
+  Statistics->RxTotalFrames = 0;
+  Statistics->RxGoodFrames = 0;
+  Statistics->RxUndersizeFrames = 0;
+  Statistics->RxOversizeFrames = 0;
+  Statistics->RxDroppedFrames = 0;
+  Statistics->RxUnicastFrames = 0;
+  Statistics->RxBroadcastFrames = 0;
+  Statistics->RxMulticastFrames = 0;
+  Statistics->RxCrcErrorFrames = 0;
+  Statistics->RxTotalBytes = 0;
+  NicDevice->RxRingOverflows = 0;
+}
+
+/**
+  This function counts a received frame in the receive statistics.
+
+  @param [in] NicDevice        Pointer to the NIC_DEVICE structure
+  @param [in] Frame            Frame, starting with the media header
+  @param [in] Length           Length of the frame in bytes
+
+**/
+STATIC
+VOID
+RxStatisticsUpdate (
+  IN NIC_DEVICE *NicDevice,
+  IN UINT8      *Frame,
+  IN UINTN      Length
+  )
+{
+  EFI_NETWORK_STATISTICS  *Statistics;
+  UINTN                   Index;
+
+  Statistics = &NicDevice->Statistics;
+  Statistics->RxTotalFrames++;
+  Statistics->RxGoodFrames++;
+  Statistics->RxTotalBytes += Length;
+
+  if ((Frame[0] & 1) == 0) {
+    Statistics->RxUnicastFrames++;
+  } else {
+    for (Index = 0; (Index < PXE_HWADDR_LEN_ETHER) && (Frame[Index] == 0xff); Index++) {
+    }
+    if (Index == PXE_HWADDR_LEN_ETHER) {
+      Statistics->RxBroadcastFrames++;
+    } else {
+      Statistics->RxMulticastFrames++;
+    }
+  }
+}
+
 /**
   This function updates the filtering on the receiver.
 
@@ -562,10 +631,10 @@ SN_Receive (
         }
 
         //
-        //  Attempt to receive a packet
+        //  Move on to the next transfer of the receive ring
         //
         if (0 == NicDevice->PktCnt) {
-          Status = Ax88772BulkIn(NicDevice);
+          Status = Ax88772RxRingNext (NicDevice);
           if (EFI_ERROR(Status)) {
             goto  no_pkt;
           }
@@ -583,6 +652,7 @@ SN_Receive (
 
             *BufferSize = CurrentPktLen;
             CopyMem (Buffer, NicDevice->CurPktOff, CurrentPktLen);
+            RxStatisticsUpdate (NicDevice, Buffer, CurrentPktLen);
             Header = (ETHERNET_HEADER *) NicDevice->CurPktOff;
 
             if ((HeaderSize != NULL)  && (*HeaderSize != 7720)) {
@@ -604,6 +674,16 @@ SN_Receive (
             NicDevice->CurPktOff = NicDevice->CurPktHdrOff + 4;
             Status = EFI_SUCCESS;
         } else {
+          if (CurrentPktLen < 60) {
+            NicDevice->Statistics.RxUndersizeFrames++;
+          } else {
+            NicDevice->Statistics.RxOversizeFrames++;
+          }
+          //
+          //  This frame and the rest of the transfer are discarded
+          //
+          NicDevice->Statistics.RxTotalFrames += NicDevice->PktCnt;
+          NicDevice->Statistics.RxDroppedFrames += NicDevice->PktCnt;
           NicDevice->PktCnt = 0;
           Status = EFI_DEVICE_ERROR;
         }
@@ -809,6 +889,7 @@ SN_ReceiveFilters (
   Mode->ReceiveFilterSetting &= ~Disable;
 
   Status = ReceiveFilterUpdate (SimpleNetwork);
+  Ax88772RxRingFlush (DEV_FROM_SIMPLE_NETWORK (SimpleNetwork));
 
   if (EFI_DEVICE_ERROR == Status || EFI_INVALID_PARAMETER == Status)
     Status = EFI_SUCCESS;
@@ -867,6 +948,7 @@ SN_Reset (
       //  Update the device state
       //
       NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
+      Ax88772RxRingFlush (NicDevice);
 
       //
       //  Reset the device
@@ -915,6 +997,7 @@ SN_Setup (
   EFI_SIMPLE_NETWORK_MODE     *Mode;
   EFI_SIMPLE_NETWORK_PROTOCOL *SimpleNetwork;
   EFI_STATUS                  Status;
+  UINTN                       Index;
 
   //
   // Initialize the simple network protocol
@@ -977,6 +1060,9 @@ SN_Setup (
   NicDevice->Grub_f = FALSE;
   NicDevice->FirstRst = TRUE;
   NicDevice->PktCnt = 0;
+  NicDevice->RxRingHead = 0;
+  NicDevice->RxRingCount = 0;
+  RxStatisticsReset (NicDevice);
 
   Status = Ax88772MacAddressGet (
                 NicDevice,
@@ -998,13 +1084,17 @@ SN_Setup (
             PXE_HWADDR_LEN_ETHER);
 
   Status = gBS->AllocatePool (EfiBootServicesData,
-                                   AX88772_MAX_BULKIN_SIZE,
+                                   AX88772_MAX_BULKIN_SIZE * RX_RING_SIZE,
                                    (VOID **) &NicDevice->BulkInbuf);
 
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  for (Index = 0; Index < RX_RING_SIZE; Index++) {
+    NicDevice->RxRing[Index].Buffer = NicDevice->BulkInbuf + Index * AX88772_MAX_BULKIN_SIZE;
+  }
+
   Status = gBS->AllocatePool (EfiBootServicesData,
                                    sizeof (RX_TX_PACKET),
                                    (VOID **) &NicDevice->TxTest);
@@ -1232,20 +1322,40 @@ SN_Statistics (
   EFI_STATUS              Status;
   EFI_TPL                 TplPrevious;
   EFI_SIMPLE_NETWORK_MODE *Mode;
+  NIC_DEVICE              *NicDevice;
 
   TplPrevious = gBS->RaiseTPL(TPL_CALLBACK);
   Mode = SimpleNetwork->Mode;
 
   if (EfiSimpleNetworkInitialized == Mode->State) {
-    if ((StatisticsSize != NULL) && (*StatisticsSize == 0)) {
-      Status = EFI_BUFFER_TOO_SMALL;
+    if ((StatisticsSize == NULL) && !Reset) {
+      Status = EFI_INVALID_PARAMETER;
       goto EXIT;
     }
 
-    if(Reset) {
-      Status = EFI_SUCCESS;
-    } else {
-      Status = EFI_SUCCESS;
+    NicDevice = DEV_FROM_SIMPLE_NETWORK (SimpleNetwork);
+
+    Status = EFI_SUCCESS;
+    if (StatisticsSize != NULL) {
+      if ((StatisticsTable == NULL) && (*StatisticsSize != 0)) {
+        Status = EFI_INVALID_PARAMETER;
+        goto EXIT;
+      }
+
+      if (*StatisticsSize < sizeof (NicDevice->Statistics)) {
+        Status = EFI_BUFFER_TOO_SMALL;
+      }
+
+      if (StatisticsTable != NULL) {
+        CopyMem (StatisticsTable,
+                 &NicDevice->Statistics,
+                 MIN (*StatisticsSize, sizeof (NicDevice->Statistics)));
+      }
+      *StatisticsSize = sizeof (NicDevice->Statistics);
+    }
+
+    if (Reset) {
+      RxStatisticsReset (NicDevice);
     }
   } else {
     if (EfiSimpleNetworkStarted == Mode->State) {
@@ -1254,9 +1364,6 @@ SN_Statistics (
       Status = EFI_NOT_STARTED ;
     }
   }
-  //
-  // This is not currently supported
-  //
 
 EXIT:
   gBS->RestoreTPL(TplPrevious);
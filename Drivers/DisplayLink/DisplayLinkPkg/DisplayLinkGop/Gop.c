@@ -69,6 +69,27 @@ CheckBounds (
   return EFI_SUCCESS;
 }
 
+/**
+ * Add lines of the screen to the area that has to be sent in the next screen update.
+ * @param UsbDisplayLinkDev
+ * @param Y                 First line that changed
+ * @param Height            Number of lines that changed
+ */
+STATIC VOID
+MarkLinesDirty (
+  IN  USB_DISPLAYLINK_DEV  *UsbDisplayLinkDev,
+  IN  UINTN                Y,
+  IN  UINTN                Height
+)
+{
+  if (Y < UsbDisplayLinkDev->LastY1) {
+    UsbDisplayLinkDev->LastY1 = Y;
+  }
+  if ((Y + Height) > UsbDisplayLinkDev->LastY2) {
+    UsbDisplayLinkDev->LastY2 = Y + Height;
+  }
+}
+
 /**
  * Update the local copy of the Frame Buffer. This local copy is periodically transmitted to the
  * DisplayLink device (via DlGopSendScreenUpdate)
@@ -122,12 +143,7 @@ BuildBackBuffer (
   case EfiBltBufferToVideo:
   {
     // Update the store of the area of the screen that is "dirty" - that we need to send in the next screen update.
-    if (DestinationY < UsbDisplayLinkDev->LastY1) {
-      UsbDisplayLinkDev->LastY1 = DestinationY;
-    }
-    if ((DestinationY + Height) > UsbDisplayLinkDev->LastY2) {
-      UsbDisplayLinkDev->LastY2 = DestinationY + Height;
-    }
+    MarkLinesDirty (UsbDisplayLinkDev, DestinationY, Height);
 
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Blt;
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
@@ -146,6 +162,8 @@ BuildBackBuffer (
 
   case EfiBltVideoToVideo:
   {
+    MarkLinesDirty (UsbDisplayLinkDev, DestinationY, Height);
+
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcB;
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
     SrcB = UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX;
@@ -163,6 +181,8 @@ BuildBackBuffer (
 
   case EfiBltVideoFill:
   {
+    MarkLinesDirty (UsbDisplayLinkDev, DestinationY, Height);
+
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
     DstB = UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX;
     for (H = 0; H < Height; H++) {
@@ -252,7 +272,10 @@ DlGopSendTestPattern (
 
 
 /**
- * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device
+ * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device.
+ * The device takes the lines of a frame in order from the top, one bulk transfer per line, so
+ * the frame is ended after the last line that changed since the previous frame. The device keeps
+ * the lines below it.
  * @param UsbDisplayLinkDev
  * @return
  */
@@ -263,13 +286,15 @@ DlGopSendScreenUpdate (
 {
   EFI_STATUS Status;
   UINT32 USBStatus;
+  BOOLEAN FullScreen;
   Status = EFI_SUCCESS;
 
   // If it has been a while since we sent an update, send a full screen.
   // This allows us to update a hot-plugged monitor quickly.
-  if (UsbDisplayLinkDev->TimeSinceLastScreenUpdate > DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD) {
+  FullScreen = (BOOLEAN)(UsbDisplayLinkDev->TimeSinceLastScreenUpdate > DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD);
+  if (FullScreen) {
     UsbDisplayLinkDev->LastY1 = 0;
-    UsbDisplayLinkDev->LastY2 = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution - 1;
+    UsbDisplayLinkDev->LastY2 = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
   }
 
   // If there has been no BLT since the last update/poll, drop out quietly.
@@ -278,37 +303,54 @@ DlGopSendScreenUpdate (
     return EFI_SUCCESS;
   }
 
-  UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
-
   EFI_TPL OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
 
   UINTN DataLen;
   UINTN Width;
   UINTN Height;
+  UINTN FrameDataSaved;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcPtr;
-  UINT8* DstPtr;
-  UINT8 DstBuffer[1920 * 3]; // Get rid of the magic numbers at some point
-                             // Could also use a buffer allocated at runtime to store the line, stored in the USB_DISPLAYLINK_DEV structure.
+  UINT8* DstBuffer;
   UINTN H;
 
   DataLen = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution * 3; // Send 1 line @ 24 bits per pixel
   Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
-  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
+  Height = MIN (UsbDisplayLinkDev->LastY2, UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution);
+
+  // Lines that were BLTted to but still hold what was last sent don't need to be sent again.
+  // There is no way to skip lines within a frame, so only the unchanged lines at the bottom of
+  // the dirty area are left out, and the frame is dropped if none of its lines changed.
+  if (!FullScreen && UsbDisplayLinkDev->SentScreenValid) {
+    while ((Height > UsbDisplayLinkDev->LastY1) &&
+           (CompareMem (
+              UsbDisplayLinkDev->Screen + (Height - 1) * Width,
+              UsbDisplayLinkDev->SentScreen + (Height - 1) * Width,
+              Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) == 0)) {
+      Height--;
+    }
+  }
+
+  FrameDataSaved = (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution - Height) * DataLen;
+
+  if (Height <= UsbDisplayLinkDev->LastY1) {
+    DEBUG ((DEBUG_VERBOSE, "Screen update - no line changed, %d bytes saved\n", FrameDataSaved));
+    UsbDisplayLinkDev->DataSaved += FrameDataSaved;
+    UsbDisplayLinkDev->LastY2 = 0;
+    UsbDisplayLinkDev->LastY1 = (UINTN)-1;
+    UsbDisplayLinkDev->TimeSinceLastScreenUpdate += (DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 1000);  // Convert us to ms
+    gBS->RestoreTPL (OriginalTPL);
+    return EFI_SUCCESS;
+  }
+
+  UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
+
   SrcPtr = UsbDisplayLinkDev->Screen;
-  DstPtr = DstBuffer;
+  DstBuffer = UsbDisplayLinkDev->LineBuffer; // Sized for the current mode by DisplayLinkSetMode
 
   for (H = 0; H < Height; H++) {
-    DstPtr = DstBuffer;
-
-    UINTN W;
-    for (W = 0; W < Width; W++) {
-      // Need to swap round the RGB values
-      DstPtr[0] = ((UINT8 *)SrcPtr)[2];
-      DstPtr[1] = ((UINT8 *)SrcPtr)[1];
-      DstPtr[2] = ((UINT8 *)SrcPtr)[0];
-      SrcPtr++;
-      DstPtr += 3;
-    }
+    // Need to swap round the RGB values
+    DlGopConvertBgrxToRgb888 (DstBuffer, SrcPtr, Width);
+    SrcPtr += Width;
 
     Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, DataLen, &USBStatus);
 
@@ -329,6 +371,21 @@ DlGopSendScreenUpdate (
   }
 
   if (!EFI_ERROR (Status)) {
+    // Keep a copy of the lines that were sent, to compare the next frame against.
+    // The copy is only trusted once it holds a whole screen, so lines that were never sent aren't compared.
+    H = UsbDisplayLinkDev->SentScreenValid ? UsbDisplayLinkDev->LastY1 : 0;
+    CopyMem (
+      UsbDisplayLinkDev->SentScreen + H * Width,
+      UsbDisplayLinkDev->Screen + H * Width,
+      (Height - H) * Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    if (Height == UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution) {
+      UsbDisplayLinkDev->SentScreenValid = TRUE;
+    }
+
+    DEBUG ((DEBUG_VERBOSE, "Screen update - %d lines sent, %d bytes saved\n", Height, FrameDataSaved));
+    UsbDisplayLinkDev->DataSent += Height * DataLen;
+    UsbDisplayLinkDev->DataSaved += FrameDataSaved;
+
     // If we've successfully transmitted the frame, reset the values that store which area of the screen has been BLTted to.
     // If we haven't succeeded, this will mean we'll try to resend it after the next poll period.
     UsbDisplayLinkDev->LastY2 = 0;
@@ -429,6 +486,30 @@ DisplayLinkQueryMode (
   return Status;
 }
 
+/**
+ * Free the buffers that DisplayLinkSetMode sizes for the current mode.
+ * @param UsbDisplayLinkDev
+ */
+STATIC VOID
+FreeModeBuffers (
+  IN  USB_DISPLAYLINK_DEV  *UsbDisplayLinkDev
+)
+{
+  if (UsbDisplayLinkDev->Screen != NULL) {
+    FreePool (UsbDisplayLinkDev->Screen);
+    UsbDisplayLinkDev->Screen = NULL;
+  }
+  if (UsbDisplayLinkDev->LineBuffer != NULL) {
+    FreePool (UsbDisplayLinkDev->LineBuffer);
+    UsbDisplayLinkDev->LineBuffer = NULL;
+  }
+  if (UsbDisplayLinkDev->SentScreen != NULL) {
+    FreePool (UsbDisplayLinkDev->SentScreen);
+    UsbDisplayLinkDev->SentScreen = NULL;
+  }
+  UsbDisplayLinkDev->SentScreenValid = FALSE;
+}
+
 /**
  *
  * @param Gop         Pointer to the instance of the GOP protocol
@@ -482,6 +563,39 @@ DisplayLinkSetMode (
     sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
 
   if (UsbDisplayLinkDev->Screen == NULL) {
+    FreeModeBuffers (UsbDisplayLinkDev);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Allocate the buffer that a line of the back buffer is converted into before it is sent
+  //
+  if (UsbDisplayLinkDev->LineBuffer != NULL) {
+    FreePool (UsbDisplayLinkDev->LineBuffer);
+  }
+
+  UsbDisplayLinkDev->LineBuffer = (UINT8*)AllocatePool (Gop->Mode->Info->HorizontalResolution * 3);
+
+  if (UsbDisplayLinkDev->LineBuffer == NULL) {
+    FreeModeBuffers (UsbDisplayLinkDev);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Allocate the copy of the screen as it was last sent. It is valid once a full screen has been sent.
+  //
+  if (UsbDisplayLinkDev->SentScreen != NULL) {
+    FreePool (UsbDisplayLinkDev->SentScreen);
+  }
+
+  UsbDisplayLinkDev->SentScreenValid = FALSE;
+  UsbDisplayLinkDev->SentScreen = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL*)AllocatePool (
+    Gop->Mode->Info->HorizontalResolution *
+    Gop->Mode->Info->VerticalResolution *
+    sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+
+  if (UsbDisplayLinkDev->SentScreen == NULL) {
+    FreeModeBuffers (UsbDisplayLinkDev);
     return EFI_OUT_OF_RESOURCES;
   }
 
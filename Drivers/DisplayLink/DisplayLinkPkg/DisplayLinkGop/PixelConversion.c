@@ -0,0 +1,68 @@
+/**
+ * @file PixelConversion.c
+ * @brief Conversion of the Blt buffer pixels to the pixel format of the DisplayLink device.
+ *
+ * Copyright (c) 2026, agent. All rights reserved.<BR>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+**/
+
+#include "UsbDisplayLink.h"
+
+//
+// Reverse the bytes of a 32-bit word. Compilers turn this into a single byte swap instruction.
+// A BGRX pixel read as a little-endian word becomes XRGB, with R, G and B in the top three bytes.
+//
+#define SWAP_BYTES_32(Value)  (((Value) << 24) | (((Value) & 0xFF00) << 8) | (((Value) >> 8) & 0xFF00) | ((Value) >> 24))
+
+/**
+ * Convert a line of pixels from the BGRX format of the Blt buffer to the RGB888 format sent to
+ * the DisplayLink device.
+ * Four pixels are read and written as 32-bit words at a time, so each group of four pixels
+ * takes four loads, four byte swaps and three stores, rather than three byte loads and three
+ * byte stores per pixel.
+ * @param Destination   Buffer of (3 * Pixels) bytes, 32-bit aligned
+ * @param Source        Pixels to convert
+ * @param Pixels        Number of pixels
+ */
+VOID
+DlGopConvertBgrxToRgb888 (
+    OUT UINT8 *Destination,
+    IN CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Source,
+    IN UINTN Pixels
+    )
+{
+  CONST UINT32 *Src;
+  UINT32 *Dst;
+  UINT32 P0;
+  UINT32 P1;
+  UINT32 P2;
+  UINT32 P3;
+  UINTN Index;
+
+  Src = (CONST UINT32 *)Source;
+  Dst = (UINT32 *)Destination;
+
+  for (Index = 0; Index + 4 <= Pixels; Index += 4) {
+    P0 = SWAP_BYTES_32 (Src[0]);
+    P1 = SWAP_BYTES_32 (Src[1]);
+    P2 = SWAP_BYTES_32 (Src[2]);
+    P3 = SWAP_BYTES_32 (Src[3]);
+
+    Dst[0] = (P0 >> 8) | ((P1 & 0xFF00) << 16);         // R0 G0 B0 R1
+    Dst[1] = (P1 >> 16) | ((P2 << 8) & 0xFFFF0000);     // G1 B1 R2 G2
+    Dst[2] = (P2 >> 24) | (P3 & 0xFFFFFF00);            // B2 R3 G3 B3
+
+    Src += 4;
+    Dst += 3;
+  }
+
+  Destination = (UINT8 *)Dst;
+  for (; Index < Pixels; Index++) {
+    Destination[0] = Source[Index].Red;
+    Destination[1] = Source[Index].Green;
+    Destination[2] = Source[Index].Blue;
+    Destination += 3;
+  }
+}
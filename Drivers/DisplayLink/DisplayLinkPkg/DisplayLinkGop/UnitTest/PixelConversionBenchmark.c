@@ -0,0 +1,212 @@
+/**
+ * @file PixelConversionBenchmark.c
+ * @brief Host-based microbenchmark of the BGRX to RGB888 line conversion of the DisplayLink driver.
+ *
+ * First checks that DlGopConvertBgrxToRgb888 gives the same bytes as the per-pixel byte loop
+ * for many line widths, and then measures both on the line widths of the supported video modes.
+ *
+ * Usage: PixelConversionBenchmarkHost [-n Iterations]
+ *
+ * Exits with 1 if the conversions don't match.
+ *
+ * Copyright (c) 2026, agent. All rights reserved.<BR>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../UsbDisplayLink.h"
+
+#define PIXEL_BENCH_MAX_WIDTH           3840
+#define PIXEL_BENCH_MAX_CHECKED_WIDTH   67
+#define PIXEL_BENCH_DEFAULT_ITERATIONS  100000
+
+typedef VOID (*PIXEL_BENCH_FUNCTION)(
+  UINT8* Destination,
+  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Source,
+  UINTN Pixels
+  );
+
+//
+// Widths of the supported video modes, and of a 4K line.
+//
+STATIC CONST UINTN mPixelBenchWidths[] = { 640, 800, 1024, 1280, 1360, 1400, 1600, 1920, PIXEL_BENCH_MAX_WIDTH };
+
+/**
+ * Convert a line of pixels one byte at a time, as the driver used to.
+ * @param Destination   Buffer of (3 * Pixels) bytes
+ * @param Source        Pixels to convert
+ * @param Pixels        Number of pixels
+ */
+STATIC VOID
+ConvertBgrxToRgb888Bytewise (
+    OUT UINT8 *Destination,
+    IN CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Source,
+    IN UINTN Pixels
+    )
+{
+  UINTN W;
+
+  for (W = 0; W < Pixels; W++) {
+    Destination[0] = ((CONST UINT8 *)Source)[2];
+    Destination[1] = ((CONST UINT8 *)Source)[1];
+    Destination[2] = ((CONST UINT8 *)Source)[0];
+    Source++;
+    Destination += 3;
+  }
+}
+
+/**
+ * Get the current time.
+ * @return The current time, in nanoseconds
+ */
+STATIC UINT64
+PixelBenchNow (
+    VOID
+    )
+{
+  struct timespec Time;
+
+  timespec_get (&Time, TIME_UTC);
+  return (UINT64)Time.tv_sec * 1000000000ULL + (UINT64)Time.tv_nsec;
+}
+
+/**
+ * Check that DlGopConvertBgrxToRgb888 matches the byte loop, and doesn't write past the line.
+ * @param Source        PIXEL_BENCH_MAX_WIDTH random pixels
+ * @return TRUE if the conversions match
+ */
+STATIC BOOLEAN
+PixelBenchCheck (
+    IN CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Source
+    )
+{
+  UINT8 Expected[PIXEL_BENCH_MAX_CHECKED_WIDTH * 3 + 4];
+  UINT32 Actual[(PIXEL_BENCH_MAX_CHECKED_WIDTH * 3 + 4) / 4 + 1];
+  UINTN Width;
+  UINTN Offset;
+
+  for (Width = 0; Width <= PIXEL_BENCH_MAX_CHECKED_WIDTH; Width++) {
+    for (Offset = 0; Offset < 4; Offset++) {
+      SetMem (Expected, sizeof (Expected), 0xA5);
+      SetMem (Actual, sizeof (Actual), 0xA5);
+
+      ConvertBgrxToRgb888Bytewise (Expected, Source + Offset, Width);
+      DlGopConvertBgrxToRgb888 ((UINT8 *)Actual, Source + Offset, Width);
+
+      if (CompareMem (Expected, Actual, Width * 3 + 4) != 0) {
+        fprintf (stderr, "Conversion mismatch: width %u, first pixel %u\n", (unsigned)Width, (unsigned)Offset);
+        return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+ * Measure the time a conversion takes per line.
+ * @param Function      Conversion to measure
+ * @param Destination   Buffer of (3 * PIXEL_BENCH_MAX_WIDTH) bytes
+ * @param Source        PIXEL_BENCH_MAX_WIDTH pixels
+ * @param Width         Line width, in pixels
+ * @param Iterations    Number of lines to convert
+ * @return The time per line, in nanoseconds
+ */
+STATIC double
+PixelBenchRun (
+    IN PIXEL_BENCH_FUNCTION Function,
+    IN UINT8 *Destination,
+    IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Source,
+    IN UINTN Width,
+    IN UINT64 Iterations
+    )
+{
+  UINT64 Index;
+  UINT64 Start;
+  UINT64 Nanoseconds;
+
+  Start = PixelBenchNow ();
+
+  for (Index = 0; Index < Iterations; Index++) {
+    //
+    // Feed each line into the next one so the calls can't be optimised away or overlapped
+    //
+    Source[0].Reserved ^= Destination[0];
+    Function (Destination, Source, Width);
+  }
+
+  Nanoseconds = PixelBenchNow () - Start;
+
+  return (double)Nanoseconds / (double)Iterations;
+}
+
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Source;
+  UINT8 *Destination;
+  UINT64 Iterations;
+  UINT64 WidthIterations;
+  UINTN Index;
+  double Bytewise;
+  double Wordwise;
+
+  Iterations = PIXEL_BENCH_DEFAULT_ITERATIONS;
+
+  if ((argc == 3) && (AsciiStrCmp (argv[1], "-n") == 0) && (atoi (argv[2]) > 0)) {
+    Iterations = (UINT64)atoi (argv[2]);
+  } else if (argc != 1) {
+    fprintf (stderr, "Usage: %s [-n Iterations]\n", argv[0]);
+    return 2;
+  }
+
+  Source = AllocatePool (PIXEL_BENCH_MAX_WIDTH * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  Destination = AllocatePool (PIXEL_BENCH_MAX_WIDTH * 3);
+  if ((Source == NULL) || (Destination == NULL)) {
+    return 2;
+  }
+
+  srand (0);
+
+  for (Index = 0; Index < PIXEL_BENCH_MAX_WIDTH * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL); Index++) {
+    ((UINT8 *)Source)[Index] = (UINT8)rand ();
+  }
+
+  if (!PixelBenchCheck (Source)) {
+    FreePool (Source);
+    FreePool (Destination);
+    return 1;
+  }
+
+  printf ("%8s %14s %14s %8s %12s\n", "width", "bytewise ns", "wordwise ns", "speedup", "Mpixel/s");
+
+  for (Index = 0; Index < ARRAY_SIZE (mPixelBenchWidths); Index++) {
+    //
+    // Convert roughly the same number of pixels for every width
+    //
+    WidthIterations = MAX (Iterations * 1920 / mPixelBenchWidths[Index], 1);
+
+    Bytewise = PixelBenchRun (ConvertBgrxToRgb888Bytewise, Destination, Source, mPixelBenchWidths[Index], WidthIterations);
+    Wordwise = PixelBenchRun (DlGopConvertBgrxToRgb888, Destination, Source, mPixelBenchWidths[Index], WidthIterations);
+    printf (
+      "%8u %14.1f %14.1f %7.1fx %12.1f\n",
+      (unsigned)mPixelBenchWidths[Index],
+      Bytewise,
+      Wordwise,
+      Bytewise / Wordwise,
+      (double)mPixelBenchWidths[Index] * 1000.0 / Wordwise
+      );
+  }
+
+  FreePool (Source);
+  FreePool (Destination);
+  return 0;
+}
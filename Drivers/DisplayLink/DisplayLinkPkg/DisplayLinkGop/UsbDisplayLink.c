@@ -532,8 +532,11 @@ DisplayLinkPeriodicTimer (
     STATIC UINTN Count = 0;
 
     if (Count++ % 50 == 0) {
-      DlGopPrintTextToScreen (&UsbDisplayLinkDev->GraphicsOutputProtocol, 32, 48, (CONST CHAR16*)L"  Bandwidth: %d MB/s    ", UsbDisplayLinkDev->DataSent * 10000000 / DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 50 / 1024 / 1024);
+      DlGopPrintTextToScreen (&UsbDisplayLinkDev->GraphicsOutputProtocol, 32, 48, (CONST CHAR16*)L"  Bandwidth: %d MB/s  Saved: %d MB/s    ",
+        UsbDisplayLinkDev->DataSent * 10000000 / DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 50 / 1024 / 1024,
+        UsbDisplayLinkDev->DataSaved * 10000000 / DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 50 / 1024 / 1024);
       UsbDisplayLinkDev->DataSent = 0;
+      UsbDisplayLinkDev->DataSaved = 0;
     }
   }
 
@@ -1065,6 +1068,16 @@ UsbDisplayLinkDriverBindingStop (
     UsbDisplayLinkDev->Screen = NULL;
   }
 
+  if (UsbDisplayLinkDev->LineBuffer != NULL) {
+    FreePool (UsbDisplayLinkDev->LineBuffer);
+    UsbDisplayLinkDev->LineBuffer = NULL;
+  }
+
+  if (UsbDisplayLinkDev->SentScreen != NULL) {
+    FreePool (UsbDisplayLinkDev->SentScreen);
+    UsbDisplayLinkDev->SentScreen = NULL;
+  }
+
   if (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode) {
     if (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info) {
       FreePool (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info);
@@ -80,7 +80,11 @@ typedef struct {
   EFI_EDID_ACTIVE_PROTOCOL      EdidActive;
   EFI_UNICODE_STRING_TABLE      *ControllerNameTable;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Screen;
+  UINT8                         *LineBuffer;                   /** One line of the screen in the pixel format of the device */
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *SentScreen;                   /** Copy of the screen as it was last sent to the device */
+  BOOLEAN                       SentScreenValid;               /** FALSE until a full screen of the video mode has been sent */
   UINTN                         DataSent;                       /** Debug - used to track the bandwidth */
+  UINTN                         DataSaved;                     /** Debug - bytes of unchanged lines that were not sent */
   EFI_EVENT                     TimerEvent;
   EFI_EVENT                     DriverExitBootServicesEvent;
   BOOLEAN                       ShowBandwidth;                 /** Debugging - show the bandwidth on the screen */
@@ -224,6 +228,13 @@ DlGopSendScreenUpdate (
   USB_DISPLAYLINK_DEV* UsbDisplayLinkDev
 );
 
+VOID
+DlGopConvertBgrxToRgb888 (
+  UINT8* Destination,
+  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Source,
+  UINTN Pixels
+);
+
 
 /* ******************************************* */
 /* ********  USB interface functions  ******** */
@@ -0,0 +1,149 @@
+/** @file
+  CRC32C calculation with the ARMv8 CRC32 extension.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "../Ext4Dxe.h"
+
+// CRC32 field of ID_AA64ISAR0_EL1
+#define ID_AA64ISAR0_CRC32_SHIFT  16
+#define ID_AA64ISAR0_CRC32_MASK   0xF
+
+#if defined (_MSC_VER)
+// ID_AA64ISAR0_EL1, encoded as op0 = 3, op1 = 0, CRn = 0, CRm = 6, op2 = 0
+#define ARM64_ID_AA64ISAR0_EL1  0x4030
+
+__int64
+_ReadStatusReg (
+  int  Register
+  );
+
+unsigned __int32
+__crc32cd (
+  unsigned __int32  Crc,
+  unsigned __int64  Value
+  );
+
+unsigned __int32
+__crc32cb (
+  unsigned __int32  Crc,
+  unsigned __int8   Value
+  );
+
+  #pragma intrinsic(_ReadStatusReg, __crc32cd, __crc32cb)
+#endif
+
+// The CRC32 instructions are optional in ARMv8.0, so the assembler needs to be told about
+// them. This has to be done in each asm statement: a file-scope one can be moved or dropped
+// with LTO.
+
+/**
+   Checks if the CPU implements the CRC32 instructions.
+
+   @retval TRUE    The CPU implements the CRC32 instructions.
+   @retval FALSE   The CPU doesn't implement the CRC32 instructions.
+**/
+BOOLEAN
+Ext4Crc32cAccelSupported (
+  VOID
+  )
+{
+  UINT64  Isar0;
+
+ #if defined (_MSC_VER)
+  Isar0 = (UINT64)_ReadStatusReg (ARM64_ID_AA64ISAR0_EL1);
+ #else
+  __asm__ ("mrs %0, id_aa64isar0_el1" : "=r" (Isar0));
+ #endif
+
+  return ((Isar0 >> ID_AA64ISAR0_CRC32_SHIFT) & ID_AA64ISAR0_CRC32_MASK) != 0;
+}
+
+/**
+   Adds 8 bytes to a CRC32C.
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Value         Bytes to add.
+
+   @return The new value of the CRC.
+**/
+STATIC
+UINT32
+Ext4Crc32cU64 (
+  IN UINT32  Crc,
+  IN UINT64  Value
+  )
+{
+ #if defined (_MSC_VER)
+  return __crc32cd (Crc, Value);
+ #else
+  __asm__ (".arch_extension crc\n\tcrc32cx %w0, %w0, %x1" : "+r" (Crc) : "r" (Value));
+  return Crc;
+ #endif
+}
+
+/**
+   Adds a byte to a CRC32C.
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Value         Byte to add.
+
+   @return The new value of the CRC.
+**/
+STATIC
+UINT32
+Ext4Crc32cU8 (
+  IN UINT32  Crc,
+  IN UINT8   Value
+  )
+{
+ #if defined (_MSC_VER)
+  return __crc32cb (Crc, Value);
+ #else
+  __asm__ (".arch_extension crc\n\tcrc32cb %w0, %w0, %w1" : "+r" (Crc) : "r" ((UINT32)Value));
+  return Crc;
+ #endif
+}
+
+/**
+   Calculates the CRC32C of a buffer with the CRC32 instructions.
+   Ext4Crc32cAccelSupported must have returned TRUE.
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32cAccel (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  )
+{
+  CONST UINT8  *Bytes;
+
+  Bytes = Buffer;
+
+  // Get to an 8-byte boundary, then do 8 bytes at a time
+  while ((Length != 0) && (((UINTN)Bytes & (sizeof (UINT64) - 1)) != 0)) {
+    Crc = Ext4Crc32cU8 (Crc, *Bytes++);
+    Length--;
+  }
+
+  while (Length >= sizeof (UINT64)) {
+    Crc     = Ext4Crc32cU64 (Crc, *(CONST UINT64 *)Bytes);
+    Bytes  += sizeof (UINT64);
+    Length -= sizeof (UINT64);
+  }
+
+  while (Length != 0) {
+    Crc = Ext4Crc32cU8 (Crc, *Bytes++);
+    Length--;
+  }
+
+  return Crc;
+}
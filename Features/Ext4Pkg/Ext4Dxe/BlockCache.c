@@ -0,0 +1,544 @@
+/** @file
+  Partition-wide metadata block cache.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  Metadata (inode tables, extent tree nodes, indirect blocks and directory blocks) is read
+  through a small, bounded cache of whole filesystem blocks, so path walks don't keep going
+  to the disk for the same blocks. Blocks are looked up through a hash table and evicted in
+  LRU order once PcdExt4BlockCacheSize blocks are cached.
+**/
+
+#include "Ext4Dxe.h"
+
+typedef struct _Ext4_BLOCK_CACHE_ENTRY {
+  LIST_ENTRY       HashNode;
+  LIST_ENTRY       LruNode;
+  EXT4_BLOCK_NR    Block;
+  VOID             *Data;
+} EXT4_BLOCK_CACHE_ENTRY;
+
+#define EXT4_BLOCK_CACHE_ENTRY_FROM_HASH_NODE(Node)  BASE_CR(Node, EXT4_BLOCK_CACHE_ENTRY, HashNode)
+#define EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE(Node)   BASE_CR(Node, EXT4_BLOCK_CACHE_ENTRY, LruNode)
+
+// Maximum number of blocks read by a single prefetch request
+#define EXT4_BLOCK_CACHE_MAX_PREFETCH  32
+
+/**
+   Initialises the partition's block cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition, with a valid BlockSize.
+
+   @retval EFI_SUCCESS             The cache was initialised (or is disabled).
+   @retval EFI_OUT_OF_RESOURCES    Failed to allocate the hash table.
+**/
+EFI_STATUS
+Ext4InitBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE  *Cache;
+  UINTN             Index;
+
+  Cache = &Partition->BlockCache;
+
+  InitializeListHead (&Cache->Lru);
+  Cache->NumberEntries = 0;
+  Cache->MaxEntries    = PcdGet32 (PcdExt4BlockCacheSize);
+  Cache->Hits          = 0;
+  Cache->Misses        = 0;
+  Cache->Prefetched    = 0;
+  Cache->Buckets       = NULL;
+  Cache->NumberBuckets = 0;
+
+  if (Cache->MaxEntries == 0) {
+    // Cache disabled, every read goes straight to the disk
+    return EFI_SUCCESS;
+  }
+
+  // Keep the load factor under 2 and make the bucket count a power of 2, so we can mask.
+  Cache->NumberBuckets = GetPowerOfTwo32 ((UINT32)Cache->MaxEntries);
+  Cache->Buckets       = AllocatePool (Cache->NumberBuckets * sizeof (LIST_ENTRY));
+
+  if (Cache->Buckets == NULL) {
+    Cache->MaxEntries = 0;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Cache->NumberBuckets; Index++) {
+    InitializeListHead (&Cache->Buckets[Index]);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the partition's block cache, and reports its hit rate.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE  *Cache;
+
+  Cache = &Partition->BlockCache;
+
+  DEBUG ((
+    DEBUG_FS,
+    "[ext4] Block cache: %lu hits, %lu misses, %lu prefetched, %lu blocks cached\n",
+    Cache->Hits,
+    Cache->Misses,
+    Cache->Prefetched,
+    (UINT64)Cache->NumberEntries
+    ));
+
+  if (Cache->Buckets == NULL) {
+    return;
+  }
+
+  Ext4InvalidateBlockCache (Partition);
+
+  FreePool (Cache->Buckets);
+  Cache->Buckets    = NULL;
+  Cache->MaxEntries = 0;
+}
+
+/**
+   Drops every block from the partition's block cache, so that following reads
+   go to the disk again.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4InvalidateBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  LIST_ENTRY              *Node;
+  LIST_ENTRY              *NextNode;
+  UINTN                   Index;
+
+  Cache = &Partition->BlockCache;
+
+  if (Cache->Buckets == NULL) {
+    return;
+  }
+
+  BASE_LIST_FOR_EACH_SAFE (Node, NextNode, &Cache->Lru) {
+    Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE (Node);
+    RemoveEntryList (&Entry->LruNode);
+    FreePool (Entry);
+  }
+
+  for (Index = 0; Index < Cache->NumberBuckets; Index++) {
+    InitializeListHead (&Cache->Buckets[Index]);
+  }
+
+  Cache->NumberEntries = 0;
+}
+
+/**
+   Gets a block's hash bucket.
+
+   @param[in]  Cache     Pointer to the block cache.
+   @param[in]  Block     Block number.
+
+   @return Pointer to the bucket's list head.
+**/
+STATIC
+LIST_ENTRY *
+Ext4BlockCacheBucket (
+  IN EXT4_BLOCK_CACHE  *Cache,
+  IN EXT4_BLOCK_NR     Block
+  )
+{
+  return &Cache->Buckets[(UINTN)Block & (Cache->NumberBuckets - 1)];
+}
+
+/**
+   Looks up a block in the cache.
+
+   @param[in]  Cache     Pointer to the block cache.
+   @param[in]  Block     Block number.
+
+   @return Pointer to the cache entry, or NULL if the block isn't cached.
+**/
+STATIC
+EXT4_BLOCK_CACHE_ENTRY *
+Ext4BlockCacheLookup (
+  IN EXT4_BLOCK_CACHE  *Cache,
+  IN EXT4_BLOCK_NR     Block
+  )
+{
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  LIST_ENTRY              *Node;
+
+  BASE_LIST_FOR_EACH (Node, Ext4BlockCacheBucket (Cache, Block)) {
+    Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_HASH_NODE (Node);
+
+    if (Entry->Block == Block) {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+   Gets a free cache entry, either by allocating a new one or by recycling the
+   least recently used one. The entry is not part of the cache when returned.
+
+   @param[in]  Partition     Pointer to the opened EXT4 partition.
+
+   @return Pointer to the entry, or NULL if we ran out of memory.
+**/
+STATIC
+EXT4_BLOCK_CACHE_ENTRY *
+Ext4BlockCacheGetFreeEntry (
+  IN EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+
+  Cache = &Partition->BlockCache;
+
+  if (Cache->NumberEntries < Cache->MaxEntries) {
+    Entry = AllocatePool (sizeof (EXT4_BLOCK_CACHE_ENTRY) + Partition->BlockSize);
+
+    if (Entry == NULL) {
+      return NULL;
+    }
+
+    Entry->Data = Entry + 1;
+    Cache->NumberEntries++;
+  } else {
+    // Cache is full, recycle the least recently used entry
+    Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE (GetPreviousNode (&Cache->Lru, &Cache->Lru));
+    RemoveEntryList (&Entry->LruNode);
+    RemoveEntryList (&Entry->HashNode);
+  }
+
+  return Entry;
+}
+
+/**
+   Releases a cache entry obtained from Ext4BlockCacheGetFreeEntry that couldn't be used.
+
+   @param[in]  Cache     Pointer to the block cache.
+   @param[in]  Entry     Pointer to the entry.
+**/
+STATIC
+VOID
+Ext4BlockCachePutFreeEntry (
+  IN EXT4_BLOCK_CACHE        *Cache,
+  IN EXT4_BLOCK_CACHE_ENTRY  *Entry
+  )
+{
+  FreePool (Entry);
+  Cache->NumberEntries--;
+}
+
+/**
+   Adds an entry to the cache, as the most recently used one.
+
+   @param[in]  Cache     Pointer to the block cache.
+   @param[in]  Entry     Pointer to the entry, with valid data.
+   @param[in]  Block     Block number.
+**/
+STATIC
+VOID
+Ext4BlockCacheInsert (
+  IN EXT4_BLOCK_CACHE        *Cache,
+  IN EXT4_BLOCK_CACHE_ENTRY  *Entry,
+  IN EXT4_BLOCK_NR           Block
+  )
+{
+  Entry->Block = Block;
+  InsertHeadList (Ext4BlockCacheBucket (Cache, Block), &Entry->HashNode);
+  InsertHeadList (&Cache->Lru, &Entry->LruNode);
+}
+
+/**
+   Gets a block from the cache, reading it from disk on a miss.
+   The returned data is only valid until the next call into the block cache.
+
+   @param[in]  Partition     Pointer to the opened EXT4 partition.
+   @param[in]  Block         Block number.
+   @param[out] Data          Pointer to where a pointer to the block's data will be stored.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BlockCacheGet (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_BLOCK_NR   Block,
+  OUT VOID            **Data
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  EFI_STATUS              Status;
+
+  Cache = &Partition->BlockCache;
+  Entry = Ext4BlockCacheLookup (Cache, Block);
+
+  if (Entry != NULL) {
+    Cache->Hits++;
+    // Move it to the head of the LRU list
+    RemoveEntryList (&Entry->LruNode);
+    InsertHeadList (&Cache->Lru, &Entry->LruNode);
+    *Data = Entry->Data;
+    return EFI_SUCCESS;
+  }
+
+  Cache->Misses++;
+
+  Entry = Ext4BlockCacheGetFreeEntry (Partition);
+
+  if (Entry == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4ReadBlocks (Partition, Entry->Data, 1, Block);
+
+  if (EFI_ERROR (Status)) {
+    Ext4BlockCachePutFreeEntry (Cache, Entry);
+    return Status;
+  }
+
+  Ext4BlockCacheInsert (Cache, Entry, Block);
+
+  *Data = Entry->Data;
+  return EFI_SUCCESS;
+}
+
+/**
+   Prefetches a range of blocks into the block cache. Blocks that aren't cached yet are
+   read with as few disk requests as possible.
+   Prefetching is only a hint, so errors are not reported.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  BlockNumber    Starting block number.
+   @param[in]  NumberBlocks   Number of blocks to prefetch.
+**/
+VOID
+Ext4BlockCachePrefetch (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_BLOCK_NR   BlockNumber,
+  IN UINTN           NumberBlocks
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  EXT4_BLOCK_NR           End;
+  EXT4_BLOCK_NR           RunEnd;
+  UINTN                   RunLength;
+  UINTN                   Index;
+  UINT8                   *Buffer;
+  EFI_STATUS              Status;
+
+  Cache = &Partition->BlockCache;
+
+  // Don't let a single prefetch evict a large part of the cache
+  if ((Cache->MaxEntries == 0) || (NumberBlocks > Cache->MaxEntries / 2)) {
+    return;
+  }
+
+  Buffer = NULL;
+  End    = BlockNumber + NumberBlocks;
+
+  while (BlockNumber < End) {
+    // Skip over blocks we already have
+    if (Ext4BlockCacheLookup (Cache, BlockNumber) != NULL) {
+      BlockNumber++;
+      continue;
+    }
+
+    RunEnd = BlockNumber + 1;
+
+    while ((RunEnd < End) && (RunEnd - BlockNumber < EXT4_BLOCK_CACHE_MAX_PREFETCH) &&
+           (Ext4BlockCacheLookup (Cache, RunEnd) == NULL))
+    {
+      RunEnd++;
+    }
+
+    RunLength = (UINTN)(RunEnd - BlockNumber);
+
+    if (Buffer == NULL) {
+      Buffer = AllocatePool (MIN (NumberBlocks, EXT4_BLOCK_CACHE_MAX_PREFETCH) * Partition->BlockSize);
+
+      if (Buffer == NULL) {
+        return;
+      }
+    }
+
+    Status = Ext4ReadBlocks (Partition, Buffer, RunLength, BlockNumber);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    for (Index = 0; Index < RunLength; Index++) {
+      Entry = Ext4BlockCacheGetFreeEntry (Partition);
+
+      if (Entry == NULL) {
+        break;
+      }
+
+      CopyMem (Entry->Data, Buffer + Index * Partition->BlockSize, Partition->BlockSize);
+      Ext4BlockCacheInsert (Cache, Entry, BlockNumber + Index);
+      Cache->Prefetched++;
+    }
+
+    BlockNumber = RunEnd;
+  }
+
+  if (Buffer != NULL) {
+    FreePool (Buffer);
+  }
+}
+
+/**
+   Updates the cached blocks that overlap a range of the disk, after it was written to.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  Buffer         Pointer to the new data.
+   @param[in]  Length         Length of the new data, in bytes.
+   @param[in]  Offset         Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4BlockCacheUpdate (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  EXT4_BLOCK_NR           Block;
+  EXT4_BLOCK_NR           LastBlock;
+
+  Cache = &Partition->BlockCache;
+
+  if ((Cache->Buckets == NULL) || (Length == 0)) {
+    return;
+  }
+
+  LastBlock = DivU64x32 (Offset + Length - 1, Partition->BlockSize);
+
+  for (Block = DivU64x32 (Offset, Partition->BlockSize); Block <= LastBlock; Block++) {
+    Entry = Ext4BlockCacheLookup (Cache, Block);
+
+    if (Entry != NULL) {
+      Ext4CopyOverlap (
+        Entry->Data,
+        Partition->BlockSize,
+        EXT4_BLOCK_TO_BYTES (Partition, Block),
+        Buffer,
+        Length,
+        Offset
+        );
+    }
+  }
+}
+
+/**
+   Reads from the partition's disk, going through the block cache.
+   Meant for metadata, which is small and frequently re-read.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  Length         Length of the destination buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to read.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadDiskIoCached (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  )
+{
+  EFI_STATUS     Status;
+  EXT4_BLOCK_NR  Block;
+  UINT32         BlockOff;
+  UINTN          ToCopy;
+  VOID           *Data;
+
+  if (Partition->BlockCache.MaxEntries == 0) {
+    return Ext4ReadDiskIo (Partition, Buffer, Length, Offset);
+  }
+
+  while (Length != 0) {
+    Block  = DivU64x32Remainder (Offset, Partition->BlockSize, &BlockOff);
+    ToCopy = MIN (Length, Partition->BlockSize - BlockOff);
+
+    Status = Ext4BlockCacheGet (Partition, Block, &Data);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    CopyMem (Buffer, (CONST CHAR8 *)Data + BlockOff, ToCopy);
+
+    Buffer  = (CHAR8 *)Buffer + ToCopy;
+    Offset += ToCopy;
+    Length -= ToCopy;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads blocks from the partition's disk, going through the block cache.
+   Meant for metadata, which is small and frequently re-read.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  NumberBlocks   Length of the read, in filesystem blocks.
+   @param[in]  BlockNumber    Starting block number.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadBlocksCached (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           NumberBlocks,
+  IN EXT4_BLOCK_NR   BlockNumber
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  VOID        *Data;
+
+  ASSERT (NumberBlocks != 0);
+  ASSERT (BlockNumber != EXT4_BLOCK_FILE_HOLE);
+
+  if (Partition->BlockCache.MaxEntries == 0) {
+    return Ext4ReadBlocks (Partition, Buffer, NumberBlocks, BlockNumber);
+  }
+
+  for (Index = 0; Index < NumberBlocks; Index++) {
+    Status = Ext4BlockCacheGet (Partition, BlockNumber + Index, &Data);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    CopyMem ((CHAR8 *)Buffer + Index * Partition->BlockSize, Data, Partition->BlockSize);
+  }
+
+  return EFI_SUCCESS;
+}
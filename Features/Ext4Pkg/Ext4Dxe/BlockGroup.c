@@ -28,27 +28,26 @@ Ext4GetBlockGroupDesc (
 }
 
 /**
-   Reads an inode from disk.
+   Gets the location of an inode on disk.
 
    @param[in]    Partition  Pointer to the opened partition.
    @param[in]    InodeNum   Number of the desired Inode
-   @param[out]   OutIno     Pointer to where it will be stored a pointer to the read inode.
+   @param[out]   Offset     Pointer to where the inode's offset, in bytes, will be stored.
 
-   @return Status of the inode read.
+   @retval EFI_SUCCESS             The inode's location was found.
+   @retval EFI_VOLUME_CORRUPTED    The inode number is invalid.
 **/
 EFI_STATUS
-Ext4ReadInode (
-  IN EXT4_PARTITION  *Partition,
-  IN EXT4_INO_NR     InodeNum,
-  OUT EXT4_INODE     **OutIno
+Ext4GetInodeOffset (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_INO_NR     InodeNum,
+  OUT UINT64          *Offset
   )
 {
   UINT64                 InodeOffset;
   UINT32                 BlockGroupNumber;
-  EXT4_INODE             *Inode;
   EXT4_BLOCK_GROUP_DESC  *BlockGroup;
   EXT4_BLOCK_NR          InodeTableStart;
-  EFI_STATUS             Status;
 
   if (!EXT4_IS_VALID_INODE_NR (Partition, InodeNum)) {
     DEBUG ((DEBUG_ERROR, "[ext4] Error reading inode: inode number %lu isn't valid\n", InodeNum));
@@ -66,38 +65,59 @@ Ext4ReadInode (
     return EFI_VOLUME_CORRUPTED;
   }
 
-  Inode = Ext4AllocateInode (Partition);
-
-  if (Inode == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
   BlockGroup = Ext4GetBlockGroupDesc (Partition, BlockGroupNumber);
 
-  // Note: We'll need to check INODE_UNINIT and friends when/if we add write support
-
   InodeTableStart = EXT4_BLOCK_NR_FROM_HALFS (
                       Partition,
                       BlockGroup->bg_inode_table_lo,
                       BlockGroup->bg_inode_table_hi
                       );
 
-  Status = Ext4ReadDiskIo (
-             Partition,
-             Inode,
-             Partition->InodeSize,
-             EXT4_BLOCK_TO_BYTES (Partition, InodeTableStart) + MultU64x32 (InodeOffset, Partition->InodeSize)
-             );
+  *Offset = EXT4_BLOCK_TO_BYTES (Partition, InodeTableStart) + MultU64x32 (InodeOffset, Partition->InodeSize);
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads an inode from disk.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    InodeNum   Number of the desired Inode
+   @param[out]   OutIno     Pointer to where it will be stored a pointer to the read inode.
+
+   @return Status of the inode read.
+**/
+EFI_STATUS
+Ext4ReadInode (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_INO_NR     InodeNum,
+  OUT EXT4_INODE     **OutIno
+  )
+{
+  UINT64      Offset;
+  EXT4_INODE  *Inode;
+  EFI_STATUS  Status;
+
+  Status = Ext4GetInodeOffset (Partition, InodeNum, &Offset);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Inode = Ext4AllocateInode (Partition);
+
+  if (Inode == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4ReadDiskIoCached (Partition, Inode, Partition->InodeSize, Offset);
 
   if (EFI_ERROR (Status)) {
     DEBUG ((
       DEBUG_ERROR,
-      "[ext4] Error reading inode: status %x; inode offset %lx"
-      " inode table start %lu block group %lu\n",
+      "[ext4] Error reading inode %lu: status %r; disk offset %lx\n",
+      InodeNum,
       Status,
-      InodeOffset,
-      InodeTableStart,
-      BlockGroupNumber
+      Offset
       ));
     FreePool (Inode);
     return Status;
@@ -118,6 +138,77 @@ Ext4ReadInode (
   return EFI_SUCCESS;
 }
 
+/**
+   Prefetches the inode table blocks that hold a set of inodes into the block cache.
+   Each table block is read only once, and runs of consecutive table blocks are read
+   with a single disk request.
+   Prefetching is only a hint, so errors are not reported.
+
+   @param[in]    Partition     Pointer to the opened partition.
+   @param[in]    InodeNums     Pointer to an array of inode numbers.
+   @param[in]    NumberInodes  Number of entries in InodeNums.
+**/
+VOID
+Ext4PrefetchInodes (
+  IN EXT4_PARTITION     *Partition,
+  IN CONST EXT4_INO_NR  *InodeNums,
+  IN UINTN              NumberInodes
+  )
+{
+  EXT4_BLOCK_NR  *Blocks;
+  EXT4_BLOCK_NR  Block;
+  UINTN          NumberBlocks;
+  UINTN          Index;
+  UINTN          Pos;
+  UINTN          RunStart;
+  UINT64         Offset;
+
+  if (NumberInodes == 0) {
+    return;
+  }
+
+  Blocks = AllocatePool (NumberInodes * sizeof (EXT4_BLOCK_NR));
+
+  if (Blocks == NULL) {
+    return;
+  }
+
+  NumberBlocks = 0;
+
+  // Collect the sorted set of table blocks. The number of inodes is bound by the number
+  // of entries in a directory block, so insertion sort is fine.
+  for (Index = 0; Index < NumberInodes; Index++) {
+    if (EFI_ERROR (Ext4GetInodeOffset (Partition, InodeNums[Index], &Offset))) {
+      continue;
+    }
+
+    Block = DivU64x32 (Offset, Partition->BlockSize);
+
+    Pos = NumberBlocks;
+
+    while ((Pos > 0) && (Blocks[Pos - 1] > Block)) {
+      Pos--;
+    }
+
+    if ((Pos > 0) && (Blocks[Pos - 1] == Block)) {
+      continue;
+    }
+
+    CopyMem (&Blocks[Pos + 1], &Blocks[Pos], (NumberBlocks - Pos) * sizeof (EXT4_BLOCK_NR));
+    Blocks[Pos] = Block;
+    NumberBlocks++;
+  }
+
+  for (RunStart = 0, Index = 1; Index <= NumberBlocks; Index++) {
+    if ((Index == NumberBlocks) || (Blocks[Index] != Blocks[Index - 1] + 1)) {
+      Ext4BlockCachePrefetch (Partition, Blocks[RunStart], Index - RunStart);
+      RunStart = Index;
+    }
+  }
+
+  FreePool (Blocks);
+}
+
 /**
    Calculates the checksum of the block group descriptor for METADATA_CSUM enabled filesystems.
    @param[in]      Partition       Pointer to the opened EXT4 partition.
@@ -227,3 +318,1069 @@ Ext4CalculateBlockGroupDescChecksum (
 
   return 0;
 }
+
+/**
+   Writes a file's inode back to the inode table, updating its checksum.
+   Other open files of the same inode are updated as well.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    File       Pointer to the file.
+
+   @return Status of the write.
+**/
+EFI_STATUS
+Ext4WriteInode (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File
+  )
+{
+  EFI_STATUS     Status;
+  UINT64         Offset;
+  UINT32         BlockOffset;
+  EXT4_BLOCK_NR  Block;
+  UINT32         Checksum;
+  UINT8          *Buffer;
+  LIST_ENTRY     *Entry;
+  EXT4_FILE      *Other;
+
+  Status = Ext4GetInodeOffset (Partition, File->InodeNum, &Offset);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Checksum = Ext4CalculateInodeChecksum (Partition, File->Inode, File->InodeNum);
+
+    File->Inode->i_osd2.data_linux.l_i_checksum_lo = (UINT16)Checksum;
+
+    if (EXT4_INODE_HAS_FIELD (File->Inode, i_checksum_hi)) {
+      File->Inode->i_checksum_hi = (UINT16)(Checksum >> 16);
+    }
+  }
+
+  Buffer = AllocatePool (Partition->BlockSize);
+
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Block  = DivU64x32Remainder (Offset, Partition->BlockSize, &BlockOffset);
+  Status = Ext4ReadBlocksCached (Partition, Buffer, 1, Block);
+
+  if (!EFI_ERROR (Status)) {
+    CopyMem (Buffer + BlockOffset, File->Inode, Partition->InodeSize);
+    Status = Ext4MarkBlockDirty (Partition, Block, Buffer);
+  }
+
+  FreePool (Buffer);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Keep the other handles of the same inode coherent
+  BASE_LIST_FOR_EACH (Entry, &Partition->OpenFiles) {
+    Other = BASE_CR (Entry, EXT4_FILE, OpenFilesListNode);
+
+    if ((Other != File) && (Other->InodeNum == File->InodeNum)) {
+      CopyMem (Other->Inode, File->Inode, Partition->InodeSize);
+      Ext4ResetExtentsMap (Other);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Checks if the block group descriptors' checksums (and so the UNINIT flags) are in use.
+
+   @param[in]    Partition  Pointer to the opened partition.
+
+   @return TRUE if the block group descriptors have checksums.
+**/
+STATIC
+BOOLEAN
+Ext4HasGroupDescChecksum (
+  IN CONST EXT4_PARTITION  *Partition
+  )
+{
+  return EXT4_HAS_METADATA_CSUM (Partition) || EXT4_HAS_GDT_CSUM (Partition);
+}
+
+/**
+   Adds to a block group descriptor counter that is split in two 16-bit halves.
+   The high half only exists in 64-bit descriptors.
+
+   @param[in]      Partition  Pointer to the opened partition.
+   @param[in out]  Lo         Pointer to the low half of the counter.
+   @param[in out]  Hi         Pointer to the high half of the counter.
+   @param[in]      Delta      Value to add.
+**/
+STATIC
+VOID
+Ext4AddToGroupCount (
+  IN     CONST EXT4_PARTITION  *Partition,
+  IN OUT UINT16                *Lo,
+  IN OUT UINT16                *Hi,
+  IN     INT32                 Delta
+  )
+{
+  UINT32  Count;
+
+  Count = *Lo;
+
+  if (Partition->DescSize >= EXT4_64BIT_BLOCK_DESC_SIZE) {
+    Count |= (UINT32)*Hi << 16;
+  }
+
+  Count += (UINT32)Delta;
+  *Lo    = (UINT16)Count;
+
+  if (Partition->DescSize >= EXT4_64BIT_BLOCK_DESC_SIZE) {
+    *Hi = (UINT16)(Count >> 16);
+  }
+}
+
+/**
+   Gets a block group descriptor counter that is split in two 16-bit halves.
+
+   @param[in]      Partition  Pointer to the opened partition.
+   @param[in]      Lo         Low half of the counter.
+   @param[in]      Hi         High half of the counter.
+
+   @return The counter's value.
+**/
+STATIC
+UINT32
+Ext4GetGroupCount (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN UINT16                Lo,
+  IN UINT16                Hi
+  )
+{
+  if (Partition->DescSize >= EXT4_64BIT_BLOCK_DESC_SIZE) {
+    return Lo | ((UINT32)Hi << 16);
+  }
+
+  return Lo;
+}
+
+/**
+   Adds to the superblock's count of free blocks.
+
+   @param[in]      Partition  Pointer to the opened partition.
+   @param[in]      Delta      Number of blocks to add.
+**/
+STATIC
+VOID
+Ext4AddToFreeBlocks (
+  IN EXT4_PARTITION  *Partition,
+  IN INT64           Delta
+  )
+{
+  EXT4_SUPERBLOCK  *Sb;
+  UINT64           Count;
+
+  Sb    = &Partition->SuperBlock;
+  Count = EXT4_BLOCK_NR_FROM_HALFS (Partition, Sb->s_free_blocks_count, Sb->s_free_blocks_count_hi);
+  Count = Count + (UINT64)Delta;
+
+  Sb->s_free_blocks_count = (UINT32)Count;
+
+  if (EXT4_IS_64_BIT (Partition)) {
+    Sb->s_free_blocks_count_hi = (UINT32)RShiftU64 (Count, 32);
+  }
+
+  Partition->SuperBlockDirty = TRUE;
+}
+
+/**
+   Writes a block group descriptor back, updating its checksum.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4WriteBlockGroupDesc (
+  IN EXT4_PARTITION  *Partition,
+  IN UINT32          Group
+  )
+{
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT64                 DescOffset;
+  UINT64                 DescBlock;
+
+  Desc = Ext4GetBlockGroupDesc (Partition, Group);
+
+  if (Ext4HasGroupDescChecksum (Partition)) {
+    Desc->bg_checksum = Ext4CalculateBlockGroupDescChecksum (Partition, Desc, Group);
+  }
+
+  // The descriptor table starts right after the superblock's block
+  DescOffset = MultU64x32 (Group, Partition->DescSize);
+  DescBlock  = DivU64x32 (DescOffset, Partition->BlockSize);
+
+  return Ext4MarkBlockDirty (
+           Partition,
+           Partition->SuperBlock.s_first_data_block + 1 + DescBlock,
+           (CONST UINT8 *)Partition->BlockGroups + MultU64x32 (DescBlock, Partition->BlockSize)
+           );
+}
+
+/**
+   Checks if a number is a power of another.
+
+   @param[in]    Number     Number.
+   @param[in]    Base       Base.
+
+   @return TRUE if Number is a power of Base.
+**/
+STATIC
+BOOLEAN
+Ext4IsPowerOf (
+  IN UINT32  Number,
+  IN UINT32  Base
+  )
+{
+  while (Number >= Base) {
+    if (Number == Base) {
+      return TRUE;
+    }
+
+    if (Number % Base != 0) {
+      return FALSE;
+    }
+
+    Number /= Base;
+  }
+
+  return FALSE;
+}
+
+/**
+   Checks if a block group holds a copy of the superblock (and of the block group descriptors).
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+
+   @return TRUE if the block group has a superblock.
+**/
+STATIC
+BOOLEAN
+Ext4GroupHasSuperblock (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN UINT32                Group
+  )
+{
+  if (Group == 0) {
+    return TRUE;
+  }
+
+  if (EXT4_HAS_COMPAT (Partition, EXT4_FEATURE_COMPAT_SPARSE_SUPER2)) {
+    return Group == Partition->SuperBlock.s_backup_bgs[0] || Group == Partition->SuperBlock.s_backup_bgs[1];
+  }
+
+  if ((Group == 1) || !EXT4_HAS_RO_COMPAT (Partition, EXT4_FEATURE_RO_COMPAT_SPARSE_SUPER)) {
+    return TRUE;
+  }
+
+  return Ext4IsPowerOf (Group, 3) || Ext4IsPowerOf (Group, 5) || Ext4IsPowerOf (Group, 7);
+}
+
+/**
+   Gets the first block of a block group, and its number of blocks.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+   @param[out]   Count      Pointer to where the number of blocks will be stored.
+
+   @return The block group's first block.
+**/
+STATIC
+EXT4_BLOCK_NR
+Ext4GetGroupFirstBlock (
+  IN  CONST EXT4_PARTITION  *Partition,
+  IN  UINT32                Group,
+  OUT UINT32                *Count
+  )
+{
+  EXT4_BLOCK_NR  First;
+
+  First  = Partition->SuperBlock.s_first_data_block + MultU64x32 (Group, Partition->SuperBlock.s_blocks_per_group);
+  *Count = (UINT32)MIN (Partition->NumberBlocks - First, Partition->SuperBlock.s_blocks_per_group);
+  return First;
+}
+
+/**
+   Sets a range of bits of a bitmap.
+
+   @param[in out]  Bitmap   Pointer to the bitmap.
+   @param[in]      Start    First bit.
+   @param[in]      End      Bit after the last bit.
+**/
+STATIC
+VOID
+Ext4SetBitmapRange (
+  IN OUT UINT8   *Bitmap,
+  IN     UINT64  Start,
+  IN     UINT64  End
+  )
+{
+  for ( ; Start < End; Start++) {
+    Bitmap[Start / 8] |= (UINT8)(1 << (Start % 8));
+  }
+}
+
+/**
+   Marks a block used by the block group's metadata, if it's in the group.
+
+   @param[in out]  Bitmap   Pointer to the block bitmap.
+   @param[in]      First    First block of the block group.
+   @param[in]      Count    Number of blocks in the block group.
+   @param[in]      Block    First block of the metadata.
+   @param[in]      Length   Length of the metadata, in blocks.
+**/
+STATIC
+VOID
+Ext4SetGroupMetadataBits (
+  IN OUT UINT8          *Bitmap,
+  IN     EXT4_BLOCK_NR  First,
+  IN     UINT32         Count,
+  IN     EXT4_BLOCK_NR  Block,
+  IN     UINT64         Length
+  )
+{
+  if ((Block >= First) && (Block < First + Count)) {
+    Ext4SetBitmapRange (Bitmap, Block - First, MIN (Block - First + Length, Count));
+  }
+}
+
+/**
+   Reads the block bitmap of a block group. BLOCK_UNINIT groups don't have one on disk,
+   so it's built from the group's metadata, like the kernel does.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+   @param[out]   Bitmap     Pointer to the bitmap, a block long.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4ReadBlockBitmap (
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT32          Group,
+  OUT UINT8           *Bitmap
+  )
+{
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  EXT4_BLOCK_NR          Block;
+  EXT4_BLOCK_NR          First;
+  UINT32                 Count;
+  UINT64                 GdtBlocks;
+
+  Desc  = Ext4GetBlockGroupDesc (Partition, Group);
+  Block = EXT4_BLOCK_NR_FROM_HALFS (Partition, Desc->bg_block_bitmap_lo, Desc->bg_block_bitmap_hi);
+
+  if ((Block == 0) || (Block >= Partition->NumberBlocks)) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Block group %u has a bad block bitmap\n", Group));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (!Ext4HasGroupDescChecksum (Partition) || ((Desc->bg_flags & EXT4_BG_BLOCK_UNINIT) == 0)) {
+    return Ext4ReadBlocksCached (Partition, Bitmap, 1, Block);
+  }
+
+  ZeroMem (Bitmap, Partition->BlockSize);
+
+  First = Ext4GetGroupFirstBlock (Partition, Group, &Count);
+
+  if (Ext4GroupHasSuperblock (Partition, Group)) {
+    GdtBlocks = DivU64x32 (
+                  MultU64x32 (Partition->NumberBlockGroups, Partition->DescSize) + Partition->BlockSize - 1,
+                  Partition->BlockSize
+                  );
+    Ext4SetBitmapRange (Bitmap, 0, MIN (1 + GdtBlocks + Partition->SuperBlock.s_reserved_gdt_blocks, Count));
+  }
+
+  // With flex_bg, the group's bitmaps and inode table may be in another group
+  Ext4SetGroupMetadataBits (Bitmap, First, Count, Block, 1);
+  Ext4SetGroupMetadataBits (
+    Bitmap,
+    First,
+    Count,
+    EXT4_BLOCK_NR_FROM_HALFS (Partition, Desc->bg_inode_bitmap_lo, Desc->bg_inode_bitmap_hi),
+    1
+    );
+  Ext4SetGroupMetadataBits (
+    Bitmap,
+    First,
+    Count,
+    EXT4_BLOCK_NR_FROM_HALFS (Partition, Desc->bg_inode_table_lo, Desc->bg_inode_table_hi),
+    DivU64x32 (
+      MultU64x32 (Partition->SuperBlock.s_inodes_per_group, Partition->InodeSize) + Partition->BlockSize - 1,
+      Partition->BlockSize
+      )
+    );
+
+  // Blocks past the end of the filesystem are never free
+  Ext4SetBitmapRange (Bitmap, Count, MultU64x32 (Partition->BlockSize, 8));
+  return EFI_SUCCESS;
+}
+
+/**
+   Writes the block bitmap of a block group back, updating its checksum.
+   The block group descriptor (which holds the checksum) needs to be written by the caller.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+   @param[in]    Bitmap     Pointer to the bitmap.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4WriteBlockBitmap (
+  IN EXT4_PARTITION  *Partition,
+  IN UINT32          Group,
+  IN CONST UINT8     *Bitmap
+  )
+{
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT32                 Checksum;
+
+  Desc = Ext4GetBlockGroupDesc (Partition, Group);
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Checksum = Ext4CalculateChecksum (
+                 Partition,
+                 Bitmap,
+                 Partition->SuperBlock.s_blocks_per_group / 8,
+                 Partition->InitialSeed
+                 );
+
+    Desc->bg_block_bitmap_csum_lo = (UINT16)Checksum;
+
+    if (Partition->DescSize >= OFFSET_OF (EXT4_BLOCK_GROUP_DESC, bg_block_bitmap_csum_hi) + sizeof (UINT16)) {
+      Desc->bg_block_bitmap_csum_hi = (UINT16)(Checksum >> 16);
+    }
+  }
+
+  Desc->bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
+
+  return Ext4MarkBlockDirty (
+           Partition,
+           EXT4_BLOCK_NR_FROM_HALFS (Partition, Desc->bg_block_bitmap_lo, Desc->bg_block_bitmap_hi),
+           Bitmap
+           );
+}
+
+/**
+   Writes out the block bitmap of a BLOCK_UNINIT block group.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4InitBlockBitmap (
+  IN EXT4_PARTITION  *Partition,
+  IN UINT32          Group
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Bitmap;
+
+  Bitmap = AllocatePool (Partition->BlockSize);
+
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4ReadBlockBitmap (Partition, Group, Bitmap);
+
+  if (!EFI_ERROR (Status)) {
+    Status = Ext4WriteBlockBitmap (Partition, Group, Bitmap);
+  }
+
+  FreePool (Bitmap);
+  return Status;
+}
+
+/**
+   Reads the inode bitmap of a block group. INODE_UNINIT groups don't have one on disk,
+   and have no inodes in use.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+   @param[out]   Bitmap     Pointer to the bitmap, a block long.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4ReadInodeBitmap (
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT32          Group,
+  OUT UINT8           *Bitmap
+  )
+{
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  EXT4_BLOCK_NR          Block;
+
+  Desc  = Ext4GetBlockGroupDesc (Partition, Group);
+  Block = EXT4_BLOCK_NR_FROM_HALFS (Partition, Desc->bg_inode_bitmap_lo, Desc->bg_inode_bitmap_hi);
+
+  if ((Block == 0) || (Block >= Partition->NumberBlocks)) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Block group %u has a bad inode bitmap\n", Group));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (!Ext4HasGroupDescChecksum (Partition) || ((Desc->bg_flags & EXT4_BG_INODE_UNINIT) == 0)) {
+    return Ext4ReadBlocksCached (Partition, Bitmap, 1, Block);
+  }
+
+  ZeroMem (Bitmap, Partition->BlockSize);
+  Ext4SetBitmapRange (Bitmap, Partition->SuperBlock.s_inodes_per_group, MultU64x32 (Partition->BlockSize, 8));
+  return EFI_SUCCESS;
+}
+
+/**
+   Writes the inode bitmap of a block group back, updating its checksum.
+   The block group descriptor (which holds the checksum) needs to be written by the caller.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Group      Block group number.
+   @param[in]    Bitmap     Pointer to the bitmap.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4WriteInodeBitmap (
+  IN EXT4_PARTITION  *Partition,
+  IN UINT32          Group,
+  IN CONST UINT8     *Bitmap
+  )
+{
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT32                 Checksum;
+
+  Desc = Ext4GetBlockGroupDesc (Partition, Group);
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Checksum = Ext4CalculateChecksum (
+                 Partition,
+                 Bitmap,
+                 Partition->SuperBlock.s_inodes_per_group / 8,
+                 Partition->InitialSeed
+                 );
+
+    Desc->bg_inode_bitmap_csum_lo = (UINT16)Checksum;
+
+    if (Partition->DescSize >= OFFSET_OF (EXT4_BLOCK_GROUP_DESC, bg_inode_bitmap_csum_hi) + sizeof (UINT16)) {
+      Desc->bg_inode_bitmap_csum_hi = (UINT16)(Checksum >> 16);
+    }
+  }
+
+  Desc->bg_flags &= ~EXT4_BG_INODE_UNINIT;
+
+  return Ext4MarkBlockDirty (
+           Partition,
+           EXT4_BLOCK_NR_FROM_HALFS (Partition, Desc->bg_inode_bitmap_lo, Desc->bg_inode_bitmap_hi),
+           Bitmap
+           );
+}
+
+/**
+   Checks if a bit of a bitmap is set.
+
+   @param[in]    Bitmap     Pointer to the bitmap.
+   @param[in]    Bit        Bit number.
+
+   @return TRUE if the bit is set.
+**/
+STATIC
+BOOLEAN
+Ext4TestBit (
+  IN CONST UINT8  *Bitmap,
+  IN UINT32       Bit
+  )
+{
+  return (Bitmap[Bit / 8] & (1 << (Bit % 8))) != 0;
+}
+
+/**
+   Finds a run of free blocks in a block bitmap: the run at Goal if the goal block is
+   free, else the first run of at least Wanted blocks, else the longest run.
+
+   @param[in]    Bitmap     Pointer to the block bitmap.
+   @param[in]    Count      Number of blocks in the block group.
+   @param[in]    Goal       Preferred first bit, or MAX_UINT32 if there's none.
+   @param[in]    Wanted     Number of blocks wanted.
+   @param[out]   RunStart   Pointer to where the run's first bit will be stored.
+
+   @return Length of the run, 0 if there are no free blocks.
+**/
+STATIC
+UINT32
+Ext4FindFreeRun (
+  IN  CONST UINT8  *Bitmap,
+  IN  UINT32       Count,
+  IN  UINT32       Goal,
+  IN  UINT32       Wanted,
+  OUT UINT32       *RunStart
+  )
+{
+  UINT32  Bit;
+  UINT32  Start;
+  UINT32  BestStart;
+  UINT32  BestLength;
+
+  if ((Goal < Count) && !Ext4TestBit (Bitmap, Goal)) {
+    for (Bit = Goal; Bit < Count && Bit - Goal < Wanted && !Ext4TestBit (Bitmap, Bit); Bit++) {
+    }
+
+    *RunStart = Goal;
+    return Bit - Goal;
+  }
+
+  BestStart  = 0;
+  BestLength = 0;
+
+  for (Bit = 0; Bit < Count; ) {
+    // Skip whole bytes of used blocks
+    if ((Bit % 8 == 0) && (Bitmap[Bit / 8] == 0xFF)) {
+      Bit += 8;
+      continue;
+    }
+
+    if (Ext4TestBit (Bitmap, Bit)) {
+      Bit++;
+      continue;
+    }
+
+    for (Start = Bit; Bit < Count && Bit - Start < Wanted && !Ext4TestBit (Bitmap, Bit); Bit++) {
+    }
+
+    if (Bit - Start > BestLength) {
+      BestStart  = Start;
+      BestLength = Bit - Start;
+
+      if (BestLength == Wanted) {
+        break;
+      }
+    }
+  }
+
+  *RunStart = BestStart;
+  return BestLength;
+}
+
+/**
+   Allocates a run of contiguous blocks. The run starts at Goal if Goal is free, else
+   at the first free run that is long enough, starting at Goal's block group.
+   The returned run may be shorter than Wanted.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Goal       Preferred first block.
+   @param[in]    Wanted     Number of blocks wanted.
+   @param[out]   Start      Pointer to where the run's first block will be stored.
+   @param[out]   Count      Pointer to where the run's length will be stored.
+
+   @retval EFI_SUCCESS             At least one block was allocated.
+   @retval EFI_VOLUME_FULL         There are no free blocks.
+   @retval !EFI_SUCCESS            Failure.
+**/
+EFI_STATUS
+Ext4AllocateBlocks (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_BLOCK_NR   Goal,
+  IN  UINT32          Wanted,
+  OUT EXT4_BLOCK_NR   *Start,
+  OUT UINT32          *Count
+  )
+{
+  EFI_STATUS             Status;
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT8                  *Bitmap;
+  UINT32                 FirstGroup;
+  UINT32                 Group;
+  UINT32                 Index;
+  UINT32                 GoalBit;
+  UINT32                 GroupBlocks;
+  UINT32                 RunStart;
+  UINT32                 RunLength;
+  EXT4_BLOCK_NR          GroupStart;
+
+  ASSERT (Wanted != 0);
+
+  if ((Goal < Partition->SuperBlock.s_first_data_block) || (Goal >= Partition->NumberBlocks)) {
+    Goal = Partition->SuperBlock.s_first_data_block;
+  }
+
+  FirstGroup = (UINT32)DivU64x32Remainder (
+                         Goal - Partition->SuperBlock.s_first_data_block,
+                         Partition->SuperBlock.s_blocks_per_group,
+                         &GoalBit
+                         );
+
+  Bitmap = AllocatePool (Partition->BlockSize);
+
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_VOLUME_FULL;
+
+  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
+    Group = (UINT32)((FirstGroup + Index) % Partition->NumberBlockGroups);
+    Desc  = Ext4GetBlockGroupDesc (Partition, Group);
+
+    if (Ext4GetGroupCount (Partition, Desc->bg_free_blocks_count_lo, Desc->bg_free_blocks_count_hi) == 0) {
+      continue;
+    }
+
+    Status = Ext4ReadBlockBitmap (Partition, Group, Bitmap);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    GroupStart = Ext4GetGroupFirstBlock (Partition, Group, &GroupBlocks);
+    RunLength  = Ext4FindFreeRun (Bitmap, GroupBlocks, Index == 0 ? GoalBit : MAX_UINT32, Wanted, &RunStart);
+
+    if (RunLength == 0) {
+      DEBUG ((DEBUG_WARN, "[ext4] Block group %u has no free blocks, but says it does\n", Group));
+      Status = EFI_VOLUME_FULL;
+      continue;
+    }
+
+    Ext4SetBitmapRange (Bitmap, RunStart, RunStart + RunLength);
+
+    Status = Ext4WriteBlockBitmap (Partition, Group, Bitmap);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Ext4AddToGroupCount (
+      Partition,
+      &Desc->bg_free_blocks_count_lo,
+      &Desc->bg_free_blocks_count_hi,
+      -(INT32)RunLength
+      );
+
+    Status = Ext4WriteBlockGroupDesc (Partition, Group);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Ext4AddToFreeBlocks (Partition, -(INT64)RunLength);
+
+    *Start = GroupStart + RunStart;
+    *Count = RunLength;
+    break;
+  }
+
+  FreePool (Bitmap);
+  return Status;
+}
+
+/**
+   Frees a run of blocks.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Start      First block of the run.
+   @param[in]    Count      Number of blocks.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4FreeBlocks (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_BLOCK_NR   Start,
+  IN UINT64          Count
+  )
+{
+  EFI_STATUS             Status;
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT8                  *Bitmap;
+  UINT32                 Group;
+  UINT32                 Bit;
+  UINT32                 Length;
+  UINT32                 Freed;
+  UINT32                 Index;
+
+  if ((Start < Partition->SuperBlock.s_first_data_block) || (Start > Partition->NumberBlocks) ||
+      (Count > Partition->NumberBlocks - Start))
+  {
+    DEBUG ((DEBUG_ERROR, "[ext4] Tried to free bad blocks %lu-%lu\n", Start, Start + Count));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Bitmap = AllocatePool (Partition->BlockSize);
+
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_SUCCESS;
+
+  // The run may span several block groups
+  while (Count != 0) {
+    Group = (UINT32)DivU64x32Remainder (
+                      Start - Partition->SuperBlock.s_first_data_block,
+                      Partition->SuperBlock.s_blocks_per_group,
+                      &Bit
+                      );
+    Length = (UINT32)MIN (Count, Partition->SuperBlock.s_blocks_per_group - Bit);
+
+    Status = Ext4ReadBlockBitmap (Partition, Group, Bitmap);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    for (Index = Bit, Freed = 0; Index < Bit + Length; Index++) {
+      if (Ext4TestBit (Bitmap, Index)) {
+        Bitmap[Index / 8] &= (UINT8) ~(1 << (Index % 8));
+        Freed++;
+      }
+    }
+
+    if (Freed != Length) {
+      DEBUG ((DEBUG_WARN, "[ext4] Freed %u blocks of group %u that were already free\n", Length - Freed, Group));
+    }
+
+    Status = Ext4WriteBlockBitmap (Partition, Group, Bitmap);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Desc = Ext4GetBlockGroupDesc (Partition, Group);
+    Ext4AddToGroupCount (Partition, &Desc->bg_free_blocks_count_lo, &Desc->bg_free_blocks_count_hi, (INT32)Freed);
+
+    Status = Ext4WriteBlockGroupDesc (Partition, Group);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Ext4AddToFreeBlocks (Partition, Freed);
+
+    Start += Length;
+    Count -= Length;
+  }
+
+  FreePool (Bitmap);
+  return Status;
+}
+
+/**
+   Allocates an inode, preferably in the same block group as its parent directory.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Parent     Inode number of the parent directory.
+   @param[in]    IsDir      TRUE if the inode will be a directory.
+   @param[out]   InodeNum   Pointer to where the inode number will be stored.
+
+   @retval EFI_SUCCESS             The inode was allocated.
+   @retval EFI_VOLUME_FULL         There are no free inodes.
+   @retval !EFI_SUCCESS            Failure.
+**/
+EFI_STATUS
+Ext4NewInode (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_INO_NR     Parent,
+  IN  BOOLEAN         IsDir,
+  OUT EXT4_INO_NR     *InodeNum
+  )
+{
+  EFI_STATUS             Status;
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT8                  *Bitmap;
+  UINT32                 InodesPerGroup;
+  UINT32                 FirstGroup;
+  UINT32                 Group;
+  UINT32                 Index;
+  UINT32                 Bit;
+  UINT32                 Unused;
+  UINT64                 FirstBit;
+
+  InodesPerGroup = Partition->SuperBlock.s_inodes_per_group;
+  FirstGroup     = (UINT32)MIN ((Parent - 1) / InodesPerGroup, Partition->NumberBlockGroups - 1);
+
+  Bitmap = AllocatePool (Partition->BlockSize);
+
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_VOLUME_FULL;
+
+  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
+    Group = (UINT32)((FirstGroup + Index) % Partition->NumberBlockGroups);
+    Desc  = Ext4GetBlockGroupDesc (Partition, Group);
+
+    if (Ext4GetGroupCount (Partition, Desc->bg_free_inodes_count_lo, Desc->bg_free_inodes_count_hi) == 0) {
+      continue;
+    }
+
+    Status = Ext4ReadInodeBitmap (Partition, Group, Bitmap);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    // Inodes below s_first_ino are reserved
+    FirstBit = MultU64x32 (Group, InodesPerGroup);
+    FirstBit = Partition->SuperBlock.s_first_ino - 1 > FirstBit ? Partition->SuperBlock.s_first_ino - 1 - FirstBit : 0;
+
+    for (Bit = (UINT32)MIN (FirstBit, InodesPerGroup); Bit < InodesPerGroup && Ext4TestBit (Bitmap, Bit); Bit++) {
+    }
+
+    if (Bit == InodesPerGroup) {
+      Status = EFI_VOLUME_FULL;
+      continue;
+    }
+
+    // Like the kernel, make sure a group with inodes in use has a block bitmap
+    if (Ext4HasGroupDescChecksum (Partition) && ((Desc->bg_flags & EXT4_BG_BLOCK_UNINIT) != 0)) {
+      Status = Ext4InitBlockBitmap (Partition, Group);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    Ext4SetBitmapRange (Bitmap, Bit, Bit + 1);
+
+    Status = Ext4WriteInodeBitmap (Partition, Group, Bitmap);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Ext4AddToGroupCount (Partition, &Desc->bg_free_inodes_count_lo, &Desc->bg_free_inodes_count_hi, -1);
+
+    if (IsDir) {
+      Ext4AddToGroupCount (Partition, &Desc->bg_used_dirs_count_lo, &Desc->bg_used_dirs_count_hi, 1);
+    }
+
+    if (Ext4HasGroupDescChecksum (Partition)) {
+      Unused = Ext4GetGroupCount (Partition, Desc->bg_itable_unused_lo, Desc->bg_itable_unused_hi);
+
+      if (Unused > InodesPerGroup - (Bit + 1)) {
+        Ext4AddToGroupCount (
+          Partition,
+          &Desc->bg_itable_unused_lo,
+          &Desc->bg_itable_unused_hi,
+          (INT32)(InodesPerGroup - (Bit + 1)) - (INT32)Unused
+          );
+      }
+    }
+
+    Status = Ext4WriteBlockGroupDesc (Partition, Group);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Partition->SuperBlock.s_free_inodes_count--;
+    Partition->SuperBlockDirty = TRUE;
+
+    *InodeNum = Group * InodesPerGroup + Bit + 1;
+    break;
+  }
+
+  FreePool (Bitmap);
+  return Status;
+}
+
+/**
+   Frees an inode.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    InodeNum   Inode number.
+   @param[in]    IsDir      TRUE if the inode was a directory.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4ReleaseInode (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_INO_NR     InodeNum,
+  IN BOOLEAN         IsDir
+  )
+{
+  EFI_STATUS             Status;
+  EXT4_BLOCK_GROUP_DESC  *Desc;
+  UINT8                  *Bitmap;
+  UINT32                 Group;
+  UINT32                 Bit;
+
+  if (!EXT4_IS_VALID_INODE_NR (Partition, InodeNum)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Group = (InodeNum - 1) / Partition->SuperBlock.s_inodes_per_group;
+  Bit   = (InodeNum - 1) % Partition->SuperBlock.s_inodes_per_group;
+
+  if (Group >= Partition->NumberBlockGroups) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Bitmap = AllocatePool (Partition->BlockSize);
+
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4ReadInodeBitmap (Partition, Group, Bitmap);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  if (!Ext4TestBit (Bitmap, Bit)) {
+    DEBUG ((DEBUG_WARN, "[ext4] Inode %u was already free\n", InodeNum));
+    goto Out;
+  }
+
+  Bitmap[Bit / 8] &= (UINT8) ~(1 << (Bit % 8));
+
+  Status = Ext4WriteInodeBitmap (Partition, Group, Bitmap);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Desc = Ext4GetBlockGroupDesc (Partition, Group);
+  Ext4AddToGroupCount (Partition, &Desc->bg_free_inodes_count_lo, &Desc->bg_free_inodes_count_hi, 1);
+
+  if (IsDir) {
+    Ext4AddToGroupCount (Partition, &Desc->bg_used_dirs_count_lo, &Desc->bg_used_dirs_count_hi, -1);
+  }
+
+  Status = Ext4WriteBlockGroupDesc (Partition, Group);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Partition->SuperBlock.s_free_inodes_count++;
+  Partition->SuperBlockDirty = TRUE;
+
+Out:
+  FreePool (Bitmap);
+  return Status;
+}
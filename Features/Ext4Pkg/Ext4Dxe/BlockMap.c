@@ -115,7 +115,7 @@ Ext4GetBlockPath (
       BlockPath[2]  = LogicalBlock % Entries;
       break;
     case EXT4_TYPE_TREBLY_BLOCK:
-      BlockPath[0]  = EXT4_DIND_BLOCK;
+      BlockPath[0]  = EXT4_TIND_BLOCK;
       LogicalBlock -= MinTreblyBlock;
       BlockPath[1]  = LogicalBlock / EntriesEntries;
       BlockPath[2]  = (LogicalBlock % EntriesEntries) / Entries;
@@ -264,7 +264,7 @@ Ext4GetBlocks (
       return EFI_NO_MAPPING;
     }
 
-    Status = Ext4ReadBlocks (Partition, Buffer, 1, Block);
+    Status = Ext4ReadBlocksCached (Partition, Buffer, 1, Block);
 
     if (EFI_ERROR (Status)) {
       FreePool (Buffer);
@@ -283,3 +283,390 @@ Ext4GetBlocks (
 
   return EFI_SUCCESS;
 }
+
+/**
+   Maps a logical block of an EXT2/3 inode (with a blockmap) to a physical block,
+   allocating the indirect blocks it needs.
+   The inode is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      LogicalBlock  Logical block.
+   @param[in]      PhysicalBlock Physical block.
+
+   @retval EFI_SUCCESS        The block was mapped.
+   @retval EFI_UNSUPPORTED    The logical block is past the largest block map.
+   @retval !EFI_SUCCESS       Failure.
+**/
+EFI_STATUS
+Ext4BlockMapSetBlock (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT2_BLOCK_NR   LogicalBlock,
+  IN EXT2_BLOCK_NR   PhysicalBlock
+  )
+{
+  EXT4_INODE     *Inode;
+  EXT2_BLOCK_NR  BlockPath[EXT4_MAX_BLOCK_PATH];
+  UINTN          BlockPathLength;
+  UINTN          Index;
+  UINT32         *Buffer;
+  UINT32         *Slot;
+  EXT4_BLOCK_NR  Block;
+  EXT4_BLOCK_NR  Container;
+  UINT32         Count;
+  EFI_STATUS     Status;
+
+  Inode = File->Inode;
+
+  BlockPathLength = Ext4GetBlockPath (Partition, LogicalBlock, BlockPath);
+
+  if (BlockPathLength - 1 == EXT4_TYPE_BAD_BLOCK) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Ext4ResetExtentsMap (File);
+
+  if (BlockPathLength == 1) {
+    Inode->i_data[BlockPath[0]] = PhysicalBlock;
+    return EFI_SUCCESS;
+  }
+
+  Buffer = AllocatePool (Partition->BlockSize);
+
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status    = EFI_SUCCESS;
+  Slot      = &Inode->i_data[BlockPath[0]];
+  Container = EXT4_BLOCK_FILE_HOLE;
+
+  // Walk down the path, allocating the missing indirect blocks
+  for (Index = 0; Index < BlockPathLength - 1; Index++) {
+    Block = *Slot;
+
+    if (Block == EXT4_BLOCK_FILE_HOLE) {
+      // Like ext2/3 do, put the indirect block right after the data it precedes
+      Status = Ext4AllocateBlocks (Partition, PhysicalBlock + 1, 1, &Block, &Count);
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+
+      Ext4InodeAddBlocks (Partition, Inode, 1);
+      *Slot = (UINT32)Block;
+
+      if (Container != EXT4_BLOCK_FILE_HOLE) {
+        Status = Ext4MarkBlockDirty (Partition, Container, Buffer);
+
+        if (EFI_ERROR (Status)) {
+          goto Out;
+        }
+      }
+
+      ZeroMem (Buffer, Partition->BlockSize);
+    } else {
+      if (Block >= Partition->NumberBlocks) {
+        Status = EFI_VOLUME_CORRUPTED;
+        goto Out;
+      }
+
+      Status = Ext4ReadBlocksCached (Partition, Buffer, 1, Block);
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+    }
+
+    Container = Block;
+    Slot      = &Buffer[BlockPath[Index + 1]];
+  }
+
+  *Slot  = PhysicalBlock;
+  Status = Ext4MarkBlockDirty (Partition, Container, Buffer);
+
+Out:
+  FreePool (Buffer);
+  return Status;
+}
+
+// Run of blocks being freed by Ext4TruncateBlockMap, so they're freed in as few calls as possible
+typedef struct {
+  EXT4_BLOCK_NR    Start;
+  UINT64           Count;
+} EXT4_BLOCK_MAP_FREE_RUN;
+
+/**
+   Frees the pending run of blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in out]  Run           Pointer to the run.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BlockMapFlushFreeRun (
+  IN     EXT4_PARTITION           *Partition,
+  IN     EXT4_FILE                *File,
+  IN OUT EXT4_BLOCK_MAP_FREE_RUN  *Run
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Run->Count == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = Ext4FreeBlocks (Partition, Run->Start, Run->Count);
+
+  if (!EFI_ERROR (Status)) {
+    Ext4InodeAddBlocks (Partition, File->Inode, -(INT64)Run->Count);
+    Run->Count = 0;
+  }
+
+  return Status;
+}
+
+/**
+   Frees a block, adding it to the pending run if possible.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in out]  Run           Pointer to the run.
+   @param[in]      Block         Block to free.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BlockMapFreeBlock (
+  IN     EXT4_PARTITION           *Partition,
+  IN     EXT4_FILE                *File,
+  IN OUT EXT4_BLOCK_MAP_FREE_RUN  *Run,
+  IN     EXT4_BLOCK_NR            Block
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((Run->Count != 0) && (Run->Start + Run->Count == Block)) {
+    Run->Count++;
+    return EFI_SUCCESS;
+  }
+
+  Status = Ext4BlockMapFlushFreeRun (Partition, File, Run);
+
+  if (!EFI_ERROR (Status)) {
+    Run->Start = Block;
+    Run->Count = 1;
+  }
+
+  return Status;
+}
+
+/**
+   Removes the mappings of an indirect block (and of the blocks it points to) starting at
+   a logical block, and frees the blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in out]  Run           Pointer to the pending run of freed blocks.
+   @param[in]      Block         The indirect block.
+   @param[in]      Level         1 for singly, 2 for doubly and 3 for trebly indirect blocks.
+   @param[in]      FirstBlock    First logical block to unmap, relative to the first block
+                                 mapped by the indirect block.
+   @param[out]     Empty         Pointer to a boolean, set to TRUE if the indirect block no
+                                 longer maps anything (and can be freed).
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4TruncateIndirectBlock (
+  IN     EXT4_PARTITION           *Partition,
+  IN     EXT4_FILE                *File,
+  IN OUT EXT4_BLOCK_MAP_FREE_RUN  *Run,
+  IN     EXT4_BLOCK_NR            Block,
+  IN     UINTN                    Level,
+  IN     UINT64                   FirstBlock,
+  OUT    BOOLEAN                  *Empty
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      *Buffer;
+  UINT32      Entries;
+  UINT32      Index;
+  UINT64      Span;
+  UINTN       Depth;
+  BOOLEAN     ChildEmpty;
+  BOOLEAN     Modified;
+
+  if (Block >= Partition->NumberBlocks) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Entries = Partition->BlockSize / sizeof (UINT32);
+
+  // Number of logical blocks mapped by each entry
+  for (Span = 1, Depth = 1; Depth < Level; Depth++) {
+    Span = MultU64x32 (Span, Entries);
+  }
+
+  Buffer = AllocatePool (Partition->BlockSize);
+
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4ReadBlocksCached (Partition, Buffer, 1, Block);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Modified = FALSE;
+
+  for (Index = (UINT32)DivU64x64Remainder (FirstBlock, Span, NULL); Index < Entries; Index++) {
+    if (Buffer[Index] == EXT4_BLOCK_FILE_HOLE) {
+      continue;
+    }
+
+    if (Level > 1) {
+      Status = Ext4TruncateIndirectBlock (
+                 Partition,
+                 File,
+                 Run,
+                 Buffer[Index],
+                 Level - 1,
+                 FirstBlock > MultU64x32 (Span, Index) ? FirstBlock - MultU64x32 (Span, Index) : 0,
+                 &ChildEmpty
+                 );
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+
+      if (!ChildEmpty) {
+        continue;
+      }
+    }
+
+    Status = Ext4BlockMapFreeBlock (Partition, File, Run, Buffer[Index]);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Buffer[Index] = EXT4_BLOCK_FILE_HOLE;
+    Modified      = TRUE;
+  }
+
+  for (Index = 0, *Empty = TRUE; Index < Entries; Index++) {
+    if (Buffer[Index] != EXT4_BLOCK_FILE_HOLE) {
+      *Empty = FALSE;
+      break;
+    }
+  }
+
+  // Empty indirect blocks get freed, so there's no need to write them
+  if (Modified && !*Empty) {
+    Status = Ext4MarkBlockDirty (Partition, Block, Buffer);
+  }
+
+Out:
+  FreePool (Buffer);
+  return Status;
+}
+
+/**
+   Removes every mapping of an EXT2/3 inode (with a blockmap) starting at a logical block,
+   and frees the blocks, including indirect blocks that become empty.
+   The inode is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      FirstBlock    First logical block to unmap.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4TruncateBlockMap (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT4_BLOCK_NR   FirstBlock
+  )
+{
+  EFI_STATUS               Status;
+  EXT4_INODE               *Inode;
+  EXT4_BLOCK_MAP_FREE_RUN  Run;
+  UINT32                   Entries;
+  UINT64                   LevelStart;
+  UINT64                   LevelSpan;
+  UINTN                    Level;
+  UINTN                    Index;
+  BOOLEAN                  Empty;
+
+  Inode     = File->Inode;
+  Entries   = Partition->BlockSize / sizeof (UINT32);
+  Run.Count = 0;
+  Status    = EFI_SUCCESS;
+
+  for (Index = (UINTN)MIN (FirstBlock, EXT4_DBLOCKS); Index < EXT4_DBLOCKS; Index++) {
+    if (Inode->i_data[Index] != EXT4_BLOCK_FILE_HOLE) {
+      Status = Ext4BlockMapFreeBlock (Partition, File, &Run, Inode->i_data[Index]);
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+
+      Inode->i_data[Index] = EXT4_BLOCK_FILE_HOLE;
+    }
+  }
+
+  // The singly, doubly and trebly indirect blocks map consecutive ranges of logical blocks
+  LevelStart = EXT4_DBLOCKS;
+  LevelSpan  = Entries;
+
+  for (Level = 1; Level <= 3; Level++) {
+    Index = EXT4_IND_BLOCK + Level - 1;
+
+    if ((FirstBlock < LevelStart + LevelSpan) && (Inode->i_data[Index] != EXT4_BLOCK_FILE_HOLE)) {
+      Status = Ext4TruncateIndirectBlock (
+                 Partition,
+                 File,
+                 &Run,
+                 Inode->i_data[Index],
+                 Level,
+                 FirstBlock > LevelStart ? FirstBlock - LevelStart : 0,
+                 &Empty
+                 );
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+
+      if (Empty) {
+        Status = Ext4BlockMapFreeBlock (Partition, File, &Run, Inode->i_data[Index]);
+
+        if (EFI_ERROR (Status)) {
+          goto Out;
+        }
+
+        Inode->i_data[Index] = EXT4_BLOCK_FILE_HOLE;
+      }
+    }
+
+    LevelStart += LevelSpan;
+    LevelSpan   = MultU64x32 (LevelSpan, Entries);
+  }
+
+Out:
+  if (!EFI_ERROR (Status)) {
+    Status = Ext4BlockMapFlushFreeRun (Partition, File, &Run);
+  }
+
+  Ext4ResetExtentsMap (File);
+  return Status;
+}
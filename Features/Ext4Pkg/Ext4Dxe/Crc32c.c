@@ -0,0 +1,79 @@
+/** @file
+  CRC32C calculation for metadata checksums.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  With metadata_csum, every inode, group descriptor, extent block and directory block
+  that is read or written is checksummed, so the CRC32C is calculated with the CPU's
+  CRC32C instructions (SSE4.2 on X64, the CRC32 extension on AArch64) when they are
+  available. Otherwise, BaseLib's table-driven CalculateCrc32c is used.
+**/
+
+#include "Ext4Dxe.h"
+
+STATIC BOOLEAN  mExt4Crc32cAccelerated;
+STATIC BOOLEAN  mExt4Crc32cInitialized;
+
+/**
+   Checks if the CPU can calculate CRC32C checksums, and picks the fastest
+   implementation. It only checks the CPU the first time it's called.
+**/
+VOID
+Ext4InitCrc32c (
+  VOID
+  )
+{
+  if (mExt4Crc32cInitialized) {
+    return;
+  }
+
+  mExt4Crc32cAccelerated = Ext4Crc32cAccelSupported ();
+  mExt4Crc32cInitialized = TRUE;
+
+  DEBUG ((DEBUG_INFO, "[ext4] CRC32C is %a\n", mExt4Crc32cAccelerated ? "accelerated" : "table-driven"));
+}
+
+/**
+   Calculates the CRC32C of a buffer, using the table-driven implementation.
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32cTable (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  )
+{
+  // CalculateCrc32c inverts the CRC before and after
+  return ~CalculateCrc32c (Buffer, Length, ~Crc);
+}
+
+/**
+   Calculates the CRC32C of a buffer, with the fastest implementation
+   available (see Ext4InitCrc32c).
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32c (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  )
+{
+  if (mExt4Crc32cAccelerated) {
+    return Ext4Crc32cAccel (Buffer, Length, Crc);
+  }
+
+  return Ext4Crc32cTable (Buffer, Length, Crc);
+}
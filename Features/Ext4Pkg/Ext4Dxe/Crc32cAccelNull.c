@@ -0,0 +1,48 @@
+/** @file
+  CRC32C calculation for architectures without CRC32C instructions, which always
+  use the table-driven implementation. It's built for every architecture, and is
+  empty on those with their own Crc32cAccel.c.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+#if !defined (MDE_CPU_X64) && !defined (MDE_CPU_AARCH64)
+
+/**
+   Checks if the CPU can calculate CRC32C checksums.
+
+   @retval FALSE   Never, on this architecture.
+**/
+BOOLEAN
+Ext4Crc32cAccelSupported (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+   Calculates the CRC32C of a buffer. Never used on this architecture,
+   since Ext4Crc32cAccelSupported returns FALSE.
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32cAccel (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  )
+{
+  ASSERT (FALSE);
+  return Ext4Crc32cTable (Buffer, Length, Crc);
+}
+
+#endif
@@ -90,619 +90,2382 @@ Ext4ValidDirent (
 }
 
 /**
-   Retrieves a directory entry.
+   Searches a single directory block for an entry with the given name.
 
-   @param[in]      Directory   Pointer to the opened directory.
-   @param[in]      NameUnicode Pointer to the UCS-2 formatted filename.
    @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block.
+   @param[in]      BlockSize   Size of the directory block, usually Partition->BlockSize.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
    @param[out]     Result      Pointer to the destination directory entry.
 
-   @return The result of the operation.
+   @retval EFI_SUCCESS           The entry was found and copied to Result.
+   @retval EFI_NOT_FOUND         No entry in this block matches Name.
+   @retval EFI_VOLUME_CORRUPTED  The directory block is corrupted.
+   @retval !EFI_SUCCESS          Failure.
 **/
+STATIC
 EFI_STATUS
-Ext4RetrieveDirent (
-  IN EXT4_FILE        *Directory,
-  IN CONST CHAR16     *Name,
+Ext4SearchDirentBlock (
   IN EXT4_PARTITION   *Partition,
+  IN CONST CHAR8      *Block,
+  IN UINTN            BlockSize,
+  IN CONST CHAR16     *Name,
   OUT EXT4_DIR_ENTRY  *Result
   )
 {
   EFI_STATUS      Status;
-  CHAR8           *Buf;
-  UINT64          Off;
-  EXT4_INODE      *Inode;
-  UINT64          DirInoSize;
-  UINT32          BlockRemainder;
-  UINTN           Length;
   EXT4_DIR_ENTRY  *Entry;
   UINTN           RemainingBlock;
   CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
   UINTN           ToCopy;
   UINTN           BlockOffset;
 
-  Buf = AllocatePool (Partition->BlockSize);
-
-  if (Buf == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  Off = 0;
-
-  Inode      = Directory->Inode;
-  DirInoSize = EXT4_INODE_SIZE (Inode);
-
-  DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
-  if (BlockRemainder != 0) {
-    // Directory inodes need to have block aligned sizes
-    Status = EFI_VOLUME_CORRUPTED;
-    goto Out;
-  }
-
-  while (Off < DirInoSize) {
-    Length = Partition->BlockSize;
-
-    Status = Ext4Read (Partition, Directory, Buf, Off, &Length);
+  for (BlockOffset = 0; BlockOffset < BlockSize; ) {
+    Entry          = (EXT4_DIR_ENTRY *)(Block + BlockOffset);
+    RemainingBlock = BlockSize - BlockOffset;
+    // Check if the minimum directory entry fits inside [BlockOffset, EndOfBlock]
+    if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
+      return EFI_VOLUME_CORRUPTED;
+    }
 
-    if (Status != EFI_SUCCESS) {
-      goto Out;
+    if (!Ext4ValidDirent (Entry)) {
+      return EFI_VOLUME_CORRUPTED;
     }
 
-    for (BlockOffset = 0; BlockOffset < Partition->BlockSize; ) {
-      Entry          = (EXT4_DIR_ENTRY *)(Buf + BlockOffset);
-      RemainingBlock = Partition->BlockSize - BlockOffset;
-      // Check if the minimum directory entry fits inside [BlockOffset, EndOfBlock]
-      if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    if ((Entry->name_len > RemainingBlock) || (Entry->rec_len > RemainingBlock)) {
+      // Corrupted filesystem
+      return EFI_VOLUME_CORRUPTED;
+    }
 
-      if (!Ext4ValidDirent (Entry)) {
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    // Unused entry
+    if (Entry->inode == 0) {
+      BlockOffset += Entry->rec_len;
+      continue;
+    }
 
-      if ((Entry->name_len > RemainingBlock) || (Entry->rec_len > RemainingBlock)) {
-        // Corrupted filesystem
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    Status = Ext4GetUcs2DirentName (Entry, DirentUcs2Name);
 
-      // Unused entry
-      if (Entry->inode == 0) {
+    /* In theory, this should never fail.
+     * In reality, it's quite possible that it can fail, considering filenames in
+     * Linux (and probably other nixes) are just null-terminated bags of bytes, and don't
+     * need to form valid ASCII/UTF-8 sequences.
+     */
+    if (EFI_ERROR (Status)) {
+      if (Status == EFI_INVALID_PARAMETER) {
+        // If we error out due to a bad UTF-8 sequence (see Ext4GetUcs2DirentName), skip this entry.
+        // I'm not sure if this is correct behaviour, but I don't think there's a precedent here.
         BlockOffset += Entry->rec_len;
         continue;
       }
 
-      Status = Ext4GetUcs2DirentName (Entry, DirentUcs2Name);
-
-      /* In theory, this should never fail.
-       * In reality, it's quite possible that it can fail, considering filenames in
-       * Linux (and probably other nixes) are just null-terminated bags of bytes, and don't
-       * need to form valid ASCII/UTF-8 sequences.
-       */
-      if (EFI_ERROR (Status)) {
-        if (Status == EFI_INVALID_PARAMETER) {
-          // If we error out due to a bad UTF-8 sequence (see Ext4GetUcs2DirentName), skip this entry.
-          // I'm not sure if this is correct behaviour, but I don't think there's a precedent here.
-          BlockOffset += Entry->rec_len;
-          continue;
-        }
-
-        // Other sorts of errors should just error out.
-        FreePool (Buf);
-        return Status;
-      }
-
-      if ((Entry->name_len == StrLen (Name)) &&
-          !Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name))
-      {
-        ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
+      // Other sorts of errors should just error out.
+      return Status;
+    }
 
-        CopyMem (Result, Entry, ToCopy);
-        Status = EFI_SUCCESS;
-        goto Out;
-      }
+    if ((Entry->name_len == StrLen (Name)) &&
+        !Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name))
+    {
+      ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
 
-      BlockOffset += Entry->rec_len;
+      CopyMem (Result, Entry, ToCopy);
+      return EFI_SUCCESS;
     }
 
-    Off += Partition->BlockSize;
+    BlockOffset += Entry->rec_len;
   }
 
-  Status = EFI_NOT_FOUND;
-
-Out:
-  FreePool (Buf);
-  return Status;
+  return EFI_NOT_FOUND;
 }
 
 /**
-   Opens a file using a directory entry.
+   Reads a whole block of a directory.
 
    @param[in]      Partition   Pointer to the ext4 partition.
-   @param[in]      OpenMode    Mode in which the file is supposed to be open.
-   @param[out]     OutFile     Pointer to the newly opened file.
-   @param[in]      Entry       Directory entry to be used.
    @param[in]      Directory   Pointer to the opened directory.
+   @param[out]     Buffer      Pointer to a buffer of Partition->BlockSize bytes.
+   @param[in]      Block       Logical block of the directory to read.
 
-   @retval EFI_STATUS          Result of the operation
+   @return The result of the operation.
 **/
+STATIC
 EFI_STATUS
-Ext4OpenDirent (
+Ext4ReadDirBlock (
   IN  EXT4_PARTITION  *Partition,
-  IN  UINT64          OpenMode,
-  OUT EXT4_FILE       **OutFile,
-  IN  EXT4_DIR_ENTRY  *Entry,
-  IN  EXT4_FILE       *Directory
+  IN  EXT4_FILE       *Directory,
+  OUT VOID            *Buffer,
+  IN  UINT32          Block
   )
 {
   EFI_STATUS  Status;
-  CHAR16      FileName[EXT4_NAME_MAX + 1];
-  EXT4_FILE   *File;
+  UINTN       Length;
 
-  File = AllocateZeroPool (sizeof (EXT4_FILE));
-
-  if (File == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Error;
-  }
+  Length = Partition->BlockSize;
 
-  Status = Ext4GetUcs2DirentName (Entry, FileName);
+  Status = Ext4Read (Partition, Directory, Buffer, MultU64x32 (Block, Partition->BlockSize), &Length);
 
   if (EFI_ERROR (Status)) {
-    goto Error;
+    return Status;
   }
 
-  if (StrCmp (FileName, L".") == 0) {
-    // We're using the parent directory's dentry
-    File->Dentry = Directory->Dentry;
+  // Short reads mean the index points past the end of the directory
+  if (Length != Partition->BlockSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
 
-    ASSERT (File->Dentry != NULL);
+  return EFI_SUCCESS;
+}
 
-    Ext4RefDentry (File->Dentry);
-  } else if (StrCmp (FileName, L"..") == 0) {
-    // Using the parent's parent's dentry
-    File->Dentry = Directory->Dentry->Parent;
+/**
+   Checks if a directory is indexed by a hash tree.
 
-    if (!File->Dentry) {
-      // Someone tried .. on root, so direct them to /
-      // This is an illegal EFI Open() but is possible to hit from a variety of internal code
-      File->Dentry = Directory->Dentry;
-    }
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
 
-    Ext4RefDentry (File->Dentry);
-  } else {
-    File->Dentry = Ext4CreateDentry (FileName, Directory->Dentry);
+   @return TRUE if the directory has a hash tree index, else FALSE.
+**/
+STATIC
+BOOLEAN
+Ext4DirIsIndexed (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN CONST EXT4_FILE       *Directory
+  )
+{
+  return EXT4_HAS_COMPAT (Partition, EXT4_FEATURE_COMPAT_DIR_INDEX) &&
+         (Directory->Inode->i_flags & EXT4_INDEX_FL) != 0;
+}
 
-    if (File->Dentry == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Error;
-    }
-  }
+/**
+   Performs a binary search for the EXT4_DX_ENTRY that covers a hash.
 
-  Status = Ext4InitExtentsMap (File);
+   @param[in]      Entries     Pointer to the dx entry array; the first entry holds the count and limit.
+   @param[in]      Count       Number of valid entries, including the first one.
+   @param[in]      Hash        Hash that will be searched.
 
-  if (EFI_ERROR (Status)) {
-    goto Error;
+   @return Pointer to the last entry whose hash is <= Hash.
+**/
+STATIC
+CONST EXT4_DX_ENTRY *
+Ext4BinsearchDxEntry (
+  IN CONST EXT4_DX_ENTRY  *Entries,
+  IN UINT16               Count,
+  IN UINT32               Hash
+  )
+{
+  CONST EXT4_DX_ENTRY  *l;
+  CONST EXT4_DX_ENTRY  *r;
+  CONST EXT4_DX_ENTRY  *m;
+
+  // The first entry has an implicit hash of 0 (its hash field holds the count/limit), so
+  // we start at the second one.
+  l = Entries + 1;
+  r = Entries + Count - 1;
+
+  while (l <= r) {
+    m = l + (r - l) / 2;
+
+    if (m->hash > Hash) {
+      r = m - 1;
+    } else {
+      l = m + 1;
+    }
   }
 
-  File->InodeNum = Entry->inode;
-
-  Ext4SetupFile (File, Partition);
-
-  Status = Ext4ReadInode (Partition, Entry->inode, &File->Inode);
+  return l - 1;
+}
 
-  if (EFI_ERROR (Status)) {
-    goto Error;
-  }
+// A level of the path from the root of a hash tree index to a leaf
+typedef struct {
+  CHAR8                  *Buffer;
+  CONST EXT4_DX_ENTRY    *Entries;
+  CONST EXT4_DX_ENTRY    *At;
+  UINT16                 Count;
+} EXT4_DX_FRAME;
 
-  *OutFile = File;
+/**
+   Calculates the checksum of a hash tree index node.
 
-  InsertTailList (&Partition->OpenFiles, &File->OpenFilesListNode);
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in]      Block          Pointer to the index node, Partition->BlockSize bytes long.
+   @param[in]      EntriesOffset  Offset of the EXT4_DX_ENTRY array in the node.
 
-  return EFI_SUCCESS;
+   @return The checksum.
+**/
+STATIC
+UINT32
+Ext4CalculateDxNodeChecksum (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN CONST EXT4_FILE       *Directory,
+  IN CONST CHAR8           *Block,
+  IN UINTN                 EntriesOffset
+  )
+{
+  UINT32                     Crc;
+  EXT4_DX_TAIL               DxTail;
+  CONST EXT4_DX_COUNT_LIMIT  *CountLimit;
 
-Error:
-  if (File != NULL) {
-    if (File->Dentry != NULL) {
-      Ext4UnrefDentry (File->Dentry);
-    }
+  // Index nodes have the tail right after the last possible entry
+  CountLimit = (CONST EXT4_DX_COUNT_LIMIT *)(Block + EntriesOffset);
+  CopyMem (&DxTail, Block + EntriesOffset + CountLimit->limit * sizeof (EXT4_DX_ENTRY), sizeof (EXT4_DX_TAIL));
 
-    if (File->ExtentsMap != NULL) {
-      OrderedCollectionUninit (File->ExtentsMap);
-    }
+  // The checksum covers the tail too, with the checksum field itself zeroed
+  DxTail.dt_checksum = 0;
 
-    FreePool (File);
-  }
+  Crc = Ext4CalculateChecksum (Partition, &Directory->InodeNum, sizeof (Directory->InodeNum), Partition->InitialSeed);
+  Crc = Ext4CalculateChecksum (Partition, &Directory->Inode->i_generation, sizeof (Directory->Inode->i_generation), Crc);
+  Crc = Ext4CalculateChecksum (Partition, Block, EntriesOffset + CountLimit->count * sizeof (EXT4_DX_ENTRY), Crc);
+  Crc = Ext4CalculateChecksum (Partition, &DxTail, sizeof (EXT4_DX_TAIL), Crc);
 
-  return Status;
+  return Crc;
 }
 
 /**
-   Opens a file.
+   Checks a hash tree index node: its entry count and, if the filesystem has
+   metadata checksums, its checksum.
 
-   @param[in]      Directory   Pointer to the opened directory.
-   @param[in]      Name        Pointer to the UCS-2 formatted filename.
-   @param[in]      Partition   Pointer to the ext4 partition.
-   @param[in]      OpenMode    Mode in which the file is supposed to be open.
-   @param[out]     OutFile     Pointer to the newly opened file.
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in]      Block          Pointer to the index node, Partition->BlockSize bytes long.
+   @param[in]      EntriesOffset  Offset of the EXT4_DX_ENTRY array in the node.
 
-   @return Result of the operation.
+   @retval EFI_SUCCESS            The index node is valid.
+   @retval EFI_VOLUME_CORRUPTED   The index node is corrupted.
 **/
+STATIC
 EFI_STATUS
-Ext4OpenFile (
-  IN  EXT4_FILE       *Directory,
-  IN  CONST CHAR16    *Name,
-  IN  EXT4_PARTITION  *Partition,
-  IN  UINT64          OpenMode,
-  OUT EXT4_FILE       **OutFile
+Ext4CheckDxNode (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN CONST EXT4_FILE       *Directory,
+  IN CONST CHAR8           *Block,
+  IN UINTN                 EntriesOffset
   )
 {
-  EXT4_DIR_ENTRY  Entry;
-  EFI_STATUS      Status;
+  CONST EXT4_DX_COUNT_LIMIT  *CountLimit;
+  CONST EXT4_DX_TAIL         *DxTail;
+  UINTN                      TailOffset;
 
-  Status = Ext4RetrieveDirent (Directory, Name, Partition, &Entry);
+  CountLimit = (CONST EXT4_DX_COUNT_LIMIT *)(Block + EntriesOffset);
+  TailOffset = EntriesOffset + CountLimit->limit * sizeof (EXT4_DX_ENTRY);
 
-  if (EFI_ERROR (Status)) {
-    return Status;
+  if ((CountLimit->count == 0) || (CountLimit->count > CountLimit->limit) ||
+      (TailOffset > Partition->BlockSize))
+  {
+    return EFI_VOLUME_CORRUPTED;
   }
 
-  // EFI requires us to error out on ".." opens for the root directory
-  if (Entry.inode == Directory->InodeNum) {
-    return EFI_NOT_FOUND;
+  if (!EXT4_HAS_METADATA_CSUM (Partition)) {
+    return EFI_SUCCESS;
   }
 
-  return Ext4OpenDirent (Partition, OpenMode, OutFile, &Entry, Directory);
+  // Like Linux, treat an index node without room for its checksum as corrupted
+  if (TailOffset + sizeof (EXT4_DX_TAIL) > Partition->BlockSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  DxTail = (CONST EXT4_DX_TAIL *)(Block + TailOffset);
+
+  if (DxTail->dt_checksum != Ext4CalculateDxNodeChecksum (Partition, Directory, Block, EntriesOffset)) {
+    DEBUG ((DEBUG_FS, "[ext4] Bad checksum in hash tree index node of inode %u\n", Directory->InodeNum));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  return EFI_SUCCESS;
 }
 
 /**
-  Open the root directory on a volume.
-
-  @param[in]   This A pointer to the volume to open the root directory.
-  @param[out]  Root A pointer to the location to return the opened file handle for the
-                    root directory.
+   Reads and checks an index node of a hash tree, and finds the entry that covers a hash.
 
-  @retval EFI_SUCCESS          The device was opened.
-  @retval EFI_UNSUPPORTED      This volume does not support the requested file system type.
-  @retval EFI_NO_MEDIA         The device has no medium.
-  @retval EFI_DEVICE_ERROR     The device reported an error.
-  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
-  @retval EFI_ACCESS_DENIED    The service denied access to the file.
-  @retval EFI_OUT_OF_RESOURCES The volume was not opened due to lack of resources.
-  @retval EFI_MEDIA_CHANGED    The device has a different medium in it or the medium is no
-                               longer supported. Any existing file handles for this volume are
-                               no longer valid. To access the files on the new medium, the
-                               volume must be reopened with OpenVolume().
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Frame          Level of the path being filled; Frame->Buffer is Partition->BlockSize bytes long.
+   @param[in]      Block          Logical block of the index node, 0 for the root (which is already in Frame->Buffer).
+   @param[in]      Hash           Hash that will be searched.
 
+   @return The result of the operation.
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-Ext4OpenVolume (
-  IN EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *This,
-  OUT EFI_FILE_PROTOCOL               **Root
+Ext4HtreeLoadFrame (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *Directory,
+  IN OUT EXT4_DX_FRAME   *Frame,
+  IN     UINT32          Block,
+  IN     UINT32          Hash
   )
 {
-  EXT4_INODE      *RootInode;
-  EFI_STATUS      Status;
-  EXT4_FILE       *RootDir;
-  EXT4_PARTITION  *Partition;
-
-  Partition = (EXT4_PARTITION *)This;
+  EFI_STATUS  Status;
+  UINTN       EntriesOffset;
 
-  Status = Ext4ReadInode (Partition, EXT4_ROOT_INODE_NR, &RootInode);
+  EntriesOffset = EXT4_DX_ROOT_ENTRIES_OFFSET;
 
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "[ext4] Could not open root inode - error %r\n", Status));
-    return Status;
-  }
+  if (Block != 0) {
+    Status = Ext4ReadDirBlock (Partition, Directory, Frame->Buffer, Block);
 
-  RootDir = AllocateZeroPool (sizeof (EXT4_FILE));
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
 
-  if (RootDir == NULL) {
-    FreePool (RootInode);
-    return EFI_OUT_OF_RESOURCES;
+    EntriesOffset = EXT4_DX_NODE_ENTRIES_OFFSET;
   }
 
-  RootDir->Inode    = RootInode;
-  RootDir->InodeNum = EXT4_ROOT_INODE_NR;
-
-  Status = Ext4InitExtentsMap (RootDir);
+  Status = Ext4CheckDxNode (Partition, Directory, Frame->Buffer, EntriesOffset);
 
   if (EFI_ERROR (Status)) {
-    FreePool (RootInode);
-    FreePool (RootDir);
-    return EFI_OUT_OF_RESOURCES;
+    return Status;
   }
 
-  Ext4SetupFile (RootDir, Partition);
-  *Root = &RootDir->Protocol;
-
-  InsertTailList (&Partition->OpenFiles, &RootDir->OpenFilesListNode);
-
-  ASSERT (Partition->RootDentry != NULL);
-  RootDir->Dentry = Partition->RootDentry;
-
-  Ext4RefDentry (RootDir->Dentry);
+  Frame->Entries = (CONST EXT4_DX_ENTRY *)(Frame->Buffer + EntriesOffset);
+  Frame->Count   = ((CONST EXT4_DX_COUNT_LIMIT *)Frame->Entries)->count;
+  Frame->At      = Ext4BinsearchDxEntry (Frame->Entries, Frame->Count, Hash);
 
   return EFI_SUCCESS;
 }
 
 /**
-   Reads a directory entry.
+   Retrieves a directory entry using the directory's hash tree index.
 
-   @param[in]      Partition   Pointer to the ext4 partition.
-   @param[in]      File        Pointer to the open directory.
+   Note that the hash tree is keyed on the exact on-disk name, so names that only
+   match case-insensitively will not be found in an indexed directory.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         The entry was not found.
+   @retval EFI_UNSUPPORTED       The index is of an unknown format and can't be used.
+   @retval !EFI_SUCCESS          Failure.
+**/
+STATIC
+EFI_STATUS
+Ext4HtreeRetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  )
+{
+  EFI_STATUS               Status;
+  CHAR8                    *Utf8Name;
+  CHAR8                    *Buf;
+  CHAR8                    *LeafBuf;
+  UINT32                   Hash;
+  UINT32                   NumberBlocks;
+  UINT32                   Block;
+  UINT32                   Levels;
+  UINT32                   Level;
+  UINT32                   MaxLevels;
+  CONST EXT4_DX_ROOT_INFO  *RootInfo;
+  EXT4_DX_FRAME            Frames[EXT4_DX_MAX_INDIRECT_LEVELS_LARGE + 1];
+
+  Buf      = NULL;
+  Utf8Name = NULL;
+
+  Status = UCS2StrToUTF8 ((CHAR16 *)Name, &Utf8Name);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (AsciiStrLen (Utf8Name) > EXT4_NAME_MAX) {
+    Status = EFI_NOT_FOUND;
+    goto Out;
+  }
+
+  // One buffer per level of the path, and one for the leaves
+  Buf = AllocatePool ((ARRAY_SIZE (Frames) + 1) * Partition->BlockSize);
+
+  if (Buf == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Out;
+  }
+
+  for (Level = 0; Level < ARRAY_SIZE (Frames); Level++) {
+    Frames[Level].Buffer = Buf + Level * Partition->BlockSize;
+  }
+
+  LeafBuf = Buf + ARRAY_SIZE (Frames) * Partition->BlockSize;
+
+  NumberBlocks = (UINT32)DivU64x32 (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize);
+
+  Status = Ext4ReadDirBlock (Partition, Directory, Frames[0].Buffer, 0);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  RootInfo  = (CONST EXT4_DX_ROOT_INFO *)(Frames[0].Buffer + EXT4_DX_ROOT_INFO_OFFSET);
+  MaxLevels = EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_LARGEDIR) ?
+              EXT4_DX_MAX_INDIRECT_LEVELS_LARGE : EXT4_DX_MAX_INDIRECT_LEVELS;
+
+  if ((RootInfo->reserved_zero != 0) || (RootInfo->info_length != sizeof (EXT4_DX_ROOT_INFO)) ||
+      (RootInfo->indirect_levels > MaxLevels))
+  {
+    DEBUG ((DEBUG_FS, "[ext4] Unknown dx root format, falling back to a linear lookup\n"));
+    Status = EFI_UNSUPPORTED;
+    goto Out;
+  }
+
+  Status = Ext4DirHash (Partition, RootInfo->hash_version, Utf8Name, AsciiStrLen (Utf8Name), &Hash);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Levels = RootInfo->indirect_levels;
+  Level  = 0;
+
+  Status = Ext4HtreeLoadFrame (Partition, Directory, &Frames[0], 0, Hash);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  while (TRUE) {
+    // Walk down to the leaf, keeping the path in Frames so that we can move on to the next leaf
+    while (TRUE) {
+      Block = Frames[Level].At->block & 0x0fffffff;
+
+      if ((Block == 0) || (Block >= NumberBlocks)) {
+        Status = EFI_VOLUME_CORRUPTED;
+        goto Out;
+      }
+
+      if (Level == Levels) {
+        break;
+      }
+
+      Level++;
+
+      Status = Ext4HtreeLoadFrame (Partition, Directory, &Frames[Level], Block, Hash);
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+    }
+
+    Status = Ext4ReadDirBlock (Partition, Directory, LeafBuf, Block);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Status = Ext4SearchDirentBlock (Partition, LeafBuf, Partition->BlockSize, Name, Result);
+
+    if (Status != EFI_NOT_FOUND) {
+      goto Out;
+    }
+
+    // Names whose hashes collide may spill into the next leaf, in which case the next index
+    // entry, which may be in the next index node, has the same hash with the low (collision)
+    // bit set. All the hashes of the nodes below that entry are above ours, so walking down
+    // from it takes the first entry of each node.
+    while (++Frames[Level].At >= Frames[Level].Entries + Frames[Level].Count) {
+      if (Level == 0) {
+        goto Out;
+      }
+
+      Level--;
+    }
+
+    if (((Frames[Level].At->hash & 1) == 0) || ((Frames[Level].At->hash & ~1U) != Hash)) {
+      goto Out;
+    }
+  }
+
+Out:
+  if (Buf != NULL) {
+    FreePool (Buf);
+  }
+
+  FreePool (Utf8Name);
+  return Status;
+}
+
+/**
+   Retrieves a directory entry.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      NameUnicode Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @return The result of the operation.
+**/
+EFI_STATUS
+Ext4RetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       *Buf;
+  UINT64      Off;
+  EXT4_INODE  *Inode;
+  UINT64      DirInoSize;
+  UINT32      BlockRemainder;
+  UINTN       Length;
+
+  Inode      = Directory->Inode;
+  DirInoSize = EXT4_INODE_SIZE (Inode);
+
+  if (EXT4_HAS_INLINE_DATA (Directory)) {
+    Status = Ext4ReadInlineDir (Partition, Directory, &Buf, &Length);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = Ext4SearchDirentBlock (Partition, Buf, Length, Name, Result);
+    FreePool (Buf);
+    return Status;
+  }
+
+  DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
+  if (BlockRemainder != 0) {
+    // Directory inodes need to have block aligned sizes
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  // "." and ".." are only in the first block, which the hash tree doesn't index
+  if (Ext4DirIsIndexed (Partition, Directory) && (StrCmp (Name, L".") != 0) && (StrCmp (Name, L"..") != 0)) {
+    Status = Ext4HtreeRetrieveDirent (Directory, Name, Partition, Result);
+
+    // Only fall back to the linear scan if we can't use the index
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
+
+  Buf = AllocatePool (Partition->BlockSize);
+
+  if (Buf == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Off = 0;
+
+  while (Off < DirInoSize) {
+    Length = Partition->BlockSize;
+
+    Status = Ext4Read (Partition, Directory, Buf, Off, &Length);
+
+    if (Status != EFI_SUCCESS) {
+      goto Out;
+    }
+
+    Status = Ext4SearchDirentBlock (Partition, Buf, Partition->BlockSize, Name, Result);
+
+    if (Status != EFI_NOT_FOUND) {
+      goto Out;
+    }
+
+    Off += Partition->BlockSize;
+  }
+
+  Status = EFI_NOT_FOUND;
+
+Out:
+  FreePool (Buf);
+  return Status;
+}
+
+/**
+   Opens a file using a directory entry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      OpenMode    Mode in which the file is supposed to be open.
+   @param[out]     OutFile     Pointer to the newly opened file.
+   @param[in]      Entry       Directory entry to be used.
+   @param[in]      Directory   Pointer to the opened directory.
+
+   @retval EFI_STATUS          Result of the operation
+**/
+EFI_STATUS
+Ext4OpenDirent (
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT64          OpenMode,
+  OUT EXT4_FILE       **OutFile,
+  IN  EXT4_DIR_ENTRY  *Entry,
+  IN  EXT4_FILE       *Directory
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      FileName[EXT4_NAME_MAX + 1];
+  EXT4_FILE   *File;
+
+  File = AllocateZeroPool (sizeof (EXT4_FILE));
+
+  if (File == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Error;
+  }
+
+  Status = Ext4GetUcs2DirentName (Entry, FileName);
+
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  if (StrCmp (FileName, L".") == 0) {
+    // We're using the parent directory's dentry
+    File->Dentry = Directory->Dentry;
+
+    ASSERT (File->Dentry != NULL);
+
+    Ext4RefDentry (File->Dentry);
+  } else if (StrCmp (FileName, L"..") == 0) {
+    // Using the parent's parent's dentry
+    File->Dentry = Directory->Dentry->Parent;
+
+    if (!File->Dentry) {
+      // Someone tried .. on root, so direct them to /
+      // This is an illegal EFI Open() but is possible to hit from a variety of internal code
+      File->Dentry = Directory->Dentry;
+    }
+
+    Ext4RefDentry (File->Dentry);
+  } else {
+    File->Dentry = Ext4CreateDentry (FileName, Directory->Dentry);
+
+    if (File->Dentry == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Error;
+    }
+
+    File->Dentry->Inode = Entry->inode;
+  }
+
+  Status = Ext4InitExtentsMap (File);
+
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  File->InodeNum = Entry->inode;
+
+  Ext4SetupFile (File, Partition);
+
+  Status = Ext4ReadInode (Partition, Entry->inode, &File->Inode);
+
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  *OutFile = File;
+
+  InsertTailList (&Partition->OpenFiles, &File->OpenFilesListNode);
+
+  return EFI_SUCCESS;
+
+Error:
+  if (File != NULL) {
+    if (File->Dentry != NULL) {
+      Ext4UnrefDentry (File->Dentry);
+    }
+
+    if (File->ExtentsMap != NULL) {
+      OrderedCollectionUninit (File->ExtentsMap);
+    }
+
+    FreePool (File);
+  }
+
+  return Status;
+}
+
+/**
+   Opens a file.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      OpenMode    Mode in which the file is supposed to be open.
+   @param[out]     OutFile     Pointer to the newly opened file.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4OpenFile (
+  IN  EXT4_FILE       *Directory,
+  IN  CONST CHAR16    *Name,
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT64          OpenMode,
+  OUT EXT4_FILE       **OutFile
+  )
+{
+  EXT4_DIR_ENTRY  Entry;
+  EFI_STATUS      Status;
+
+  Status = Ext4RetrieveDirent (Directory, Name, Partition, &Entry);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // EFI requires us to error out on ".." opens for the root directory
+  if (Entry.inode == Directory->InodeNum) {
+    return EFI_NOT_FOUND;
+  }
+
+  return Ext4OpenDirent (Partition, OpenMode, OutFile, &Entry, Directory);
+}
+
+/**
+  Open the root directory on a volume.
+
+  @param[in]   This A pointer to the volume to open the root directory.
+  @param[out]  Root A pointer to the location to return the opened file handle for the
+                    root directory.
+
+  @retval EFI_SUCCESS          The device was opened.
+  @retval EFI_UNSUPPORTED      This volume does not support the requested file system type.
+  @retval EFI_NO_MEDIA         The device has no medium.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_ACCESS_DENIED    The service denied access to the file.
+  @retval EFI_OUT_OF_RESOURCES The volume was not opened due to lack of resources.
+  @retval EFI_MEDIA_CHANGED    The device has a different medium in it or the medium is no
+                               longer supported. Any existing file handles for this volume are
+                               no longer valid. To access the files on the new medium, the
+                               volume must be reopened with OpenVolume().
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4OpenVolume (
+  IN EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL               **Root
+  )
+{
+  EXT4_INODE      *RootInode;
+  EFI_STATUS      Status;
+  EXT4_FILE       *RootDir;
+  EXT4_PARTITION  *Partition;
+
+  Partition = (EXT4_PARTITION *)This;
+
+  Status = Ext4ReadInode (Partition, EXT4_ROOT_INODE_NR, &RootInode);
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Could not open root inode - error %r\n", Status));
+    return Status;
+  }
+
+  RootDir = AllocateZeroPool (sizeof (EXT4_FILE));
+
+  if (RootDir == NULL) {
+    FreePool (RootInode);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  RootDir->Inode    = RootInode;
+  RootDir->InodeNum = EXT4_ROOT_INODE_NR;
+
+  Status = Ext4InitExtentsMap (RootDir);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (RootInode);
+    FreePool (RootDir);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Ext4SetupFile (RootDir, Partition);
+  *Root = &RootDir->Protocol;
+
+  InsertTailList (&Partition->OpenFiles, &RootDir->OpenFilesListNode);
+
+  ASSERT (Partition->RootDentry != NULL);
+  RootDir->Dentry = Partition->RootDentry;
+
+  Ext4RefDentry (RootDir->Dentry);
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Prefetches the inodes referenced by the entries of a directory block, so opening
+   each of them (e.g to fill EFI_FILE_INFO in ReadDir) doesn't need its own disk read.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+**/
+STATIC
+VOID
+Ext4PrefetchDirBlockInodes (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST CHAR8     *Block
+  )
+{
+  CONST EXT4_DIR_ENTRY  *Entry;
+  EXT4_INO_NR           *InodeNums;
+  UINTN                 NumberInodes;
+  UINTN                 BlockOffset;
+  BOOLEAN               IsDotOrDotDot;
+
+  InodeNums = AllocatePool ((Partition->BlockSize / EXT4_MIN_DIR_ENTRY_LEN) * sizeof (EXT4_INO_NR));
+
+  if (InodeNums == NULL) {
+    return;
+  }
+
+  NumberInodes = 0;
+
+  for (BlockOffset = 0; BlockOffset + EXT4_MIN_DIR_ENTRY_LEN <= Partition->BlockSize; ) {
+    Entry = (CONST EXT4_DIR_ENTRY *)(Block + BlockOffset);
+
+    // Stop at anything that looks corrupted, ReadDir will complain about it once it gets there.
+    if (!Ext4ValidDirent (Entry) || (Entry->rec_len > Partition->BlockSize - BlockOffset)) {
+      break;
+    }
+
+    IsDotOrDotDot = Entry->name_len > 0 && Entry->name_len <= 2 &&
+                    CompareMem (Entry->name, "..", Entry->name_len) == 0;
+
+    if ((Entry->inode != 0) && (Entry->name_len != 0) && !IsDotOrDotDot) {
+      InodeNums[NumberInodes++] = Entry->inode;
+    }
+
+    BlockOffset += Entry->rec_len;
+  }
+
+  Ext4PrefetchInodes (Partition, InodeNums, NumberInodes);
+
+  FreePool (InodeNums);
+}
+
+/**
+   Reads a directory entry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      File        Pointer to the open directory.
    @param[out]     Buffer      Pointer to the output buffer.
    @param[in]      Offset      Initial directory position.
    @param[in out] OutLength    Pointer to a UINTN that contains the length of the buffer,
                                and the length of the actual EFI_FILE_INFO after the call.
 
-   @return Result of the operation.
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4ReadDir (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  OUT VOID           *Buffer,
+  IN UINT64          Offset,
+  IN OUT UINTN       *OutLength
+  )
+{
+  EXT4_INODE      *DirIno;
+  EFI_STATUS      Status;
+  UINT64          DirInoSize;
+  UINTN           Len;
+  UINT32          BlockRemainder;
+  UINT32          BlockOffset;
+  UINT64          BlockStart;
+  UINT32          BlockSize;
+  UINTN           RemainingBlock;
+  CHAR8           *Block;
+  EXT4_DIR_ENTRY  Entry;
+  EXT4_FILE       *TempFile;
+  BOOLEAN         ShouldSkip;
+  BOOLEAN         IsDotOrDotDot;
+  CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
+
+  DirIno     = File->Inode;
+  Status     = EFI_SUCCESS;
+  DirInoSize = EXT4_INODE_SIZE (DirIno);
+
+  if (EXT4_HAS_INLINE_DATA (File)) {
+    // Inline directories are small, and are handled as a single block (positions are
+    // offsets in that block).
+    Status = Ext4ReadInlineDir (Partition, File, &Block, &Len);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    BlockSize  = (UINT32)Len;
+    DirInoSize = Len;
+    BlockStart = 0;
+  } else {
+    DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
+    if (BlockRemainder != 0) {
+      // Directory inodes need to have block aligned sizes
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Block = AllocatePool (Partition->BlockSize);
+
+    if (Block == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    BlockSize = Partition->BlockSize;
+    // No block read yet
+    BlockStart = MAX_UINT64;
+  }
+
+  while (TRUE) {
+    TempFile = NULL;
+
+    if (Offset >= DirInoSize) {
+      *OutLength = 0;
+      Status     = EFI_SUCCESS;
+      goto Out;
+    }
+
+    // We read whole directory blocks at a time, since directory entries never cross them.
+    DivU64x32Remainder (Offset, BlockSize, &BlockOffset);
+
+    if (Offset - BlockOffset != BlockStart) {
+      BlockStart = Offset - BlockOffset;
+      Len        = BlockSize;
+      Status     = Ext4Read (Partition, File, Block, BlockStart, &Len);
+
+      if (EFI_ERROR (Status)) {
+        goto Out;
+      }
+
+      if (Len != BlockSize) {
+        Status = EFI_VOLUME_CORRUPTED;
+        goto Out;
+      }
+
+      // Listings enter each block at its start, which is a good time to fetch the inodes of
+      // every entry in it at once, instead of one at a time in Ext4OpenDirent below.
+      if (BlockOffset == 0) {
+        Ext4PrefetchDirBlockInodes (Partition, Block);
+      }
+    }
+
+    RemainingBlock = BlockSize - BlockOffset;
+
+    if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Out;
+    }
+
+    // Note that we don't need to copy any padding that may exist after the entry.
+    CopyMem (&Entry, Block + BlockOffset, MIN (RemainingBlock, sizeof (Entry)));
+
+    // Invalid directory entry length
+    if (!Ext4ValidDirent (&Entry)) {
+      DEBUG ((DEBUG_ERROR, "[ext4] Invalid dirent at offset %lu\n", Offset));
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Out;
+    }
+
+    // Check if the entire dir entry fits in the block
+    if (Entry.rec_len > RemainingBlock) {
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Out;
+    }
+
+    // We don't care about passing . or .. entries to the caller of ReadDir(),
+    // since they're generally useless entries *and* may break things if too
+    // many callers assume FAT32.
+
+    // Entry.name_len may be 0 if it's a nameless entry, like an unused entry
+    // or a checksum at the end of the directory block.
+    // memcmp (and CompareMem) return 0 when the passed length is 0.
+
+    // We must bound name_len as > 0 and <= 2 to avoid any out-of-bounds accesses or bad detection of
+    // "." and "..".
+    IsDotOrDotDot = Entry.name_len > 0 && Entry.name_len <= 2 &&
+                    CompareMem (Entry.name, "..", Entry.name_len) == 0;
+
+    // When inode = 0, it's unused. When name_len == 0, it's a nameless entry
+    // (which we should not expose to ReadDir).
+    ShouldSkip = Entry.inode == 0 || Entry.name_len == 0 || IsDotOrDotDot;
+
+    if (ShouldSkip) {
+      Offset += Entry.rec_len;
+      continue;
+    }
+
+    // Test if the dirent is valid utf-8. This is already done inside Ext4OpenDirent but EFI_INVALID_PARAMETER
+    // has the danger of its meaning being overloaded in many places, so we can't skip according to that.
+    // So test outside of it, explicitly.
+    Status = Ext4GetUcs2DirentName (&Entry, DirentUcs2Name);
+
+    if (EFI_ERROR (Status)) {
+      if (Status == EFI_INVALID_PARAMETER) {
+        // Bad UTF-8, skip.
+        Offset += Entry.rec_len;
+        continue;
+      }
+
+      goto Out;
+    }
+
+    Status = Ext4OpenDirent (Partition, EFI_FILE_MODE_READ, &TempFile, &Entry, File);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Status = Ext4GetFileInfo (TempFile, Buffer, OutLength);
+    if (!EFI_ERROR (Status)) {
+      File->Position = Offset + Entry.rec_len;
+    }
+
+    Ext4CloseInternal (TempFile);
+
+    goto Out;
+  }
+
+  Status = EFI_SUCCESS;
+Out:
+  FreePool (Block);
+  return Status;
+}
+
+/**
+   Removes a dentry from the other's list.
+
+   @param[in out]            Parent       Pointer to the parent EXT4_DENTRY.
+   @param[in out]            ToBeRemoved  Pointer to the child EXT4_DENTRY.
+**/
+STATIC
+VOID
+Ext4RemoveDentry (
+  IN OUT EXT4_DENTRY  *Parent,
+  IN OUT EXT4_DENTRY  *ToBeRemoved
+  )
+{
+  ASSERT (IsNodeInList (&ToBeRemoved->ListNode, &Parent->Children));
+  RemoveEntryList (&ToBeRemoved->ListNode);
+}
+
+/**
+   Adds a dentry to the other's list.
+
+   The dentry that is added to the other one's list gets ->Parent set to Parent,
+   and the parent gets its reference count incremented.
+
+   @param[in out]            Parent       Pointer to the parent EXT4_DENTRY.
+   @param[in out]            ToBeAdded    Pointer to the child EXT4_DENTRY.
+**/
+STATIC
+VOID
+Ext4AddDentry (
+  IN OUT EXT4_DENTRY  *Parent,
+  IN OUT EXT4_DENTRY  *ToBeAdded
+  )
+{
+  ToBeAdded->Parent = Parent;
+  InsertTailList (&Parent->Children, &ToBeAdded->ListNode);
+  Ext4RefDentry (Parent);
+}
+
+/**
+   Creates a new dentry object.
+
+   @param[in]              Name        Name of the dentry.
+   @param[in out opt]      Parent      Parent dentry, if it's not NULL.
+
+   @return The new allocated and initialised dentry.
+           The ref count will be set to 1.
+**/
+EXT4_DENTRY *
+Ext4CreateDentry (
+  IN CONST CHAR16     *Name,
+  IN OUT EXT4_DENTRY  *Parent  OPTIONAL
+  )
+{
+  EXT4_DENTRY  *Dentry;
+  EFI_STATUS   Status;
+
+  Dentry = AllocateZeroPool (sizeof (EXT4_DENTRY));
+
+  if (Dentry == NULL) {
+    return NULL;
+  }
+
+  Dentry->RefCount = 1;
+
+  // This StrCpyS should not fail.
+  Status = StrCpyS (Dentry->Name, ARRAY_SIZE (Dentry->Name), Name);
+
+  ASSERT_EFI_ERROR (Status);
+
+  InitializeListHead (&Dentry->Children);
+
+  if (Parent != NULL) {
+    Ext4AddDentry (Parent, Dentry);
+  }
+
+  DEBUG ((DEBUG_FS, "[ext4] Created dentry %s\n", Name));
+
+  return Dentry;
+}
+
+/**
+   Increments the ref count of the dentry.
+
+   @param[in out]            Dentry    Pointer to a valid EXT4_DENTRY.
+**/
+VOID
+Ext4RefDentry (
+  IN OUT EXT4_DENTRY  *Dentry
+  )
+{
+  UINTN  OldRef;
+
+  OldRef = Dentry->RefCount;
+
+  Dentry->RefCount++;
+
+  // I'm not sure if this (Refcount overflow) is a valid concern,
+  // but it's better to be safe than sorry.
+  ASSERT (OldRef < Dentry->RefCount);
+}
+
+/**
+   Deletes the dentry.
+
+   @param[in out]            Dentry    Pointer to a valid EXT4_DENTRY.
+**/
+STATIC
+VOID
+Ext4DeleteDentry (
+  IN OUT EXT4_DENTRY  *Dentry
+  )
+{
+  if (Dentry->Parent) {
+    Ext4RemoveDentry (Dentry->Parent, Dentry);
+    Ext4UnrefDentry (Dentry->Parent);
+  }
+
+  DEBUG ((DEBUG_FS, "[ext4] Deleted dentry %s\n", Dentry->Name));
+  FreePool (Dentry);
+}
+
+/**
+   Decrements the ref count of the dentry.
+   If the ref count is 0, it's destroyed.
+
+   @param[in out]            Dentry    Pointer to a valid EXT4_DENTRY.
+
+   @retval True if it was destroyed, false if it's alive.
+**/
+BOOLEAN
+Ext4UnrefDentry (
+  IN OUT EXT4_DENTRY  *Dentry
+  )
+{
+  Dentry->RefCount--;
+
+  if (Dentry->RefCount == 0) {
+    Ext4DeleteDentry (Dentry);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+// Entry of a directory block being split, see Ext4HtreeAddDirent
+typedef struct {
+  UINT32                  Hash;
+  CONST EXT4_DIR_ENTRY    *Entry;
+} EXT4_DIR_MAP_ENTRY;
+
+/**
+   Checks if a directory block ends with a checksum tail (EXT4_DIR_ENTRY_TAIL).
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+
+   @return TRUE if the block has a checksum tail.
+**/
+STATIC
+BOOLEAN
+Ext4DirBlockHasTail (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN CONST CHAR8           *Block
+  )
+{
+  CONST EXT4_DIR_ENTRY_TAIL  *Tail;
+
+  if (!EXT4_HAS_METADATA_CSUM (Partition)) {
+    return FALSE;
+  }
+
+  Tail = (CONST EXT4_DIR_ENTRY_TAIL *)(Block + Partition->BlockSize - sizeof (EXT4_DIR_ENTRY_TAIL));
+
+  return Tail->det_reserved_zero1 == 0 && Tail->det_rec_len == sizeof (EXT4_DIR_ENTRY_TAIL) &&
+         Tail->det_reserved_zero2 == 0 && Tail->det_reserved_ft == EXT4_DIR_ENTRY_TAIL_FT;
+}
+
+/**
+   Gets the size of the part of a directory block that holds directory entries.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+
+   @return Size of the block without its checksum tail, if any.
+**/
+STATIC
+UINTN
+Ext4DirBlockEntriesSize (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN CONST CHAR8           *Block
+  )
+{
+  return Ext4DirBlockHasTail (Partition, Block) ?
+         Partition->BlockSize - sizeof (EXT4_DIR_ENTRY_TAIL) : Partition->BlockSize;
+}
+
+/**
+   Initialises an empty directory block: an unused entry that spans the whole block, and
+   a checksum tail if the filesystem has metadata checksums.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Block       Pointer to the directory block, Partition->BlockSize bytes long.
+**/
+STATIC
+VOID
+Ext4InitDirBlock (
+  IN  CONST EXT4_PARTITION  *Partition,
+  OUT CHAR8                 *Block
+  )
+{
+  EXT4_DIR_ENTRY_TAIL  *Tail;
+  EXT4_DIR_ENTRY       *Entry;
+
+  ZeroMem (Block, Partition->BlockSize);
+
+  Entry          = (EXT4_DIR_ENTRY *)Block;
+  Entry->rec_len = (UINT16)Partition->BlockSize;
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Entry->rec_len -= sizeof (EXT4_DIR_ENTRY_TAIL);
+
+    Tail                  = (EXT4_DIR_ENTRY_TAIL *)(Block + Entry->rec_len);
+    Tail->det_rec_len     = sizeof (EXT4_DIR_ENTRY_TAIL);
+    Tail->det_reserved_ft = EXT4_DIR_ENTRY_TAIL_FT;
+  }
+}
+
+/**
+   Updates the checksum of a directory block, if the filesystem has metadata checksums.
+
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Block          Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      EntriesOffset  Offset of the EXT4_DX_ENTRY array for hash tree index nodes,
+                                  0 for blocks of directory entries.
+
+   @retval EFI_SUCCESS            The checksum was updated.
+   @retval EFI_VOLUME_CORRUPTED   The index node has no room for its checksum.
+**/
+STATIC
+EFI_STATUS
+Ext4UpdateDirBlockChecksum (
+  IN     CONST EXT4_PARTITION  *Partition,
+  IN     CONST EXT4_FILE       *Directory,
+  IN OUT CHAR8                 *Block,
+  IN     UINTN                 EntriesOffset
+  )
+{
+  UINT32                     Crc;
+  EXT4_DIR_ENTRY_TAIL        *Tail;
+  EXT4_DX_TAIL               *DxTail;
+  CONST EXT4_DX_COUNT_LIMIT  *CountLimit;
+  UINTN                      TailOffset;
+
+  if (!EXT4_HAS_METADATA_CSUM (Partition)) {
+    return EFI_SUCCESS;
+  }
+
+  if (EntriesOffset == 0) {
+    // Blocks without a tail have no checksum (e2fsck adds them back)
+    if (Ext4DirBlockHasTail (Partition, Block)) {
+      Crc                = Ext4CalculateChecksum (Partition, &Directory->InodeNum, sizeof (Directory->InodeNum), Partition->InitialSeed);
+      Crc                = Ext4CalculateChecksum (Partition, &Directory->Inode->i_generation, sizeof (Directory->Inode->i_generation), Crc);
+      Tail               = (EXT4_DIR_ENTRY_TAIL *)(Block + Partition->BlockSize - sizeof (EXT4_DIR_ENTRY_TAIL));
+      Tail->det_checksum = Ext4CalculateChecksum (Partition, Block, Partition->BlockSize - sizeof (EXT4_DIR_ENTRY_TAIL), Crc);
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  // Index nodes have the tail right after the last possible entry
+  CountLimit = (CONST EXT4_DX_COUNT_LIMIT *)(Block + EntriesOffset);
+  TailOffset = EntriesOffset + CountLimit->limit * sizeof (EXT4_DX_ENTRY);
+
+  if (TailOffset + sizeof (EXT4_DX_TAIL) > Partition->BlockSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  DxTail              = (EXT4_DX_TAIL *)(Block + TailOffset);
+  DxTail->dt_checksum = Ext4CalculateDxNodeChecksum (Partition, Directory, Block, EntriesOffset);
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Writes back a (modified) block of a directory, updating its checksum.
+   Directory blocks are metadata, so they're kept dirty in memory (see Writeback.c).
+
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Block          Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      LogicalBlock   Logical block of the directory.
+   @param[in]      EntriesOffset  Offset of the EXT4_DX_ENTRY array for hash tree index nodes,
+                                  0 for blocks of directory entries.
+
+   @return Status of the write.
+**/
+STATIC
+EFI_STATUS
+Ext4WriteDirBlock (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *Directory,
+  IN OUT CHAR8           *Block,
+  IN     UINT32          LogicalBlock,
+  IN     UINTN           EntriesOffset
+  )
+{
+  EXT4_EXTENT  Extent;
+  EFI_STATUS   Status;
+
+  Status = Ext4UpdateDirBlockChecksum (Partition, Directory, Block, EntriesOffset);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Ext4GetExtent (Partition, Directory, LogicalBlock, &Extent);
+
+  if ((Status == EFI_NO_MAPPING) || (!EFI_ERROR (Status) && EXT4_EXTENT_IS_UNINITIALIZED (&Extent))) {
+    // We've just read this block, so it can't be a hole
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return Ext4MarkBlockDirty (
+           Partition,
+           LShiftU64 (Extent.ee_start_hi, 32) + Extent.ee_start_lo + (LogicalBlock - Extent.ee_block),
+           Block
+           );
+}
+
+/**
+   Appends a block to a directory, updating its checksum.
+
+   @param[in]      Partition      Pointer to the ext4 partition.
+   @param[in]      Directory      Pointer to the opened directory.
+   @param[in out]  Block          Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[out]     LogicalBlock   Pointer to where the logical block of the new block will be stored.
+
+   @return Status of the write.
+**/
+STATIC
+EFI_STATUS
+Ext4AppendDirBlock (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *Directory,
+  IN OUT CHAR8           *Block,
+  OUT    UINT32          *LogicalBlock
+  )
+{
+  UINT64      Size;
+  UINTN       Length;
+  EFI_STATUS  Status;
+
+  Size = EXT4_INODE_SIZE (Directory->Inode);
+
+  if (DivU64x32 (Size, Partition->BlockSize) >= 0x0fffffff) {
+    // Hash tree indexes only have 28 bits for block numbers
+    return EFI_VOLUME_FULL;
+  }
+
+  Ext4UpdateDirBlockChecksum (Partition, Directory, Block, 0);
+
+  Length = Partition->BlockSize;
+  Status = Ext4Write (Partition, Directory, Block, Size, &Length);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  *LogicalBlock = (UINT32)DivU64x32 (Size, Partition->BlockSize);
+  return EFI_SUCCESS;
+}
+
+/**
+   Inserts an entry in a block of directory entries, if there's room for it.
+
+   @param[in out]  Block       Pointer to the directory block.
+   @param[in]      BlockSize   Size of the part of the block that holds entries.
+   @param[in]      Entry       Pointer to the new entry. Its rec_len is ignored.
+
+   @retval EFI_SUCCESS           The entry was inserted.
+   @retval EFI_VOLUME_FULL       There's no room for the entry.
+   @retval EFI_VOLUME_CORRUPTED  The directory block is corrupted.
+**/
+STATIC
+EFI_STATUS
+Ext4InsertDirentInBlock (
+  IN OUT CHAR8                 *Block,
+  IN     UINTN                 BlockSize,
+  IN     CONST EXT4_DIR_ENTRY  *Entry
+  )
+{
+  EXT4_DIR_ENTRY  *Current;
+  EXT4_DIR_ENTRY  *New;
+  UINTN           BlockOffset;
+  UINTN           Needed;
+  UINTN           Used;
+  UINT16          RecLen;
+
+  Needed = EXT4_DIR_ENTRY_LEN (Entry->name_len);
+
+  for (BlockOffset = 0; BlockOffset < BlockSize; BlockOffset += Current->rec_len) {
+    Current = (EXT4_DIR_ENTRY *)(Block + BlockOffset);
+
+    if ((BlockSize - BlockOffset < EXT4_MIN_DIR_ENTRY_LEN) || !Ext4ValidDirent (Current) ||
+        (Current->rec_len > BlockSize - BlockOffset))
+    {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    // Unused entries can be reused as a whole, used ones may have room after their name
+    Used = Current->inode == 0 ? 0 : EXT4_DIR_ENTRY_LEN (Current->name_len);
+
+    if (Current->rec_len - Used < Needed) {
+      continue;
+    }
+
+    RecLen = (UINT16)(Current->rec_len - Used);
+    New    = (EXT4_DIR_ENTRY *)((CHAR8 *)Current + Used);
+
+    if (Used != 0) {
+      Current->rec_len = (UINT16)Used;
+    }
+
+    CopyMem (New, Entry, EXT4_MIN_DIR_ENTRY_LEN + Entry->name_len);
+    New->rec_len = RecLen;
+
+    return EFI_SUCCESS;
+  }
+
+  return EFI_VOLUME_FULL;
+}
+
+/**
+   Adds an entry to a directory without a hash tree index, in the first block
+   with room for it, or in a new block at the end of the directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Entry       Pointer to the new entry.
+
+   @return Status of the operation.
 **/
+STATIC
 EFI_STATUS
-Ext4ReadDir (
-  IN EXT4_PARTITION  *Partition,
-  IN EXT4_FILE       *File,
-  OUT VOID           *Buffer,
-  IN UINT64          Offset,
-  IN OUT UINTN       *OutLength
+Ext4LinearAddDirent (
+  IN EXT4_PARTITION        *Partition,
+  IN EXT4_FILE             *Directory,
+  IN CONST EXT4_DIR_ENTRY  *Entry
   )
 {
-  EXT4_INODE      *DirIno;
-  EFI_STATUS      Status;
-  UINT64          DirInoSize;
-  UINTN           Len;
-  UINT32          BlockRemainder;
-  EXT4_DIR_ENTRY  Entry;
-  EXT4_FILE       *TempFile;
-  BOOLEAN         ShouldSkip;
-  BOOLEAN         IsDotOrDotDot;
-  CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
+  CHAR8       *Block;
+  UINT32      NumberBlocks;
+  UINT32      LogicalBlock;
+  EFI_STATUS  Status;
 
-  DirIno     = File->Inode;
-  Status     = EFI_SUCCESS;
-  DirInoSize = EXT4_INODE_SIZE (DirIno);
+  Block = AllocatePool (Partition->BlockSize);
 
-  DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
-  if (BlockRemainder != 0) {
-    // Directory inodes need to have block aligned sizes
-    return EFI_VOLUME_CORRUPTED;
+  if (Block == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  while (TRUE) {
-    TempFile = NULL;
+  NumberBlocks = (UINT32)DivU64x32 (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize);
 
-    // We (try to) read the maximum size of a directory entry at a time
-    // Note that we don't need to read any padding that may exist after it.
-    Len    = sizeof (Entry);
-    Status = Ext4Read (Partition, File, &Entry, Offset, &Len);
+  for (LogicalBlock = 0; LogicalBlock < NumberBlocks; LogicalBlock++) {
+    Status = Ext4ReadDirBlock (Partition, Directory, Block, LogicalBlock);
 
     if (EFI_ERROR (Status)) {
       goto Out;
     }
 
-    if (Len == 0) {
-      *OutLength = 0;
-      Status     = EFI_SUCCESS;
+    Status = Ext4InsertDirentInBlock (Block, Ext4DirBlockEntriesSize (Partition, Block), Entry);
+
+    if (Status == EFI_SUCCESS) {
+      Status = Ext4WriteDirBlock (Partition, Directory, Block, LogicalBlock, 0);
       goto Out;
     }
 
-    if (Len < EXT4_MIN_DIR_ENTRY_LEN) {
-      Status = EFI_VOLUME_CORRUPTED;
+    if (Status != EFI_VOLUME_FULL) {
       goto Out;
     }
+  }
 
-    // Invalid directory entry length
-    if (!Ext4ValidDirent (&Entry)) {
-      DEBUG ((DEBUG_ERROR, "[ext4] Invalid dirent at offset %lu\n", Offset));
-      Status = EFI_VOLUME_CORRUPTED;
+  // Every block is full, start a new one
+  Ext4InitDirBlock (Partition, Block);
+  Ext4InsertDirentInBlock (Block, Ext4DirBlockEntriesSize (Partition, Block), Entry);
+
+  Status = Ext4AppendDirBlock (Partition, Directory, Block, &LogicalBlock);
+
+Out:
+  FreePool (Block);
+  return Status;
+}
+
+/**
+   Fills a block of directory entries with the given entries, packed together.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Block       Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      Map         Pointer to the entries.
+   @param[in]      Count       Number of entries. They must fit in the block.
+**/
+STATIC
+VOID
+Ext4FillDirBlock (
+  IN  CONST EXT4_PARTITION      *Partition,
+  OUT CHAR8                     *Block,
+  IN  CONST EXT4_DIR_MAP_ENTRY  *Map,
+  IN  UINTN                     Count
+  )
+{
+  EXT4_DIR_ENTRY  *Entry;
+  UINTN           BlockSize;
+  UINTN           BlockOffset;
+  UINTN           Index;
+
+  Ext4InitDirBlock (Partition, Block);
+
+  BlockSize   = Ext4DirBlockEntriesSize (Partition, Block);
+  BlockOffset = 0;
+  Entry       = NULL;
+
+  for (Index = 0; Index < Count; Index++) {
+    Entry = (EXT4_DIR_ENTRY *)(Block + BlockOffset);
+
+    CopyMem (Entry, Map[Index].Entry, EXT4_MIN_DIR_ENTRY_LEN + Map[Index].Entry->name_len);
+    Entry->rec_len = (UINT16)EXT4_DIR_ENTRY_LEN (Entry->name_len);
+    BlockOffset   += Entry->rec_len;
+  }
+
+  // The last entry spans the rest of the block
+  if (Entry != NULL) {
+    Entry->rec_len += (UINT16)(BlockSize - BlockOffset);
+  }
+}
+
+/**
+   Adds an entry to a directory with a hash tree index, in the leaf its hash belongs to.
+   If the leaf is full, it's split in two, as long as its index node has room for the new leaf.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Entry       Pointer to the new entry.
+
+   @retval EFI_SUCCESS        The entry was added.
+   @retval EFI_UNSUPPORTED    The index is of an unknown format, or the index node that
+                              should point to a new leaf is full.
+   @retval !EFI_SUCCESS       Failure.
+**/
+STATIC
+EFI_STATUS
+Ext4HtreeAddDirent (
+  IN EXT4_PARTITION        *Partition,
+  IN EXT4_FILE             *Directory,
+  IN CONST EXT4_DIR_ENTRY  *Entry
+  )
+{
+  EFI_STATUS               Status;
+  CHAR8                    *NodeBuf;
+  CHAR8                    *LeafBuf;
+  CHAR8                    *OldLeafBuf;
+  CHAR8                    *NewLeafBuf;
+  EXT4_DIR_MAP_ENTRY       *Map;
+  EXT4_DIR_MAP_ENTRY       Temp;
+  CONST EXT4_DIR_ENTRY     *Current;
+  UINT32                   Hash;
+  UINT32                   SplitHash;
+  UINT32                   NumberBlocks;
+  UINT32                   NodeBlock;
+  UINT32                   LeafBlock;
+  UINT32                   NewLeafBlock;
+  UINT32                   Levels;
+  UINT32                   MaxLevels;
+  UINTN                    EntriesOffset;
+  UINTN                    BlockSize;
+  UINTN                    BlockOffset;
+  UINTN                    Count;
+  UINTN                    Index;
+  UINTN                    Split;
+  UINTN                    TotalSize;
+  UINTN                    HalfSize;
+  CONST EXT4_DX_ROOT_INFO  *RootInfo;
+  EXT4_DX_ENTRY            *Entries;
+  EXT4_DX_ENTRY            *At;
+  EXT4_DX_COUNT_LIMIT      *CountLimit;
+  UINT8                    HashVersion;
+
+  Map     = NULL;
+  NodeBuf = AllocatePool (4 * Partition->BlockSize);
+
+  if (NodeBuf == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  LeafBuf    = NodeBuf + Partition->BlockSize;
+  OldLeafBuf = LeafBuf + Partition->BlockSize;
+  NewLeafBuf = OldLeafBuf + Partition->BlockSize;
+
+  NumberBlocks = (UINT32)DivU64x32 (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize);
+
+  Status = Ext4ReadDirBlock (Partition, Directory, NodeBuf, 0);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  RootInfo  = (CONST EXT4_DX_ROOT_INFO *)(NodeBuf + EXT4_DX_ROOT_INFO_OFFSET);
+  MaxLevels = EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_LARGEDIR) ?
+              EXT4_DX_MAX_INDIRECT_LEVELS_LARGE : EXT4_DX_MAX_INDIRECT_LEVELS;
+
+  if ((RootInfo->reserved_zero != 0) || (RootInfo->info_length != sizeof (EXT4_DX_ROOT_INFO)) ||
+      (RootInfo->indirect_levels > MaxLevels))
+  {
+    DEBUG ((DEBUG_ERROR, "[ext4] Unknown dx root format, can't add entries\n"));
+    Status = EFI_UNSUPPORTED;
+    goto Out;
+  }
+
+  HashVersion = RootInfo->hash_version;
+
+  Status = Ext4DirHash (Partition, HashVersion, Entry->name, Entry->name_len, &Hash);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  // Find the leaf, keeping the index node that points to it in NodeBuf
+  Levels        = RootInfo->indirect_levels;
+  NodeBlock     = 0;
+  EntriesOffset = EXT4_DX_ROOT_ENTRIES_OFFSET;
+
+  while (TRUE) {
+    Status = Ext4CheckDxNode (Partition, Directory, NodeBuf, EntriesOffset);
+
+    if (EFI_ERROR (Status)) {
       goto Out;
     }
 
-    // Check if the entire dir entry length fits in Len
-    if (Len < (UINTN)(EXT4_MIN_DIR_ENTRY_LEN + Entry.name_len)) {
+    Entries    = (EXT4_DX_ENTRY *)(NodeBuf + EntriesOffset);
+    CountLimit = (EXT4_DX_COUNT_LIMIT *)Entries;
+
+    At        = (EXT4_DX_ENTRY *)Ext4BinsearchDxEntry (Entries, CountLimit->count, Hash);
+    LeafBlock = At->block & 0x0fffffff;
+
+    if ((LeafBlock == 0) || (LeafBlock >= NumberBlocks)) {
       Status = EFI_VOLUME_CORRUPTED;
       goto Out;
     }
 
-    // We don't care about passing . or .. entries to the caller of ReadDir(),
-    // since they're generally useless entries *and* may break things if too
-    // many callers assume FAT32.
+    if (Levels == 0) {
+      break;
+    }
 
-    // Entry.name_len may be 0 if it's a nameless entry, like an unused entry
-    // or a checksum at the end of the directory block.
-    // memcmp (and CompareMem) return 0 when the passed length is 0.
+    Levels--;
+    NodeBlock = LeafBlock;
 
-    // We must bound name_len as > 0 and <= 2 to avoid any out-of-bounds accesses or bad detection of
-    // "." and "..".
-    IsDotOrDotDot = Entry.name_len > 0 && Entry.name_len <= 2 &&
-                    CompareMem (Entry.name, "..", Entry.name_len) == 0;
+    Status = Ext4ReadDirBlock (Partition, Directory, NodeBuf, NodeBlock);
 
-    // When inode = 0, it's unused. When name_len == 0, it's a nameless entry
-    // (which we should not expose to ReadDir).
-    ShouldSkip = Entry.inode == 0 || Entry.name_len == 0 || IsDotOrDotDot;
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
 
-    if (ShouldSkip) {
-      Offset += Entry.rec_len;
+    EntriesOffset = EXT4_DX_NODE_ENTRIES_OFFSET;
+  }
+
+  Status = Ext4ReadDirBlock (Partition, Directory, LeafBuf, LeafBlock);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  BlockSize = Ext4DirBlockEntriesSize (Partition, LeafBuf);
+  Status    = Ext4InsertDirentInBlock (LeafBuf, BlockSize, Entry);
+
+  if (Status == EFI_SUCCESS) {
+    Status = Ext4WriteDirBlock (Partition, Directory, LeafBuf, LeafBlock, 0);
+    goto Out;
+  }
+
+  if (Status != EFI_VOLUME_FULL) {
+    goto Out;
+  }
+
+  // The leaf is full, so it needs to be split in two, which needs room for a new index entry.
+  // Note: Growing the index (splitting index nodes, or adding a level) isn't supported.
+  if (CountLimit->count == CountLimit->limit) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Hash tree index node %u is full\n", NodeBlock));
+    Status = EFI_UNSUPPORTED;
+    goto Out;
+  }
+
+  // Gather the leaf's entries, and the new one, sorted by hash
+  CopyMem (OldLeafBuf, LeafBuf, Partition->BlockSize);
+
+  Map = AllocatePool ((BlockSize / EXT4_MIN_DIR_ENTRY_LEN + 1) * sizeof (EXT4_DIR_MAP_ENTRY));
+
+  if (Map == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Out;
+  }
+
+  Count     = 0;
+  TotalSize = 0;
+
+  for (BlockOffset = 0; BlockOffset < BlockSize; BlockOffset += Current->rec_len) {
+    Current = (CONST EXT4_DIR_ENTRY *)(OldLeafBuf + BlockOffset);
+
+    // Ext4InsertDirentInBlock checked the block already
+    if (Current->inode == 0) {
       continue;
     }
 
-    // Test if the dirent is valid utf-8. This is already done inside Ext4OpenDirent but EFI_INVALID_PARAMETER
-    // has the danger of its meaning being overloaded in many places, so we can't skip according to that.
-    // So test outside of it, explicitly.
-    Status = Ext4GetUcs2DirentName (&Entry, DirentUcs2Name);
+    Map[Count].Entry = Current;
+    Status           = Ext4DirHash (Partition, HashVersion, Current->name, Current->name_len, &Map[Count].Hash);
 
     if (EFI_ERROR (Status)) {
-      if (Status == EFI_INVALID_PARAMETER) {
-        // Bad UTF-8, skip.
-        Offset += Entry.rec_len;
-        continue;
-      }
-
       goto Out;
     }
 
-    Status = Ext4OpenDirent (Partition, EFI_FILE_MODE_READ, &TempFile, &Entry, File);
+    TotalSize += EXT4_DIR_ENTRY_LEN (Current->name_len);
+    Count++;
+  }
+
+  Map[Count].Entry = Entry;
+  Map[Count].Hash  = Hash;
+  TotalSize       += EXT4_DIR_ENTRY_LEN (Entry->name_len);
+  Count++;
+
+  for (Index = 1; Index < Count; Index++) {
+    Temp = Map[Index];
+
+    for (Split = Index; Split > 0 && Map[Split - 1].Hash > Temp.Hash; Split--) {
+      Map[Split] = Map[Split - 1];
+    }
+
+    Map[Split] = Temp;
+  }
+
+  // Split the entries in two halves of about the same size
+  HalfSize = 0;
+
+  for (Split = 0; Split < Count - 1 && HalfSize < TotalSize / 2; Split++) {
+    HalfSize += EXT4_DIR_ENTRY_LEN (Map[Split].Entry->name_len);
+  }
+
+  if (Split == 0) {
+    Split = 1;
+  }
+
+  // If the hashes on both sides of the split are the same, the new index entry gets the
+  // collision bit set, so lookups continue into the new leaf.
+  SplitHash = Map[Split].Hash;
+
+  if (Map[Split - 1].Hash == SplitHash) {
+    SplitHash |= 1;
+  }
+
+  Ext4FillDirBlock (Partition, NewLeafBuf, Map + Split, Count - Split);
+
+  Status = Ext4AppendDirBlock (Partition, Directory, NewLeafBuf, &NewLeafBlock);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Ext4FillDirBlock (Partition, LeafBuf, Map, Split);
+
+  Status = Ext4WriteDirBlock (Partition, Directory, LeafBuf, LeafBlock, 0);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  // Point the index at the new leaf
+  CopyMem (At + 2, At + 1, (Entries + CountLimit->count - (At + 1)) * sizeof (EXT4_DX_ENTRY));
+
+  (At + 1)->hash  = SplitHash;
+  (At + 1)->block = NewLeafBlock;
+  CountLimit->count++;
+
+  Status = Ext4WriteDirBlock (Partition, Directory, NodeBuf, NodeBlock, EntriesOffset);
+
+Out:
+  if (Map != NULL) {
+    FreePool (Map);
+  }
+
+  FreePool (NodeBuf);
+  return Status;
+}
+
+/**
+   Adds an entry to a directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      InodeNum    Inode number of the entry.
+   @param[in]      FileType    File type of the entry, EXT4_FT_*.
+
+   @retval EFI_SUCCESS            The entry was added.
+   @retval EFI_INVALID_PARAMETER  The name isn't a valid ext4 filename.
+   @retval !EFI_SUCCESS           Failure.
+**/
+EFI_STATUS
+Ext4AddDirent (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *Directory,
+  IN CONST CHAR16    *Name,
+  IN EXT4_INO_NR     InodeNum,
+  IN UINT8           FileType
+  )
+{
+  EXT4_DIR_ENTRY  Entry;
+  CHAR8           *Utf8Name;
+  UINTN           Length;
+  EFI_STATUS      Status;
+
+  if (EXT4_HAS_INLINE_DATA (Directory)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if ((StrCmp (Name, L".") == 0) || (StrCmp (Name, L"..") == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = UCS2StrToUTF8 ((CHAR16 *)Name, &Utf8Name);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Length = AsciiStrLen (Utf8Name);
+
+  // '/' is the path separator in every other ext4 implementation
+  if ((Length == 0) || (Length > EXT4_NAME_MAX) || (ScanMem8 (Utf8Name, Length, '/') != NULL)) {
+    FreePool (Utf8Name);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&Entry, sizeof (Entry));
+  Entry.inode    = InodeNum;
+  Entry.name_len = (UINT8)Length;
+  CopyMem (Entry.name, Utf8Name, Length);
+  FreePool (Utf8Name);
+
+  if (EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_FILETYPE)) {
+    Entry.file_type = FileType;
+  }
+
+  if (Ext4DirIsIndexed (Partition, Directory)) {
+    Status = Ext4HtreeAddDirent (Partition, Directory, &Entry);
+  } else {
+    Status = Ext4LinearAddDirent (Partition, Directory, &Entry);
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Ext4SetInodeTimes (Directory->Inode, EXT4_INODE_MTIME | EXT4_INODE_CTIME, NULL);
+  return Ext4WriteInode (Partition, Directory);
+}
+
+/**
+   Removes an entry from a directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename. It's compared case-insensitively.
+   @param[in]      InodeNum    Inode number of the entry.
+
+   @retval EFI_SUCCESS            The entry was removed.
+   @retval EFI_NOT_FOUND          There's no such entry.
+   @retval !EFI_SUCCESS           Failure.
+**/
+EFI_STATUS
+Ext4RemoveDirent (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *Directory,
+  IN CONST CHAR16    *Name,
+  IN EXT4_INO_NR     InodeNum
+  )
+{
+  CHAR8           *Block;
+  EXT4_DIR_ENTRY  *Entry;
+  EXT4_DIR_ENTRY  *Previous;
+  CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
+  UINT32          NumberBlocks;
+  UINT32          LogicalBlock;
+  UINTN           BlockSize;
+  UINTN           BlockOffset;
+  EFI_STATUS      Status;
+
+  if (EXT4_HAS_INLINE_DATA (Directory)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Block = AllocatePool (Partition->BlockSize);
+
+  if (Block == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NumberBlocks = (UINT32)DivU64x32 (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize);
+
+  for (LogicalBlock = 0; LogicalBlock < NumberBlocks; LogicalBlock++) {
+    Status = Ext4ReadDirBlock (Partition, Directory, Block, LogicalBlock);
 
     if (EFI_ERROR (Status)) {
       goto Out;
     }
 
-    Status = Ext4GetFileInfo (TempFile, Buffer, OutLength);
-    if (!EFI_ERROR (Status)) {
-      File->Position = Offset + Entry.rec_len;
-    }
+    BlockSize = Ext4DirBlockEntriesSize (Partition, Block);
+    Previous  = NULL;
 
-    Ext4CloseInternal (TempFile);
+    for (BlockOffset = 0; BlockOffset < BlockSize; BlockOffset += Entry->rec_len) {
+      Entry = (EXT4_DIR_ENTRY *)(Block + BlockOffset);
 
-    goto Out;
+      if ((BlockSize - BlockOffset < EXT4_MIN_DIR_ENTRY_LEN) || !Ext4ValidDirent (Entry) ||
+          (Entry->rec_len > BlockSize - BlockOffset))
+      {
+        Status = EFI_VOLUME_CORRUPTED;
+        goto Out;
+      }
+
+      if ((Entry->inode == InodeNum) &&
+          !EFI_ERROR (Ext4GetUcs2DirentName (Entry, DirentUcs2Name)) &&
+          (Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name) == 0))
+      {
+        // Merge the entry into the previous one, or mark it unused if it's the first one
+        if (Previous != NULL) {
+          Previous->rec_len += Entry->rec_len;
+        } else {
+          Entry->inode = 0;
+        }
+
+        Status = Ext4WriteDirBlock (Partition, Directory, Block, LogicalBlock, 0);
+
+        if (!EFI_ERROR (Status)) {
+          Ext4SetInodeTimes (Directory->Inode, EXT4_INODE_MTIME | EXT4_INODE_CTIME, NULL);
+          Status = Ext4WriteInode (Partition, Directory);
+        }
+
+        goto Out;
+      }
+
+      Previous = Entry;
+    }
   }
 
-  Status = EFI_SUCCESS;
+  Status = EFI_NOT_FOUND;
+
 Out:
+  FreePool (Block);
   return Status;
 }
 
 /**
-   Removes a dentry from the other's list.
+   Checks if a block of directory entries has entries other than "." and "..".
 
-   @param[in out]            Parent       Pointer to the parent EXT4_DENTRY.
-   @param[in out]            ToBeRemoved  Pointer to the child EXT4_DENTRY.
+   @param[in]      Block       Pointer to the directory block.
+   @param[in]      BlockSize   Size of the directory block.
+   @param[out]     Empty       Pointer to where the result will be stored.
+
+   @retval EFI_SUCCESS           The block was checked.
+   @retval EFI_VOLUME_CORRUPTED  The directory block is corrupted.
 **/
 STATIC
-VOID
-Ext4RemoveDentry (
-  IN OUT EXT4_DENTRY  *Parent,
-  IN OUT EXT4_DENTRY  *ToBeRemoved
+EFI_STATUS
+Ext4DirBlockIsEmpty (
+  IN  CONST CHAR8  *Block,
+  IN  UINTN        BlockSize,
+  OUT BOOLEAN      *Empty
   )
 {
-  ASSERT (IsNodeInList (&ToBeRemoved->ListNode, &Parent->Children));
-  RemoveEntryList (&ToBeRemoved->ListNode);
-}
+  CONST EXT4_DIR_ENTRY  *Entry;
+  UINTN                 BlockOffset;
+  BOOLEAN               IsDotOrDotDot;
 
-/**
-   Adds a dentry to the other's list.
+  *Empty = TRUE;
 
-   The dentry that is added to the other one's list gets ->Parent set to Parent,
-   and the parent gets its reference count incremented.
+  for (BlockOffset = 0; BlockOffset + EXT4_MIN_DIR_ENTRY_LEN <= BlockSize; BlockOffset += Entry->rec_len) {
+    Entry = (CONST EXT4_DIR_ENTRY *)(Block + BlockOffset);
 
-   @param[in out]            Parent       Pointer to the parent EXT4_DENTRY.
-   @param[in out]            ToBeAdded    Pointer to the child EXT4_DENTRY.
-**/
-STATIC
-VOID
-Ext4AddDentry (
-  IN OUT EXT4_DENTRY  *Parent,
-  IN OUT EXT4_DENTRY  *ToBeAdded
-  )
-{
-  ToBeAdded->Parent = Parent;
-  InsertTailList (&Parent->Children, &ToBeAdded->ListNode);
-  Ext4RefDentry (Parent);
+    if (!Ext4ValidDirent (Entry) || (Entry->rec_len > BlockSize - BlockOffset)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    IsDotOrDotDot = Entry->name_len > 0 && Entry->name_len <= 2 &&
+                    CompareMem (Entry->name, "..", Entry->name_len) == 0;
+
+    if ((Entry->inode != 0) && (Entry->name_len != 0) && !IsDotOrDotDot) {
+      *Empty = FALSE;
+      break;
+    }
+  }
+
+  return EFI_SUCCESS;
 }
 
 /**
-   Creates a new dentry object.
+   Checks if a directory is empty, that is, if it only has the "." and ".." entries.
 
-   @param[in]              Name        Name of the dentry.
-   @param[in out opt]      Parent      Parent dentry, if it's not NULL.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[out]     Empty       Pointer to where the result will be stored.
 
-   @return The new allocated and initialised dentry.
-           The ref count will be set to 1.
+   @return Status of the operation.
 **/
-EXT4_DENTRY *
-Ext4CreateDentry (
-  IN CONST CHAR16     *Name,
-  IN OUT EXT4_DENTRY  *Parent  OPTIONAL
+EFI_STATUS
+Ext4DirIsEmpty (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  OUT BOOLEAN         *Empty
   )
 {
-  EXT4_DENTRY  *Dentry;
-  EFI_STATUS   Status;
+  CHAR8       *Block;
+  UINTN       Length;
+  UINT32      NumberBlocks;
+  UINT32      LogicalBlock;
+  EFI_STATUS  Status;
 
-  Dentry = AllocateZeroPool (sizeof (EXT4_DENTRY));
+  if (EXT4_HAS_INLINE_DATA (Directory)) {
+    Status = Ext4ReadInlineDir (Partition, Directory, &Block, &Length);
 
-  if (Dentry == NULL) {
-    return NULL;
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = Ext4DirBlockIsEmpty (Block, Length, Empty);
+    FreePool (Block);
+    return Status;
   }
 
-  Dentry->RefCount = 1;
+  Block = AllocatePool (Partition->BlockSize);
 
-  // This StrCpyS should not fail.
-  Status = StrCpyS (Dentry->Name, ARRAY_SIZE (Dentry->Name), Name);
+  if (Block == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  ASSERT_EFI_ERROR (Status);
+  NumberBlocks = (UINT32)DivU64x32 (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize);
+  Status       = EFI_SUCCESS;
+  *Empty       = TRUE;
 
-  InitializeListHead (&Dentry->Children);
+  for (LogicalBlock = 0; LogicalBlock < NumberBlocks && *Empty; LogicalBlock++) {
+    Status = Ext4ReadDirBlock (Partition, Directory, Block, LogicalBlock);
 
-  if (Parent != NULL) {
-    Ext4AddDentry (Parent, Dentry);
-  }
+    if (EFI_ERROR (Status)) {
+      break;
+    }
 
-  DEBUG ((DEBUG_FS, "[ext4] Created dentry %s\n", Name));
+    Status = Ext4DirBlockIsEmpty (Block, Partition->BlockSize, Empty);
 
-  return Dentry;
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  FreePool (Block);
+  return Status;
 }
 
 /**
-   Increments the ref count of the dentry.
+   Opens the directory a file was opened from.
 
-   @param[in out]            Dentry    Pointer to a valid EXT4_DENTRY.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      File        Pointer to the opened file.
+   @param[out]     OutFile     Pointer to where the opened directory will be stored.
+
+   @retval EFI_SUCCESS            The directory was opened.
+   @retval EFI_ACCESS_DENIED      The file is the root directory.
+   @retval !EFI_SUCCESS           Failure.
 **/
-VOID
-Ext4RefDentry (
-  IN OUT EXT4_DENTRY  *Dentry
+EFI_STATUS
+Ext4OpenParentDirectory (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *File,
+  OUT EXT4_FILE       **OutFile
   )
 {
-  UINTN  OldRef;
+  EXT4_FILE   *Directory;
+  EFI_STATUS  Status;
 
-  OldRef = Dentry->RefCount;
+  if ((File->Dentry->Parent == NULL) || (File->InodeNum == EXT4_ROOT_INODE_NR)) {
+    return EFI_ACCESS_DENIED;
+  }
 
-  Dentry->RefCount++;
+  Directory = AllocateZeroPool (sizeof (EXT4_FILE));
 
-  // I'm not sure if this (Refcount overflow) is a valid concern,
-  // but it's better to be safe than sorry.
-  ASSERT (OldRef < Dentry->RefCount);
+  if (Directory == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4InitExtentsMap (Directory);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Directory);
+    return Status;
+  }
+
+  Directory->InodeNum = File->Dentry->Parent->Inode;
+  Ext4SetupFile (Directory, Partition);
+
+  Status = Ext4ReadInode (Partition, Directory->InodeNum, &Directory->Inode);
+
+  if (EFI_ERROR (Status)) {
+    Ext4FreeExtentsMap (Directory);
+    FreePool (Directory);
+    return Status;
+  }
+
+  Directory->Dentry = File->Dentry->Parent;
+  Ext4RefDentry (Directory->Dentry);
+
+  InsertTailList (&Partition->OpenFiles, &Directory->OpenFilesListNode);
+
+  *OutFile = Directory;
+  return EFI_SUCCESS;
 }
 
 /**
-   Deletes the dentry.
+   Adds a link to a directory's link count, for a new subdirectory.
+   With the dir_nlink feature, directories with too many subdirectories have a link count of 1.
 
-   @param[in out]            Dentry    Pointer to a valid EXT4_DENTRY.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in out]  Inode       Pointer to the directory's inode.
+
+   @retval EFI_SUCCESS        The link count was updated.
+   @retval EFI_VOLUME_FULL    The directory has too many subdirectories.
 **/
 STATIC
-VOID
-Ext4DeleteDentry (
-  IN OUT EXT4_DENTRY  *Dentry
+EFI_STATUS
+Ext4DirAddLink (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT EXT4_INODE      *Inode
   )
 {
-  if (Dentry->Parent) {
-    Ext4RemoveDentry (Dentry->Parent, Dentry);
-    Ext4UnrefDentry (Dentry->Parent);
+  if (Inode->i_links == 1) {
+    return EFI_SUCCESS;
   }
 
-  DEBUG ((DEBUG_FS, "[ext4] Deleted dentry %s\n", Dentry->Name));
-  FreePool (Dentry);
+  if (Inode->i_links + 1 >= EXT4_LINK_MAX) {
+    if (!EXT4_HAS_RO_COMPAT (Partition, EXT4_FEATURE_RO_COMPAT_DIR_NLINK)) {
+      return EFI_VOLUME_FULL;
+    }
+
+    Inode->i_links = 1;
+    return EFI_SUCCESS;
+  }
+
+  Inode->i_links++;
+  return EFI_SUCCESS;
 }
 
 /**
-   Decrements the ref count of the dentry.
-   If the ref count is 0, it's destroyed.
+   Creates a file or a directory, and adds it to a directory.
 
-   @param[in out]            Dentry    Pointer to a valid EXT4_DENTRY.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Attributes  Attributes of the new file, EFI_FILE_*.
+   @param[out]     OutFile     Pointer to where the new opened file will be stored.
 
-   @retval True if it was destroyed, false if it's alive.
+   @return Status of the operation.
 **/
-BOOLEAN
-Ext4UnrefDentry (
-  IN OUT EXT4_DENTRY  *Dentry
+EFI_STATUS
+Ext4CreateFile (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  IN  CONST CHAR16    *Name,
+  IN  UINT64          Attributes,
+  OUT EXT4_FILE       **OutFile
   )
 {
-  Dentry->RefCount--;
+  EXT4_FILE           *File;
+  EXT4_INODE          *Inode;
+  EXT4_EXTENT_HEADER  *ExtHeader;
+  EXT4_INO_NR         InodeNum;
+  EXT4_DIR_ENTRY      *Entry;
+  CHAR8               *Block;
+  UINT32              LogicalBlock;
+  BOOLEAN             IsDir;
+  BOOLEAN             Linked;
+  EFI_STATUS          Status;
+
+  IsDir  = (Attributes & EFI_FILE_DIRECTORY) != 0;
+  Block  = NULL;
+  Linked = FALSE;
+
+  if (EXT4_HAS_INLINE_DATA (Directory)) {
+    return EFI_UNSUPPORTED;
+  }
 
-  if (Dentry->RefCount == 0) {
-    Ext4DeleteDentry (Dentry);
-    return TRUE;
+  File = AllocateZeroPool (sizeof (EXT4_FILE));
+
+  if (File == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  return FALSE;
+  File->Inode = Ext4AllocateInode (Partition);
+
+  if (File->Inode == NULL) {
+    FreePool (File);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4InitExtentsMap (File);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (File->Inode);
+    FreePool (File);
+    return Status;
+  }
+
+  File->Dentry = Ext4CreateDentry (Name, Directory->Dentry);
+
+  if (File->Dentry == NULL) {
+    Ext4FreeExtentsMap (File);
+    FreePool (File->Inode);
+    FreePool (File);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Ext4SetupFile (File, Partition);
+  InsertTailList (&Partition->OpenFiles, &File->OpenFilesListNode);
+
+  Status = Ext4NewInode (Partition, Directory->InodeNum, IsDir, &InodeNum);
+
+  if (EFI_ERROR (Status)) {
+    Ext4CloseInternal (File);
+    return Status;
+  }
+
+  File->InodeNum       = InodeNum;
+  File->Dentry->Inode  = InodeNum;
+  Inode                = File->Inode;
+  Inode->i_mode        = IsDir ? EXT4_INO_TYPE_DIR | 0755 : EXT4_INO_TYPE_REGFILE | 0644;
+  Inode->i_links       = IsDir ? 2 : 1;
+  Inode->i_extra_isize = Partition->InodeSize > EXT4_GOOD_OLD_INODE_SIZE ?
+                          (UINT16)MIN (Partition->InodeSize, sizeof (EXT4_INODE)) - EXT4_GOOD_OLD_INODE_SIZE : 0;
+
+  if ((Attributes & EFI_FILE_READ_ONLY) != 0) {
+    Inode->i_mode &= ~0222;
+  }
+
+  if (EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_EXTENTS)) {
+    Inode->i_flags     |= EXT4_EXTENTS_FL;
+    ExtHeader           = (EXT4_EXTENT_HEADER *)Inode->i_data;
+    ExtHeader->eh_magic = EXT4_EXTENT_HEADER_MAGIC;
+    ExtHeader->eh_max   = (sizeof (Inode->i_data) - sizeof (EXT4_EXTENT_HEADER)) / sizeof (EXT4_EXTENT);
+  }
+
+  Ext4SetInodeTimes (Inode, EXT4_INODE_ATIME | EXT4_INODE_CTIME | EXT4_INODE_MTIME | EXT4_INODE_CRTIME, NULL);
+
+  if (IsDir) {
+    // The first block holds "." and ".."
+    Block = AllocatePool (Partition->BlockSize);
+
+    if (Block == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Error;
+    }
+
+    Ext4InitDirBlock (Partition, Block);
+
+    Entry            = (EXT4_DIR_ENTRY *)Block;
+    Entry->inode     = InodeNum;
+    Entry->name_len  = 1;
+    Entry->name[0]   = '.';
+    Entry->rec_len  -= EXT4_DIR_ENTRY_LEN (1);
+
+    CopyMem (Block + EXT4_DIR_ENTRY_LEN (1), Entry, EXT4_MIN_DIR_ENTRY_LEN);
+    Entry->rec_len = EXT4_DIR_ENTRY_LEN (1);
+
+    Entry           = (EXT4_DIR_ENTRY *)(Block + EXT4_DIR_ENTRY_LEN (1));
+    Entry->inode    = Directory->InodeNum;
+    Entry->name_len = 2;
+    Entry->name[0]  = '.';
+    Entry->name[1]  = '.';
+
+    if (EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_FILETYPE)) {
+      ((EXT4_DIR_ENTRY *)Block)->file_type = EXT4_FT_DIR;
+      Entry->file_type                     = EXT4_FT_DIR;
+    }
+
+    // This writes the inode as well
+    Status = Ext4AppendDirBlock (Partition, File, Block, &LogicalBlock);
+  } else {
+    Status = Ext4WriteInode (Partition, File);
+  }
+
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  if (IsDir) {
+    Status = Ext4DirAddLink (Partition, Directory->Inode);
+
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+
+    Linked = TRUE;
+  }
+
+  // This writes the directory's inode back, with the new link count
+  Status = Ext4AddDirent (Partition, Directory, Name, InodeNum, IsDir ? EXT4_FT_DIR : EXT4_FT_REG_FILE);
+
+  if (EFI_ERROR (Status)) {
+    goto Error;
+  }
+
+  if (Block != NULL) {
+    FreePool (Block);
+  }
+
+  *OutFile = File;
+  return EFI_SUCCESS;
+
+Error:
+  // Undo everything, so the inode and its blocks aren't leaked
+  if (Linked && (Directory->Inode->i_links > 2)) {
+    Directory->Inode->i_links--;
+    Ext4WriteInode (Partition, Directory);
+  }
+
+  Ext4TruncateFile (Partition, File, 0);
+
+  Inode->i_links = 0;
+  Ext4SetInodeTimes (Inode, EXT4_INODE_CTIME, NULL);
+  Inode->i_dtime = Inode->i_ctime;
+  Ext4WriteInode (Partition, File);
+  Ext4ReleaseInode (Partition, InodeNum, IsDir);
+
+  if (Block != NULL) {
+    FreePool (Block);
+  }
+
+  Ext4CloseInternal (File);
+  return Status;
 }
@@ -8,6 +8,7 @@
 
 /**
    Reads from the partition's disk using the DISK_IO protocol.
+   Blocks replayed from the journal take precedence over the ones on disk.
 
    @param[in]  Partition      Pointer to the opened ext4 partition.
    @param[out] Buffer         Pointer to a destination buffer.
@@ -24,13 +25,138 @@ Ext4ReadDiskIo (
   IN UINT64          Offset
   )
 {
-  return EXT4_DISK_IO (Partition)->ReadDisk (
-                                     EXT4_DISK_IO (Partition),
-                                     EXT4_MEDIA_ID (Partition),
-                                     Offset,
-                                     Length,
-                                     Buffer
-                                     );
+  EFI_STATUS  Status;
+
+  Status = EXT4_DISK_IO (Partition)->ReadDisk (
+                                       EXT4_DISK_IO (Partition),
+                                       EXT4_MEDIA_ID (Partition),
+                                       Offset,
+                                       Length,
+                                       Buffer
+                                       );
+
+  if (!EFI_ERROR (Status) && (Partition->JournalOverlay != NULL)) {
+    Ext4JournalApplyOverlay (Partition, Buffer, Length, Offset);
+  }
+
+  // Metadata that hasn't been written back yet is newer than anything on the disk
+  if (!EFI_ERROR (Status) && (Partition->DirtyBlocks != NULL)) {
+    Ext4ApplyDirtyBlocks (Partition, Buffer, Length, Offset);
+  }
+
+  return Status;
+}
+
+/**
+   Writes to the partition's disk using the DISK_IO protocol.
+   The in-memory copies of the written range are updated, see Ext4UpdateCachedCopies.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  Buffer         Pointer to a source buffer.
+   @param[in]  Length         Length of the source buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to write.
+
+   @return Success status of the disk write.
+**/
+EFI_STATUS
+Ext4WriteDiskIo (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Partition->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  Status = EXT4_DISK_IO (Partition)->WriteDisk (
+                                       EXT4_DISK_IO (Partition),
+                                       EXT4_MEDIA_ID (Partition),
+                                       Offset,
+                                       Length,
+                                       (VOID *)Buffer
+                                       );
+
+  if (!EFI_ERROR (Status)) {
+    Ext4UpdateCachedCopies (Partition, Buffer, Length, Offset);
+  }
+
+  return Status;
+}
+
+/**
+   Copies the part of a range of the disk that overlaps an in-memory copy of the disk into it.
+
+   @param[out]     Copy          Pointer to the in-memory copy.
+   @param[in]      CopyLength    Length of the copy, in bytes.
+   @param[in]      CopyOffset    Offset, in bytes, of the copy in the disk.
+   @param[in]      Buffer        Pointer to the new data.
+   @param[in]      Length        Length of the new data, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4CopyOverlap (
+  OUT VOID        *Copy,
+  IN  UINTN       CopyLength,
+  IN  UINT64      CopyOffset,
+  IN  CONST VOID  *Buffer,
+  IN  UINTN       Length,
+  IN  UINT64      Offset
+  )
+{
+  UINT64  Start;
+  UINT64  End;
+
+  Start = MAX (CopyOffset, Offset);
+  End   = MIN (CopyOffset + CopyLength, Offset + Length);
+
+  if (Start >= End) {
+    return;
+  }
+
+  CopyMem (
+    (UINT8 *)Copy + (Start - CopyOffset),
+    (CONST UINT8 *)Buffer + (Start - Offset),
+    (UINTN)(End - Start)
+    );
+}
+
+/**
+   Updates every in-memory copy of the disk that overlaps a range of it (the block cache,
+   the readahead buffer and the dirty blocks), after the range was written to.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  Buffer         Pointer to the new data.
+   @param[in]  Length         Length of the new data, in bytes.
+   @param[in]  Offset         Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4UpdateCachedCopies (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  )
+{
+  Ext4BlockCacheUpdate (Partition, Buffer, Length, Offset);
+
+  if (Partition->ReadAheadLength != 0) {
+    Ext4CopyOverlap (
+      Partition->ReadAheadBuffer,
+      Partition->ReadAheadLength,
+      Partition->ReadAheadOffset,
+      Buffer,
+      Length,
+      Offset
+      );
+  }
+
+  if (Partition->DirtyBlocks != NULL) {
+    Ext4UpdateDirtyBlocks (Partition, Buffer, Length, Offset);
+  }
 }
 
 /**
@@ -121,3 +247,91 @@ Ext4AllocAndReadBlocks (
 
   return Buf;
 }
+
+/**
+   Reads from the partition's disk through the partition's readahead buffer.
+   On a miss, ReadAheadLength bytes starting at Offset are read into the buffer, so that
+   the following sequential reads can be served from memory.
+
+   @param[in]  Partition        Pointer to the opened ext4 partition.
+   @param[out] Buffer           Pointer to a destination buffer.
+   @param[in]  Length           Length of the destination buffer.
+   @param[in]  Offset           Offset, in bytes, of the location to read.
+   @param[in]  ReadAheadLength  Number of bytes that may be read ahead, starting at Offset.
+                                Must be at least Length.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadAheadDiskIo (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset,
+  IN UINTN           ReadAheadLength
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       BufferSize;
+
+  ASSERT (ReadAheadLength >= Length);
+
+  BufferSize = PcdGet32 (PcdExt4ReadAheadSize);
+
+  if (ReadAheadLength > BufferSize) {
+    ReadAheadLength = BufferSize;
+  }
+
+  if (Length > ReadAheadLength) {
+    return Ext4ReadDiskIo (Partition, Buffer, Length, Offset);
+  }
+
+  // Hit, the whole range is in the readahead buffer
+  if ((Partition->ReadAheadBuffer != NULL) && (Offset >= Partition->ReadAheadOffset) &&
+      (Offset - Partition->ReadAheadOffset + Length <= Partition->ReadAheadLength))
+  {
+    CopyMem (Buffer, (CHAR8 *)Partition->ReadAheadBuffer + (Offset - Partition->ReadAheadOffset), Length);
+    return EFI_SUCCESS;
+  }
+
+  if (Partition->ReadAheadBuffer == NULL) {
+    Partition->ReadAheadBuffer = AllocatePool (BufferSize);
+
+    if (Partition->ReadAheadBuffer == NULL) {
+      // Not a big deal, we can still read without readahead
+      return Ext4ReadDiskIo (Partition, Buffer, Length, Offset);
+    }
+  }
+
+  Partition->ReadAheadLength = 0;
+
+  Status = Ext4ReadDiskIo (Partition, Partition->ReadAheadBuffer, ReadAheadLength, Offset);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Partition->ReadAheadOffset = Offset;
+  Partition->ReadAheadLength = ReadAheadLength;
+
+  CopyMem (Buffer, Partition->ReadAheadBuffer, Length);
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the partition's readahead buffer.
+
+   @param[in out]  Partition      Pointer to the opened ext4 partition.
+**/
+VOID
+Ext4FreeReadAhead (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  if (Partition->ReadAheadBuffer != NULL) {
+    FreePool (Partition->ReadAheadBuffer);
+    Partition->ReadAheadBuffer = NULL;
+  }
+
+  Partition->ReadAheadLength = 0;
+}
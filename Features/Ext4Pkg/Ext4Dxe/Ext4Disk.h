@@ -43,7 +43,8 @@
      an old filesystem), and holds various metadata about the file. Since the
      largest inode structure right now is ~160 bytes, the rest of the inode
      contains inline extended attributes. Inodes' data is stored using either
-     data blocks (under ext2/3) or extents (under ext4).
+     data blocks (under ext2/3), extents (under ext4) or, for small files on
+     filesystems with inline_data, inside the inode itself.
 
   5) Extents
      Ext4 inodes store data in extents. These let N contiguous logical blocks
@@ -68,12 +69,16 @@
           mostly-list of EXT4_DIR_ENTRY.
        2) Hash tree directories: These are used for larger directories, with
           hundreds of entries, and are designed in a backwards compatible way.
-          These are not yet implemented in the Ext4Dxe driver.
+          Ext4Dxe uses the hash tree to speed up lookups, but still understands
+          these directories as linear ones when listing them.
 
   7) Journal
      Ext3/4 filesystems have a journal to help protect the filesystem against
-     system crashes. This is not yet implemented in Ext4Dxe but is described
-     in detail in the Linux kernel's documentation.
+     system crashes. Ext4Dxe never writes to the journal, but when a filesystem
+     needs recovery, committed transactions are replayed into an in-memory
+     overlay of blocks that takes precedence over the blocks on disk (see
+     Journal.c). The journal format (JBD2) is described in detail in the Linux
+     kernel's documentation.
 **/
 
 #ifndef EXT4_DISK_H_
@@ -110,6 +115,7 @@
 #define EXT4_FEATURE_COMPAT_EXT_ATTR       0x08
 #define EXT4_FEATURE_COMPAT_RESIZE_INO     0x10
 #define EXT4_FEATURE_COMPAT_DIR_INDEX      0x20
+#define EXT4_FEATURE_COMPAT_SPARSE_SUPER2  0x200
 
 #define EXT4_FEATURE_INCOMPAT_COMPRESSION  0x00001
 #define EXT4_FEATURE_INCOMPAT_FILETYPE     0x00002
@@ -172,8 +178,11 @@
 #define EXT4_COMPRBLK_FL      0x00000200
 #define EXT4_NOCOMPR_FL       0x00000400
 #define EXT4_ENCRYPT_FL       0x00000800
+// Note: Hash-indexed directories are marked with EXT4_INDEX_FL, which shares its value
+// with the older EXT4_BTREE_FL name.
 #define EXT4_BTREE_FL         0x00001000
-#define EXT4_INDEX_FL         0x00002000
+#define EXT4_INDEX_FL         0x00001000
+#define EXT4_IMAGIC_FL        0x00002000
 #define EXT4_JOURNAL_DATA_FL  0x00004000
 #define EXT4_NOTAIL_FL        0x00008000
 #define EXT4_DIRSYNC_FL       0x00010000
@@ -182,6 +191,7 @@
 #define EXT4_EXTENTS_FL       0x00080000
 #define EXT4_VERITY_FL        0x00100000
 #define EXT4_EA_INODE_FL      0x00200000
+#define EXT4_INLINE_DATA_FL   0x10000000
 #define EXT4_RESERVED_FL      0x80000000
 
 /* File type flags that are stored in the directory entries */
@@ -235,7 +245,7 @@ typedef struct {
   UINT32    s_algo_bitmap;
   UINT8     s_prealloc_blocks;
   UINT8     s_prealloc_dir_blocks;
-  UINT16    unused;
+  UINT16    s_reserved_gdt_blocks;
   UINT8     s_journal_uuid[16];
   UINT32    s_journal_inum;
   UINT32    s_journal_dev;
@@ -327,6 +337,13 @@ typedef struct {
 #define EXT4_OLD_BLOCK_DESC_SIZE    32
 #define EXT4_64BIT_BLOCK_DESC_SIZE  64
 
+/* Block group flags (bg_flags) */
+// The inode table and bitmap aren't initialised; every inode in the group is free
+#define EXT4_BG_INODE_UNINIT  0x0001
+// The block bitmap isn't initialised; only the group's own metadata is in use
+#define EXT4_BG_BLOCK_UNINIT  0x0002
+#define EXT4_BG_INODE_ZEROED  0x0004
+
 STATIC_ASSERT (
   sizeof (EXT4_BLOCK_GROUP_DESC) == EXT4_64BIT_BLOCK_DESC_SIZE,
   "ext4 block group descriptor struct has incorrect size"
@@ -397,6 +414,9 @@ typedef struct _Ext4Inode {
   UINT32       i_projid;
 } EXT4_INODE;
 
+// Maximum link count. With dir_nlink, directories with more subdirectories have a link count of 1.
+#define EXT4_LINK_MAX  65000
+
 #define EXT4_NAME_MAX  255
 
 typedef struct {
@@ -424,6 +444,114 @@ typedef struct {
 
 #define EXT4_MIN_DIR_ENTRY_LEN  8
 
+// Size of a directory entry with a name of NameLen bytes, as laid out by ext4
+#define EXT4_DIR_ENTRY_LEN(NameLen)  ALIGN_VALUE (EXT4_MIN_DIR_ENTRY_LEN + (NameLen), 4)
+
+/**
+ * Checksummed (metadata_csum) linear directory blocks end with this fake entry, which
+ * looks like an unused entry to older readers.
+ */
+typedef struct {
+  // Always 0, so the entry looks unused
+  UINT32    det_reserved_zero1;
+  // Always 12, sizeof (EXT4_DIR_ENTRY_TAIL)
+  UINT16    det_rec_len;
+  UINT8     det_reserved_zero2;
+  // Always EXT4_DIR_ENTRY_TAIL_FT
+  UINT8     det_reserved_ft;
+  // CRC32C of UUID + inode number + igeneration + the rest of the block
+  UINT32    det_checksum;
+} EXT4_DIR_ENTRY_TAIL;
+
+#define EXT4_DIR_ENTRY_TAIL_FT  0xDE
+
+/**
+ * Inline data: Files with EXT4_INLINE_DATA_FL store their first EXT4_MIN_INLINE_DATA_SIZE
+ * bytes in i_data, and the rest in the value of the system.data extended attribute, stored
+ * in the inode itself (past i_extra_isize).
+ * Inline directories start with the parent's inode number instead of "." and "..".
+ */
+#define EXT4_MIN_INLINE_DATA_SIZE  (EXT4_NR_BLOCKS * sizeof (UINT32))
+#define EXT4_INLINE_DOTDOT_SIZE    4
+
+#define EXT4_XATTR_MAGIC         0xEA020000U
+#define EXT4_XATTR_INDEX_SYSTEM  7
+
+typedef struct {
+  UINT32    h_magic;
+} EXT4_XATTR_IBODY_HEADER;
+
+typedef struct {
+  UINT8     e_name_len;
+  UINT8     e_name_index;
+  // Offset of the value, from the first entry (for in-inode attributes)
+  UINT16    e_value_offs;
+  // Inode holding the value, with EXT4_FEATURE_INCOMPAT_EA_INODE
+  UINT32    e_value_inum;
+  UINT32    e_value_size;
+  UINT32    e_hash;
+  // Followed by e_name[e_name_len], and padding up to a 4 byte boundary.
+} EXT4_XATTR_ENTRY;
+
+#define EXT4_XATTR_ENTRY_LEN(NameLen)  ALIGN_VALUE (sizeof (EXT4_XATTR_ENTRY) + (NameLen), 4)
+
+// Hash tree (dx_dir) directory structures.
+// Block 0 of an indexed directory starts with fake "." and ".." entries (the latter spans the rest
+// of the block so linear readers skip the index), followed by EXT4_DX_ROOT_INFO and the root's
+// EXT4_DX_ENTRY array. Interior nodes start with a fake, empty dirent that spans the whole block,
+// followed by an EXT4_DX_ENTRY array. In both cases, the hash field of the first EXT4_DX_ENTRY is
+// replaced by an EXT4_DX_COUNT_LIMIT.
+
+#define EXT4_DX_HASH_LEGACY             0
+#define EXT4_DX_HASH_HALF_MD4           1
+#define EXT4_DX_HASH_TEA                2
+#define EXT4_DX_HASH_LEGACY_UNSIGNED    3
+#define EXT4_DX_HASH_HALF_MD4_UNSIGNED  4
+#define EXT4_DX_HASH_TEA_UNSIGNED       5
+#define EXT4_DX_HASH_SIPHASH            6
+
+// Superblock s_flags
+#define EXT4_FLAGS_SIGNED_HASH    0x0001
+#define EXT4_FLAGS_UNSIGNED_HASH  0x0002
+
+// Maximum number of index levels below the root (2 with largedir, 1 otherwise)
+#define EXT4_DX_MAX_INDIRECT_LEVELS        1
+#define EXT4_DX_MAX_INDIRECT_LEVELS_LARGE  2
+
+// The largest 32-bit hash value is reserved as an end-of-directory marker
+#define EXT4_HTREE_EOF_32BIT  0x7fffffffU
+
+typedef struct {
+  UINT32    reserved_zero;
+  UINT8     hash_version;
+  // Length of this structure, always 8
+  UINT8     info_length;
+  UINT8     indirect_levels;
+  UINT8     unused_flags;
+} EXT4_DX_ROOT_INFO;
+
+typedef struct {
+  UINT32    hash;
+  // Logical block (inside the directory) of the next level
+  UINT32    block;
+} EXT4_DX_ENTRY;
+
+typedef struct {
+  UINT16    limit;
+  UINT16    count;
+} EXT4_DX_COUNT_LIMIT;
+
+typedef struct {
+  UINT32    dt_reserved;
+  // CRC32C of UUID + inode number + igeneration + the count/limit'd index
+  UINT32    dt_checksum;
+} EXT4_DX_TAIL;
+
+// Offsets of the dx entries inside the root and inner node blocks, as described above
+#define EXT4_DX_ROOT_INFO_OFFSET     24
+#define EXT4_DX_ROOT_ENTRIES_OFFSET  (EXT4_DX_ROOT_INFO_OFFSET + sizeof (EXT4_DX_ROOT_INFO))
+#define EXT4_DX_NODE_ENTRIES_OFFSET  8
+
 // This on-disk structure is present at the bottom of the extent tree
 typedef struct {
   // First logical block
@@ -471,6 +599,10 @@ typedef struct {
   UINT32    eb_checksum;
 } EXT4_EXTENT_TAIL;
 
+// The tail follows the node's last possible entry, which isn't always at the end of the block
+#define EXT4_EXTENT_TAIL_OFFSET(Header)                                        \
+  (sizeof (EXT4_EXTENT_HEADER) + sizeof (EXT4_EXTENT) * (Header)->eh_max)
+
 /**
  * EXT4 has this feature called uninitialized extents:
  * An extent has a maximum of 32768 blocks (2^15 or 1 << 15).
@@ -498,4 +630,107 @@ typedef UINT32  EXT4_INO_NR;
 
 #define EXT4_BLOCK_FILE_HOLE  0
 
+//
+// JBD2 journal structures. Unlike the rest of the filesystem, these are big-endian.
+//
+
+#define JBD2_MAGIC_NUMBER  0xC03B3998U
+
+// Block types, stored in h_blocktype
+#define JBD2_DESCRIPTOR_BLOCK  1
+#define JBD2_COMMIT_BLOCK      2
+#define JBD2_SUPERBLOCK_V1     3
+#define JBD2_SUPERBLOCK_V2     4
+#define JBD2_REVOKE_BLOCK      5
+
+#define JBD2_FEATURE_INCOMPAT_REVOKE        0x00000001
+#define JBD2_FEATURE_INCOMPAT_64BIT         0x00000002
+#define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT  0x00000004
+#define JBD2_FEATURE_INCOMPAT_CSUM_V2       0x00000008
+#define JBD2_FEATURE_INCOMPAT_CSUM_V3       0x00000010
+#define JBD2_FEATURE_INCOMPAT_FAST_COMMIT   0x00000020
+
+// Descriptor block tag flags
+#define JBD2_FLAG_ESCAPE     1 // The first 4 bytes of the block were the magic number
+#define JBD2_FLAG_SAME_UUID  2 // No UUID follows this tag
+#define JBD2_FLAG_DELETED    4
+#define JBD2_FLAG_LAST_TAG   8 // Last tag in the descriptor block
+
+typedef struct {
+  UINT32    h_magic;
+  UINT32    h_blocktype;
+  // Transaction this block belongs to
+  UINT32    h_sequence;
+} JBD2_HEADER;
+
+typedef struct {
+  JBD2_HEADER    s_header;
+
+  // Static information describing the journal
+  UINT32         s_blocksize;
+  // Total number of blocks in the journal
+  UINT32         s_maxlen;
+  // First block of log information
+  UINT32         s_first;
+
+  // Dynamic information describing the current state of the log
+  // First commit ID expected in the log
+  UINT32         s_sequence;
+  // Block number of the start of the log, 0 if the journal is clean
+  UINT32         s_start;
+  INT32          s_errno;
+
+  // Remaining fields are only valid in a v2 superblock
+  UINT32         s_feature_compat;
+  UINT32         s_feature_incompat;
+  UINT32         s_feature_ro_compat;
+  UINT8          s_uuid[16];
+  UINT32         s_nr_users;
+  UINT32         s_dynsuper;
+  UINT32         s_max_transaction;
+  UINT32         s_max_trans_data;
+  UINT8          s_checksum_type;
+  UINT8          s_padding2[3];
+  UINT32         s_num_fc_blks;
+  UINT32         s_head;
+  UINT32         s_padding[40];
+  UINT32         s_checksum;
+  UINT8          s_users[16 * 48];
+} JBD2_SUPERBLOCK;
+
+STATIC_ASSERT (
+  sizeof (JBD2_SUPERBLOCK) == 1024,
+  "jbd2 superblock struct has incorrect size"
+  );
+
+// Descriptor block tag, for journals without JBD2_FEATURE_INCOMPAT_CSUM_V3.
+// t_blocknr_high is only present with JBD2_FEATURE_INCOMPAT_64BIT, and
+// JBD2_FEATURE_INCOMPAT_CSUM_V2 adds 2 bytes to the tag.
+typedef struct {
+  UINT32    t_blocknr;
+  UINT16    t_checksum;
+  UINT16    t_flags;
+  UINT32    t_blocknr_high;
+} JBD2_BLOCK_TAG;
+
+// Descriptor block tag, for journals with JBD2_FEATURE_INCOMPAT_CSUM_V3
+typedef struct {
+  UINT32    t_blocknr;
+  UINT32    t_flags;
+  UINT32    t_blocknr_high;
+  UINT32    t_checksum;
+} JBD2_BLOCK_TAG3;
+
+// Tail of descriptor and revoke blocks, for checksummed journals
+typedef struct {
+  UINT32    t_checksum;
+} JBD2_BLOCK_TAIL;
+
+typedef struct {
+  JBD2_HEADER    r_header;
+  // Number of bytes used in the block, including the header
+  UINT32         r_count;
+  // Followed by the revoked block numbers, 8 bytes each with JBD2_FEATURE_INCOMPAT_64BIT, else 4
+} JBD2_REVOKE_HEADER;
+
 #endif
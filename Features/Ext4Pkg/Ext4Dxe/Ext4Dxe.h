@@ -77,6 +77,20 @@ Ext4OpenPartition (
 typedef struct _Ext4File     EXT4_FILE;
 typedef struct _Ext4_Dentry  EXT4_DENTRY;
 
+//
+// Partition-wide cache of metadata blocks, see BlockCache.c
+//
+typedef struct _Ext4_BLOCK_CACHE {
+  LIST_ENTRY    *Buckets;
+  UINTN         NumberBuckets;
+  LIST_ENTRY    Lru;
+  UINTN         NumberEntries;
+  UINTN         MaxEntries;
+  UINT64        Hits;
+  UINT64        Misses;
+  UINT64        Prefetched;
+} EXT4_BLOCK_CACHE;
+
 typedef struct _Ext4_PARTITION {
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL    Interface;
   EFI_DISK_IO_PROTOCOL               *DiskIo;
@@ -104,6 +118,22 @@ typedef struct _Ext4_PARTITION {
   LIST_ENTRY                         OpenFiles;
 
   EXT4_DENTRY                        *RootDentry;
+
+  EXT4_BLOCK_CACHE                   BlockCache;
+
+  // Readahead buffer shared by sequential file reads, see Ext4ReadAheadDiskIo
+  VOID                               *ReadAheadBuffer;
+  UINT64                             ReadAheadOffset;
+  UINTN                              ReadAheadLength;
+
+  // Blocks replayed from the journal, which take precedence over the disk; see Journal.c
+  ORDERED_COLLECTION                 *JournalOverlay;
+  UINTN                              JournalOverlayBlocks;
+
+  // Metadata blocks modified in memory and not yet written back, see Writeback.c
+  ORDERED_COLLECTION                 *DirtyBlocks;
+  UINTN                              NumberDirtyBlocks;
+  BOOLEAN                            SuperBlockDirty;
 } EXT4_PARTITION;
 
 /**
@@ -177,6 +207,18 @@ Ext4OpenSuperblock (
   OUT EXT4_PARTITION  *Partition
   );
 
+/**
+   Writes the in-memory superblock back to the disk, updating its checksum.
+
+   @param[in]      Partition     Pointer to the opened partition.
+
+   @return Status of the write.
+**/
+EFI_STATUS
+Ext4WriteSuperblock (
+  IN EXT4_PARTITION  *Partition
+  );
+
 /**
    Retrieves the EFI_BLOCK_IO_PROTOCOL of the partition.
 
@@ -212,6 +254,7 @@ Ext4OpenSuperblock (
 
 /**
    Reads from the partition's disk using the DISK_IO protocol.
+   Blocks replayed from the journal take precedence over the ones on disk.
 
    @param[in]  Partition      Pointer to the opened ext4 partition.
    @param[out] Buffer         Pointer to a destination buffer.
@@ -264,6 +307,328 @@ Ext4AllocAndReadBlocks (
   IN EXT4_BLOCK_NR   BlockNumber
   );
 
+/**
+   Reads from the partition's disk through the partition's readahead buffer.
+   On a miss, ReadAheadLength bytes starting at Offset are read into the buffer, so that
+   the following sequential reads can be served from memory.
+
+   @param[in]  Partition        Pointer to the opened ext4 partition.
+   @param[out] Buffer           Pointer to a destination buffer.
+   @param[in]  Length           Length of the destination buffer.
+   @param[in]  Offset           Offset, in bytes, of the location to read.
+   @param[in]  ReadAheadLength  Number of bytes that may be read ahead, starting at Offset.
+                                Must be at least Length.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadAheadDiskIo (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset,
+  IN UINTN           ReadAheadLength
+  );
+
+/**
+   Frees the partition's readahead buffer.
+
+   @param[in out]  Partition      Pointer to the opened ext4 partition.
+**/
+VOID
+Ext4FreeReadAhead (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Writes to the partition's disk using the DISK_IO protocol.
+   The in-memory copies of the written range are updated, see Ext4UpdateCachedCopies.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  Buffer         Pointer to a source buffer.
+   @param[in]  Length         Length of the source buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to write.
+
+   @return Success status of the disk write.
+**/
+EFI_STATUS
+Ext4WriteDiskIo (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  );
+
+/**
+   Copies the part of a range of the disk that overlaps an in-memory copy of the disk into it.
+
+   @param[out]     Copy          Pointer to the in-memory copy.
+   @param[in]      CopyLength    Length of the copy, in bytes.
+   @param[in]      CopyOffset    Offset, in bytes, of the copy in the disk.
+   @param[in]      Buffer        Pointer to the new data.
+   @param[in]      Length        Length of the new data, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4CopyOverlap (
+  OUT VOID        *Copy,
+  IN  UINTN       CopyLength,
+  IN  UINT64      CopyOffset,
+  IN  CONST VOID  *Buffer,
+  IN  UINTN       Length,
+  IN  UINT64      Offset
+  );
+
+/**
+   Updates every in-memory copy of the disk that overlaps a range of it (the block cache,
+   the readahead buffer and the dirty blocks), after the range was written to.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  Buffer         Pointer to the new data.
+   @param[in]  Length         Length of the new data, in bytes.
+   @param[in]  Offset         Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4UpdateCachedCopies (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  );
+
+/**
+   Initialises the partition's block cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition, with a valid BlockSize.
+
+   @retval EFI_SUCCESS             The cache was initialised (or is disabled).
+   @retval EFI_OUT_OF_RESOURCES    Failed to allocate the hash table.
+**/
+EFI_STATUS
+Ext4InitBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Frees the partition's block cache, and reports its hit rate.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Drops every block from the partition's block cache, so that following reads
+   go to the disk again.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4InvalidateBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Reads from the partition's disk, going through the block cache.
+   Meant for metadata, which is small and frequently re-read.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  Length         Length of the destination buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to read.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadDiskIoCached (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  );
+
+/**
+   Reads blocks from the partition's disk, going through the block cache.
+   Meant for metadata, which is small and frequently re-read.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  NumberBlocks   Length of the read, in filesystem blocks.
+   @param[in]  BlockNumber    Starting block number.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadBlocksCached (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           NumberBlocks,
+  IN EXT4_BLOCK_NR   BlockNumber
+  );
+
+/**
+   Prefetches a range of blocks into the block cache. Blocks that aren't cached yet are
+   read with as few disk requests as possible.
+   Prefetching is only a hint, so errors are not reported.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  BlockNumber    Starting block number.
+   @param[in]  NumberBlocks   Number of blocks to prefetch.
+**/
+VOID
+Ext4BlockCachePrefetch (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_BLOCK_NR   BlockNumber,
+  IN UINTN           NumberBlocks
+  );
+
+/**
+   Updates the cached blocks that overlap a range of the disk, after it was written to.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  Buffer         Pointer to the new data.
+   @param[in]  Length         Length of the new data, in bytes.
+   @param[in]  Offset         Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4BlockCacheUpdate (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  );
+
+/**
+   Replays the partition's journal into an in-memory overlay of blocks.
+   The journal and the disk are never written to; instead, every later read of a
+   replayed block returns the journal's copy of it.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition, with valid block group
+                                 descriptors.
+
+   @retval EFI_SUCCESS             The journal was replayed, or there was nothing to replay.
+   @retval EFI_UNSUPPORTED         The journal is external or uses unsupported features.
+   @retval EFI_VOLUME_CORRUPTED    The journal is corrupted.
+   @retval EFI_OUT_OF_RESOURCES    Failed to allocate memory.
+**/
+EFI_STATUS
+Ext4ReplayJournal (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Copies the replayed journal blocks that overlap a disk read into its buffer.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Buffer        Pointer to the buffer, holding the data read from disk.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the data in the disk.
+**/
+VOID
+Ext4JournalApplyOverlay (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT VOID            *Buffer,
+  IN     UINTN           Length,
+  IN     UINT64          Offset
+  );
+
+/**
+   Frees the partition's journal overlay.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeJournal (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Replaces the contents of a metadata block. The block is kept in memory, and is only
+   written to the disk by Ext4FlushPartition.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Block         Block number.
+   @param[in]      Data          Pointer to the new contents, Partition->BlockSize bytes long.
+
+   @retval EFI_SUCCESS             The block was marked dirty.
+   @retval EFI_OUT_OF_RESOURCES    Failed to allocate memory.
+**/
+EFI_STATUS
+Ext4MarkBlockDirty (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_BLOCK_NR   Block,
+  IN CONST VOID      *Data
+  );
+
+/**
+   Copies the dirty blocks that overlap a disk read into its buffer.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Buffer        Pointer to the buffer, holding the data read from disk.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the data in the disk.
+**/
+VOID
+Ext4ApplyDirtyBlocks (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT VOID            *Buffer,
+  IN     UINTN           Length,
+  IN     UINT64          Offset
+  );
+
+/**
+   Updates the dirty blocks that overlap a range of the disk, after it was written to.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Buffer        Pointer to the new data.
+   @param[in]      Length        Length of the new data, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4UpdateDirtyBlocks (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  );
+
+/**
+   Writes every dirty metadata block (and the superblock, if it was modified) back to the
+   disk, and flushes the disk's write cache.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+
+   @return Status of the writeback. On failure, the blocks are kept dirty.
+**/
+EFI_STATUS
+Ext4FlushPartition (
+  IN EXT4_PARTITION  *Partition
+  );
+
+/**
+   Writes the dirty metadata back if there are more than PcdExt4DirtyBlockLimit dirty blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+
+   @return Status of the writeback.
+**/
+EFI_STATUS
+Ext4FlushPartitionIfNeeded (
+  IN EXT4_PARTITION  *Partition
+  );
+
+/**
+   Drops every dirty block, without writing it back.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeDirtyBlocks (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
 /**
    Checks if the opened partition has the 64-bit feature (see
 EXT4_FEATURE_INCOMPAT_64BIT).
@@ -328,6 +693,131 @@ Ext4ReadInode (
   OUT EXT4_INODE     **OutIno
   );
 
+/**
+   Prefetches the inode table blocks that hold a set of inodes into the block cache.
+   Each table block is read only once, and runs of consecutive table blocks are read
+   with a single disk request.
+   Prefetching is only a hint, so errors are not reported.
+
+   @param[in]    Partition     Pointer to the opened partition.
+   @param[in]    InodeNums     Pointer to an array of inode numbers.
+   @param[in]    NumberInodes  Number of entries in InodeNums.
+**/
+VOID
+Ext4PrefetchInodes (
+  IN EXT4_PARTITION     *Partition,
+  IN CONST EXT4_INO_NR  *InodeNums,
+  IN UINTN              NumberInodes
+  );
+
+/**
+   Gets the location of an inode on disk.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    InodeNum   Number of the desired Inode
+   @param[out]   Offset     Pointer to where the inode's offset, in bytes, will be stored.
+
+   @retval EFI_SUCCESS             The inode's location was found.
+   @retval EFI_VOLUME_CORRUPTED    The inode number is invalid.
+**/
+EFI_STATUS
+Ext4GetInodeOffset (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_INO_NR     InodeNum,
+  OUT UINT64          *Offset
+  );
+
+/**
+   Writes a file's inode back to the inode table, updating its checksum.
+   Other open files of the same inode are updated as well.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    File       Pointer to the file.
+
+   @return Status of the write.
+**/
+EFI_STATUS
+Ext4WriteInode (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File
+  );
+
+/**
+   Allocates a run of contiguous blocks. The run starts at Goal if Goal is free, else
+   at the first free run that is long enough, starting at Goal's block group.
+   The returned run may be shorter than Wanted.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Goal       Preferred first block.
+   @param[in]    Wanted     Number of blocks wanted.
+   @param[out]   Start      Pointer to where the run's first block will be stored.
+   @param[out]   Count      Pointer to where the run's length will be stored.
+
+   @retval EFI_SUCCESS             At least one block was allocated.
+   @retval EFI_VOLUME_FULL         There are no free blocks.
+   @retval !EFI_SUCCESS            Failure.
+**/
+EFI_STATUS
+Ext4AllocateBlocks (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_BLOCK_NR   Goal,
+  IN  UINT32          Wanted,
+  OUT EXT4_BLOCK_NR   *Start,
+  OUT UINT32          *Count
+  );
+
+/**
+   Frees a run of blocks.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Start      First block of the run.
+   @param[in]    Count      Number of blocks.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4FreeBlocks (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_BLOCK_NR   Start,
+  IN UINT64          Count
+  );
+
+/**
+   Allocates an inode, preferably in the same block group as its parent directory.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    Parent     Inode number of the parent directory.
+   @param[in]    IsDir      TRUE if the inode will be a directory.
+   @param[out]   InodeNum   Pointer to where the inode number will be stored.
+
+   @retval EFI_SUCCESS             The inode was allocated.
+   @retval EFI_VOLUME_FULL         There are no free inodes.
+   @retval !EFI_SUCCESS            Failure.
+**/
+EFI_STATUS
+Ext4NewInode (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_INO_NR     Parent,
+  IN  BOOLEAN         IsDir,
+  OUT EXT4_INO_NR     *InodeNum
+  );
+
+/**
+   Frees an inode.
+
+   @param[in]    Partition  Pointer to the opened partition.
+   @param[in]    InodeNum   Inode number.
+   @param[in]    IsDir      TRUE if the inode was a directory.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4ReleaseInode (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_INO_NR     InodeNum,
+  IN BOOLEAN         IsDir
+  );
+
 /**
    Converts blocks to bytes.
 
@@ -360,6 +850,79 @@ Ext4Read (
   IN OUT UINTN           *Length
   );
 
+/**
+   Writes to an EXT4 inode, allocating blocks for the parts of the file that aren't mapped.
+   The file's size is extended if needed, and its inode written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the write.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After the write, it's updated to the number of written bytes.
+
+   @return Status of the write operation.
+**/
+EFI_STATUS
+Ext4Write (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  IN     CONST VOID      *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  );
+
+/**
+   Changes the size of a file. Shrinking frees the blocks past the new end of the file,
+   growing leaves a hole.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      NewSize       New size of the file, in bytes.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4TruncateFile (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN UINT64          NewSize
+  );
+
+/**
+   Adds (or, if Blocks is negative, subtracts) filesystem blocks to the inode's i_blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Inode         Pointer to the inode.
+   @param[in]      Blocks        Number of filesystem blocks.
+**/
+VOID
+Ext4InodeAddBlocks (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT EXT4_INODE      *Inode,
+  IN     INT64           Blocks
+  );
+
+// Timestamps updated by Ext4SetInodeTimes
+#define EXT4_INODE_ATIME   BIT0
+#define EXT4_INODE_CTIME   BIT1
+#define EXT4_INODE_MTIME   BIT2
+#define EXT4_INODE_CRTIME  BIT3
+
+/**
+   Sets timestamps of an inode.
+
+   @param[in out]  Inode         Pointer to the inode.
+   @param[in]      Which         Timestamps to set, EXT4_INODE_*TIME.
+   @param[in]      Time          Pointer to the new time, or NULL to use the current time.
+**/
+VOID
+Ext4SetInodeTimes (
+  IN OUT EXT4_INODE      *Inode,
+  IN     UINT32          Which,
+  IN     CONST EFI_TIME  *Time OPTIONAL
+  );
+
 /**
    Retrieves the size of the inode.
 
@@ -403,6 +966,9 @@ struct _Ext4File {
 
   ORDERED_COLLECTION    *ExtentsMap;
 
+  // Offset right past the end of the last read, used to detect sequential reads
+  UINT64                NextReadOffset;
+
   LIST_ENTRY            OpenFilesListNode;
 
   // Owning reference to this file's directory entry.
@@ -832,6 +1398,27 @@ Ext4SetInfo (
   IN VOID               *Buffer
   );
 
+/**
+  Flushes all modified data associated with a file to a device.
+
+  @param[in]  This            A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                              handle to flush.
+
+  @retval EFI_SUCCESS          The data was flushed.
+  @retval EFI_NO_MEDIA         The device has no medium.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_WRITE_PROTECTED  The file or medium is write-protected.
+  @retval EFI_ACCESS_DENIED    The file was opened read-only.
+  @retval EFI_VOLUME_FULL      The volume is full.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Flush (
+  IN EFI_FILE_PROTOCOL  *This
+  );
+
 // EFI_FILE_PROTOCOL implementation ends here.
 
 /**
@@ -997,6 +1584,27 @@ Ext4GetFileInfo (
   IN OUT UINTN       *BufferSize
   );
 
+/**
+   Calculates the hash of a directory entry name, as used by hash tree directories.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      HashVersion   Hash algorithm (EXT4_DX_HASH_*), as stored in the dx root.
+   @param[in]      Name          Pointer to the name.
+   @param[in]      Length        Length of the name, in bytes.
+   @param[out]     Hash          Pointer to the resulting hash.
+
+   @retval EFI_SUCCESS        The hash was calculated.
+   @retval EFI_UNSUPPORTED    The hash algorithm is unknown or unsupported.
+**/
+EFI_STATUS
+Ext4DirHash (
+  IN  CONST EXT4_PARTITION  *Partition,
+  IN  UINT8                 HashVersion,
+  IN  CONST CHAR8           *Name,
+  IN  UINTN                 Length,
+  OUT UINT32                *Hash
+  );
+
 /**
    Reads a directory entry.
 
@@ -1018,6 +1626,151 @@ Ext4ReadDir (
   IN OUT UINTN       *OutLength
   );
 
+/**
+   Adds an entry to a directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      InodeNum    Inode number of the entry.
+   @param[in]      FileType    File type of the entry, EXT4_FT_*.
+
+   @retval EFI_SUCCESS            The entry was added.
+   @retval EFI_INVALID_PARAMETER  The name isn't a valid ext4 filename.
+   @retval !EFI_SUCCESS           Failure.
+**/
+EFI_STATUS
+Ext4AddDirent (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *Directory,
+  IN CONST CHAR16    *Name,
+  IN EXT4_INO_NR     InodeNum,
+  IN UINT8           FileType
+  );
+
+/**
+   Removes an entry from a directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename. It's compared case-insensitively.
+   @param[in]      InodeNum    Inode number of the entry.
+
+   @retval EFI_SUCCESS            The entry was removed.
+   @retval EFI_NOT_FOUND          There's no such entry.
+   @retval !EFI_SUCCESS           Failure.
+**/
+EFI_STATUS
+Ext4RemoveDirent (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *Directory,
+  IN CONST CHAR16    *Name,
+  IN EXT4_INO_NR     InodeNum
+  );
+
+/**
+   Checks if a directory is empty, that is, if it only has the "." and ".." entries.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[out]     Empty       Pointer to where the result will be stored.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4DirIsEmpty (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  OUT BOOLEAN         *Empty
+  );
+
+/**
+   Opens the directory a file was opened from.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      File        Pointer to the opened file.
+   @param[out]     OutFile     Pointer to where the opened directory will be stored.
+
+   @retval EFI_SUCCESS            The directory was opened.
+   @retval EFI_ACCESS_DENIED      The file is the root directory.
+   @retval !EFI_SUCCESS           Failure.
+**/
+EFI_STATUS
+Ext4OpenParentDirectory (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *File,
+  OUT EXT4_FILE       **OutFile
+  );
+
+/**
+   Creates a file or a directory, and adds it to a directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Attributes  Attributes of the new file, EFI_FILE_*.
+   @param[out]     OutFile     Pointer to where the new opened file will be stored.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4CreateFile (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  IN  CONST CHAR16    *Name,
+  IN  UINT64          Attributes,
+  OUT EXT4_FILE       **OutFile
+  );
+
+/**
+   Checks if a file's data is stored inline, in the inode itself.
+   @param[in]      File          Pointer to the opened file.
+
+   @return TRUE if the file has inline data.
+**/
+#define EXT4_HAS_INLINE_DATA(File)                                             \
+  (((File)->Inode->i_flags & EXT4_INLINE_DATA_FL) != 0)
+
+/**
+   Reads from a file with inline data.
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[out]     Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the read.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After a successful read, it's updated to the
+                                 number of read bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4ReadInlineData (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  OUT    VOID            *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  );
+
+/**
+   Reads the entries of a directory with inline data, as a single directory block
+   that starts with the "." and ".." entries.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[out]     Block         Pointer to where the block, allocated from the pool, will be stored.
+   @param[out]     BlockSize     Pointer to the size of the block, in bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4ReadInlineDir (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  OUT CHAR8           **Block,
+  OUT UINTN           *BlockSize
+  );
+
 /**
    Initialises the (empty) extents map, that will work as a cache of extents.
 
@@ -1040,6 +1793,52 @@ Ext4FreeExtentsMap (
   IN EXT4_FILE  *File
   );
 
+/**
+   Drops every extent cached in the extents map, after the file's mappings changed.
+
+   @param[in]      File        Pointer to the open file.
+**/
+VOID
+Ext4ResetExtentsMap (
+  IN EXT4_FILE  *File
+  );
+
+/**
+   Inserts an extent in a file's extent tree, merging it with the previous extent when
+   possible. The extent must not overlap any other extent.
+   The inode (which holds the root of the tree) is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Extent        Pointer to the extent.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4InsertExtent (
+  IN EXT4_PARTITION     *Partition,
+  IN EXT4_FILE          *File,
+  IN CONST EXT4_EXTENT  *Extent
+  );
+
+/**
+   Removes every mapping of a file's extent tree starting at a logical block, and frees
+   the blocks.
+   The inode (which holds the root of the tree) is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      FirstBlock    First logical block to unmap.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4TruncateExtents (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT4_BLOCK_NR   FirstBlock
+  );
+
 /**
    Calculates the checksum of the given buffer.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -1057,6 +1856,78 @@ Ext4CalculateChecksum (
   IN UINT32                InitialValue
   );
 
+/**
+   Checks if the CPU can calculate CRC32C checksums, and picks the fastest
+   implementation. It only checks the CPU the first time it's called.
+**/
+VOID
+Ext4InitCrc32c (
+  VOID
+  );
+
+/**
+   Calculates the CRC32C of a buffer, with the fastest implementation
+   available (see Ext4InitCrc32c).
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32c (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  );
+
+/**
+   Calculates the CRC32C of a buffer, using the table-driven implementation.
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32cTable (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  );
+
+/**
+   Checks if the CPU can calculate CRC32C checksums. Implemented for each
+   architecture.
+
+   @retval TRUE    Ext4Crc32cAccel can be used.
+   @retval FALSE   The CPU doesn't have CRC32C instructions.
+**/
+BOOLEAN
+Ext4Crc32cAccelSupported (
+  VOID
+  );
+
+/**
+   Calculates the CRC32C of a buffer with the CPU's CRC32C instructions.
+   Implemented for each architecture. Ext4Crc32cAccelSupported must have
+   returned TRUE.
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32cAccel (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  );
+
 /**
    Calculates the checksum of the given inode.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -1252,4 +2123,44 @@ Ext4GetBlocks (
   OUT EXT4_EXTENT     *Extent
   );
 
+/**
+   Maps a logical block of an EXT2/3 inode (with a blockmap) to a physical block,
+   allocating the indirect blocks it needs.
+   The inode is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      LogicalBlock  Logical block.
+   @param[in]      PhysicalBlock Physical block.
+
+   @retval EFI_SUCCESS        The block was mapped.
+   @retval EFI_UNSUPPORTED    The logical block is past the largest block map.
+   @retval !EFI_SUCCESS       Failure.
+**/
+EFI_STATUS
+Ext4BlockMapSetBlock (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT2_BLOCK_NR   LogicalBlock,
+  IN EXT2_BLOCK_NR   PhysicalBlock
+  );
+
+/**
+   Removes every mapping of an EXT2/3 inode (with a blockmap) starting at a logical block,
+   and frees the blocks, including indirect blocks that become empty.
+   The inode is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      FirstBlock    First logical block to unmap.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4TruncateBlockMap (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT4_BLOCK_NR   FirstBlock
+  );
+
 #endif
@@ -229,6 +229,83 @@ Ext4ExtentIdxLeafBlock (
 // Results of sizeof(i_data) / sizeof(extent) - 1 = 4
 #define EXT4_NR_INLINE_EXTENTS  4
 
+// Holes are cached as uninitialized extents, so they're limited to the maximum length of those
+#define EXT4_HOLE_MAX_LENGTH  (EXT4_EXTENT_MAX_INITIALIZED - 1)
+
+/**
+   Builds (and caches) a file hole extent for a logical block that isn't mapped by a leaf node.
+   The hole spans the whole gap between the neighbouring extents, clipped to the range of logical
+   blocks covered by the leaf (so that holes are always disjoint from each other and from extents,
+   no matter which block of the hole was looked up first).
+
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      ExtHeader     Pointer to the leaf node's EXT4_EXTENT_HEADER.
+   @param[in]      LeafStart     First logical block covered by the leaf.
+   @param[in]      LeafEnd       Last logical block covered by the leaf, exclusive.
+   @param[in]      LogicalBlock  Block number which the hole must cover.
+   @param[out]     Extent        Pointer to the output buffer, where the hole extent will be copied to.
+
+   @retval EFI_SUCCESS        A hole extent was built.
+   @retval EFI_NO_MAPPING     The leaf is inconsistent with the block's position in the tree.
+**/
+STATIC
+EFI_STATUS
+Ext4GetHoleExtent (
+  IN  EXT4_FILE           *File,
+  IN  EXT4_EXTENT_HEADER  *ExtHeader,
+  IN  UINT64              LeafStart,
+  IN  UINT64              LeafEnd,
+  IN  UINT32              LogicalBlock,
+  OUT EXT4_EXTENT         *Extent
+  )
+{
+  EXT4_EXTENT  *Extents;
+  EXT4_EXTENT  *Prev;
+  EXT4_EXTENT  *Next;
+  UINT64       HoleStart;
+  UINT64       HoleEnd;
+  UINT64       HoleLength;
+
+  Extents = (EXT4_EXTENT *)(ExtHeader + 1);
+  Prev    = Ext4BinsearchExtentExt (ExtHeader, LogicalBlock);
+
+  // Note that the binary search returns the first extent if every extent starts past LogicalBlock.
+  if ((Prev != NULL) && (Prev->ee_block > LogicalBlock)) {
+    Next = Prev;
+    Prev = NULL;
+  } else {
+    Next = Prev == NULL ? NULL : Prev + 1;
+  }
+
+  HoleStart = LeafStart;
+  HoleEnd   = LeafEnd;
+
+  if (Prev != NULL) {
+    HoleStart = MAX (HoleStart, (UINT64)Prev->ee_block + Ext4GetExtentLength (Prev));
+  }
+
+  if ((Next != NULL) && (Next < Extents + ExtHeader->eh_entries)) {
+    HoleEnd = MIN (HoleEnd, Next->ee_block);
+  }
+
+  if ((LogicalBlock < HoleStart) || (LogicalBlock >= HoleEnd)) {
+    return EFI_NO_MAPPING;
+  }
+
+  // Long holes are split into EXT4_HOLE_MAX_LENGTH sized pieces, aligned to the hole's start
+  HoleStart += MultU64x32 (DivU64x32 (LogicalBlock - HoleStart, EXT4_HOLE_MAX_LENGTH), EXT4_HOLE_MAX_LENGTH);
+  HoleLength = MIN (HoleEnd - HoleStart, EXT4_HOLE_MAX_LENGTH);
+
+  Extent->ee_block    = (UINT32)HoleStart;
+  Extent->ee_len      = (UINT16)(EXT4_EXTENT_MAX_INITIALIZED + HoleLength);
+  Extent->ee_start_hi = 0;
+  Extent->ee_start_lo = EXT4_BLOCK_FILE_HOLE;
+
+  Ext4CacheExtents (File, Extent, 1);
+
+  return EFI_SUCCESS;
+}
+
 /**
    Retrieves an extent from an EXT4 inode.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -236,7 +313,8 @@ Ext4ExtentIdxLeafBlock (
    @param[in]      LogicalBlock  Block number which the returned extent must cover.
    @param[out]     Extent        Pointer to the output buffer, where the extent will be copied to.
 
-   @retval EFI_SUCCESS        Retrieval was successful.
+   @retval EFI_SUCCESS        Retrieval was successful. Note that file holes are returned
+                              as uninitialized extents.
    @retval EFI_NO_MAPPING     Block has no mapping.
 **/
 EFI_STATUS
@@ -256,6 +334,8 @@ Ext4GetExtent (
   EFI_STATUS          Status;
   UINT32              MaxExtentsPerNode;
   EXT4_BLOCK_NR       BlockNumber;
+  UINT64              LeafStart;
+  UINT64              LeafEnd;
 
   Inode  = File->Inode;
   Ext    = NULL;
@@ -268,8 +348,8 @@ Ext4GetExtent (
     return EFI_NO_MAPPING;
   }
 
-  // Note: Right now, holes are the single biggest reason for cache misses
-  // We should find a way to get (or cache) holes
+  // Note: File holes are cached as well (see Ext4GetHoleExtent), so sparse files don't
+  // need a tree walk for every block of a hole.
   if ((Ext = Ext4GetExtentFromMap (File, (UINT32)LogicalBlock)) != NULL) {
     *Extent = *Ext;
 
@@ -304,6 +384,10 @@ Ext4GetExtent (
   // and so are individual entries.
   MaxExtentsPerNode = (Partition->BlockSize / sizeof (EXT4_EXTENT)) - 1;
 
+  // Range of logical blocks [LeafStart, LeafEnd) covered by the current node
+  LeafStart = 0;
+  LeafEnd   = (UINT64)MAX_UINT32 + 1;
+
   while (ExtHeader->eh_depth != 0) {
     CurrentDepth--;
     // While depth != 0, we're traversing the tree itself and not any leaves
@@ -315,6 +399,15 @@ Ext4GetExtent (
     Index       = Ext4BinsearchExtentIndex (ExtHeader, LogicalBlock);
     BlockNumber = Ext4ExtentIdxLeafBlock (Index);
 
+    // The first index also covers every block before it, the last one every block after it.
+    if (Index != (EXT4_EXTENT_INDEX *)(ExtHeader + 1)) {
+      LeafStart = MAX (LeafStart, Index->ei_block);
+    }
+
+    if (Index + 1 < (EXT4_EXTENT_INDEX *)(ExtHeader + 1) + ExtHeader->eh_entries) {
+      LeafEnd = MIN (LeafEnd, (Index + 1)->ei_block);
+    }
+
     // Check that block isn't file hole
     if (BlockNumber == EXT4_BLOCK_FILE_HOLE) {
       if (Buffer != NULL) {
@@ -333,7 +426,7 @@ Ext4GetExtent (
 
     // Read the leaf block onto the previously-allocated buffer.
 
-    Status = Ext4ReadBlocks (Partition, Buffer, 1, BlockNumber);
+    Status = Ext4ReadBlocksCached (Partition, Buffer, 1, BlockNumber);
     if (EFI_ERROR (Status)) {
       FreePool (Buffer);
       return Status;
@@ -367,21 +460,17 @@ Ext4GetExtent (
 
   Ext = Ext4BinsearchExtentExt (ExtHeader, LogicalBlock);
 
-  if (!Ext) {
-    if (Buffer != NULL) {
-      FreePool (Buffer);
-    }
+  if ((Ext == NULL) ||
+      !((LogicalBlock >= Ext->ee_block) && (Ext->ee_block + Ext4GetExtentLength (Ext) > LogicalBlock)))
+  {
+    // No extent covers the block, so it's part of a file hole
+    Status = Ext4GetHoleExtent (File, ExtHeader, LeafStart, LeafEnd, (UINT32)LogicalBlock, Extent);
 
-    return EFI_NO_MAPPING;
-  }
-
-  if (!((LogicalBlock >= Ext->ee_block) && (Ext->ee_block + Ext4GetExtentLength (Ext) > LogicalBlock))) {
-    // This extent does not cover the block
     if (Buffer != NULL) {
       FreePool (Buffer);
     }
 
-    return EFI_NO_MAPPING;
+    return Status;
   }
 
   *Extent = *Ext;
@@ -493,6 +582,22 @@ VOID
 Ext4FreeExtentsMap (
   IN EXT4_FILE  *File
   )
+{
+  Ext4ResetExtentsMap (File);
+
+  OrderedCollectionUninit (File->ExtentsMap);
+  File->ExtentsMap = NULL;
+}
+
+/**
+   Drops every extent cached in the extents map, after the file's mappings changed.
+
+   @param[in]      File        Pointer to the open file.
+**/
+VOID
+Ext4ResetExtentsMap (
+  IN EXT4_FILE  *File
+  )
 {
   // Keep calling Min(), so we get an arbitrary node we can delete.
   // If Min() returns NULL, it's empty.
@@ -508,9 +613,6 @@ Ext4FreeExtentsMap (
   }
 
   ASSERT (OrderedCollectionIsEmpty (File->ExtentsMap));
-
-  OrderedCollectionUninit (File->ExtentsMap);
-  File->ExtentsMap = NULL;
 }
 
 /**
@@ -605,7 +707,7 @@ Ext4CalculateExtentChecksum (
 
   Csum = Ext4CalculateChecksum (Partition, &File->InodeNum, sizeof (EXT4_INO_NR), Partition->InitialSeed);
   Csum = Ext4CalculateChecksum (Partition, &Inode->i_generation, sizeof (Inode->i_generation), Csum);
-  Csum = Ext4CalculateChecksum (Partition, ExtHeader, Partition->BlockSize - sizeof (EXT4_EXTENT_TAIL), Csum);
+  Csum = Ext4CalculateChecksum (Partition, ExtHeader, EXT4_EXTENT_TAIL_OFFSET (ExtHeader), Csum);
 
   return Csum;
 }
@@ -632,7 +734,7 @@ Ext4CheckExtentChecksum (
     return TRUE;
   }
 
-  Tail = (EXT4_EXTENT_TAIL *)((CONST CHAR8 *)ExtHeader + (Partition->BlockSize - 4));
+  Tail = (EXT4_EXTENT_TAIL *)((CONST CHAR8 *)ExtHeader + EXT4_EXTENT_TAIL_OFFSET (ExtHeader));
 
   return Tail->eb_checksum == Ext4CalculateExtentChecksum (ExtHeader, File);
 }
@@ -656,3 +758,656 @@ Ext4GetExtentLength (
 
   return Extent->ee_len;
 }
+
+// Maximum number of times Ext4InsertExtent restructures the tree before inserting an extent
+#define EXT4_EXTENT_MAX_TREE_CHANGES  (2 * (EXT4_EXTENT_TREE_MAX_DEPTH + 1))
+
+/**
+   Gets the physical block an extent starts at.
+
+   @param[in]      Extent        Pointer to the extent.
+
+   @return The extent's first physical block.
+**/
+STATIC
+EXT4_BLOCK_NR
+Ext4ExtentPhysicalStart (
+  IN CONST EXT4_EXTENT  *Extent
+  )
+{
+  return LShiftU64 (Extent->ee_start_hi, 32) | Extent->ee_start_lo;
+}
+
+/**
+   Writes an extent tree node back, updating its checksum.
+   The root node lives in the inode, which is written by the callers instead.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Header        Pointer to the node.
+   @param[in]      Block         Block of the node, EXT4_BLOCK_FILE_HOLE for the root.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4WriteExtentNode (
+  IN EXT4_PARTITION      *Partition,
+  IN EXT4_FILE           *File,
+  IN EXT4_EXTENT_HEADER  *Header,
+  IN EXT4_BLOCK_NR       Block
+  )
+{
+  EXT4_EXTENT_TAIL  *Tail;
+
+  if (Block == EXT4_BLOCK_FILE_HOLE) {
+    return EFI_SUCCESS;
+  }
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Tail              = (EXT4_EXTENT_TAIL *)((CHAR8 *)Header + EXT4_EXTENT_TAIL_OFFSET (Header));
+    Tail->eb_checksum = Ext4CalculateExtentChecksum (Header, File);
+  }
+
+  return Ext4MarkBlockDirty (Partition, Block, Header);
+}
+
+/**
+   Allocates a new extent tree node, near the node that points to it.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Goal          Preferred block.
+   @param[in]      Depth         Depth of the node.
+   @param[out]     Block         Pointer to where the node's block will be stored.
+   @param[out]     Header        Pointer to where the node, allocated from the pool, will be stored.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4AllocateExtentNode (
+  IN  EXT4_PARTITION      *Partition,
+  IN  EXT4_FILE           *File,
+  IN  EXT4_BLOCK_NR       Goal,
+  IN  UINT16              Depth,
+  OUT EXT4_BLOCK_NR       *Block,
+  OUT EXT4_EXTENT_HEADER  **Header
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Count;
+
+  *Header = AllocateZeroPool (Partition->BlockSize);
+
+  if (*Header == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4AllocateBlocks (Partition, Goal, 1, Block, &Count);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (*Header);
+    return Status;
+  }
+
+  Ext4InodeAddBlocks (Partition, File->Inode, 1);
+
+  (*Header)->eh_magic   = EXT4_EXTENT_HEADER_MAGIC;
+  (*Header)->eh_entries = 0;
+  (*Header)->eh_max     = (UINT16)((Partition->BlockSize - sizeof (EXT4_EXTENT_HEADER)) / sizeof (EXT4_EXTENT));
+  (*Header)->eh_depth   = Depth;
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads the path of extent tree nodes that leads to a logical block.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      LogicalBlock  Logical block.
+   @param[out]     Nodes         Nodes of the path, from the root (which is in the inode) to the leaf.
+                                 Every node but the root is allocated from the pool.
+   @param[out]     Blocks        Blocks of the nodes, EXT4_BLOCK_FILE_HOLE for the root.
+   @param[out]     Positions     Index followed in each index node.
+
+   @return Status of the operation. On failure, the nodes are freed.
+**/
+STATIC
+EFI_STATUS
+Ext4ReadExtentPath (
+  IN  EXT4_PARTITION      *Partition,
+  IN  EXT4_FILE           *File,
+  IN  UINT32              LogicalBlock,
+  OUT EXT4_EXTENT_HEADER  **Nodes,
+  OUT EXT4_BLOCK_NR       *Blocks,
+  OUT UINT16              *Positions
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_EXTENT_HEADER  *Header;
+  EXT4_EXTENT_INDEX   *Index;
+  UINT16              Level;
+  UINT16              Depth;
+  UINT16              MaxEntries;
+
+  Header = Ext4GetInoExtentHeader (File->Inode);
+
+  if (!Ext4ExtentHeaderValid (Header, EXT4_NR_INLINE_EXTENTS)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Nodes[0]  = Header;
+  Blocks[0] = EXT4_BLOCK_FILE_HOLE;
+  Depth     = Header->eh_depth;
+
+  MaxEntries = (UINT16)((Partition->BlockSize - sizeof (EXT4_EXTENT_HEADER)) / sizeof (EXT4_EXTENT));
+
+  for (Level = 0; Level < Depth; Level++) {
+    if (Nodes[Level]->eh_entries == 0) {
+      Status = EFI_VOLUME_CORRUPTED;
+      goto Error;
+    }
+
+    Index            = Ext4BinsearchExtentIndex (Nodes[Level], LogicalBlock);
+    Positions[Level] = (UINT16)(Index - (EXT4_EXTENT_INDEX *)(Nodes[Level] + 1));
+    Blocks[Level + 1] = Ext4ExtentIdxLeafBlock (Index);
+
+    Nodes[Level + 1] = AllocatePool (Partition->BlockSize);
+
+    if (Nodes[Level + 1] == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Error;
+    }
+
+    Status = Ext4ReadBlocksCached (Partition, Nodes[Level + 1], 1, Blocks[Level + 1]);
+
+    if (EFI_ERROR (Status)) {
+      Level++;
+      goto Error;
+    }
+
+    Header = Nodes[Level + 1];
+
+    if (!Ext4ExtentHeaderValid (Header, MaxEntries) || (Header->eh_depth != Depth - Level - 1) ||
+        !Ext4CheckExtentChecksum (Header, File))
+    {
+      Status = EFI_VOLUME_CORRUPTED;
+      Level++;
+      goto Error;
+    }
+  }
+
+  return EFI_SUCCESS;
+
+Error:
+  while (Level > 0) {
+    FreePool (Nodes[Level]);
+    Level--;
+  }
+
+  return Status;
+}
+
+/**
+   Frees the nodes of an extent tree path, see Ext4ReadExtentPath.
+
+   @param[in]      Nodes         Nodes of the path.
+   @param[in]      Depth         Depth of the tree when the path was read. The root's
+                                 depth changes when the tree grows.
+**/
+STATIC
+VOID
+Ext4FreeExtentPath (
+  IN EXT4_EXTENT_HEADER  **Nodes,
+  IN UINT16              Depth
+  )
+{
+  UINT16  Level;
+
+  for (Level = Depth; Level > 0; Level--) {
+    FreePool (Nodes[Level]);
+  }
+}
+
+/**
+   Inserts an entry in a node of the extent tree, at a given position.
+
+   @param[in out]  Header        Pointer to the node, which must have room for the entry.
+   @param[in]      Position      Position of the new entry.
+   @param[in]      Entry         Pointer to the entry (an extent or an index, both are as large).
+**/
+STATIC
+VOID
+Ext4InsertExtentEntry (
+  IN OUT EXT4_EXTENT_HEADER  *Header,
+  IN     UINT16              Position,
+  IN     CONST VOID          *Entry
+  )
+{
+  EXT4_EXTENT  *Entries;
+
+  ASSERT (Header->eh_entries < Header->eh_max);
+
+  Entries = (EXT4_EXTENT *)(Header + 1);
+
+  CopyMem (&Entries[Position + 1], &Entries[Position], (Header->eh_entries - Position) * sizeof (EXT4_EXTENT));
+  CopyMem (&Entries[Position], Entry, sizeof (EXT4_EXTENT));
+  Header->eh_entries++;
+}
+
+/**
+   Makes room in a full node of an extent tree path, by splitting it (and inserting the new
+   node in its parent) or, if every node of the path is full, by adding a level to the tree.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Nodes         Nodes of the path.
+   @param[in]      Blocks        Blocks of the nodes.
+   @param[in]      Positions     Index followed in each index node.
+   @param[in]      Append        TRUE if the new extent goes after every extent of the leaf.
+   @param[in]      Key           First logical block of the new extent.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4GrowExtentPath (
+  IN EXT4_PARTITION      *Partition,
+  IN EXT4_FILE           *File,
+  IN EXT4_EXTENT_HEADER  **Nodes,
+  IN EXT4_BLOCK_NR       *Blocks,
+  IN UINT16              *Positions,
+  IN BOOLEAN             Append,
+  IN UINT32              Key
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_EXTENT_HEADER  *Root;
+  EXT4_EXTENT_HEADER  *Child;
+  EXT4_EXTENT_HEADER  *NewNode;
+  EXT4_EXTENT_INDEX   NewIndex;
+  EXT4_BLOCK_NR       NewBlock;
+  UINT16              Depth;
+  UINT16              Level;
+  UINT16              Moved;
+
+  Root  = Nodes[0];
+  Depth = Root->eh_depth;
+
+  // Find the deepest index node with room for one more index
+  for (Level = Depth; Level > 0; Level--) {
+    if (Nodes[Level - 1]->eh_entries < Nodes[Level - 1]->eh_max) {
+      break;
+    }
+  }
+
+  if (Level == 0) {
+    // Every node is full, so the root's entries move to a new node, and the root points to it
+    if (Depth == EXT4_EXTENT_TREE_MAX_DEPTH) {
+      return EFI_VOLUME_FULL;
+    }
+
+    // Keep the node close to the file's data
+    Status = Ext4AllocateExtentNode (
+               Partition,
+               File,
+               Depth > 0 ? Blocks[1] : Ext4ExtentPhysicalStart ((EXT4_EXTENT *)(Root + 1)),
+               Depth,
+               &NewBlock,
+               &NewNode
+               );
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    NewNode->eh_entries = Root->eh_entries;
+    CopyMem (NewNode + 1, Root + 1, Root->eh_entries * sizeof (EXT4_EXTENT));
+
+    ZeroMem (&NewIndex, sizeof (NewIndex));
+    NewIndex.ei_block   = Root->eh_entries != 0 ? ((EXT4_EXTENT *)(Root + 1))->ee_block : Key;
+    NewIndex.ei_leaf_lo = (UINT32)NewBlock;
+    NewIndex.ei_leaf_hi = (UINT16)RShiftU64 (NewBlock, 32);
+
+    Status = Ext4WriteExtentNode (Partition, File, NewNode, NewBlock);
+    FreePool (NewNode);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Root->eh_depth   = Depth + 1;
+    Root->eh_entries = 1;
+    CopyMem (Root + 1, &NewIndex, sizeof (NewIndex));
+    return EFI_SUCCESS;
+  }
+
+  // Split Nodes[Level], and add the new node to its parent, after the node
+  Child = Nodes[Level];
+
+  Status = Ext4AllocateExtentNode (Partition, File, Blocks[Level], Child->eh_depth, &NewBlock, &NewNode);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&NewIndex, sizeof (NewIndex));
+
+  if ((Level == Depth) && Append) {
+    // Files usually grow at the end, so leave the full leaf alone and start a new one
+    NewIndex.ei_block = Key;
+  } else {
+    Moved = Child->eh_entries / 2;
+    CopyMem (
+      NewNode + 1,
+      (EXT4_EXTENT *)(Child + 1) + (Child->eh_entries - Moved),
+      Moved * sizeof (EXT4_EXTENT)
+      );
+    NewNode->eh_entries = Moved;
+    Child->eh_entries  -= Moved;
+
+    // Both extents and indexes start with their first logical block
+    NewIndex.ei_block = ((EXT4_EXTENT *)(NewNode + 1))->ee_block;
+  }
+
+  NewIndex.ei_leaf_lo = (UINT32)NewBlock;
+  NewIndex.ei_leaf_hi = (UINT16)RShiftU64 (NewBlock, 32);
+
+  Status = Ext4WriteExtentNode (Partition, File, NewNode, NewBlock);
+  FreePool (NewNode);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Ext4WriteExtentNode (Partition, File, Child, Blocks[Level]);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Ext4InsertExtentEntry (Nodes[Level - 1], Positions[Level - 1] + 1, &NewIndex);
+  return Ext4WriteExtentNode (Partition, File, Nodes[Level - 1], Blocks[Level - 1]);
+}
+
+/**
+   Inserts an extent in a file's extent tree, merging it with the previous extent when
+   possible. The extent must not overlap any other extent.
+   The inode (which holds the root of the tree) is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Extent        Pointer to the extent.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4InsertExtent (
+  IN EXT4_PARTITION     *Partition,
+  IN EXT4_FILE          *File,
+  IN CONST EXT4_EXTENT  *Extent
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_EXTENT_HEADER  *Nodes[EXT4_EXTENT_TREE_MAX_DEPTH + 1];
+  EXT4_BLOCK_NR       Blocks[EXT4_EXTENT_TREE_MAX_DEPTH + 1];
+  UINT16              Positions[EXT4_EXTENT_TREE_MAX_DEPTH + 1];
+  EXT4_EXTENT_HEADER  *Leaf;
+  EXT4_EXTENT         *Extents;
+  EXT4_EXTENT         *Prev;
+  EXT4_EXTENT_INDEX   *Index;
+  UINT16              Depth;
+  UINT16              Position;
+  INTN                Level;
+  UINTN               Changes;
+
+  ASSERT (!EXT4_EXTENT_IS_UNINITIALIZED (Extent));
+
+  for (Changes = 0; Changes <= EXT4_EXTENT_MAX_TREE_CHANGES; Changes++) {
+    Status = Ext4ReadExtentPath (Partition, File, Extent->ee_block, Nodes, Blocks, Positions);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Depth   = Nodes[0]->eh_depth;
+    Leaf    = Nodes[Depth];
+    Extents = (EXT4_EXTENT *)(Leaf + 1);
+
+    for (Position = 0; Position < Leaf->eh_entries && Extents[Position].ee_block < Extent->ee_block; Position++) {
+    }
+
+    Prev = Position > 0 ? &Extents[Position - 1] : NULL;
+
+    // Sequential writes usually get blocks right after the previous ones, so this is the common case
+    if ((Prev != NULL) && !EXT4_EXTENT_IS_UNINITIALIZED (Prev) &&
+        (Prev->ee_block + Prev->ee_len == Extent->ee_block) &&
+        (Ext4ExtentPhysicalStart (Prev) + Prev->ee_len == Ext4ExtentPhysicalStart (Extent)) &&
+        ((UINT32)Prev->ee_len + Extent->ee_len <= EXT4_EXTENT_MAX_INITIALIZED))
+    {
+      Prev->ee_len = (UINT16)(Prev->ee_len + Extent->ee_len);
+      Status       = Ext4WriteExtentNode (Partition, File, Leaf, Blocks[Depth]);
+      break;
+    }
+
+    if (Leaf->eh_entries == Leaf->eh_max) {
+      Status = Ext4GrowExtentPath (
+                 Partition,
+                 File,
+                 Nodes,
+                 Blocks,
+                 Positions,
+                 Position == Leaf->eh_entries,
+                 Extent->ee_block
+                 );
+      Ext4FreeExtentPath (Nodes, Depth);
+
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      // The tree changed, look the leaf up again
+      continue;
+    }
+
+    Ext4InsertExtentEntry (Leaf, Position, Extent);
+    Status = Ext4WriteExtentNode (Partition, File, Leaf, Blocks[Depth]);
+
+    // The indexes that lead to the leaf are keyed by its first block
+    for (Level = Depth - 1; Level >= 0 && Position == 0 && !EFI_ERROR (Status); Level--) {
+      Index = (EXT4_EXTENT_INDEX *)(Nodes[Level] + 1) + Positions[Level];
+
+      if (Index->ei_block <= Extent->ee_block) {
+        break;
+      }
+
+      Index->ei_block = Extent->ee_block;
+      Status          = Ext4WriteExtentNode (Partition, File, Nodes[Level], Blocks[Level]);
+      Position        = Positions[Level];
+    }
+
+    break;
+  }
+
+  if (Changes > EXT4_EXTENT_MAX_TREE_CHANGES) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Ext4FreeExtentPath (Nodes, Depth);
+  Ext4ResetExtentsMap (File);
+  return Status;
+}
+
+/**
+   Removes the mappings of a node of an extent tree (and of its children) starting at a logical
+   block, and frees the blocks. Children that become empty are freed as well.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in out]  Header        Pointer to the node.
+   @param[in]      FirstBlock    First logical block to unmap.
+   @param[out]     Modified      Pointer to a boolean, set to TRUE if the node was modified.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4TruncateExtentNode (
+  IN     EXT4_PARTITION      *Partition,
+  IN     EXT4_FILE           *File,
+  IN OUT EXT4_EXTENT_HEADER  *Header,
+  IN     UINT32              FirstBlock,
+  OUT    BOOLEAN             *Modified
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_EXTENT         *Extent;
+  EXT4_EXTENT_INDEX   *Index;
+  EXT4_EXTENT_HEADER  *Child;
+  EXT4_BLOCK_NR       ChildBlock;
+  UINT32              Length;
+  UINT32              Kept;
+  UINT64              NextKey;
+  BOOLEAN             ChildModified;
+
+  *Modified = FALSE;
+
+  if (Header->eh_depth == 0) {
+    // Extents are sorted, so the ones to remove are at the end
+    while (Header->eh_entries != 0) {
+      Extent = (EXT4_EXTENT *)(Header + 1) + Header->eh_entries - 1;
+      Length = (UINT32)Ext4GetExtentLength (Extent);
+
+      if (Extent->ee_block + Length <= FirstBlock) {
+        break;
+      }
+
+      Kept = Extent->ee_block >= FirstBlock ? 0 : FirstBlock - Extent->ee_block;
+
+      Status = Ext4FreeBlocks (Partition, Ext4ExtentPhysicalStart (Extent) + Kept, Length - Kept);
+
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      Ext4InodeAddBlocks (Partition, File->Inode, -(INT64)(Length - Kept));
+      *Modified = TRUE;
+
+      if (Kept == 0) {
+        Header->eh_entries--;
+        continue;
+      }
+
+      Extent->ee_len = (UINT16)(EXT4_EXTENT_IS_UNINITIALIZED (Extent) ? EXT4_EXTENT_MAX_INITIALIZED + Kept : Kept);
+      break;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  Child = AllocatePool (Partition->BlockSize);
+
+  if (Child == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status  = EFI_SUCCESS;
+  NextKey = MAX_UINT64;
+
+  while (Header->eh_entries != 0) {
+    Index = (EXT4_EXTENT_INDEX *)(Header + 1) + Header->eh_entries - 1;
+
+    // The child only covers blocks before the next index's
+    if (NextKey <= FirstBlock) {
+      break;
+    }
+
+    ChildBlock = Ext4ExtentIdxLeafBlock (Index);
+    Status     = Ext4ReadBlocksCached (Partition, Child, 1, ChildBlock);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (!Ext4ExtentHeaderValid (Child, (UINT16)((Partition->BlockSize - sizeof (EXT4_EXTENT_HEADER)) / sizeof (EXT4_EXTENT))) ||
+        (Child->eh_depth != Header->eh_depth - 1) || !Ext4CheckExtentChecksum (Child, File))
+    {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+
+    Status = Ext4TruncateExtentNode (Partition, File, Child, FirstBlock, &ChildModified);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (Child->eh_entries != 0) {
+      if (ChildModified) {
+        Status = Ext4WriteExtentNode (Partition, File, Child, ChildBlock);
+      }
+
+      break;
+    }
+
+    Status = Ext4FreeBlocks (Partition, ChildBlock, 1);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Ext4InodeAddBlocks (Partition, File->Inode, -1);
+
+    NextKey = Index->ei_block;
+    Header->eh_entries--;
+    *Modified = TRUE;
+  }
+
+  FreePool (Child);
+  return Status;
+}
+
+/**
+   Removes every mapping of a file's extent tree starting at a logical block, and frees
+   the blocks.
+   The inode (which holds the root of the tree) is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the open file.
+   @param[in]      FirstBlock    First logical block to unmap.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4TruncateExtents (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT4_BLOCK_NR   FirstBlock
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_EXTENT_HEADER  *Root;
+  BOOLEAN             Modified;
+
+  if (FirstBlock > MAX_UINT32) {
+    return EFI_SUCCESS;
+  }
+
+  Root = Ext4GetInoExtentHeader (File->Inode);
+
+  if (!Ext4ExtentHeaderValid (Root, EXT4_NR_INLINE_EXTENTS)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Status = Ext4TruncateExtentNode (Partition, File, Root, (UINT32)FirstBlock, &Modified);
+
+  // An empty tree is a single empty leaf, in the inode
+  if (Root->eh_entries == 0) {
+    Root->eh_depth = 0;
+    Root->eh_max   = EXT4_NR_INLINE_EXTENTS;
+  }
+
+  Ext4ResetExtentsMap (File);
+  return Status;
+}
@@ -200,11 +200,13 @@ Ext4OpenInternal (
   UINTN           Length;
   EXT4_FILE       *File;
   CHAR16          *Symlink;
+  BOOLEAN         Created;
   EFI_STATUS      Status;
 
   Current   = Source;
   Partition = Current->Partition;
   Level     = 0;
+  Created   = FALSE;
 
   DEBUG ((DEBUG_FS, "[ext4] Ext4OpenInternal %s\n", FileName));
 
@@ -212,6 +214,14 @@ Ext4OpenInternal (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (((OpenMode & EFI_FILE_MODE_CREATE) != 0) && ((OpenMode & EFI_FILE_MODE_WRITE) == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (((OpenMode & EFI_FILE_MODE_WRITE) != 0) && Partition->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
   // If the path starts with a backslash, we treat the root directory as the base directory
   if (FileName[0] == L'\\') {
     FileName++;
@@ -262,9 +272,22 @@ Ext4OpenInternal (
     if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
       return Status;
     } else if (Status == EFI_NOT_FOUND) {
-      // We explicitly ignore the EFI_FILE_MODE_CREATE flag, since we don't have write support
-      /// If/ we add write support, this should be changed.
-      return Status;
+      // Only the last component of the path is created, like in other EFI filesystem drivers
+      if (((OpenMode & EFI_FILE_MODE_CREATE) == 0) || !Ext4IsLastPathSegment (FileName)) {
+        return Status;
+      }
+
+      if ((Current->Inode->i_mode & EXT4_INO_PERM_WRITE_OWNER) == 0) {
+        return EFI_ACCESS_DENIED;
+      }
+
+      Status = Ext4CreateFile (Partition, Current, PathSegment, Attributes, &File);
+
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      Created = TRUE;
     }
 
     // Check if this is a valid file to open in EFI
@@ -325,7 +348,10 @@ Ext4OpenInternal (
     }
   }
 
-  if (!Ext4ApplyPermissions (Current, OpenMode)) {
+  if (Created) {
+    // New files can be written to, even if they were created read-only
+    Current->OpenMode = OpenMode;
+  } else if (!Ext4ApplyPermissions (Current, OpenMode)) {
     Ext4CloseInternal (Current);
     return EFI_ACCESS_DENIED;
   }
@@ -429,6 +455,10 @@ Ext4CloseInternal (
   IN EXT4_FILE  *File
   )
 {
+  if (((File->OpenMode & EFI_FILE_MODE_WRITE) != 0) && !File->Partition->Unmounting) {
+    Ext4FlushPartition (File->Partition);
+  }
+
   if ((File == File->Partition->Root) && !File->Partition->Unmounting) {
     return EFI_SUCCESS;
   }
@@ -442,6 +472,119 @@ Ext4CloseInternal (
   return EFI_SUCCESS;
 }
 
+/**
+   Deletes a file: removes its entry from its directory and, if it was the last link
+   to the file, frees its blocks and its inode.
+
+   @param[in]      Partition   Pointer to the opened partition.
+   @param[in]      File        Pointer to the file.
+
+   @return Status of the deletion.
+**/
+STATIC
+EFI_STATUS
+Ext4DeleteInternal (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File
+  )
+{
+  EXT4_FILE   *Directory;
+  EXT4_FILE   *Other;
+  LIST_ENTRY  *Entry;
+  BOOLEAN     IsDir;
+  BOOLEAN     Empty;
+  EFI_STATUS  Status;
+
+  if (Partition->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  if (((File->OpenMode & EFI_FILE_MODE_WRITE) == 0) || (File->InodeNum == EXT4_ROOT_INODE_NR)) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  // Extended attribute blocks may be shared between inodes, and we don't update them
+  if ((File->Inode->i_file_acl != 0) ||
+      (EXT4_IS_64_BIT (Partition) && (File->Inode->i_osd2.data_linux.l_i_file_acl_high != 0)))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  // Other handles to the file would be left with a freed inode
+  BASE_LIST_FOR_EACH (Entry, &Partition->OpenFiles) {
+    Other = EXT4_FILE_FROM_OPEN_FILES_NODE (Entry);
+
+    if ((Other != File) && (Other->InodeNum == File->InodeNum)) {
+      return EFI_ACCESS_DENIED;
+    }
+  }
+
+  IsDir = Ext4FileIsDir (File);
+
+  if (IsDir) {
+    Status = Ext4DirIsEmpty (Partition, File, &Empty);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (!Empty) {
+      return EFI_ACCESS_DENIED;
+    }
+  }
+
+  Status = Ext4OpenParentDirectory (Partition, File, &Directory);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Ext4RemoveDirent (Partition, Directory, File->Dentry->Name, File->InodeNum);
+
+  // The directory loses the link from our ".." entry
+  if (!EFI_ERROR (Status) && IsDir && (Directory->Inode->i_links > 2)) {
+    Directory->Inode->i_links--;
+    Status = Ext4WriteInode (Partition, Directory);
+  }
+
+  Ext4CloseInternal (Directory);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Directories can't be hard linked, and their "." entry is gone with them
+  if (IsDir || (File->Inode->i_links <= 1)) {
+    File->Inode->i_links = 0;
+  } else {
+    File->Inode->i_links--;
+  }
+
+  Ext4SetInodeTimes (File->Inode, EXT4_INODE_CTIME, NULL);
+
+  if (File->Inode->i_links != 0) {
+    return Ext4WriteInode (Partition, File);
+  }
+
+  if (!EXT4_HAS_INLINE_DATA (File)) {
+    Status = Ext4TruncateFile (Partition, File, 0);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  File->Inode->i_dtime = File->Inode->i_ctime;
+
+  Status = Ext4WriteInode (Partition, File);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return Ext4ReleaseInode (Partition, File->InodeNum, IsDir);
+}
+
 /**
   Close and delete the file handle.
 
@@ -458,9 +601,22 @@ Ext4Delete (
   IN EFI_FILE_PROTOCOL  *This
   )
 {
-  // We do a regular close here since we don't have write support.
+  EXT4_FILE       *File;
+  EXT4_PARTITION  *Partition;
+  EFI_STATUS      Status;
+
+  File      = EXT4_FILE_FROM_THIS (This);
+  Partition = File->Partition;
+
+  Status = Ext4DeleteInternal (Partition, File);
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_FS, "[ext4] Could not delete inode %u - error %r\n", File->InodeNum, Status));
+  }
+
   Ext4Close (This);
-  return EFI_WARN_DELETE_FAILURE;
+
+  return EFI_ERROR (Status) ? EFI_WARN_DELETE_FAILURE : EFI_SUCCESS;
 }
 
 /**
@@ -544,15 +700,35 @@ Ext4WriteFile (
   IN VOID               *Buffer
   )
 {
-  EXT4_FILE  *File;
+  EXT4_FILE       *File;
+  EXT4_PARTITION  *Partition;
+  EFI_STATUS      Status;
 
-  File = EXT4_FILE_FROM_THIS (This);
+  File      = EXT4_FILE_FROM_THIS (This);
+  Partition = File->Partition;
 
   if (!(File->OpenMode & EFI_FILE_MODE_WRITE)) {
     return EFI_ACCESS_DENIED;
   }
 
-  return EFI_WRITE_PROTECTED;
+  if (Partition->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  if (Ext4FileIsDir (File)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = Ext4Write (Partition, File, Buffer, File->Position, BufferSize);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  File->Position += *BufferSize;
+
+  // Metadata is written back at Flush/Close, unless too much of it is dirty
+  return Ext4FlushPartitionIfNeeded (Partition);
 }
 
 /**
@@ -668,7 +844,7 @@ Ext4GetFileInfo (
   Info->PhysicalSize = Ext4FilePhysicalSpace (File);
   Ext4FileATime (File, &Info->LastAccessTime);
   Ext4FileMTime (File, &Info->ModificationTime);
-  Ext4FileCreateTime (File, &Info->LastAccessTime);
+  Ext4FileCreateTime (File, &Info->CreateTime);
   Info->Attribute = 0;
   Info->Size      = NeededLength;
 
@@ -676,6 +852,10 @@ Ext4GetFileInfo (
     Info->Attribute |= EFI_FILE_DIRECTORY;
   }
 
+  if ((File->Inode->i_mode & EXT4_INO_PERM_WRITE_OWNER) == 0) {
+    Info->Attribute |= EFI_FILE_READ_ONLY;
+  }
+
   *BufferSize = NeededLength;
 
   return StrCpyS (Info->FileName, FileNameLen + 1, FileName);
@@ -954,6 +1134,289 @@ Ext4DuplicateFile (
   return File;
 }
 
+/**
+   Checks if SetInfo was asked to change a timestamp. A zeroed EFI_TIME leaves it unchanged.
+
+   @param[in]      New         Pointer to the timestamp passed to SetInfo.
+   @param[in]      Old         Pointer to the current timestamp.
+
+   @return TRUE if the timestamp should be changed.
+**/
+STATIC
+BOOLEAN
+Ext4TimeChanged (
+  IN CONST EFI_TIME  *New,
+  IN CONST EFI_TIME  *Old
+  )
+{
+  if (IsZeroBuffer (New, sizeof (EFI_TIME))) {
+    return FALSE;
+  }
+
+  return CompareMem (New, Old, sizeof (EFI_TIME)) != 0;
+}
+
+/**
+   Renames a file, inside the directory it was opened from.
+
+   @param[in]      Partition   Pointer to the opened partition.
+   @param[in]      File        Pointer to the opened file.
+   @param[in]      NewName     Pointer to the new name.
+
+   @retval EFI_SUCCESS         The file was renamed.
+   @retval EFI_ACCESS_DENIED   Another file has that name, or the file is the root directory.
+   @retval EFI_UNSUPPORTED     The new name is a path, which would move the file to another directory.
+   @retval !EFI_SUCCESS        Failure.
+**/
+STATIC
+EFI_STATUS
+Ext4RenameFile (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN CONST CHAR16    *NewName
+  )
+{
+  EXT4_FILE   *Directory;
+  EXT4_FILE   *Existing;
+  UINT8       FileType;
+  BOOLEAN     SameFile;
+  EFI_STATUS  Status;
+
+  if (StrStr (NewName, L"\\") != NULL) {
+    DEBUG ((DEBUG_FS, "[ext4] Moving files between directories is not supported\n"));
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = Ext4OpenParentDirectory (Partition, File, &Directory);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // The name may only be taken by the file itself, if it's a change of case
+  SameFile = FALSE;
+  Status   = Ext4OpenFile (Directory, NewName, Partition, EFI_FILE_MODE_READ, &Existing);
+
+  if (!EFI_ERROR (Status)) {
+    SameFile = Existing->InodeNum == File->InodeNum;
+    Ext4CloseInternal (Existing);
+
+    if (!SameFile) {
+      Status = EFI_ACCESS_DENIED;
+      goto Out;
+    }
+  } else if (Status != EFI_NOT_FOUND) {
+    goto Out;
+  }
+
+  FileType = Ext4FileIsDir (File) ? EXT4_FT_DIR : EXT4_FT_REG_FILE;
+
+  if (SameFile) {
+    // Names are compared case-insensitively, so the old entry has to go first
+    Status = Ext4RemoveDirent (Partition, Directory, File->Dentry->Name, File->InodeNum);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Status = Ext4AddDirent (Partition, Directory, NewName, File->InodeNum, FileType);
+
+    if (EFI_ERROR (Status)) {
+      Ext4AddDirent (Partition, Directory, File->Dentry->Name, File->InodeNum, FileType);
+      goto Out;
+    }
+  } else {
+    Status = Ext4AddDirent (Partition, Directory, NewName, File->InodeNum, FileType);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Status = Ext4RemoveDirent (Partition, Directory, File->Dentry->Name, File->InodeNum);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+  }
+
+  Status = StrCpyS (File->Dentry->Name, EXT4_NAME_MAX + 1, NewName);
+
+Out:
+  Ext4CloseInternal (Directory);
+  return Status;
+}
+
+/**
+   Sets the information of a file from an EFI_FILE_INFO.
+
+   @param[in]      File        Pointer to the opened file.
+   @param[in]      Info        Pointer to the EFI_FILE_INFO.
+   @param[in]      BufferSize  Size of the buffer Info points to.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4SetFileInfo (
+  IN EXT4_FILE            *File,
+  IN CONST EFI_FILE_INFO  *Info,
+  IN UINTN                BufferSize
+  )
+{
+  EXT4_PARTITION  *Partition;
+  EXT4_INODE      *Inode;
+  EFI_TIME        ATime;
+  EFI_TIME        MTime;
+  EFI_TIME        CreateTime;
+  BOOLEAN         IsDir;
+  BOOLEAN         Rename;
+  BOOLEAN         Resize;
+  UINT16          Mode;
+  EFI_STATUS      Status;
+
+  Partition = File->Partition;
+  Inode     = File->Inode;
+  IsDir     = Ext4FileIsDir (File);
+
+  if ((BufferSize < SIZE_OF_EFI_FILE_INFO + sizeof (CHAR16)) || (Info->Size > BufferSize) ||
+      (Info->Size < SIZE_OF_EFI_FILE_INFO + sizeof (CHAR16)) ||
+      (StrnLenS (Info->FileName, (Info->Size - SIZE_OF_EFI_FILE_INFO) / sizeof (CHAR16)) ==
+       (Info->Size - SIZE_OF_EFI_FILE_INFO) / sizeof (CHAR16)))
+  {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if ((Info->Attribute & ~EFI_FILE_VALID_ATTR) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (((Info->Attribute & EFI_FILE_DIRECTORY) != 0) != IsDir) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  Rename = File->InodeNum != EXT4_ROOT_INODE_NR && StrCmp (Info->FileName, File->Dentry->Name) != 0;
+  Resize = Info->FileSize != EXT4_INODE_SIZE (Inode);
+
+  if (Resize && IsDir) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  // Files opened read-only may only change their attributes
+  if (((File->OpenMode & EFI_FILE_MODE_WRITE) == 0) && (Rename || Resize)) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  // Timestamps are compared to the current ones before truncating the file changes them
+  Ext4FileATime (File, &ATime);
+  Ext4FileMTime (File, &MTime);
+  Ext4FileCreateTime (File, &CreateTime);
+
+  if (Rename) {
+    Status = Ext4RenameFile (Partition, File, Info->FileName);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (Resize) {
+    Status = Ext4TruncateFile (Partition, File, Info->FileSize);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (Ext4TimeChanged (&Info->LastAccessTime, &ATime)) {
+    Ext4SetInodeTimes (Inode, EXT4_INODE_ATIME, &Info->LastAccessTime);
+  }
+
+  if (Ext4TimeChanged (&Info->ModificationTime, &MTime)) {
+    Ext4SetInodeTimes (Inode, EXT4_INODE_MTIME, &Info->ModificationTime);
+  }
+
+  if (Ext4TimeChanged (&Info->CreateTime, &CreateTime)) {
+    Ext4SetInodeTimes (Inode, EXT4_INODE_CRTIME, &Info->CreateTime);
+  }
+
+  // EFI_FILE_READ_ONLY maps to the write permission bits, the other attributes have no equivalent
+  Mode = Inode->i_mode;
+
+  if ((Info->Attribute & EFI_FILE_READ_ONLY) != 0) {
+    Mode &= ~0222;
+  } else if ((Mode & EXT4_INO_PERM_WRITE_OWNER) == 0) {
+    Mode |= EXT4_INO_PERM_WRITE_OWNER;
+  }
+
+  Inode->i_mode = Mode;
+
+  Ext4SetInodeTimes (Inode, EXT4_INODE_CTIME, NULL);
+
+  Status = Ext4WriteInode (Partition, File);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return Ext4FlushPartition (Partition);
+}
+
+/**
+   Sets the volume label.
+
+   @param[in]      Partition   Pointer to the opened partition.
+   @param[in]      Label       Pointer to the new label.
+   @param[in]      MaxLength   Maximum length of the label, in characters, including the null terminator.
+
+   @retval EFI_SUCCESS            The label was set.
+   @retval EFI_BAD_BUFFER_SIZE    The label isn't null terminated.
+   @retval EFI_INVALID_PARAMETER  The label doesn't fit in the superblock.
+   @retval EFI_UNSUPPORTED        The filesystem has no volume label.
+   @retval !EFI_SUCCESS           Failure.
+**/
+STATIC
+EFI_STATUS
+Ext4SetVolumeLabel (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST CHAR16    *Label,
+  IN UINTN           MaxLength
+  )
+{
+  CHAR8       *Utf8Label;
+  UINTN       Length;
+  EFI_STATUS  Status;
+
+  // s_volume_name is only valid on dynamic revision; old filesystems don't support this
+  if (Partition->SuperBlock.s_rev_level != EXT4_DYNAMIC_REV) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (StrnLenS (Label, MaxLength) == MaxLength) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Status = UCS2StrToUTF8 ((CHAR16 *)Label, &Utf8Label);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Length = AsciiStrLen (Utf8Label);
+
+  if (Length > sizeof (Partition->SuperBlock.s_volume_name)) {
+    FreePool (Utf8Label);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (Partition->SuperBlock.s_volume_name, sizeof (Partition->SuperBlock.s_volume_name));
+  CopyMem (Partition->SuperBlock.s_volume_name, Utf8Label, Length);
+  FreePool (Utf8Label);
+
+  Partition->SuperBlockDirty = TRUE;
+
+  return Ext4FlushPartition (Partition);
+}
+
 /**
   Sets information about a file.
 
@@ -997,8 +1460,10 @@ Ext4SetInfo (
   IN VOID               *Buffer
   )
 {
-  EXT4_FILE       *File;
-  EXT4_PARTITION  *Partition;
+  EXT4_FILE                     *File;
+  EXT4_PARTITION                *Partition;
+  EFI_FILE_SYSTEM_INFO          *FsInfo;
+  EFI_FILE_SYSTEM_VOLUME_LABEL  *LabelInfo;
 
   File      = EXT4_FILE_FROM_THIS (This);
   Partition = File->Partition;
@@ -1007,6 +1472,64 @@ Ext4SetInfo (
     return EFI_WRITE_PROTECTED;
   }
 
-  // There's no write support just yet.
+  if (CompareGuid (InformationType, &gEfiFileInfoGuid)) {
+    return Ext4SetFileInfo (File, Buffer, BufferSize);
+  }
+
+  if (CompareGuid (InformationType, &gEfiFileSystemInfoGuid)) {
+    if (BufferSize < SIZE_OF_EFI_FILE_SYSTEM_INFO + sizeof (CHAR16)) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    // Only the label can be changed
+    FsInfo = Buffer;
+    return Ext4SetVolumeLabel (
+             Partition,
+             FsInfo->VolumeLabel,
+             (BufferSize - SIZE_OF_EFI_FILE_SYSTEM_INFO) / sizeof (CHAR16)
+             );
+  }
+
+  if (CompareGuid (InformationType, &gEfiFileSystemVolumeLabelInfoIdGuid)) {
+    if (BufferSize < sizeof (CHAR16)) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    LabelInfo = Buffer;
+    return Ext4SetVolumeLabel (Partition, LabelInfo->VolumeLabel, BufferSize / sizeof (CHAR16));
+  }
+
   return EFI_UNSUPPORTED;
 }
+
+/**
+  Flushes all modified data associated with a file to a device.
+
+  @param[in]  This            A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                              handle to flush.
+
+  @retval EFI_SUCCESS          The data was flushed.
+  @retval EFI_NO_MEDIA         The device has no medium.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_WRITE_PROTECTED  The file or medium is write-protected.
+  @retval EFI_ACCESS_DENIED    The file was opened read-only.
+  @retval EFI_VOLUME_FULL      The volume is full.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Flush (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  EXT4_FILE  *File;
+
+  File = EXT4_FILE_FROM_THIS (This);
+
+  if ((File->OpenMode & EFI_FILE_MODE_WRITE) == 0) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  return Ext4FlushPartition (File->Partition);
+}
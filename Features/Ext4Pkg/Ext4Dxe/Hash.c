@@ -0,0 +1,307 @@
+/** @file
+  Directory hash routines, used to look up names in hash tree (dx_dir) directories.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  The hash functions below follow the description of the ext4 directory hashes
+  in https://www.kernel.org/doc/html/latest/filesystems/ext4/dynamic.html#hash-tree-directories.
+  Names are hashed as raw bytes, exactly as stored in the directory entries.
+**/
+
+#include "Ext4Dxe.h"
+
+#define EXT4_TEA_DELTA    0x9E3779B9U
+#define EXT4_TEA_ROUNDS   16
+#define EXT4_MD4_K2       013240474631U
+#define EXT4_MD4_K3       015666365641U
+#define EXT4_MD4_F(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define EXT4_MD4_G(x, y, z)  (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define EXT4_MD4_H(x, y, z)  ((x) ^ (y) ^ (z))
+
+#define EXT4_MD4_ROUND(f, a, b, c, d, x, s)                                     \
+  do {                                                                          \
+    (a) += f ((b), (c), (d)) + (x);                                             \
+    (a)  = ((a) << (s)) | ((a) >> (32 - (s)));                                  \
+  } while (FALSE)
+
+/**
+   Runs the TEA transform over a 16 byte input block.
+
+   @param[in out]  Buf    The 4-word hash state.
+   @param[in]      In     4 words of input.
+**/
+STATIC
+VOID
+Ext4TeaTransform (
+  IN OUT UINT32    Buf[4],
+  IN CONST UINT32  In[4]
+  )
+{
+  UINT32  Sum;
+  UINT32  B0;
+  UINT32  B1;
+  UINTN   Round;
+
+  Sum = 0;
+  B0  = Buf[0];
+  B1  = Buf[1];
+
+  for (Round = 0; Round < EXT4_TEA_ROUNDS; Round++) {
+    Sum += EXT4_TEA_DELTA;
+    B0  += ((B1 << 4) + In[0]) ^ (B1 + Sum) ^ ((B1 >> 5) + In[1]);
+    B1  += ((B0 << 4) + In[2]) ^ (B0 + Sum) ^ ((B0 >> 5) + In[3]);
+  }
+
+  Buf[0] += B0;
+  Buf[1] += B1;
+}
+
+/**
+   Runs the (reduced round) MD4 transform over a 32 byte input block.
+
+   @param[in out]  Buf    The 4-word hash state.
+   @param[in]      In     8 words of input.
+**/
+STATIC
+VOID
+Ext4HalfMd4Transform (
+  IN OUT UINT32    Buf[4],
+  IN CONST UINT32  In[8]
+  )
+{
+  UINT32  A;
+  UINT32  B;
+  UINT32  C;
+  UINT32  D;
+
+  A = Buf[0];
+  B = Buf[1];
+  C = Buf[2];
+  D = Buf[3];
+
+  EXT4_MD4_ROUND (EXT4_MD4_F, A, B, C, D, In[0], 3);
+  EXT4_MD4_ROUND (EXT4_MD4_F, D, A, B, C, In[1], 7);
+  EXT4_MD4_ROUND (EXT4_MD4_F, C, D, A, B, In[2], 11);
+  EXT4_MD4_ROUND (EXT4_MD4_F, B, C, D, A, In[3], 19);
+  EXT4_MD4_ROUND (EXT4_MD4_F, A, B, C, D, In[4], 3);
+  EXT4_MD4_ROUND (EXT4_MD4_F, D, A, B, C, In[5], 7);
+  EXT4_MD4_ROUND (EXT4_MD4_F, C, D, A, B, In[6], 11);
+  EXT4_MD4_ROUND (EXT4_MD4_F, B, C, D, A, In[7], 19);
+
+  EXT4_MD4_ROUND (EXT4_MD4_G, A, B, C, D, In[1] + EXT4_MD4_K2, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_G, D, A, B, C, In[3] + EXT4_MD4_K2, 5);
+  EXT4_MD4_ROUND (EXT4_MD4_G, C, D, A, B, In[5] + EXT4_MD4_K2, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_G, B, C, D, A, In[7] + EXT4_MD4_K2, 13);
+  EXT4_MD4_ROUND (EXT4_MD4_G, A, B, C, D, In[0] + EXT4_MD4_K2, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_G, D, A, B, C, In[2] + EXT4_MD4_K2, 5);
+  EXT4_MD4_ROUND (EXT4_MD4_G, C, D, A, B, In[4] + EXT4_MD4_K2, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_G, B, C, D, A, In[6] + EXT4_MD4_K2, 13);
+
+  EXT4_MD4_ROUND (EXT4_MD4_H, A, B, C, D, In[3] + EXT4_MD4_K3, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_H, D, A, B, C, In[7] + EXT4_MD4_K3, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_H, C, D, A, B, In[2] + EXT4_MD4_K3, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_H, B, C, D, A, In[6] + EXT4_MD4_K3, 15);
+  EXT4_MD4_ROUND (EXT4_MD4_H, A, B, C, D, In[1] + EXT4_MD4_K3, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_H, D, A, B, C, In[5] + EXT4_MD4_K3, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_H, C, D, A, B, In[0] + EXT4_MD4_K3, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_H, B, C, D, A, In[4] + EXT4_MD4_K3, 15);
+
+  Buf[0] += A;
+  Buf[1] += B;
+  Buf[2] += C;
+  Buf[3] += D;
+}
+
+/**
+   Computes the legacy directory hash.
+
+   @param[in]  Name       Pointer to the name.
+   @param[in]  Length     Length of the name, in bytes.
+   @param[in]  Unsigned   Whether the name's characters are treated as unsigned.
+
+   @return The legacy hash of the name.
+**/
+STATIC
+UINT32
+Ext4LegacyHash (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Length,
+  IN BOOLEAN      Unsigned
+  )
+{
+  UINT32  Hash;
+  UINT32  Hash0;
+  UINT32  Hash1;
+  INT32   Char;
+
+  Hash0 = 0x12a3fe2d;
+  Hash1 = 0x37abe8f9;
+
+  while (Length-- != 0) {
+    Char = Unsigned ? (INT32)(UINT8)*Name : (INT32)(INT8)*Name;
+    Name++;
+
+    Hash = Hash1 + (Hash0 ^ ((UINT32)Char * 7152373U));
+
+    if ((Hash & 0x80000000) != 0) {
+      Hash -= 0x7fffffff;
+    }
+
+    Hash1 = Hash0;
+    Hash0 = Hash;
+  }
+
+  return Hash0 << 1;
+}
+
+/**
+   Packs (part of) a name into the input words of the TEA or half-MD4 transforms.
+
+   @param[in]  Name       Pointer to the name.
+   @param[in]  Length     Remaining length of the name, in bytes.
+   @param[out] Buf        Pointer to the output word array.
+   @param[in]  Words      Number of words in Buf.
+   @param[in]  Unsigned   Whether the name's characters are treated as unsigned.
+**/
+STATIC
+VOID
+Ext4StrToHashBuf (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Length,
+  OUT UINT32      *Buf,
+  IN UINTN        Words,
+  IN BOOLEAN      Unsigned
+  )
+{
+  UINT32  Pad;
+  UINT32  Value;
+  UINTN   Index;
+  INT32   Char;
+
+  Pad  = (UINT32)Length | ((UINT32)Length << 8);
+  Pad |= Pad << 16;
+
+  Value = Pad;
+
+  if (Length > Words * 4) {
+    Length = Words * 4;
+  }
+
+  for (Index = 0; Index < Length; Index++) {
+    Char  = Unsigned ? (INT32)(UINT8)Name[Index] : (INT32)(INT8)Name[Index];
+    Value = (UINT32)Char + (Value << 8);
+
+    if ((Index % 4) == 3) {
+      *Buf++ = Value;
+      Value  = Pad;
+      Words--;
+    }
+  }
+
+  if (Words != 0) {
+    *Buf++ = Value;
+    Words--;
+  }
+
+  while (Words-- != 0) {
+    *Buf++ = Pad;
+  }
+}
+
+/**
+   Calculates the hash of a directory entry name, as used by hash tree directories.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      HashVersion   Hash algorithm (EXT4_DX_HASH_*), as stored in the dx root.
+   @param[in]      Name          Pointer to the name.
+   @param[in]      Length        Length of the name, in bytes.
+   @param[out]     Hash          Pointer to the resulting hash.
+
+   @retval EFI_SUCCESS        The hash was calculated.
+   @retval EFI_UNSUPPORTED    The hash algorithm is unknown or unsupported.
+**/
+EFI_STATUS
+Ext4DirHash (
+  IN  CONST EXT4_PARTITION  *Partition,
+  IN  UINT8                 HashVersion,
+  IN  CONST CHAR8           *Name,
+  IN  UINTN                 Length,
+  OUT UINT32                *Hash
+  )
+{
+  UINT32   Buf[4];
+  UINT32   In[8];
+  UINT32   Result;
+  UINTN    Index;
+  BOOLEAN  Unsigned;
+  INTN     Remaining;
+
+  // Legacy, half-MD4 and TEA hashes have signed variants, chosen by the superblock flags.
+  if ((HashVersion <= EXT4_DX_HASH_TEA) &&
+      ((Partition->SuperBlock.s_flags & EXT4_FLAGS_UNSIGNED_HASH) != 0))
+  {
+    HashVersion += EXT4_DX_HASH_LEGACY_UNSIGNED;
+  }
+
+  Unsigned = HashVersion >= EXT4_DX_HASH_LEGACY_UNSIGNED;
+
+  // Default seed, used when the superblock's seed is all zeroes
+  Buf[0] = 0x67452301;
+  Buf[1] = 0xefcdab89;
+  Buf[2] = 0x98badcfe;
+  Buf[3] = 0x10325476;
+
+  for (Index = 0; Index < 4; Index++) {
+    if (Partition->SuperBlock.s_hash_seed[Index] != 0) {
+      CopyMem (Buf, Partition->SuperBlock.s_hash_seed, sizeof (Buf));
+      break;
+    }
+  }
+
+  Remaining = (INTN)Length;
+
+  switch (HashVersion) {
+    case EXT4_DX_HASH_LEGACY:
+    case EXT4_DX_HASH_LEGACY_UNSIGNED:
+      Result = Ext4LegacyHash (Name, Length, Unsigned);
+      break;
+    case EXT4_DX_HASH_HALF_MD4:
+    case EXT4_DX_HASH_HALF_MD4_UNSIGNED:
+      while (Remaining > 0) {
+        Ext4StrToHashBuf (Name, (UINTN)Remaining, In, 8, Unsigned);
+        Ext4HalfMd4Transform (Buf, In);
+        Remaining -= 32;
+        Name      += 32;
+      }
+
+      Result = Buf[1];
+      break;
+    case EXT4_DX_HASH_TEA:
+    case EXT4_DX_HASH_TEA_UNSIGNED:
+      while (Remaining > 0) {
+        Ext4StrToHashBuf (Name, (UINTN)Remaining, In, 4, Unsigned);
+        Ext4TeaTransform (Buf, In);
+        Remaining -= 16;
+        Name      += 16;
+      }
+
+      Result = Buf[0];
+      break;
+    default:
+      // SipHash is only used by casefolded + encrypted directories, which we can't read anyway.
+      DEBUG ((DEBUG_FS, "[ext4] Unsupported directory hash version %u\n", HashVersion));
+      return EFI_UNSUPPORTED;
+  }
+
+  // The low bit is used as a collision marker in the index, and the largest hash is reserved.
+  Result &= ~1U;
+
+  if (Result == (EXT4_HTREE_EOF_32BIT << 1)) {
+    Result = (EXT4_HTREE_EOF_32BIT - 1) << 1;
+  }
+
+  *Hash = Result;
+
+  return EFI_SUCCESS;
+}
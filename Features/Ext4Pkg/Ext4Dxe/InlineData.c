@@ -0,0 +1,282 @@
+/** @file
+  Inline data (EXT4_FEATURE_INCOMPAT_INLINE_DATA) support.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  Small files and directories can be stored entirely in the inode: the first
+  EXT4_MIN_INLINE_DATA_SIZE bytes go in i_data, and the rest in the value of the
+  system.data extended attribute, which lives in the inode's extra space.
+**/
+
+#include "Ext4Dxe.h"
+
+#define EXT4_INLINE_DATA_XATTR_NAME  "data"
+
+/**
+   Finds the value of the system.data extended attribute of an inode.
+   Only in-inode attributes are searched, since that's the only place where ext4 stores it.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Inode         Pointer to the inode.
+   @param[out]     Value         Pointer to where a pointer to the value (inside Inode) will be stored.
+   @param[out]     ValueLength   Pointer to the length of the value, in bytes.
+
+   @retval EFI_SUCCESS           The attribute was found.
+   @retval EFI_NOT_FOUND         The inode has no system.data attribute.
+   @retval EFI_VOLUME_CORRUPTED  The inode's attributes are corrupted.
+   @retval EFI_UNSUPPORTED       The value is stored in a separate inode.
+**/
+STATIC
+EFI_STATUS
+Ext4GetInlineDataXattr (
+  IN  CONST EXT4_PARTITION  *Partition,
+  IN  CONST EXT4_INODE      *Inode,
+  OUT CONST UINT8           **Value,
+  OUT UINTN                 *ValueLength
+  )
+{
+  CONST UINT8                    *Base;
+  CONST EXT4_XATTR_ENTRY         *Entry;
+  CONST EXT4_XATTR_IBODY_HEADER  *Header;
+  UINTN                          Start;
+  UINTN                          End;
+  UINTN                          Offset;
+  UINTN                          EntryLength;
+  UINTN                          ValueStart;
+
+  Base = (CONST UINT8 *)Inode;
+  End  = Partition->InodeSize;
+
+  if (End <= EXT4_GOOD_OLD_INODE_SIZE) {
+    return EFI_NOT_FOUND;
+  }
+
+  // In-inode attributes start right after the extra fields, with a header
+  Start = EXT4_GOOD_OLD_INODE_SIZE + Inode->i_extra_isize;
+
+  if ((Start % 4 != 0) || (Start + sizeof (EXT4_XATTR_IBODY_HEADER) > End)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Header = (CONST EXT4_XATTR_IBODY_HEADER *)(Base + Start);
+
+  if (Header->h_magic != EXT4_XATTR_MAGIC) {
+    return EFI_NOT_FOUND;
+  }
+
+  Start += sizeof (EXT4_XATTR_IBODY_HEADER);
+
+  // The list of entries is terminated by 4 zero bytes
+  for (Offset = Start; Offset + sizeof (UINT32) <= End; Offset += EntryLength) {
+    Entry = (CONST EXT4_XATTR_ENTRY *)(Base + Offset);
+
+    if (*(CONST UINT32 *)Entry == 0) {
+      break;
+    }
+
+    EntryLength = EXT4_XATTR_ENTRY_LEN (Entry->e_name_len);
+
+    if (Offset + EntryLength > End) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    if ((Entry->e_name_index != EXT4_XATTR_INDEX_SYSTEM) ||
+        (Entry->e_name_len != sizeof (EXT4_INLINE_DATA_XATTR_NAME) - 1) ||
+        (CompareMem (Entry + 1, EXT4_INLINE_DATA_XATTR_NAME, Entry->e_name_len) != 0))
+    {
+      continue;
+    }
+
+    if (Entry->e_value_inum != 0) {
+      return EFI_UNSUPPORTED;
+    }
+
+    // Value offsets are relative to the first entry
+    ValueStart = Start + Entry->e_value_offs;
+
+    if ((ValueStart > End) || (Entry->e_value_size > End - ValueStart)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    *Value       = Base + ValueStart;
+    *ValueLength = Entry->e_value_size;
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+   Gets the part of a file's inline data that is stored in the system.data attribute.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[out]     Value         Pointer to where a pointer to the data will be stored.
+   @param[out]     ValueLength   Pointer to the length of the data, in bytes. 0 if everything
+                                 fits in i_data.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4GetInlineDataTail (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *File,
+  OUT CONST UINT8     **Value,
+  OUT UINTN           *ValueLength
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = Ext4GetInlineDataXattr (Partition, File->Inode, Value, ValueLength);
+
+  if (Status == EFI_NOT_FOUND) {
+    *Value       = NULL;
+    *ValueLength = 0;
+    return EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+/**
+   Reads from a file with inline data.
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[out]     Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the read.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After a successful read, it's updated to the
+                                 number of read bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4ReadInlineData (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  OUT    VOID            *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  )
+{
+  EFI_STATUS   Status;
+  CONST UINT8  *Tail;
+  UINTN        TailLength;
+  UINT64       InodeSize;
+  UINTN        ToRead;
+  UINTN        FromInode;
+
+  InodeSize = EXT4_INODE_SIZE (File->Inode);
+
+  Status = Ext4GetInlineDataTail (Partition, File, &Tail, &TailLength);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (InodeSize > EXT4_MIN_INLINE_DATA_SIZE + TailLength) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Inode %u is too large for its inline data\n", File->InodeNum));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (Offset >= InodeSize) {
+    *Length = 0;
+    return EFI_SUCCESS;
+  }
+
+  ToRead    = (UINTN)MIN (*Length, InodeSize - Offset);
+  FromInode = 0;
+
+  if (Offset < EXT4_MIN_INLINE_DATA_SIZE) {
+    FromInode = MIN (ToRead, EXT4_MIN_INLINE_DATA_SIZE - (UINTN)Offset);
+    CopyMem (Buffer, (CONST UINT8 *)File->Inode->i_data + (UINTN)Offset, FromInode);
+  }
+
+  if (ToRead > FromInode) {
+    CopyMem (
+      (UINT8 *)Buffer + FromInode,
+      Tail + ((UINTN)Offset + FromInode - EXT4_MIN_INLINE_DATA_SIZE),
+      ToRead - FromInode
+      );
+  }
+
+  *Length = ToRead;
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads the entries of a directory with inline data, as a single directory block
+   that starts with the "." and ".." entries.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[out]     Block         Pointer to where the block, allocated from the pool, will be stored.
+   @param[out]     BlockSize     Pointer to the size of the block, in bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4ReadInlineDir (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  OUT CHAR8           **Block,
+  OUT UINTN           *BlockSize
+  )
+{
+  EFI_STATUS      Status;
+  CONST UINT8     *Tail;
+  UINTN           TailLength;
+  UINTN           DotLength;
+  UINTN           Size;
+  CHAR8           *Buffer;
+  EXT4_DIR_ENTRY  *Entry;
+
+  Status = Ext4GetInlineDataTail (Partition, Directory, &Tail, &TailLength);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Inline directories don't store "." and "..", so we make them up, so the rest of the
+  // directory code (and in particular, lookups of "..") works as usual.
+  DotLength = ALIGN_VALUE (EXT4_MIN_DIR_ENTRY_LEN + 2, 4);
+  Size      = 2 * DotLength + EXT4_MIN_INLINE_DATA_SIZE - EXT4_INLINE_DOTDOT_SIZE + TailLength;
+  Buffer    = AllocateZeroPool (Size);
+
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Entry            = (EXT4_DIR_ENTRY *)Buffer;
+  Entry->inode     = Directory->InodeNum;
+  Entry->rec_len   = (UINT16)DotLength;
+  Entry->name_len  = 1;
+  Entry->file_type = EXT4_FT_DIR;
+  Entry->name[0]   = '.';
+
+  Entry            = (EXT4_DIR_ENTRY *)(Buffer + DotLength);
+  Entry->inode     = Directory->Inode->i_data[0];
+  Entry->rec_len   = (UINT16)DotLength;
+  Entry->name_len  = 2;
+  Entry->file_type = EXT4_FT_DIR;
+  Entry->name[0]   = '.';
+  Entry->name[1]   = '.';
+
+  // The entries in i_data and in the attribute are separate runs, each of them ending with
+  // an entry whose rec_len reaches the end of the run, so they can simply be concatenated.
+  CopyMem (
+    Buffer + 2 * DotLength,
+    (CONST UINT8 *)Directory->Inode->i_data + EXT4_INLINE_DOTDOT_SIZE,
+    EXT4_MIN_INLINE_DATA_SIZE - EXT4_INLINE_DOTDOT_SIZE
+    );
+
+  if (TailLength != 0) {
+    CopyMem (Buffer + Size - TailLength, Tail, TailLength);
+  }
+
+  *Block     = Buffer;
+  *BlockSize = Size;
+  return EFI_SUCCESS;
+}
@@ -69,6 +69,72 @@ Ext4CalculateInodeChecksum (
   return Crc;
 }
 
+/**
+   Gets the physical block an extent starts at.
+
+   @param[in]      Extent        Pointer to the extent.
+
+   @return The extent's first physical block.
+**/
+STATIC
+EXT4_BLOCK_NR
+Ext4GetExtentPhysicalStart (
+  IN CONST EXT4_EXTENT  *Extent
+  )
+{
+  return LShiftU64 (Extent->ee_start_hi, 32) | Extent->ee_start_lo;
+}
+
+/**
+   Extends a read from an extent over the following extents, as long as they're contiguous
+   both logically and physically, so that they can be read with a single disk request.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Extent        Pointer to the (initialized) extent the read starts in.
+   @param[in]      Length        Number of bytes that may be read from Extent.
+   @param[in]      Wanted        Number of bytes we'd like to read in a single request.
+
+   @return Number of contiguous bytes, at least Length. May be larger than Wanted.
+**/
+STATIC
+UINT64
+Ext4GetContiguousLength (
+  IN EXT4_PARTITION     *Partition,
+  IN EXT4_FILE          *File,
+  IN CONST EXT4_EXTENT  *Extent,
+  IN UINT64             Length,
+  IN UINT64             Wanted
+  )
+{
+  EXT4_EXTENT    Current;
+  EXT4_EXTENT    Next;
+  EXT4_BLOCK_NR  NextBlock;
+  EFI_STATUS     Status;
+
+  Current = *Extent;
+
+  while (Length < Wanted) {
+    NextBlock = (EXT4_BLOCK_NR)Current.ee_block + Current.ee_len;
+
+    // Note: Extents are usually cached, so this is normally just a lookup
+    Status = Ext4GetExtent (Partition, File, NextBlock, &Next);
+
+    if (EFI_ERROR (Status) || EXT4_EXTENT_IS_UNINITIALIZED (&Next) || (Next.ee_block != NextBlock)) {
+      break;
+    }
+
+    if (Ext4GetExtentPhysicalStart (&Next) != Ext4GetExtentPhysicalStart (&Current) + Current.ee_len) {
+      break;
+    }
+
+    Length += MultU64x32 (Next.ee_len, Partition->BlockSize);
+    Current = Next;
+  }
+
+  return Length;
+}
+
 /**
    Reads from an EXT4 inode.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -106,8 +172,10 @@ Ext4Read (
   UINT64       ExtentLogicalBytes;
 
   // Our extent offset is the difference between CurrentSeek and ExtentLogicalBytes
-  UINT64  ExtentOffset;
-  UINTN   ExtentMayRead;
+  UINT64   ExtentOffset;
+  UINT64   ExtentMayRead;
+  UINT64   ReadAheadSize;
+  BOOLEAN  Sequential;
 
   Inode         = File->Inode;
   InodeSize     = EXT4_INODE_SIZE (Inode);
@@ -125,6 +193,16 @@ Ext4Read (
     RemainingRead = (UINTN)(InodeSize - Offset);
   }
 
+  if (EXT4_HAS_INLINE_DATA (File)) {
+    *Length = RemainingRead;
+    return Ext4ReadInlineData (Partition, File, Buffer, Offset, Length);
+  }
+
+  // Regular files that are read sequentially (in chunks smaller than the readahead size)
+  // get read ahead, to cut down on the number of disk requests.
+  Sequential    = Ext4FileIsReg (File) && (Offset == File->NextReadOffset);
+  ReadAheadSize = Sequential ? PcdGet32 (PcdExt4ReadAheadSize) : 0;
+
   while (RemainingRead != 0) {
     WasRead = 0;
 
@@ -151,13 +229,15 @@ Ext4Read (
         HoleLen = Partition->BlockSize - HoleOff;
       } else {
         // Uninitialized extents behave exactly the same as file holes, except they have
-        // blocks already allocated to them.
-        HoleLen = MultU64x32 (Ext4GetExtentLength (&Extent), Partition->BlockSize) - HoleOff;
+        // blocks already allocated to them. File holes themselves are also returned as
+        // uninitialized extents (see Ext4GetExtent), so we can zero the rest of the hole at once.
+        HoleLen = MultU64x32 (
+                    (UINT64)Extent.ee_block + Ext4GetExtentLength (&Extent),
+                    Partition->BlockSize
+                    ) - CurrentSeek;
       }
 
       WasRead = HoleLen > RemainingRead ? RemainingRead : (UINTN)HoleLen;
-      // Potential improvement: In the future, we could get the file hole's total
-      // size and memset all that
       ZeroMem (Buffer, WasRead);
     } else {
       ExtentStartBytes = MultU64x32 (
@@ -168,11 +248,36 @@ Ext4Read (
       ExtentLengthBytes  = Extent.ee_len * Partition->BlockSize;
       ExtentLogicalBytes = MultU64x32 ((UINT64)Extent.ee_block, Partition->BlockSize);
       ExtentOffset       = CurrentSeek - ExtentLogicalBytes;
-      ExtentMayRead      = (UINTN)(ExtentLengthBytes - ExtentOffset);
-
-      WasRead = ExtentMayRead > RemainingRead ? RemainingRead : ExtentMayRead;
+      ExtentMayRead      = ExtentLengthBytes - ExtentOffset;
+
+      // Merge physically adjacent extents into the same disk request. Directories don't need
+      // this, as they're read through the block cache.
+      if (!Ext4FileIsDir (File)) {
+        ExtentMayRead = Ext4GetContiguousLength (
+                          Partition,
+                          File,
+                          &Extent,
+                          ExtentMayRead,
+                          MIN (MAX (RemainingRead, ReadAheadSize), InodeSize - CurrentSeek)
+                          );
+      }
 
-      Status = Ext4ReadDiskIo (Partition, Buffer, WasRead, ExtentStartBytes + ExtentOffset);
+      WasRead = ExtentMayRead > RemainingRead ? RemainingRead : (UINTN)ExtentMayRead;
+
+      // Directory blocks are metadata and are re-read on every lookup, so they go through the block cache.
+      if (Ext4FileIsDir (File)) {
+        Status = Ext4ReadDiskIoCached (Partition, Buffer, WasRead, ExtentStartBytes + ExtentOffset);
+      } else if (WasRead < ReadAheadSize) {
+        Status = Ext4ReadAheadDiskIo (
+                   Partition,
+                   Buffer,
+                   WasRead,
+                   ExtentStartBytes + ExtentOffset,
+                   (UINTN)MIN (ExtentMayRead, ReadAheadSize)
+                   );
+      } else {
+        Status = Ext4ReadDiskIo (Partition, Buffer, WasRead, ExtentStartBytes + ExtentOffset);
+      }
 
       if (EFI_ERROR (Status)) {
         DEBUG ((
@@ -192,11 +297,481 @@ Ext4Read (
     CurrentSeek   += WasRead;
   }
 
-  *Length = BeenRead;
+  *Length              = BeenRead;
+  File->NextReadOffset = Offset + BeenRead;
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Gets the block new blocks of a file should preferably be allocated at: right after
+   the block mapped before them, or else at the start of the inode's block group.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      LogicalBlock  First logical block to allocate.
+
+   @return The goal block.
+**/
+STATIC
+EXT4_BLOCK_NR
+Ext4GetAllocationGoal (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN EXT4_BLOCK_NR   LogicalBlock
+  )
+{
+  EXT4_EXTENT  Extent;
+  UINT32       Group;
+
+  if ((LogicalBlock != 0) &&
+      !EFI_ERROR (Ext4GetExtent (Partition, File, LogicalBlock - 1, &Extent)) &&
+      !EXT4_EXTENT_IS_UNINITIALIZED (&Extent))
+  {
+    return Ext4GetExtentPhysicalStart (&Extent) + (LogicalBlock - 1 - Extent.ee_block) + 1;
+  }
+
+  Group = (UINT32)((File->InodeNum - 1) / Partition->SuperBlock.s_inodes_per_group);
+
+  return Partition->SuperBlock.s_first_data_block + MultU64x32 (Group, Partition->SuperBlock.s_blocks_per_group);
+}
+
+/**
+   Maps a run of logical blocks of a file to a run of physical blocks.
+   The inode is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      LogicalBlock  First logical block.
+   @param[in]      PhysicalBlock First physical block.
+   @param[in]      Count         Number of blocks, at most EXT4_EXTENT_MAX_INITIALIZED.
+   @param[out]     Mapped        Pointer to where the number of blocks that were mapped will be stored.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4MapBlocks (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *File,
+  IN  EXT4_BLOCK_NR   LogicalBlock,
+  IN  EXT4_BLOCK_NR   PhysicalBlock,
+  IN  UINT32          Count,
+  OUT UINT32          *Mapped
+  )
+{
+  EXT4_EXTENT  Extent;
+  EFI_STATUS   Status;
+
+  *Mapped = 0;
+
+  if ((File->Inode->i_flags & EXT4_EXTENTS_FL) != 0) {
+    Extent.ee_block    = (UINT32)LogicalBlock;
+    Extent.ee_len      = (UINT16)Count;
+    Extent.ee_start_hi = (UINT16)RShiftU64 (PhysicalBlock, 32);
+    Extent.ee_start_lo = (UINT32)PhysicalBlock;
+
+    Status = Ext4InsertExtent (Partition, File, &Extent);
+
+    if (!EFI_ERROR (Status)) {
+      *Mapped = Count;
+    }
+
+    return Status;
+  }
+
+  // Block maps only hold 32-bit block numbers
+  if (PhysicalBlock + Count - 1 > MAX_UINT32) {
+    return EFI_UNSUPPORTED;
+  }
+
+  for ( ; *Mapped < Count; (*Mapped)++) {
+    Status = Ext4BlockMapSetBlock (
+               Partition,
+               File,
+               (EXT2_BLOCK_NR)(LogicalBlock + *Mapped),
+               (EXT2_BLOCK_NR)(PhysicalBlock + *Mapped)
+               );
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
 
   return EFI_SUCCESS;
 }
 
+/**
+   Writes data to a file's blocks. Blocks that aren't mapped yet are allocated, with the
+   parts of them that aren't written to zeroed.
+   The inode is modified, but not written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Buffer        Pointer to the data.
+   @param[in]      Offset        Offset of the write.
+   @param[in]      Length        Length of the data, in bytes.
+   @param[out]     Written       Pointer to where the number of written bytes will be stored.
+
+   @return Status of the write. Part of the data may have been written on failure.
+**/
+STATIC
+EFI_STATUS
+Ext4WriteBlocks (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *File,
+  IN  CONST UINT8     *Buffer,
+  IN  UINT64          Offset,
+  IN  UINTN           Length,
+  OUT UINTN           *Written
+  )
+{
+  EXT4_EXTENT    Extent;
+  EXT4_BLOCK_NR  LogicalBlock;
+  EXT4_BLOCK_NR  PhysicalBlock;
+  UINT32         BlockOff;
+  UINT32         BlockSize;
+  UINT64         Chunk;
+  UINT64         RunBytes;
+  UINT32         Wanted;
+  UINT32         Count;
+  UINT32         Mapped;
+  VOID           *Zeroes;
+  EFI_STATUS     Status;
+
+  BlockSize = Partition->BlockSize;
+  Zeroes    = NULL;
+  Status    = EFI_SUCCESS;
+  *Written  = 0;
+
+  while (Length != 0) {
+    LogicalBlock = DivU64x32Remainder (Offset, BlockSize, &BlockOff);
+
+    Status = Ext4GetExtent (Partition, File, LogicalBlock, &Extent);
+
+    if (Status == EFI_NO_MAPPING) {
+      // Block maps without the indirect block for LogicalBlock; that's a hole as well.
+      Extent.ee_block    = (UINT32)LogicalBlock;
+      Extent.ee_len      = EXT4_EXTENT_MAX_INITIALIZED + 1;
+      Extent.ee_start_hi = 0;
+      Extent.ee_start_lo = EXT4_BLOCK_FILE_HOLE;
+    } else if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Chunk = MultU64x32 ((UINT64)Extent.ee_block + Ext4GetExtentLength (&Extent), BlockSize) - Offset;
+    Chunk = MIN (Chunk, Length);
+
+    if (!EXT4_EXTENT_IS_UNINITIALIZED (&Extent)) {
+      PhysicalBlock = Ext4GetExtentPhysicalStart (&Extent) + (LogicalBlock - Extent.ee_block);
+
+      Status = Ext4WriteDiskIo (Partition, Buffer, (UINTN)Chunk, MultU64x32 (PhysicalBlock, BlockSize) + BlockOff);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    } else if (Ext4GetExtentPhysicalStart (&Extent) != EXT4_BLOCK_FILE_HOLE) {
+      // Converting unwritten extents into written ones isn't supported.
+      Status = EFI_UNSUPPORTED;
+      break;
+    } else {
+      // File hole, allocate as much of it as we're going to write to
+      Wanted = (UINT32)MIN (DivU64x32 (BlockOff + Chunk + BlockSize - 1, BlockSize), EXT4_EXTENT_MAX_INITIALIZED);
+
+      Status = Ext4AllocateBlocks (
+                 Partition,
+                 Ext4GetAllocationGoal (Partition, File, LogicalBlock),
+                 Wanted,
+                 &PhysicalBlock,
+                 &Count
+                 );
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      RunBytes = MultU64x32 (Count, BlockSize);
+      Chunk    = MIN (Chunk, RunBytes - BlockOff);
+
+      if ((Zeroes == NULL) && ((BlockOff != 0) || (BlockOff + Chunk < RunBytes))) {
+        Zeroes = AllocateZeroPool (BlockSize);
+
+        if (Zeroes == NULL) {
+          Ext4FreeBlocks (Partition, PhysicalBlock, Count);
+          Status = EFI_OUT_OF_RESOURCES;
+          break;
+        }
+      }
+
+      // Zero the parts of the first and last blocks we don't write to, so the old
+      // contents of the blocks never become part of the file.
+      if (BlockOff != 0) {
+        Status = Ext4WriteDiskIo (Partition, Zeroes, BlockOff, MultU64x32 (PhysicalBlock, BlockSize));
+      }
+
+      if (!EFI_ERROR (Status)) {
+        Status = Ext4WriteDiskIo (Partition, Buffer, (UINTN)Chunk, MultU64x32 (PhysicalBlock, BlockSize) + BlockOff);
+      }
+
+      if (!EFI_ERROR (Status) && (BlockOff + Chunk < RunBytes)) {
+        Status = Ext4WriteDiskIo (
+                   Partition,
+                   Zeroes,
+                   (UINTN)(RunBytes - BlockOff - Chunk),
+                   MultU64x32 (PhysicalBlock, BlockSize) + BlockOff + Chunk
+                   );
+      }
+
+      Mapped = 0;
+
+      if (!EFI_ERROR (Status)) {
+        Status = Ext4MapBlocks (Partition, File, LogicalBlock, PhysicalBlock, Count, &Mapped);
+      }
+
+      Ext4InodeAddBlocks (Partition, File->Inode, Mapped);
+
+      if (Mapped < Count) {
+        Ext4FreeBlocks (Partition, PhysicalBlock + Mapped, Count - Mapped);
+      }
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    Buffer   += Chunk;
+    Offset   += Chunk;
+    Length   -= (UINTN)Chunk;
+    *Written += (UINTN)Chunk;
+  }
+
+  if (Zeroes != NULL) {
+    FreePool (Zeroes);
+  }
+
+  return Status;
+}
+
+/**
+   Zeroes the end of the block that contains a given offset of a file, if it's mapped.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Offset        Offset of the first byte to zero.
+
+   @return Status of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4ZeroBlockTail (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN UINT64          Offset
+  )
+{
+  EXT4_EXTENT    Extent;
+  EXT4_BLOCK_NR  LogicalBlock;
+  EXT4_BLOCK_NR  PhysicalBlock;
+  UINT32         BlockOff;
+  VOID           *Zeroes;
+  EFI_STATUS     Status;
+
+  LogicalBlock = DivU64x32Remainder (Offset, Partition->BlockSize, &BlockOff);
+
+  if (BlockOff == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = Ext4GetExtent (Partition, File, LogicalBlock, &Extent);
+
+  if ((Status == EFI_NO_MAPPING) || (!EFI_ERROR (Status) && EXT4_EXTENT_IS_UNINITIALIZED (&Extent))) {
+    // Holes and unwritten extents read as zeroes already
+    return EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Zeroes = AllocateZeroPool (Partition->BlockSize - BlockOff);
+
+  if (Zeroes == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  PhysicalBlock = Ext4GetExtentPhysicalStart (&Extent) + (LogicalBlock - Extent.ee_block);
+
+  Status = Ext4WriteDiskIo (
+             Partition,
+             Zeroes,
+             Partition->BlockSize - BlockOff,
+             MultU64x32 (PhysicalBlock, Partition->BlockSize) + BlockOff
+             );
+
+  FreePool (Zeroes);
+  return Status;
+}
+
+/**
+   Sets the size of a file's inode, marking the filesystem as having large files if needed.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Size          New size of the file, in bytes.
+**/
+STATIC
+VOID
+Ext4SetInodeSize (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN UINT64          Size
+  )
+{
+  File->Inode->i_size_lo = (UINT32)Size;
+  File->Inode->i_size_hi = (UINT32)RShiftU64 (Size, 32);
+
+  if ((Size > MAX_INT32) && Ext4FileIsReg (File) && !EXT4_HAS_RO_COMPAT (Partition, EXT4_FEATURE_RO_COMPAT_LARGE_FILE)) {
+    Partition->SuperBlock.s_feature_ro_compat |= EXT4_FEATURE_RO_COMPAT_LARGE_FILE;
+    Partition->FeaturesRoCompat               |= EXT4_FEATURE_RO_COMPAT_LARGE_FILE;
+    Partition->SuperBlockDirty                 = TRUE;
+  }
+}
+
+/**
+   Writes to an EXT4 inode, allocating blocks for the parts of the file that aren't mapped.
+   The file's size is extended if needed, and its inode written back.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the write.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After the write, it's updated to the number of written bytes.
+
+   @return Status of the write operation.
+**/
+EFI_STATUS
+Ext4Write (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  IN     CONST VOID      *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  )
+{
+  UINT64      InodeSize;
+  UINTN       Written;
+  EFI_STATUS  Status;
+
+  DEBUG ((DEBUG_FS, "[ext4] Ext4Write(%s, Offset %lu, Length %lu)\n", File->Dentry->Name, Offset, (UINT64)*Length));
+
+  InodeSize = EXT4_INODE_SIZE (File->Inode);
+  Written   = 0;
+
+  if (*Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (EXT4_HAS_INLINE_DATA (File)) {
+    // Writing to inline data would need to move it to blocks once it outgrows the inode
+    return EFI_UNSUPPORTED;
+  }
+
+  // Logical block numbers are 32-bit
+  if ((Offset + *Length < Offset) ||
+      (DivU64x32 (Offset + *Length - 1, Partition->BlockSize) > MAX_UINT32))
+  {
+    return EFI_VOLUME_FULL;
+  }
+
+  // The bytes between the current end of the file and the write become part of the file
+  if (Offset > InodeSize) {
+    Status = Ext4ZeroBlockTail (Partition, File, InodeSize);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Status = Ext4WriteBlocks (Partition, File, Buffer, Offset, *Length, &Written);
+
+  if (Offset + Written > InodeSize) {
+    Ext4SetInodeSize (Partition, File, Offset + Written);
+  }
+
+  Ext4SetInodeTimes (File->Inode, EXT4_INODE_MTIME | EXT4_INODE_CTIME, NULL);
+
+  // Even on failure, blocks may have been allocated, so the inode must be written back.
+  if (!EFI_ERROR (Status)) {
+    Status = Ext4WriteInode (Partition, File);
+  } else {
+    Ext4WriteInode (Partition, File);
+  }
+
+  *Length = Written;
+  return Status;
+}
+
+/**
+   Changes the size of a file. Shrinking frees the blocks past the new end of the file,
+   growing leaves a hole.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[in]      NewSize       New size of the file, in bytes.
+
+   @return Status of the operation.
+**/
+EFI_STATUS
+Ext4TruncateFile (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File,
+  IN UINT64          NewSize
+  )
+{
+  UINT64         InodeSize;
+  EXT4_BLOCK_NR  FirstBlock;
+  EFI_STATUS     Status;
+
+  InodeSize = EXT4_INODE_SIZE (File->Inode);
+
+  if (EXT4_HAS_INLINE_DATA (File)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (DivU64x32 (NewSize + Partition->BlockSize - 1, Partition->BlockSize) > (UINT64)MAX_UINT32 + 1) {
+    return EFI_VOLUME_FULL;
+  }
+
+  // Zero the end of the (new or old) last block, so it doesn't show up if the file grows again
+  Status = Ext4ZeroBlockTail (Partition, File, MIN (NewSize, InodeSize));
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (NewSize < InodeSize) {
+    FirstBlock = DivU64x32 (NewSize + Partition->BlockSize - 1, Partition->BlockSize);
+
+    if ((File->Inode->i_flags & EXT4_EXTENTS_FL) != 0) {
+      Status = Ext4TruncateExtents (Partition, File, FirstBlock);
+    } else {
+      Status = Ext4TruncateBlockMap (Partition, File, FirstBlock);
+    }
+
+    if (EFI_ERROR (Status)) {
+      // Some blocks may have been freed already
+      Ext4WriteInode (Partition, File);
+      return Status;
+    }
+  }
+
+  Ext4SetInodeSize (Partition, File, NewSize);
+  Ext4SetInodeTimes (File->Inode, EXT4_INODE_MTIME | EXT4_INODE_CTIME, NULL);
+
+  return Ext4WriteInode (Partition, File);
+}
+
 /**
    Allocates a zeroed inode structure.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -315,6 +890,44 @@ Ext4FilePhysicalSpace (
   return MultU64x32 (Blocks, 512);
 }
 
+/**
+   Adds (or, if Blocks is negative, subtracts) filesystem blocks to the inode's i_blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Inode         Pointer to the inode.
+   @param[in]      Blocks        Number of filesystem blocks.
+**/
+VOID
+Ext4InodeAddBlocks (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT EXT4_INODE      *Inode,
+  IN     INT64           Blocks
+  )
+{
+  BOOLEAN  HugeFile;
+  UINT64   Count;
+
+  HugeFile = EXT4_HAS_RO_COMPAT (Partition, EXT4_FEATURE_RO_COMPAT_HUGE_FILE);
+  Count    = Inode->i_blocks;
+
+  if (HugeFile) {
+    Count |= LShiftU64 (Inode->i_osd2.data_linux.l_i_blocks_high, 32);
+  }
+
+  // See Ext4FilePhysicalSpace for the units of i_blocks
+  if (!HugeFile || ((Inode->i_flags & EXT4_HUGE_FILE_FL) == 0)) {
+    Blocks = MultS64x64 (Blocks, Partition->BlockSize / 512);
+  }
+
+  Count += (UINT64)Blocks;
+
+  Inode->i_blocks = (UINT32)Count;
+
+  if (HugeFile) {
+    Inode->i_osd2.data_linux.l_i_blocks_high = (UINT16)RShiftU64 (Count, 32);
+  }
+}
+
 // Copied from EmbeddedPkg at my mentor's request.
 // The lack of comments and good variable names is frightening...
 
@@ -393,9 +1006,13 @@ EpochToEfiTime (
     UINT32      Nanoseconds  = 0;                                \
                                                            \
     if (EXT4_INODE_HAS_FIELD (Inode, Field ## _extra)) {          \
-      SecondsEpoch |= LShiftU64 ((UINT64)(Inode->Field ## _extra & EXT4_EXTRA_TIMESTAMP_MASK), 32); \
+      /* The 32-bit field is signed, the epoch bits are added to it */                        \
+      SecondsEpoch = (UINT64)(INT64)(INT32)Inode->Field;                                      \
+      SecondsEpoch += LShiftU64 ((UINT64)(Inode->Field ## _extra & EXT4_EXTRA_TIMESTAMP_MASK), 32); \
       Nanoseconds   = Inode->Field ## _extra >> 2;                                            \
     }                                                                                       \
+    /* ext4 timestamps are in UTC, EpochToEfiTime leaves TimeZone and Daylight alone */     \
+    ZeroMem (Time, sizeof (EFI_TIME));                                                      \
     EpochToEfiTime ((UINTN)SecondsEpoch, Time);                                                     \
     Time->Nanosecond = Nanoseconds;                                                         \
   }
@@ -453,6 +1070,109 @@ Ext4FileCreateTime (
   Ext4FileCrTime (File, Time);
 }
 
+/**
+   Converts an EFI_TIME to seconds since the Epoch (1970 JANUARY 01, 00:00:00 UTC).
+
+   @param[in]   Time   Pointer to the time.
+
+   @return Seconds since the Epoch. Times before the Epoch are clamped to it.
+**/
+STATIC
+UINT64
+Ext4EfiTimeToEpoch (
+  IN CONST EFI_TIME  *Time
+  )
+{
+  INT64  Year;
+  INT64  Month;
+  INT64  Days;
+  INT64  Seconds;
+
+  // Count the years from March, so the leap day is the last day of the year
+  Year  = Time->Year;
+  Month = Time->Month;
+
+  if (Month <= 2) {
+    Year--;
+    Month += 12;
+  }
+
+  // 719468 is the number of days from 0000-03-01 to 1970-01-01
+  Days = 365 * Year + DivS64x64Remainder (Year, 4, NULL) - DivS64x64Remainder (Year, 100, NULL)
+         + DivS64x64Remainder (Year, 400, NULL) + DivS64x64Remainder (153 * (Month - 3) + 2, 5, NULL)
+         + Time->Day - 1 - 719468;
+
+  Seconds = MultS64x64 (Days, 86400) + Time->Hour * 3600 + Time->Minute * 60 + Time->Second;
+
+  // Localtime = UTC - TimeZone
+  if (Time->TimeZone != EFI_UNSPECIFIED_TIMEZONE) {
+    Seconds += Time->TimeZone * 60;
+  }
+
+  return Seconds < 0 ? 0 : (UINT64)Seconds;
+}
+
+/**
+   Sets timestamps of an inode.
+
+   @param[in out]  Inode         Pointer to the inode.
+   @param[in]      Which         Timestamps to set, EXT4_INODE_*TIME.
+   @param[in]      Time          Pointer to the new time, or NULL to use the current time.
+**/
+VOID
+Ext4SetInodeTimes (
+  IN OUT EXT4_INODE      *Inode,
+  IN     UINT32          Which,
+  IN     CONST EFI_TIME  *Time OPTIONAL
+  )
+{
+  EFI_TIME  Now;
+  UINT64    Seconds;
+  UINT32    Extra;
+
+  if (Time == NULL) {
+    if (EFI_ERROR (gRT->GetTime (&Now, NULL))) {
+      return;
+    }
+
+    Time = &Now;
+  }
+
+  Seconds = Ext4EfiTimeToEpoch (Time);
+
+  // The 32-bit field is signed, the epoch bits extend it past 2038
+  Extra = ((UINT32)RShiftU64 (Seconds + BIT31, 32) & EXT4_EXTRA_TIMESTAMP_MASK) | (Time->Nanosecond << 2);
+
+  if ((Which & EXT4_INODE_ATIME) != 0) {
+    Inode->i_atime = (UINT32)Seconds;
+
+    if (EXT4_INODE_HAS_FIELD (Inode, i_atime_extra)) {
+      Inode->i_atime_extra = Extra;
+    }
+  }
+
+  if ((Which & EXT4_INODE_CTIME) != 0) {
+    Inode->i_ctime = (UINT32)Seconds;
+
+    if (EXT4_INODE_HAS_FIELD (Inode, i_ctime_extra)) {
+      Inode->i_ctime_extra = Extra;
+    }
+  }
+
+  if ((Which & EXT4_INODE_MTIME) != 0) {
+    Inode->i_mtime = (UINT32)Seconds;
+
+    if (EXT4_INODE_HAS_FIELD (Inode, i_mtime_extra)) {
+      Inode->i_mtime_extra = Extra;
+    }
+  }
+
+  if (((Which & EXT4_INODE_CRTIME) != 0) && EXT4_INODE_HAS_FIELD (Inode, i_crtime_extra)) {
+    Inode->i_crtime       = (UINT32)Seconds;
+    Inode->i_crtime_extra = Extra;
+  }
+}
+
 /**
    Checks if the checksum of the inode is correct.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -0,0 +1,927 @@
+/** @file
+  Journal (JBD2) replay.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  When a filesystem wasn't cleanly unmounted (EXT4_FEATURE_INCOMPAT_RECOVER), the latest
+  metadata changes may only be in the journal. Ext4Dxe never writes to the disk, so instead
+  of replaying the journal in place, committed transactions are replayed into an overlay of
+  blocks kept in memory, which Ext4ReadDiskIo consults on every read.
+
+  Like the Linux kernel's recovery code, the log is walked three times: the first pass finds
+  the end of the log (the last committed transaction), the second collects revoked blocks and
+  the third copies every logged block that wasn't revoked by the same or a later transaction
+  into the overlay.
+  Fast commits are not replayed, since they're logical (not block) updates; the overlay then
+  reflects the last full commit, which is still consistent.
+**/
+
+#include "Ext4Dxe.h"
+
+typedef enum {
+  EXT4_JOURNAL_PASS_SCAN = 0,
+  EXT4_JOURNAL_PASS_REVOKE,
+  EXT4_JOURNAL_PASS_REPLAY
+} EXT4_JOURNAL_PASS;
+
+// Entry of the overlay and of the revoke table, keyed by filesystem block number
+typedef struct {
+  EXT4_BLOCK_NR    Block;
+  // Revoke table only: latest transaction that revoked the block
+  UINT32           Sequence;
+} EXT4_JOURNAL_BLOCK;
+
+// Overlay entries are followed by the block's contents
+#define EXT4_JOURNAL_BLOCK_DATA(Entry)  ((UINT8 *)((Entry) + 1))
+
+#define EXT4_JOURNAL_SUPPORTED_INCOMPAT                                         \
+  (JBD2_FEATURE_INCOMPAT_REVOKE | JBD2_FEATURE_INCOMPAT_64BIT |                 \
+   JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | JBD2_FEATURE_INCOMPAT_CSUM_V2 |         \
+   JBD2_FEATURE_INCOMPAT_CSUM_V3 | JBD2_FEATURE_INCOMPAT_FAST_COMMIT)
+
+// Number of fast commit blocks when the journal superblock doesn't specify it
+#define EXT4_JOURNAL_DEFAULT_FC_BLOCKS  256
+
+// Sequence numbers wrap around, so they must be compared like this
+#define EXT4_JOURNAL_SEQ_AFTER(A, B)  ((INT32)((A) - (B)) > 0)
+
+typedef struct {
+  EXT4_PARTITION        *Partition;
+
+  // The journal inode, opened just enough to map its blocks
+  EXT4_FILE             File;
+
+  // Log blocks are in [First, Last)
+  UINT32                First;
+  UINT32                Last;
+  UINT32                Start;
+  UINT32                StartSequence;
+  // First transaction that wasn't committed
+  UINT32                EndSequence;
+
+  UINT32                Features;
+  UINTN                 TagSize;
+  UINTN                 TailSize;
+
+  ORDERED_COLLECTION    *Revoked;
+  ORDERED_COLLECTION    *Overlay;
+  UINTN                 OverlayBlocks;
+
+  // Holds the current log block
+  UINT8                 *Buffer;
+} EXT4_JOURNAL;
+
+/**
+  Compare two EXT4_JOURNAL_BLOCK structures.
+  Used in the overlay's and revoke table's ORDERED_COLLECTION.
+
+  @param[in] UserStruct1  Pointer to the first user structure.
+
+  @param[in] UserStruct2  Pointer to the second user structure.
+
+  @retval <0  If UserStruct1 compares less than UserStruct2.
+
+  @retval  0  If UserStruct1 compares equal to UserStruct2.
+
+  @retval >0  If UserStruct1 compares greater than UserStruct2.
+**/
+STATIC
+INTN
+EFIAPI
+Ext4JournalBlockStructCompare (
+  IN CONST VOID  *UserStruct1,
+  IN CONST VOID  *UserStruct2
+  )
+{
+  CONST EXT4_JOURNAL_BLOCK  *Block1;
+  CONST EXT4_JOURNAL_BLOCK  *Block2;
+
+  Block1 = UserStruct1;
+  Block2 = UserStruct2;
+
+  return Block1->Block < Block2->Block ? -1 :
+         Block1->Block > Block2->Block ? 1 : 0;
+}
+
+/**
+  Compare a standalone key against a EXT4_JOURNAL_BLOCK containing an embedded key.
+  Used in the overlay's and revoke table's ORDERED_COLLECTION.
+
+  @param[in] StandaloneKey  Pointer to the bare key, an EXT4_BLOCK_NR.
+
+  @param[in] UserStruct     Pointer to the user structure with the embedded
+                            key.
+
+  @retval <0  If StandaloneKey compares less than UserStruct's key.
+
+  @retval  0  If StandaloneKey compares equal to UserStruct's key.
+
+  @retval >0  If StandaloneKey compares greater than UserStruct's key.
+**/
+STATIC
+INTN
+EFIAPI
+Ext4JournalBlockKeyCompare (
+  IN CONST VOID  *StandaloneKey,
+  IN CONST VOID  *UserStruct
+  )
+{
+  CONST EXT4_JOURNAL_BLOCK  *Entry;
+  EXT4_BLOCK_NR             Block;
+
+  // Block numbers may not fit in a pointer on 32-bit architectures, so the key is passed by reference
+  Entry = UserStruct;
+  Block = *(CONST EXT4_BLOCK_NR *)StandaloneKey;
+
+  return Block < Entry->Block ? -1 :
+         Block > Entry->Block ? 1 : 0;
+}
+
+/**
+   Frees an overlay or revoke table, along with every entry in it.
+
+   @param[in]      Collection  Pointer to the collection, may be NULL.
+**/
+STATIC
+VOID
+Ext4JournalFreeCollection (
+  IN ORDERED_COLLECTION  *Collection
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *MinEntry;
+  EXT4_JOURNAL_BLOCK        *Entry;
+
+  if (Collection == NULL) {
+    return;
+  }
+
+  while ((MinEntry = OrderedCollectionMin (Collection)) != NULL) {
+    OrderedCollectionDelete (Collection, MinEntry, (VOID **)&Entry);
+    FreePool (Entry);
+  }
+
+  OrderedCollectionUninit (Collection);
+}
+
+/**
+   Gets the block following a log block, wrapping around at the end of the log.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      LogBlock    Block of the journal.
+
+   @return The next log block.
+**/
+STATIC
+UINT32
+Ext4JournalNextBlock (
+  IN CONST EXT4_JOURNAL  *Journal,
+  IN UINT32              LogBlock
+  )
+{
+  LogBlock++;
+
+  if (LogBlock >= Journal->Last) {
+    LogBlock = Journal->First;
+  }
+
+  return LogBlock;
+}
+
+/**
+   Reads a block of the journal.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      LogBlock    Block of the journal (a logical block of the journal inode).
+   @param[out]     Buffer      Pointer to the destination buffer, a block long.
+
+   @return Status of the read.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalReadBlock (
+  IN  EXT4_JOURNAL  *Journal,
+  IN  UINT32        LogBlock,
+  OUT VOID          *Buffer
+  )
+{
+  EXT4_PARTITION  *Partition;
+  EXT4_EXTENT     Extent;
+  EXT4_BLOCK_NR   Block;
+  EFI_STATUS      Status;
+
+  Partition = Journal->Partition;
+
+  Status = Ext4GetExtent (Partition, &Journal->File, LogBlock, &Extent);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // The journal is fully allocated and initialized when it's created
+  if (EXT4_EXTENT_IS_UNINITIALIZED (&Extent)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Block = (LShiftU64 (Extent.ee_start_hi, 32) | Extent.ee_start_lo) + (LogBlock - Extent.ee_block);
+
+  // The log is read sequentially, so read ahead up to the end of the extent.
+  return Ext4ReadAheadDiskIo (
+           Partition,
+           Buffer,
+           Partition->BlockSize,
+           EXT4_BLOCK_TO_BYTES (Partition, Block),
+           (UINTN)MultU64x32 (Extent.ee_block + Extent.ee_len - LogBlock, Partition->BlockSize)
+           );
+}
+
+/**
+   Checks if a block was revoked by a transaction, or by a later one.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      Block       Filesystem block number.
+   @param[in]      Sequence    Transaction that logged the block.
+
+   @return TRUE if the logged block must not be replayed, else FALSE.
+**/
+STATIC
+BOOLEAN
+Ext4JournalIsRevoked (
+  IN CONST EXT4_JOURNAL  *Journal,
+  IN EXT4_BLOCK_NR       Block,
+  IN UINT32              Sequence
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  EXT4_JOURNAL_BLOCK        *Revoke;
+
+  Entry = OrderedCollectionFind (Journal->Revoked, &Block);
+
+  if (Entry == NULL) {
+    return FALSE;
+  }
+
+  Revoke = OrderedCollectionUserStruct (Entry);
+
+  return !EXT4_JOURNAL_SEQ_AFTER (Sequence, Revoke->Sequence);
+}
+
+/**
+   Records the revocation of a block by a transaction.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      Block       Filesystem block number.
+   @param[in]      Sequence    Transaction that revoked the block.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalSetRevoked (
+  IN EXT4_JOURNAL   *Journal,
+  IN EXT4_BLOCK_NR  Block,
+  IN UINT32         Sequence
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  EXT4_JOURNAL_BLOCK        *Revoke;
+  EFI_STATUS                Status;
+
+  Entry = OrderedCollectionFind (Journal->Revoked, &Block);
+
+  if (Entry != NULL) {
+    Revoke = OrderedCollectionUserStruct (Entry);
+
+    if (EXT4_JOURNAL_SEQ_AFTER (Sequence, Revoke->Sequence)) {
+      Revoke->Sequence = Sequence;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  Revoke = AllocatePool (sizeof (EXT4_JOURNAL_BLOCK));
+
+  if (Revoke == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Revoke->Block    = Block;
+  Revoke->Sequence = Sequence;
+
+  Status = OrderedCollectionInsert (Journal->Revoked, NULL, Revoke);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Revoke);
+  }
+
+  return Status;
+}
+
+/**
+   Copies a logged block into the overlay, replacing any older copy of it.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      Block       Filesystem block number.
+   @param[in]      LogBlock    Block of the journal that holds the block's contents.
+   @param[in]      Escaped     Whether the block's magic number was escaped (JBD2_FLAG_ESCAPE).
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalReplayBlock (
+  IN EXT4_JOURNAL   *Journal,
+  IN EXT4_BLOCK_NR  Block,
+  IN UINT32         LogBlock,
+  IN BOOLEAN        Escaped
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  EXT4_JOURNAL_BLOCK        *Replayed;
+  EFI_STATUS                Status;
+
+  if (Block >= Journal->Partition->NumberBlocks) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Journal logs out of range block %lu\n", Block));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Entry = OrderedCollectionFind (Journal->Overlay, &Block);
+
+  if (Entry != NULL) {
+    Replayed = OrderedCollectionUserStruct (Entry);
+  } else {
+    Replayed = AllocatePool (sizeof (EXT4_JOURNAL_BLOCK) + Journal->Partition->BlockSize);
+
+    if (Replayed == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Replayed->Block    = Block;
+    Replayed->Sequence = 0;
+
+    Status = OrderedCollectionInsert (Journal->Overlay, NULL, Replayed);
+
+    if (EFI_ERROR (Status)) {
+      FreePool (Replayed);
+      return Status;
+    }
+
+    Journal->OverlayBlocks++;
+  }
+
+  Status = Ext4JournalReadBlock (Journal, LogBlock, EXT4_JOURNAL_BLOCK_DATA (Replayed));
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Escaped) {
+    *(UINT32 *)EXT4_JOURNAL_BLOCK_DATA (Replayed) = SwapBytes32 (JBD2_MAGIC_NUMBER);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Processes the tags of a descriptor block, which is in the journal's buffer.
+   The logged blocks follow the descriptor block, one per tag.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      Pass        Current pass.
+   @param[in]      Sequence    Transaction the descriptor block belongs to.
+   @param[in out]  LogBlock    Block following the descriptor block. On return, the block
+                               following the last logged block.
+   @param[in out]  Visited     Number of log blocks visited in this pass.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalProcessDescriptor (
+  IN     EXT4_JOURNAL       *Journal,
+  IN     EXT4_JOURNAL_PASS  Pass,
+  IN     UINT32             Sequence,
+  IN OUT UINT32             *LogBlock,
+  IN OUT UINT32             *Visited
+  )
+{
+  JBD2_BLOCK_TAG   Tag;
+  JBD2_BLOCK_TAG3  Tag3;
+  UINTN            Offset;
+  UINTN            Limit;
+  UINT32           Flags;
+  EXT4_BLOCK_NR    Block;
+  EFI_STATUS       Status;
+
+  Limit  = Journal->Partition->BlockSize - Journal->TailSize;
+  Offset = sizeof (JBD2_HEADER);
+
+  while (Offset + Journal->TagSize <= Limit) {
+    // Tags aren't necessarily aligned, and may be shorter than the structures.
+    if ((Journal->Features & JBD2_FEATURE_INCOMPAT_CSUM_V3) != 0) {
+      CopyMem (&Tag3, Journal->Buffer + Offset, sizeof (JBD2_BLOCK_TAG3));
+      Flags = SwapBytes32 (Tag3.t_flags);
+      Block = SwapBytes32 (Tag3.t_blocknr);
+
+      if ((Journal->Features & JBD2_FEATURE_INCOMPAT_64BIT) != 0) {
+        Block |= LShiftU64 (SwapBytes32 (Tag3.t_blocknr_high), 32);
+      }
+    } else {
+      ZeroMem (&Tag, sizeof (JBD2_BLOCK_TAG));
+      CopyMem (&Tag, Journal->Buffer + Offset, MIN (Journal->TagSize, sizeof (JBD2_BLOCK_TAG)));
+      Flags = SwapBytes16 (Tag.t_flags);
+      Block = SwapBytes32 (Tag.t_blocknr);
+
+      if ((Journal->Features & JBD2_FEATURE_INCOMPAT_64BIT) != 0) {
+        Block |= LShiftU64 (SwapBytes32 (Tag.t_blocknr_high), 32);
+      }
+    }
+
+    if (*Visited >= Journal->Last - Journal->First) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    if ((Pass == EXT4_JOURNAL_PASS_REPLAY) && !Ext4JournalIsRevoked (Journal, Block, Sequence)) {
+      Status = Ext4JournalReplayBlock (Journal, Block, *LogBlock, (Flags & JBD2_FLAG_ESCAPE) != 0);
+
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    *LogBlock = Ext4JournalNextBlock (Journal, *LogBlock);
+    (*Visited)++;
+
+    if ((Flags & JBD2_FLAG_LAST_TAG) != 0) {
+      break;
+    }
+
+    Offset += Journal->TagSize;
+
+    if ((Flags & JBD2_FLAG_SAME_UUID) == 0) {
+      Offset += 16;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Collects the blocks revoked by a revoke block, which is in the journal's buffer.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      Sequence    Transaction the revoke block belongs to.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalProcessRevoke (
+  IN EXT4_JOURNAL  *Journal,
+  IN UINT32        Sequence
+  )
+{
+  JBD2_REVOKE_HEADER  *Header;
+  UINTN               Count;
+  UINTN               Offset;
+  UINTN               RecordSize;
+  EXT4_BLOCK_NR       Block;
+  EFI_STATUS          Status;
+
+  Header = (JBD2_REVOKE_HEADER *)Journal->Buffer;
+  Count  = SwapBytes32 (Header->r_count);
+
+  if ((Count < sizeof (JBD2_REVOKE_HEADER)) || (Count > Journal->Partition->BlockSize - Journal->TailSize)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  RecordSize = (Journal->Features & JBD2_FEATURE_INCOMPAT_64BIT) != 0 ? sizeof (UINT64) : sizeof (UINT32);
+
+  // Records start right after the 16 byte header, so they're naturally aligned.
+  for (Offset = sizeof (JBD2_REVOKE_HEADER); Offset + RecordSize <= Count; Offset += RecordSize) {
+    if (RecordSize == sizeof (UINT64)) {
+      Block = SwapBytes64 (*(UINT64 *)(Journal->Buffer + Offset));
+    } else {
+      Block = SwapBytes32 (*(UINT32 *)(Journal->Buffer + Offset));
+    }
+
+    Status = Ext4JournalSetRevoked (Journal, Block, Sequence);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Walks the log, from its start to its end.
+
+   @param[in]      Journal     Pointer to the journal.
+   @param[in]      Pass        The pass. EXT4_JOURNAL_PASS_SCAN finds the end of the log,
+                               which the other passes stop at.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalPass (
+  IN EXT4_JOURNAL       *Journal,
+  IN EXT4_JOURNAL_PASS  Pass
+  )
+{
+  JBD2_HEADER  *Header;
+  UINT32       Sequence;
+  UINT32       LogBlock;
+  UINT32       Visited;
+  BOOLEAN      EndOfLog;
+  EFI_STATUS   Status;
+
+  Header   = (JBD2_HEADER *)Journal->Buffer;
+  Sequence = Journal->StartSequence;
+  LogBlock = Journal->Start;
+  Visited  = 0;
+  EndOfLog = FALSE;
+
+  // Every log block is visited at most once, so corrupted journals can't make us loop forever.
+  while (!EndOfLog && (Visited < Journal->Last - Journal->First)) {
+    if ((Pass != EXT4_JOURNAL_PASS_SCAN) && (Sequence == Journal->EndSequence)) {
+      break;
+    }
+
+    Status = Ext4JournalReadBlock (Journal, LogBlock, Journal->Buffer);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    // Anything that isn't a block of the expected transaction marks the end of the log.
+    if ((SwapBytes32 (Header->h_magic) != JBD2_MAGIC_NUMBER) || (SwapBytes32 (Header->h_sequence) != Sequence)) {
+      break;
+    }
+
+    LogBlock = Ext4JournalNextBlock (Journal, LogBlock);
+    Visited++;
+
+    switch (SwapBytes32 (Header->h_blocktype)) {
+      case JBD2_DESCRIPTOR_BLOCK:
+        Status = Ext4JournalProcessDescriptor (Journal, Pass, Sequence, &LogBlock, &Visited);
+        break;
+      case JBD2_COMMIT_BLOCK:
+        Sequence++;
+        Status = EFI_SUCCESS;
+        break;
+      case JBD2_REVOKE_BLOCK:
+        Status = Pass == EXT4_JOURNAL_PASS_REVOKE ? Ext4JournalProcessRevoke (Journal, Sequence) : EFI_SUCCESS;
+        break;
+      default:
+        EndOfLog = TRUE;
+        Status   = EFI_SUCCESS;
+        break;
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (Pass == EXT4_JOURNAL_PASS_SCAN) {
+    Journal->EndSequence = Sequence;
+  } else if (Sequence != Journal->EndSequence) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "[ext4] Journal pass %u ended at transaction %u, expected %u\n",
+      Pass,
+      Sequence,
+      Journal->EndSequence
+      ));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads and validates the journal superblock.
+
+   @param[in out]  Journal     Pointer to the journal, with an opened journal inode.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4JournalReadSuperblock (
+  IN OUT EXT4_JOURNAL  *Journal
+  )
+{
+  JBD2_SUPERBLOCK  *Jsb;
+  EFI_STATUS       Status;
+  UINT32           BlockType;
+  UINT32           MaxLen;
+  UINT32           FcBlocks;
+  UINT64           InodeBlocks;
+
+  // The journal's block size is the filesystem's, so the (1024 byte) superblock always fits.
+  Status = Ext4JournalReadBlock (Journal, 0, Journal->Buffer);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Jsb       = (JBD2_SUPERBLOCK *)Journal->Buffer;
+  BlockType = SwapBytes32 (Jsb->s_header.h_blocktype);
+
+  if ((SwapBytes32 (Jsb->s_header.h_magic) != JBD2_MAGIC_NUMBER) ||
+      ((BlockType != JBD2_SUPERBLOCK_V1) && (BlockType != JBD2_SUPERBLOCK_V2)))
+  {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (SwapBytes32 (Jsb->s_blocksize) != Journal->Partition->BlockSize) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Journal->Features = BlockType == JBD2_SUPERBLOCK_V2 ? SwapBytes32 (Jsb->s_feature_incompat) : 0;
+
+  if ((Journal->Features & ~EXT4_JOURNAL_SUPPORTED_INCOMPAT) != 0) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "[ext4] Unsupported journal features %x\n",
+      Journal->Features & ~EXT4_JOURNAL_SUPPORTED_INCOMPAT
+      ));
+    return EFI_UNSUPPORTED;
+  }
+
+  MaxLen         = SwapBytes32 (Jsb->s_maxlen);
+  Journal->First = SwapBytes32 (Jsb->s_first);
+  Journal->Last  = MaxLen;
+
+  if ((Journal->Features & JBD2_FEATURE_INCOMPAT_FAST_COMMIT) != 0) {
+    // Fast commit blocks sit at the end of the journal, after the log.
+    FcBlocks = SwapBytes32 (Jsb->s_num_fc_blks);
+
+    if (FcBlocks == 0) {
+      FcBlocks = EXT4_JOURNAL_DEFAULT_FC_BLOCKS;
+    }
+
+    Journal->Last = MaxLen > FcBlocks ? MaxLen - FcBlocks : 0;
+  }
+
+  InodeBlocks = DivU64x32 (EXT4_INODE_SIZE (Journal->File.Inode), Journal->Partition->BlockSize);
+
+  if ((Journal->First == 0) || (Journal->First >= Journal->Last) || (MaxLen > InodeBlocks)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Journal->Start         = SwapBytes32 (Jsb->s_start);
+  Journal->StartSequence = SwapBytes32 (Jsb->s_sequence);
+
+  // s_start == 0 means the journal is empty
+  if ((Journal->Start != 0) && ((Journal->Start < Journal->First) || (Journal->Start >= Journal->Last))) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if ((Journal->Features & JBD2_FEATURE_INCOMPAT_CSUM_V3) != 0) {
+    Journal->TagSize = sizeof (JBD2_BLOCK_TAG3);
+  } else {
+    Journal->TagSize = sizeof (JBD2_BLOCK_TAG);
+
+    if ((Journal->Features & JBD2_FEATURE_INCOMPAT_CSUM_V2) != 0) {
+      Journal->TagSize += sizeof (UINT16);
+    }
+
+    if ((Journal->Features & JBD2_FEATURE_INCOMPAT_64BIT) == 0) {
+      Journal->TagSize -= sizeof (UINT32);
+    }
+  }
+
+  if ((Journal->Features & (JBD2_FEATURE_INCOMPAT_CSUM_V2 | JBD2_FEATURE_INCOMPAT_CSUM_V3)) != 0) {
+    Journal->TailSize = sizeof (JBD2_BLOCK_TAIL);
+  } else {
+    Journal->TailSize = 0;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Replays the partition's journal into an in-memory overlay of blocks.
+   The journal and the disk are never written to; instead, every later read of a
+   replayed block returns the journal's copy of it.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition, with valid block group
+                                 descriptors.
+
+   @retval EFI_SUCCESS             The journal was replayed, or there was nothing to replay.
+   @retval EFI_UNSUPPORTED         The journal is external or uses unsupported features.
+   @retval EFI_VOLUME_CORRUPTED    The journal is corrupted.
+   @retval EFI_OUT_OF_RESOURCES    Failed to allocate memory.
+**/
+EFI_STATUS
+Ext4ReplayJournal (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_JOURNAL  Journal;
+  EFI_STATUS    Status;
+
+  if (!EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_RECOVER)) {
+    return EFI_SUCCESS;
+  }
+
+  if (!EXT4_HAS_COMPAT (Partition, EXT3_FEATURE_COMPAT_HAS_JOURNAL)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (Partition->SuperBlock.s_journal_inum == 0) {
+    DEBUG ((DEBUG_WARN, "[ext4] External journals are not supported\n"));
+    return EFI_UNSUPPORTED;
+  }
+
+  ZeroMem (&Journal, sizeof (EXT4_JOURNAL));
+  Journal.Partition      = Partition;
+  Journal.File.Partition = Partition;
+  Journal.File.InodeNum  = Partition->SuperBlock.s_journal_inum;
+
+  Status = Ext4ReadInode (Partition, Journal.File.InodeNum, &Journal.File.Inode);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Ext4InitExtentsMap (&Journal.File);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Journal.Buffer  = AllocatePool (Partition->BlockSize);
+  Journal.Revoked = OrderedCollectionInit (Ext4JournalBlockStructCompare, Ext4JournalBlockKeyCompare);
+  Journal.Overlay = OrderedCollectionInit (Ext4JournalBlockStructCompare, Ext4JournalBlockKeyCompare);
+
+  if ((Journal.Buffer == NULL) || (Journal.Revoked == NULL) || (Journal.Overlay == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Out;
+  }
+
+  Status = Ext4JournalReadSuperblock (&Journal);
+
+  if (EFI_ERROR (Status) || (Journal.Start == 0)) {
+    goto Out;
+  }
+
+  Status = Ext4JournalPass (&Journal, EXT4_JOURNAL_PASS_SCAN);
+
+  if (!EFI_ERROR (Status)) {
+    Status = Ext4JournalPass (&Journal, EXT4_JOURNAL_PASS_REVOKE);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = Ext4JournalPass (&Journal, EXT4_JOURNAL_PASS_REPLAY);
+  }
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "[ext4] Replayed %u transactions (%lu blocks) from the journal\n",
+    Journal.EndSequence - Journal.StartSequence,
+    (UINT64)Journal.OverlayBlocks
+    ));
+
+  if (Journal.OverlayBlocks != 0) {
+    Partition->JournalOverlay       = Journal.Overlay;
+    Partition->JournalOverlayBlocks = Journal.OverlayBlocks;
+    Journal.Overlay                 = NULL;
+
+    // Cached copies of replayed blocks are now stale.
+    Ext4InvalidateBlockCache (Partition);
+  }
+
+Out:
+  // Log blocks won't be read again.
+  Ext4FreeReadAhead (Partition);
+
+  Ext4JournalFreeCollection (Journal.Overlay);
+  Ext4JournalFreeCollection (Journal.Revoked);
+
+  if (Journal.Buffer != NULL) {
+    FreePool (Journal.Buffer);
+  }
+
+  if (Journal.File.ExtentsMap != NULL) {
+    Ext4FreeExtentsMap (&Journal.File);
+  }
+
+  FreePool (Journal.File.Inode);
+
+  return Status;
+}
+
+/**
+   Copies the part of a replayed block that overlaps a disk read into its buffer.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Replayed      Pointer to the replayed block.
+   @param[in out]  Buffer        Pointer to the buffer, holding the data read from disk.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the data in the disk.
+**/
+STATIC
+VOID
+Ext4JournalCopyOverlayBlock (
+  IN     EXT4_PARTITION            *Partition,
+  IN     CONST EXT4_JOURNAL_BLOCK  *Replayed,
+  IN OUT VOID                      *Buffer,
+  IN     UINTN                     Length,
+  IN     UINT64                    Offset
+  )
+{
+  UINT64  BlockOffset;
+  UINT64  Start;
+  UINT64  End;
+
+  BlockOffset = EXT4_BLOCK_TO_BYTES (Partition, Replayed->Block);
+  Start       = MAX (BlockOffset, Offset);
+  End         = MIN (BlockOffset + Partition->BlockSize, Offset + Length);
+
+  CopyMem (
+    (UINT8 *)Buffer + (Start - Offset),
+    EXT4_JOURNAL_BLOCK_DATA (Replayed) + (Start - BlockOffset),
+    (UINTN)(End - Start)
+    );
+}
+
+/**
+   Copies the replayed journal blocks that overlap a disk read into its buffer.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Buffer        Pointer to the buffer, holding the data read from disk.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the data in the disk.
+**/
+VOID
+Ext4JournalApplyOverlay (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT VOID            *Buffer,
+  IN     UINTN           Length,
+  IN     UINT64          Offset
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  EXT4_JOURNAL_BLOCK        *Replayed;
+  EXT4_BLOCK_NR             FirstBlock;
+  EXT4_BLOCK_NR             LastBlock;
+  EXT4_BLOCK_NR             Block;
+
+  if ((Partition->JournalOverlay == NULL) || (Length == 0)) {
+    return;
+  }
+
+  FirstBlock = DivU64x32 (Offset, Partition->BlockSize);
+  LastBlock  = DivU64x32 (Offset + Length - 1, Partition->BlockSize);
+
+  if (LastBlock - FirstBlock < Partition->JournalOverlayBlocks) {
+    // Small read, look up each of its blocks
+    for (Block = FirstBlock; Block <= LastBlock; Block++) {
+      Entry = OrderedCollectionFind (Partition->JournalOverlay, &Block);
+
+      if (Entry != NULL) {
+        Ext4JournalCopyOverlayBlock (Partition, OrderedCollectionUserStruct (Entry), Buffer, Length, Offset);
+      }
+    }
+
+    return;
+  }
+
+  // Large read, walk the (sorted) overlay instead
+  for (Entry = OrderedCollectionMin (Partition->JournalOverlay); Entry != NULL; Entry = OrderedCollectionNext (Entry)) {
+    Replayed = OrderedCollectionUserStruct (Entry);
+
+    if (Replayed->Block > LastBlock) {
+      break;
+    }
+
+    if (Replayed->Block >= FirstBlock) {
+      Ext4JournalCopyOverlayBlock (Partition, Replayed, Buffer, Length, Offset);
+    }
+  }
+}
+
+/**
+   Frees the partition's journal overlay.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeJournal (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  Ext4JournalFreeCollection (Partition->JournalOverlay);
+  Partition->JournalOverlay       = NULL;
+  Partition->JournalOverlayBlocks = 0;
+}
@@ -89,6 +89,7 @@ Ext4SetupFile (
   File->Protocol.GetPosition = Ext4GetPosition;
   File->Protocol.GetInfo     = Ext4GetInfo;
   File->Protocol.SetInfo     = Ext4SetInfo;
+  File->Protocol.Flush       = Ext4Flush;
 
   File->Partition = Partition;
 }
@@ -109,6 +110,7 @@ Ext4UnmountAndFreePartition (
   LIST_ENTRY  *NextEntry;
   EXT4_FILE   *File;
   BOOLEAN     DeletedRootDentry;
+  EFI_STATUS  Status;
 
   Partition->Unmounting = TRUE;
   Ext4CloseInternal (Partition->Root);
@@ -119,12 +121,24 @@ Ext4UnmountAndFreePartition (
     Ext4CloseInternal (File);
   }
 
+  if (!Partition->ReadOnly) {
+    Status = Ext4FlushPartition (Partition);
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "[ext4] Failed to write back metadata on unmount - %r\n", Status));
+    }
+  }
+
   DeletedRootDentry = Ext4UnrefDentry (Partition->RootDentry);
 
   if (!DeletedRootDentry) {
     DEBUG ((DEBUG_ERROR, "[ext4] Failed to delete root dentry - resource leak present.\n"));
   }
 
+  Ext4FreeBlockCache (Partition);
+  Ext4FreeReadAhead (Partition);
+  Ext4FreeJournal (Partition);
+  Ext4FreeDirtyBlocks (Partition);
   FreePool (Partition->BlockGroups);
   FreePool (Partition);
 
@@ -18,21 +18,23 @@ STATIC CONST UINT32  gSupportedIncompatFeat =
   EXT4_FEATURE_INCOMPAT_64BIT | EXT4_FEATURE_INCOMPAT_DIRDATA |
   EXT4_FEATURE_INCOMPAT_FLEX_BG | EXT4_FEATURE_INCOMPAT_FILETYPE |
   EXT4_FEATURE_INCOMPAT_EXTENTS | EXT4_FEATURE_INCOMPAT_LARGEDIR |
-  EXT4_FEATURE_INCOMPAT_MMP | EXT4_FEATURE_INCOMPAT_RECOVER | EXT4_FEATURE_INCOMPAT_CSUM_SEED;
+  EXT4_FEATURE_INCOMPAT_MMP | EXT4_FEATURE_INCOMPAT_RECOVER | EXT4_FEATURE_INCOMPAT_CSUM_SEED |
+  EXT4_FEATURE_INCOMPAT_INLINE_DATA;
 
 // Future features that may be nice additions in the future:
-// 1) Btree support: Required for write support and would speed up lookups in large directories.
+// 1) Btree support: Splitting full hash tree index nodes on writes (lookups already use the
+//    hash tree index, and entries are added to it as long as the index node has room).
 // 2) meta_bg: Required to mount meta_bg-enabled partitions.
 
-// Note: We ignore MMP because it's impossible that it's mapped elsewhere,
+// Note: We ignore MMP when reading because it's impossible that it's mapped elsewhere,
 // I think (unless there's some sort of network setup where we're accessing a remote partition).
+// Since we don't update the MMP block, MMP filesystems are mounted read-only though.
 
 // Note on corruption signaling:
 // We (Ext4Dxe) could signal corruption by setting s_state to |= EXT4_FS_STATE_ERRORS_DETECTED.
-// I've decided against that, because right now the driver is read-only, and
-// that would mean we would need to writeback the superblock. If something like
-// this is desired, it's fairly trivial to look for EFI_VOLUME_CORRUPTED
-// references and add some Ext4SignalCorruption function + function call.
+// I've decided against that, because that would mean writing back the superblock even on
+// read-only mounts. If something like this is desired, it's fairly trivial to look for
+// EFI_VOLUME_CORRUPTED references and add some Ext4SignalCorruption function + function call.
 
 /**
    Checks the superblock's magic value.
@@ -148,25 +150,50 @@ Ext4VerifySuperblockChecksum (
 }
 
 /**
-   Opens and parses the superblock.
+   Verifies that the checksums of every block group descriptor are valid.
 
-   @param[out]     Partition Partition structure to fill with filesystem details.
-   @retval EFI_SUCCESS       Parsing was successful and the partition is a
-                             valid ext4 partition.
+   @param[in] Partition    Pointer to the opened partition, with its block group descriptors.
+
+   @return TRUE if all the checksums are valid, else FALSE.
 **/
-EFI_STATUS
-Ext4OpenSuperblock (
-  OUT EXT4_PARTITION  *Partition
+STATIC
+BOOLEAN
+Ext4VerifyBlockGroupDescs (
+  EXT4_PARTITION  *Partition
   )
 {
   UINT32                 Index;
-  EFI_STATUS             Status;
-  EXT4_SUPERBLOCK        *Sb;
-  UINT32                 NrBlocksRem;
-  UINTN                  NrBlocks;
-  UINT32                 UnsupportedRoCompat;
   EXT4_BLOCK_GROUP_DESC  *Desc;
 
+  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
+    Desc = Ext4GetBlockGroupDesc (Partition, Index);
+    if (!Ext4VerifyBlockGroupDescChecksum (Partition, Desc, Index)) {
+      DEBUG ((DEBUG_ERROR, "[ext4] Block group descriptor %u has an invalid checksum\n", Index));
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+   Reads the superblock and derives the partition's feature set and geometry from it.
+
+   @param[in out]  Partition Partition structure to fill with filesystem details.
+   @retval EFI_SUCCESS       The superblock is valid and was parsed.
+   @retval EFI_VOLUME_CORRUPTED The superblock is corrupted.
+   @retval EFI_UNSUPPORTED   The filesystem uses features we don't support.
+**/
+STATIC
+EFI_STATUS
+Ext4ParseSuperblock (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EFI_STATUS       Status;
+  EXT4_SUPERBLOCK  *Sb;
+  UINT32           UnsupportedRoCompat;
+
   Status = Ext4ReadDiskIo (
              Partition,
              &Partition->SuperBlock,
@@ -219,11 +246,24 @@ Ext4OpenSuperblock (
     Partition->ReadOnly = TRUE;
   }
 
+  // We can read these, but we don't know how to keep them up to date on writes
+  if (EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_MMP) || EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_DIRDATA)) {
+    Partition->ReadOnly = TRUE;
+  }
+
+  if (Partition->BlockIo->Media->ReadOnly) {
+    Partition->ReadOnly = TRUE;
+  }
+
   // At the time of writing, it's the only supported checksum.
   if (EXT4_HAS_METADATA_CSUM (Partition) && (Sb->s_checksum_type != EXT4_CHECKSUM_CRC32C)) {
     return EFI_UNSUPPORTED;
   }
 
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Ext4InitCrc32c ();
+  }
+
   if (EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_CSUM_SEED)) {
     Partition->InitialSeed = Sb->s_checksum_seed;
   } else {
@@ -260,8 +300,17 @@ Ext4OpenSuperblock (
     return EFI_UNSUPPORTED;
   }
 
-  Partition->NumberBlocks      = EXT4_BLOCK_NR_FROM_HALFS (Partition, Sb->s_blocks_count, Sb->s_blocks_count_hi);
-  Partition->NumberBlockGroups = DivU64x32 (Partition->NumberBlocks, Sb->s_blocks_per_group);
+  Partition->NumberBlocks = EXT4_BLOCK_NR_FROM_HALFS (Partition, Sb->s_blocks_count, Sb->s_blocks_count_hi);
+
+  if (Partition->NumberBlocks <= Sb->s_first_data_block) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  // The last block group may be partial
+  Partition->NumberBlockGroups = DivU64x32 (
+                                   Partition->NumberBlocks - Sb->s_first_data_block + Sb->s_blocks_per_group - 1,
+                                   Sb->s_blocks_per_group
+                                   );
 
   DEBUG ((
     DEBUG_FS,
@@ -287,6 +336,35 @@ Ext4OpenSuperblock (
     return EFI_VOLUME_CORRUPTED;
   }
 
+  return EFI_SUCCESS;
+}
+
+/**
+   Opens and parses the superblock.
+
+   @param[out]     Partition Partition structure to fill with filesystem details.
+   @retval EFI_SUCCESS       Parsing was successful and the partition is a
+                             valid ext4 partition.
+**/
+EFI_STATUS
+Ext4OpenSuperblock (
+  OUT EXT4_PARTITION  *Partition
+  )
+{
+  EFI_STATUS       Status;
+  UINT32           NrBlocksRem;
+  UINTN            NrBlocks;
+  EXT4_BLOCK_NR    DescBlock;
+  UINT32           BlockSize;
+  UINT64           NumberBlockGroups;
+  UINT32           DescSize;
+
+  Status = Ext4ParseSuperblock (Partition);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   NrBlocks = (UINTN)DivU64x32Remainder (
                       MultU64x32 (Partition->NumberBlockGroups, Partition->DescSize),
                       Partition->BlockSize,
@@ -297,18 +375,65 @@ Ext4OpenSuperblock (
     NrBlocks++;
   }
 
-  Partition->BlockGroups = Ext4AllocAndReadBlocks (Partition, NrBlocks, Partition->BlockSize == 1024 ? 2 : 1);
+  DescBlock              = Partition->BlockSize == 1024 ? 2 : 1;
+  Partition->BlockGroups = Ext4AllocAndReadBlocks (Partition, NrBlocks, DescBlock);
 
   if (Partition->BlockGroups == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
-    Desc = Ext4GetBlockGroupDesc (Partition, Index);
-    if (!Ext4VerifyBlockGroupDescChecksum (Partition, Desc, Index)) {
-      DEBUG ((DEBUG_ERROR, "[ext4] Block group descriptor %u has an invalid checksum\n", Index));
-      FreePool (Partition->BlockGroups);
-      return EFI_VOLUME_CORRUPTED;
+  if (!Ext4VerifyBlockGroupDescs (Partition)) {
+    FreePool (Partition->BlockGroups);
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Status = Ext4InitBlockCache (Partition);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Partition->BlockGroups);
+    return Status;
+  }
+
+  if (EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_RECOVER)) {
+    Status = Ext4ReplayJournal (Partition);
+
+    if (EFI_ERROR (Status)) {
+      // Not fatal, we can still read the filesystem as it is on disk, however stale.
+      DEBUG ((DEBUG_WARN, "[ext4] Failed to replay the journal: %r\n", Status));
+    } else if (Partition->JournalOverlay != NULL) {
+      // The replayed transactions may have updated the superblock and the block group
+      // descriptors, so parse them again through the overlay. The descriptor buffer and
+      // the block cache were sized from the old geometry, which must not have changed.
+      // ReadOnly stays set, as the replay only lives in memory.
+      BlockSize         = Partition->BlockSize;
+      NumberBlockGroups = Partition->NumberBlockGroups;
+      DescSize          = Partition->DescSize;
+
+      Status = Ext4ParseSuperblock (Partition);
+
+      if (  !EFI_ERROR (Status)
+         && (  (Partition->BlockSize != BlockSize)
+            || (Partition->NumberBlockGroups != NumberBlockGroups)
+            || (Partition->DescSize != DescSize)))
+      {
+        DEBUG ((DEBUG_ERROR, "[ext4] Journal replay changed the filesystem geometry\n"));
+        Status = EFI_VOLUME_CORRUPTED;
+      }
+
+      if (!EFI_ERROR (Status)) {
+        Status = Ext4ReadBlocks (Partition, Partition->BlockGroups, NrBlocks, DescBlock);
+      }
+
+      if (!EFI_ERROR (Status) && !Ext4VerifyBlockGroupDescs (Partition)) {
+        Status = EFI_VOLUME_CORRUPTED;
+      }
+
+      if (EFI_ERROR (Status)) {
+        Ext4FreeJournal (Partition);
+        Ext4FreeBlockCache (Partition);
+        FreePool (Partition->BlockGroups);
+        return Status;
+      }
     }
   }
 
@@ -316,21 +441,57 @@ Ext4OpenSuperblock (
   Partition->RootDentry = Ext4CreateDentry (L"\\", NULL);
 
   if (Partition->RootDentry == NULL) {
+    Ext4FreeJournal (Partition);
+    Ext4FreeBlockCache (Partition);
     FreePool (Partition->BlockGroups);
     return EFI_OUT_OF_RESOURCES;
   }
 
+  Partition->RootDentry->Inode = EXT4_ROOT_INODE_NR;
+
   // Note that the cast below is completely safe, because EXT4_FILE is a specialization of EFI_FILE_PROTOCOL
   Status = Ext4OpenVolume (&Partition->Interface, (EFI_FILE_PROTOCOL **)&Partition->Root);
 
   if (EFI_ERROR (Status)) {
     Ext4UnrefDentry (Partition->RootDentry);
+    Ext4FreeJournal (Partition);
+    Ext4FreeBlockCache (Partition);
     FreePool (Partition->BlockGroups);
   }
 
   return Status;
 }
 
+/**
+   Writes the in-memory superblock back to the disk, updating its checksum.
+
+   @param[in]      Partition     Pointer to the opened partition.
+
+   @return Status of the write.
+**/
+EFI_STATUS
+Ext4WriteSuperblock (
+  IN EXT4_PARTITION  *Partition
+  )
+{
+  EFI_STATUS       Status;
+  EXT4_SUPERBLOCK  *Sb;
+
+  Sb = &Partition->SuperBlock;
+
+  if (EXT4_HAS_METADATA_CSUM (Partition)) {
+    Sb->s_checksum = Ext4CalculateSuperblockChecksum (Partition, Sb);
+  }
+
+  Status = Ext4WriteDiskIo (Partition, Sb, sizeof (EXT4_SUPERBLOCK), EXT4_SUPERBLOCK_OFFSET);
+
+  if (!EFI_ERROR (Status)) {
+    Partition->SuperBlockDirty = FALSE;
+  }
+
+  return Status;
+}
+
 /**
    Calculates the checksum of the given buffer.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -355,7 +516,7 @@ Ext4CalculateChecksum (
   switch (Partition->SuperBlock.s_checksum_type) {
     case EXT4_CHECKSUM_CRC32C:
       // For some reason, EXT4 really likes non-inverted CRC32C checksums, so we stick to that here.
-      return ~CalculateCrc32c(Buffer, Length, ~InitialValue);
+      return Ext4Crc32c (Buffer, Length, InitialValue);
     default:
       ASSERT (FALSE);
       return 0;
@@ -32,6 +32,11 @@ Ext4SymlinkIsFastSymlink (
   UINT32  FileAcl;
   UINT32  ExtAttrBlocks;
 
+  // Symlinks with inline data don't use any blocks either, but may be longer than i_data.
+  if (EXT4_HAS_INLINE_DATA (File)) {
+    return FALSE;
+  }
+
   if ((File->Inode->i_flags & EXT4_EA_INODE_FL) == 0) {
     FileAcl = File->Inode->i_file_acl;
     if (EXT4_IS_64_BIT (File->Partition)) {
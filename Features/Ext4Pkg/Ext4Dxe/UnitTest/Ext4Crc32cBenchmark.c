@@ -0,0 +1,217 @@
+/** @file
+  Host-based microbenchmark of Ext4Dxe's CRC32C implementations.
+
+  First checks that the accelerated implementation (Ext4Crc32cAccel) returns the same
+  CRCs as the table-driven one (Ext4Crc32cTable), for every alignment and many lengths,
+  and then measures the throughput of both on buffers of the sizes that are checksummed
+  with metadata_csum: inodes, 1KiB and 4KiB blocks, and larger runs of blocks.
+
+  Usage: Ext4Crc32cBenchmarkHost [-s MiBPerSize]
+
+  Exits with 1 if the implementations don't match.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../Ext4Dxe.h"
+
+#define EXT4_CRC_BENCH_BUFFER_SIZE      SIZE_64KB
+#define EXT4_CRC_BENCH_DEFAULT_MIB      256
+#define EXT4_CRC_BENCH_MAX_CHECKED_LEN  1100
+
+typedef UINT32 (*EXT4_CRC_BENCH_FUNCTION)(
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  );
+
+STATIC CONST UINTN  mExt4CrcBenchSizes[] = { 256, SIZE_1KB, SIZE_4KB, SIZE_64KB };
+
+/**
+   Gets the current time, in nanoseconds.
+
+   @return The current time.
+**/
+STATIC
+UINT64
+Ext4CrcBenchNow (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  timespec_get (&Time, TIME_UTC);
+  return (UINT64)Time.tv_sec * 1000000000ULL + (UINT64)Time.tv_nsec;
+}
+
+/**
+   Checks that the accelerated implementation matches the table-driven one.
+
+   @param[in]      Buffer        Pointer to a buffer of EXT4_CRC_BENCH_BUFFER_SIZE random bytes.
+
+   @retval TRUE    The implementations match.
+   @retval FALSE   The implementations don't match.
+**/
+STATIC
+BOOLEAN
+Ext4CrcBenchCheck (
+  IN CONST UINT8  *Buffer
+  )
+{
+  UINTN   Offset;
+  UINTN   Length;
+  UINT32  Seed;
+  UINT32  Expected;
+  UINT32  Actual;
+
+  // Known answer: the CRC32C of "123456789" is 0xE3069283
+  Actual = ~Ext4Crc32cAccel ("123456789", 9, ~0U);
+
+  if (Actual != 0xE3069283) {
+    fprintf (stderr, "CRC32C of \"123456789\" is %08x, expected e3069283\n", Actual);
+    return FALSE;
+  }
+
+  for (Offset = 0; Offset < 2 * sizeof (UINT64); Offset++) {
+    for (Length = 0; Length <= EXT4_CRC_BENCH_MAX_CHECKED_LEN; Length++) {
+      Seed     = (UINT32)rand () ^ ((UINT32)rand () << 16);
+      Expected = Ext4Crc32cTable (Buffer + Offset, Length, Seed);
+      Actual   = Ext4Crc32cAccel (Buffer + Offset, Length, Seed);
+
+      if (Actual != Expected) {
+        fprintf (
+          stderr,
+          "CRC32C mismatch: offset %u, length %u, seed %08x: %08x, expected %08x\n",
+          (unsigned)Offset,
+          (unsigned)Length,
+          Seed,
+          Actual,
+          Expected
+          );
+        return FALSE;
+      }
+    }
+  }
+
+  Expected = Ext4Crc32cTable (Buffer, EXT4_CRC_BENCH_BUFFER_SIZE, ~0U);
+  Actual   = Ext4Crc32cAccel (Buffer, EXT4_CRC_BENCH_BUFFER_SIZE, ~0U);
+
+  if (Actual != Expected) {
+    fprintf (stderr, "CRC32C mismatch on the whole buffer: %08x, expected %08x\n", Actual, Expected);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+   Measures the throughput of an implementation.
+
+   @param[in]      Function      Implementation to measure.
+   @param[in]      Buffer        Pointer to a buffer of EXT4_CRC_BENCH_BUFFER_SIZE bytes.
+   @param[in]      Size          Size of each checksummed buffer, in bytes.
+   @param[in]      TotalSize     Number of bytes to checksum in total.
+
+   @return The throughput, in MiB/s.
+**/
+STATIC
+double
+Ext4CrcBenchRun (
+  IN EXT4_CRC_BENCH_FUNCTION  Function,
+  IN CONST UINT8              *Buffer,
+  IN UINTN                    Size,
+  IN UINT64                   TotalSize
+  )
+{
+  UINT64           Iterations;
+  UINT64           Index;
+  UINT64           Start;
+  UINT64           Nanoseconds;
+  volatile UINT32  Sink;
+  UINT32           Crc;
+
+  Iterations = TotalSize / Size;
+  Crc        = 0;
+  Start      = Ext4CrcBenchNow ();
+
+  for (Index = 0; Index < Iterations; Index++) {
+    // Chain the CRCs so the calls can't be optimised away or overlapped
+    Crc = Function (Buffer + (Index * Size) % EXT4_CRC_BENCH_BUFFER_SIZE, Size, Crc);
+  }
+
+  Nanoseconds = Ext4CrcBenchNow () - Start;
+  Sink        = Crc;
+  (VOID)Sink;
+
+  if (Nanoseconds == 0) {
+    Nanoseconds = 1;
+  }
+
+  return (double)(Iterations * Size) / (double)SIZE_1MB / ((double)Nanoseconds / 1e9);
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  UINT8    *Buffer;
+  UINT64   TotalSize;
+  UINTN    Index;
+  BOOLEAN  Accelerated;
+  double   Table;
+  double   Accel;
+
+  TotalSize = (UINT64)EXT4_CRC_BENCH_DEFAULT_MIB * SIZE_1MB;
+
+  if ((argc == 3) && (AsciiStrCmp (argv[1], "-s") == 0) && (atoi (argv[2]) > 0)) {
+    TotalSize = (UINT64)atoi (argv[2]) * SIZE_1MB;
+  } else if (argc != 1) {
+    fprintf (stderr, "Usage: %s [-s MiBPerSize]\n", argv[0]);
+    return 2;
+  }
+
+  Buffer = AllocatePool (EXT4_CRC_BENCH_BUFFER_SIZE + 2 * sizeof (UINT64));
+
+  if (Buffer == NULL) {
+    return 2;
+  }
+
+  srand (0);
+
+  for (Index = 0; Index < EXT4_CRC_BENCH_BUFFER_SIZE + 2 * sizeof (UINT64); Index++) {
+    Buffer[Index] = (UINT8)rand ();
+  }
+
+  Accelerated = Ext4Crc32cAccelSupported ();
+
+  if (!Accelerated) {
+    printf ("CRC32C instructions not supported, only measuring the table-driven implementation\n");
+  } else if (!Ext4CrcBenchCheck (Buffer)) {
+    FreePool (Buffer);
+    return 1;
+  }
+
+  printf ("%8s %14s %14s %8s\n", "size", "table MiB/s", "accel MiB/s", "speedup");
+
+  for (Index = 0; Index < ARRAY_SIZE (mExt4CrcBenchSizes); Index++) {
+    Table = Ext4CrcBenchRun (Ext4Crc32cTable, Buffer, mExt4CrcBenchSizes[Index], TotalSize);
+
+    if (!Accelerated) {
+      printf ("%8u %14.1f %14s %8s\n", (unsigned)mExt4CrcBenchSizes[Index], Table, "-", "-");
+      continue;
+    }
+
+    Accel = Ext4CrcBenchRun (Ext4Crc32cAccel, Buffer, mExt4CrcBenchSizes[Index], TotalSize);
+    printf ("%8u %14.1f %14.1f %7.1fx\n", (unsigned)mExt4CrcBenchSizes[Index], Table, Accel, Accel / Table);
+  }
+
+  FreePool (Buffer);
+  return 0;
+}
@@ -0,0 +1,760 @@
+/** @file
+  Host-based benchmark of Ext4Dxe.
+
+  Mounts a raw ext2/3/4 image through a fake EFI_DISK_IO_PROTOCOL, and then lists
+  every directory, looks up and reads every file sequentially, and does sparse reads
+  of the largest file. With -w, it also creates, overwrites and deletes a file, which
+  modifies the image. For each phase, it reports the number of disk requests, the
+  bytes read from and written to the disk and the wall time, so changes to caching,
+  readahead and writeback can be measured (and checked for regressions, with -m).
+
+  Usage: Ext4DxeBenchmarkHost [-c ChunkSize] [-n SparseReads] [-w WriteSize] [-m MaxRequests] Image [Path...]
+
+  Without paths, every file in the image is used.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Ext4HostDisk.h"
+
+#define EXT4_BENCH_DEFAULT_CHUNK_SIZE    SIZE_1MB
+#define EXT4_BENCH_DEFAULT_SPARSE_READS  1024
+#define EXT4_BENCH_SPARSE_READ_SIZE      SIZE_4KB
+#define EXT4_BENCH_MAX_PATH              4096
+#define EXT4_BENCH_MAX_DEPTH             64
+#define EXT4_BENCH_FILE_INFO_SIZE        (SIZE_OF_EFI_FILE_INFO + (EXT4_NAME_MAX + 1) * sizeof (CHAR16))
+#define EXT4_BENCH_WRITE_FILE            L"\\Ext4DxeBenchmark.tmp"
+
+typedef enum {
+  Ext4BenchPhaseMount,
+  Ext4BenchPhaseList,
+  Ext4BenchPhaseLookup,
+  Ext4BenchPhaseSequential,
+  Ext4BenchPhaseSparse,
+  Ext4BenchPhaseWrite,
+  Ext4BenchPhaseMax
+} EXT4_BENCH_PHASE_ID;
+
+typedef struct {
+  CONST CHAR8    *Name;
+  UINT64         Operations;
+  UINT64         Requests;
+  UINT64         BytesRead;
+  UINT64         BytesWritten;
+  UINT64         Nanoseconds;
+} EXT4_BENCH_PHASE;
+
+typedef struct {
+  EXT4_HOST_DISK        Disk;
+  EXT4_PARTITION        *Partition;
+  EFI_FILE_PROTOCOL     *Root;
+
+  UINTN                 ChunkSize;
+  UINTN                 SparseReads;
+  UINT64                WriteSize;
+  UINT8                 *Buffer;
+
+  // Paths of the files used by the lookup and read phases
+  CHAR16                **Paths;
+  UINTN                 NumberPaths;
+  UINTN                 MaxPaths;
+  UINTN                 LargestFile;
+  UINT64                LargestFileSize;
+
+  EXT4_BENCH_PHASE      Phases[Ext4BenchPhaseMax];
+
+  // State of the phase being measured
+  EXT4_BENCH_PHASE_ID   Current;
+  UINT64                StartRequests;
+  UINT64                StartBytesRead;
+  UINT64                StartBytesWritten;
+  UINT64                StartTime;
+} EXT4_BENCH;
+
+/**
+   Gets the current time, in nanoseconds.
+
+   @return The current time.
+**/
+STATIC
+UINT64
+Ext4BenchNow (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  timespec_get (&Time, TIME_UTC);
+  return (UINT64)Time.tv_sec * 1000000000ULL + (UINT64)Time.tv_nsec;
+}
+
+/**
+   Starts measuring a phase.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+   @param[in]      Phase         Phase to measure.
+**/
+STATIC
+VOID
+Ext4BenchStart (
+  IN OUT EXT4_BENCH        *Bench,
+  IN EXT4_BENCH_PHASE_ID   Phase
+  )
+{
+  Bench->Current           = Phase;
+  Bench->StartRequests     = Bench->Disk.Requests;
+  Bench->StartBytesRead    = Bench->Disk.BytesRead;
+  Bench->StartBytesWritten = Bench->Disk.BytesWritten;
+  Bench->StartTime         = Ext4BenchNow ();
+}
+
+/**
+   Stops measuring the current phase, accumulating the measurements into it.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+**/
+STATIC
+VOID
+Ext4BenchStop (
+  IN OUT EXT4_BENCH  *Bench
+  )
+{
+  EXT4_BENCH_PHASE  *Phase;
+
+  Phase                = &Bench->Phases[Bench->Current];
+  Phase->Nanoseconds  += Ext4BenchNow () - Bench->StartTime;
+  Phase->Requests     += Bench->Disk.Requests - Bench->StartRequests;
+  Phase->BytesRead    += Bench->Disk.BytesRead - Bench->StartBytesRead;
+  Phase->BytesWritten += Bench->Disk.BytesWritten - Bench->StartBytesWritten;
+}
+
+/**
+   Reports an error on a file.
+
+   @param[in]      Path          Path of the file.
+   @param[in]      Operation     Name of the operation that failed.
+   @param[in]      Status        Status of the operation.
+**/
+STATIC
+VOID
+Ext4BenchError (
+  IN CONST CHAR16  *Path,
+  IN CONST CHAR8   *Operation,
+  IN EFI_STATUS    Status
+  )
+{
+  // Paths may have any unicode character, only print the ASCII ones
+  for ( ; *Path != L'\0'; Path++) {
+    fputc (*Path < 0x80 ? (int)*Path : '?', stderr);
+  }
+
+  fprintf (stderr, ": %s failed: 0x%llx\n", Operation, (UINT64)Status);
+}
+
+/**
+   Adds a file to the list of files used by the benchmark.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+   @param[in]      Path          Path of the file.
+
+   @retval EFI_SUCCESS           The file was added.
+   @retval EFI_OUT_OF_RESOURCES  Out of memory.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchAddPath (
+  IN OUT EXT4_BENCH    *Bench,
+  IN CONST CHAR16      *Path
+  )
+{
+  CHAR16  **Paths;
+  UINTN   NewMax;
+
+  if (Bench->NumberPaths == Bench->MaxPaths) {
+    NewMax = MAX (Bench->MaxPaths * 2, 64);
+    Paths  = ReallocatePool (
+               Bench->MaxPaths * sizeof (CHAR16 *),
+               NewMax * sizeof (CHAR16 *),
+               Bench->Paths
+               );
+
+    if (Paths == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Bench->Paths    = Paths;
+    Bench->MaxPaths = NewMax;
+  }
+
+  Bench->Paths[Bench->NumberPaths] = AllocateCopyPool (StrSize (Path), Path);
+
+  if (Bench->Paths[Bench->NumberPaths] == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Bench->NumberPaths++;
+  return EFI_SUCCESS;
+}
+
+/**
+   Lists a directory and, recursively, all of its subdirectories, adding every
+   regular file to the list of files.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[in out]  Path          Path of the directory, EXT4_BENCH_MAX_PATH characters long.
+                                 Subdirectories are appended to it temporarily.
+   @param[in]      Depth         Depth of the directory.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchListDirectory (
+  IN OUT EXT4_BENCH      *Bench,
+  IN EFI_FILE_PROTOCOL   *Directory,
+  IN OUT CHAR16          *Path,
+  IN UINTN               Depth
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_INFO      *Info;
+  EFI_FILE_PROTOCOL  *Child;
+  UINTN              Length;
+  UINTN              PathLength;
+
+  Info = AllocatePool (EXT4_BENCH_FILE_INFO_SIZE);
+
+  if (Info == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  PathLength = StrLen (Path);
+
+  while (TRUE) {
+    Length = EXT4_BENCH_FILE_INFO_SIZE;
+    Status = Directory->Read (Directory, &Length, Info);
+
+    if (EFI_ERROR (Status) || (Length == 0)) {
+      break;
+    }
+
+    Bench->Phases[Ext4BenchPhaseList].Operations++;
+
+    Status = StrCatS (Path, EXT4_BENCH_MAX_PATH, L"\\");
+
+    if (!EFI_ERROR (Status)) {
+      Status = StrCatS (Path, EXT4_BENCH_MAX_PATH, Info->FileName);
+    }
+
+    if (EFI_ERROR (Status)) {
+      // Path too long, skip the entry
+      Path[PathLength] = L'\0';
+      continue;
+    }
+
+    if ((Info->Attribute & EFI_FILE_DIRECTORY) == 0) {
+      Status = Ext4BenchAddPath (Bench, Path);
+    } else if (Depth < EXT4_BENCH_MAX_DEPTH) {
+      Status = Directory->Open (Directory, &Child, Info->FileName, EFI_FILE_MODE_READ, 0);
+
+      if (!EFI_ERROR (Status)) {
+        Status = Ext4BenchListDirectory (Bench, Child, Path, Depth + 1);
+        Child->Close (Child);
+      }
+    }
+
+    Path[PathLength] = L'\0';
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  FreePool (Info);
+  return Status;
+}
+
+/**
+   Looks up every file from the root directory, and finds the largest one.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchLookup (
+  IN OUT EXT4_BENCH  *Bench
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  UINTN              Index;
+  UINT64             FileSize;
+
+  for (Index = 0; Index < Bench->NumberPaths; Index++) {
+    Status = Bench->Root->Open (Bench->Root, &File, Bench->Paths[Index], EFI_FILE_MODE_READ, 0);
+
+    if (EFI_ERROR (Status)) {
+      Ext4BenchError (Bench->Paths[Index], "open", Status);
+      return Status;
+    }
+
+    Bench->Phases[Ext4BenchPhaseLookup].Operations++;
+
+    // Seeking to the end doesn't touch the disk, and gives us the size of the file
+    if (!EFI_ERROR (File->SetPosition (File, MAX_UINT64)) &&
+        !EFI_ERROR (File->GetPosition (File, &FileSize)) &&
+        (FileSize > Bench->LargestFileSize))
+    {
+      Bench->LargestFile     = Index;
+      Bench->LargestFileSize = FileSize;
+    }
+
+    File->Close (File);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads every file sequentially, ChunkSize bytes at a time.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchSequential (
+  IN OUT EXT4_BENCH  *Bench
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  UINTN              Index;
+  UINTN              Length;
+
+  for (Index = 0; Index < Bench->NumberPaths; Index++) {
+    Status = Bench->Root->Open (Bench->Root, &File, Bench->Paths[Index], EFI_FILE_MODE_READ, 0);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    do {
+      Length = Bench->ChunkSize;
+      Status = File->Read (File, &Length, Bench->Buffer);
+      Bench->Phases[Ext4BenchPhaseSequential].Operations++;
+    } while (!EFI_ERROR (Status) && (Length != 0));
+
+    File->Close (File);
+
+    if (EFI_ERROR (Status)) {
+      Ext4BenchError (Bench->Paths[Index], "read", Status);
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads EXT4_BENCH_SPARSE_READ_SIZE bytes at pseudo-random offsets of the largest file.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchSparse (
+  IN OUT EXT4_BENCH  *Bench
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  UINTN              Index;
+  UINTN              Length;
+  UINT64             Seed;
+  UINT64             Blocks;
+
+  if (Bench->LargestFileSize == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = Bench->Root->Open (Bench->Root, &File, Bench->Paths[Bench->LargestFile], EFI_FILE_MODE_READ, 0);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Use a fixed seed, so runs are comparable
+  Seed   = 0x9E3779B97F4A7C15ULL;
+  Blocks = DivU64x32 (Bench->LargestFileSize + EXT4_BENCH_SPARSE_READ_SIZE - 1, EXT4_BENCH_SPARSE_READ_SIZE);
+
+  for (Index = 0; Index < Bench->SparseReads; Index++) {
+    Seed   = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    Status = File->SetPosition (File, MultU64x32 ((Seed >> 16) % Blocks, EXT4_BENCH_SPARSE_READ_SIZE));
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Length = EXT4_BENCH_SPARSE_READ_SIZE;
+    Status = File->Read (File, &Length, Bench->Buffer);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Bench->Phases[Ext4BenchPhaseSparse].Operations++;
+  }
+
+  File->Close (File);
+  return Status;
+}
+
+/**
+   Creates a file of WriteSize bytes, writing it ChunkSize bytes at a time, overwrites
+   it in place, and then deletes it.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchWrite (
+  IN OUT EXT4_BENCH  *Bench
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  UINTN              Pass;
+  UINTN              Length;
+  UINT64             Written;
+
+  Status = Bench->Root->Open (
+                          Bench->Root,
+                          &File,
+                          EXT4_BENCH_WRITE_FILE,
+                          EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                          0
+                          );
+
+  if (EFI_ERROR (Status)) {
+    Ext4BenchError (EXT4_BENCH_WRITE_FILE, "create", Status);
+    return Status;
+  }
+
+  // The first pass allocates the blocks, the second one only overwrites them
+  for (Pass = 0; Pass < 2 && !EFI_ERROR (Status); Pass++) {
+    Status = File->SetPosition (File, 0);
+
+    for (Written = 0; !EFI_ERROR (Status) && Written < Bench->WriteSize; Written += Length) {
+      Length = (UINTN)MIN (Bench->ChunkSize, Bench->WriteSize - Written);
+      SetMem (Bench->Buffer, Length, (UINT8)(Written + Pass));
+      Status = File->Write (File, &Length, Bench->Buffer);
+      Bench->Phases[Ext4BenchPhaseWrite].Operations++;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = File->Flush (File);
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    Ext4BenchError (EXT4_BENCH_WRITE_FILE, "write", Status);
+    File->Close (File);
+    return Status;
+  }
+
+  if (File->Delete (File) != EFI_SUCCESS) {
+    Ext4BenchError (EXT4_BENCH_WRITE_FILE, "delete", EFI_WARN_DELETE_FAILURE);
+    return EFI_WARN_DELETE_FAILURE;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Prints the results of the benchmark.
+
+   @param[in]      Bench         Pointer to the benchmark.
+   @param[out]     Total         Pointer to where the totals will be stored.
+**/
+STATIC
+VOID
+Ext4BenchReport (
+  IN  CONST EXT4_BENCH  *Bench,
+  OUT EXT4_BENCH_PHASE  *Total
+  )
+{
+  CONST EXT4_BENCH_PHASE  *Phase;
+  UINTN                   Index;
+
+  ZeroMem (Total, sizeof (*Total));
+  Total->Name = "total";
+
+  printf (
+    "%-12s %12s %12s %16s %16s %14s\n",
+    "phase",
+    "operations",
+    "requests",
+    "bytes read",
+    "bytes written",
+    "time (us)"
+    );
+
+  for (Index = 0; Index <= Ext4BenchPhaseMax; Index++) {
+    if (Index == Ext4BenchPhaseMax) {
+      Phase = Total;
+    } else {
+      Phase                = &Bench->Phases[Index];
+      Total->Operations   += Phase->Operations;
+      Total->Requests     += Phase->Requests;
+      Total->BytesRead    += Phase->BytesRead;
+      Total->BytesWritten += Phase->BytesWritten;
+      Total->Nanoseconds  += Phase->Nanoseconds;
+    }
+
+    printf (
+      "%-12s %12llu %12llu %16llu %16llu %14llu\n",
+      Phase->Name,
+      Phase->Operations,
+      Phase->Requests,
+      Phase->BytesRead,
+      Phase->BytesWritten,
+      Phase->Nanoseconds / 1000
+      );
+  }
+}
+
+/**
+   Prints the usage of the benchmark.
+
+   @param[in]      Name          Name of the program.
+**/
+STATIC
+VOID
+Ext4BenchUsage (
+  IN CONST CHAR8  *Name
+  )
+{
+  fprintf (
+    stderr,
+    "Usage: %s [-c ChunkSize] [-n SparseReads] [-w WriteSize] [-m MaxRequests] Image [Path...]\n"
+    "  -c  Size of each sequential read and write, in bytes (default %u)\n"
+    "  -n  Number of %u byte reads at random offsets of the largest file (default %u)\n"
+    "  -w  Create, overwrite and delete a file of WriteSize bytes. This modifies the image\n"
+    "  -m  Fail if the benchmark does more than MaxRequests disk requests\n"
+    "Paths are relative to the root of the filesystem. Without them, every file is used.\n",
+    Name,
+    EXT4_BENCH_DEFAULT_CHUNK_SIZE,
+    EXT4_BENCH_SPARSE_READ_SIZE,
+    EXT4_BENCH_DEFAULT_SPARSE_READS
+    );
+}
+
+/**
+   Runs the benchmark.
+
+   @param[in out]  Bench         Pointer to the benchmark.
+   @param[in]      Image         Path of the image file.
+   @param[in]      NumberPaths   Number of files given on the command line.
+   @param[in]      Paths         Files given on the command line. If there are none,
+                                 every file in the image is used.
+
+   @return Result of the benchmark.
+**/
+STATIC
+EFI_STATUS
+Ext4BenchRun (
+  IN OUT EXT4_BENCH  *Bench,
+  IN CONST CHAR8     *Image,
+  IN UINTN           NumberPaths,
+  IN CHAR8           **Paths
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      *Path;
+  CHAR16      *Char;
+  UINTN       Index;
+
+  Path = AllocateZeroPool (EXT4_BENCH_MAX_PATH * sizeof (CHAR16));
+
+  if (Path == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4HostDiskInitFile (&Bench->Disk, Image, Bench->WriteSize != 0);
+
+  if (EFI_ERROR (Status)) {
+    fprintf (stderr, "%s: could not open image\n", Image);
+    FreePool (Path);
+    return Status;
+  }
+
+  Ext4BenchStart (Bench, Ext4BenchPhaseMount);
+  Status = Ext4HostMount (&Bench->Disk, &Bench->Partition);
+
+  if (!EFI_ERROR (Status)) {
+    Status = Bench->Partition->Interface.OpenVolume (&Bench->Partition->Interface, &Bench->Root);
+
+    if (EFI_ERROR (Status)) {
+      Ext4UnmountAndFreePartition (Bench->Partition);
+    }
+  }
+
+  Ext4BenchStop (Bench);
+
+  if (EFI_ERROR (Status)) {
+    fprintf (stderr, "%s: mount failed: 0x%llx\n", Image, (UINT64)Status);
+    goto Out;
+  }
+
+  Bench->Phases[Ext4BenchPhaseMount].Operations = 1;
+
+  if (NumberPaths != 0) {
+    // Accept '/' as a path separator, for convenience
+    for (Index = 0; Index < NumberPaths && !EFI_ERROR (Status); Index++) {
+      Status = AsciiStrToUnicodeStrS (Paths[Index], Path, EXT4_BENCH_MAX_PATH);
+
+      for (Char = Path; !EFI_ERROR (Status) && *Char != L'\0'; Char++) {
+        if (*Char == L'/') {
+          *Char = L'\\';
+        }
+      }
+
+      if (!EFI_ERROR (Status)) {
+        Status = Ext4BenchAddPath (Bench, Path);
+      }
+    }
+  } else {
+    Ext4BenchStart (Bench, Ext4BenchPhaseList);
+    Status = Ext4BenchListDirectory (Bench, Bench->Root, Path, 0);
+    Ext4BenchStop (Bench);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Ext4BenchStart (Bench, Ext4BenchPhaseLookup);
+    Status = Ext4BenchLookup (Bench);
+    Ext4BenchStop (Bench);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Ext4BenchStart (Bench, Ext4BenchPhaseSequential);
+    Status = Ext4BenchSequential (Bench);
+    Ext4BenchStop (Bench);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Ext4BenchStart (Bench, Ext4BenchPhaseSparse);
+    Status = Ext4BenchSparse (Bench);
+    Ext4BenchStop (Bench);
+  }
+
+  if (!EFI_ERROR (Status) && (Bench->WriteSize != 0)) {
+    Ext4BenchStart (Bench, Ext4BenchPhaseWrite);
+    Status = Ext4BenchWrite (Bench);
+    Ext4BenchStop (Bench);
+  }
+
+  Bench->Root->Close (Bench->Root);
+  Ext4UnmountAndFreePartition (Bench->Partition);
+
+Out:
+  Ext4HostDiskClose (&Bench->Disk);
+  FreePool (Path);
+  return Status;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  EXT4_BENCH        *Bench;
+  EXT4_BENCH_PHASE  Total;
+  EFI_STATUS        Status;
+  UINT64            MaxRequests;
+  UINTN             Index;
+  int               Arg;
+
+  Bench = AllocateZeroPool (sizeof (*Bench));
+
+  if (Bench == NULL) {
+    return 1;
+  }
+
+  Bench->ChunkSize   = EXT4_BENCH_DEFAULT_CHUNK_SIZE;
+  Bench->SparseReads = EXT4_BENCH_DEFAULT_SPARSE_READS;
+  MaxRequests        = MAX_UINT64;
+
+  Bench->Phases[Ext4BenchPhaseMount].Name      = "mount";
+  Bench->Phases[Ext4BenchPhaseList].Name       = "list";
+  Bench->Phases[Ext4BenchPhaseLookup].Name     = "lookup";
+  Bench->Phases[Ext4BenchPhaseSequential].Name = "sequential";
+  Bench->Phases[Ext4BenchPhaseSparse].Name     = "sparse";
+  Bench->Phases[Ext4BenchPhaseWrite].Name      = "write";
+
+  for (Arg = 1; Arg + 1 < argc && argv[Arg][0] == '-'; Arg += 2) {
+    if (AsciiStrCmp (argv[Arg], "-c") == 0) {
+      Bench->ChunkSize = (UINTN)strtoull (argv[Arg + 1], NULL, 0);
+    } else if (AsciiStrCmp (argv[Arg], "-n") == 0) {
+      Bench->SparseReads = (UINTN)strtoull (argv[Arg + 1], NULL, 0);
+    } else if (AsciiStrCmp (argv[Arg], "-w") == 0) {
+      Bench->WriteSize = strtoull (argv[Arg + 1], NULL, 0);
+    } else if (AsciiStrCmp (argv[Arg], "-m") == 0) {
+      MaxRequests = strtoull (argv[Arg + 1], NULL, 0);
+    } else {
+      break;
+    }
+  }
+
+  if ((Arg >= argc) || (argv[Arg][0] == '-') || (Bench->ChunkSize == 0)) {
+    Ext4BenchUsage (argv[0]);
+    FreePool (Bench);
+    return 1;
+  }
+
+  Bench->Buffer = AllocatePool (MAX (Bench->ChunkSize, EXT4_BENCH_SPARSE_READ_SIZE));
+
+  if (Bench->Buffer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+  } else {
+    Status = Ext4BenchRun (Bench, argv[Arg], argc - Arg - 1, argv + Arg + 1);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Ext4BenchReport (Bench, &Total);
+
+    if (Total.Requests > MaxRequests) {
+      fprintf (stderr, "%llu disk requests, more than the maximum of %llu\n", Total.Requests, MaxRequests);
+      Status = EFI_ABORTED;
+    }
+  }
+
+  for (Index = 0; Index < Bench->NumberPaths; Index++) {
+    FreePool (Bench->Paths[Index]);
+  }
+
+  if (Bench->Paths != NULL) {
+    FreePool (Bench->Paths);
+  }
+
+  if (Bench->Buffer != NULL) {
+    FreePool (Bench->Buffer);
+  }
+
+  FreePool (Bench);
+  return EFI_ERROR (Status) ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+/** @file
+  libFuzzer target for Ext4Dxe's superblock and extent parsing.
+
+  Each input is a filesystem image, which is mounted with Ext4OpenSuperblock. If that
+  succeeds, Ext4GetExtent is used to map the blocks of the root directory and of the
+  files in it.
+
+  When built without libFuzzer (that is, without EXT4_LIBFUZZER defined), main() runs
+  every file given on the command line through the target, to reproduce crashes.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Ext4HostDisk.h"
+
+#define EXT4_FUZZ_MAX_FILES       16
+#define EXT4_FUZZ_MAX_BLOCKS      64
+#define EXT4_FUZZ_MAX_INPUT       SIZE_64MB
+#define EXT4_FUZZ_FILE_INFO_SIZE  (SIZE_OF_EFI_FILE_INFO + (EXT4_NAME_MAX + 1) * sizeof (CHAR16))
+
+/**
+   Maps the first blocks of a file, and a few more past its end.
+
+   @param[in]      Partition     Pointer to the opened partition.
+   @param[in]      File          Pointer to the opened file.
+**/
+STATIC
+VOID
+Ext4FuzzExtents (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_FILE       *File
+  )
+{
+  EXT4_EXTENT    Extent;
+  EXT4_BLOCK_NR  Block;
+  UINT64         Blocks;
+
+  // Ext4Read never maps blocks of inline data files, neither should we
+  if (EXT4_HAS_INLINE_DATA (File)) {
+    return;
+  }
+
+  Blocks = DivU64x32 (EXT4_INODE_SIZE (File->Inode) + Partition->BlockSize - 1, Partition->BlockSize);
+
+  for (Block = 0; Block < MIN (Blocks, EXT4_FUZZ_MAX_BLOCKS); Block++) {
+    Ext4GetExtent (Partition, File, Block, &Extent);
+  }
+
+  if (Blocks <= MAX_UINT32) {
+    Ext4GetExtent (Partition, File, (EXT4_BLOCK_NR)Blocks, &Extent);
+  }
+
+  Ext4GetExtent (Partition, File, MAX_UINT32, &Extent);
+}
+
+/**
+   Fuzzes the mount of an image, and the mapping of the blocks of its root
+   directory and the files in it.
+
+   @param[in]      Data          Pointer to the image.
+   @param[in]      Size          Size of the image, in bytes.
+
+   @return Always 0.
+**/
+int
+LLVMFuzzerTestOneInput (
+  const uint8_t  *Data,
+  size_t         Size
+  )
+{
+  EXT4_HOST_DISK     Disk;
+  EXT4_PARTITION     *Partition;
+  EFI_FILE_PROTOCOL  *Root;
+  EFI_FILE_PROTOCOL  *Child;
+  EFI_FILE_INFO      *Info;
+  EFI_STATUS         Status;
+  UINTN              Length;
+  UINTN              Index;
+
+  Ext4HostDiskInitBuffer (&Disk, Data, Size);
+
+  if (EFI_ERROR (Ext4HostMount (&Disk, &Partition))) {
+    return 0;
+  }
+
+  Status = Partition->Interface.OpenVolume (&Partition->Interface, &Root);
+
+  if (EFI_ERROR (Status)) {
+    Ext4UnmountAndFreePartition (Partition);
+    return 0;
+  }
+
+  Ext4FuzzExtents (Partition, EXT4_FILE_FROM_THIS (Root));
+
+  Info = AllocatePool (EXT4_FUZZ_FILE_INFO_SIZE);
+
+  for (Index = 0; Info != NULL && Index < EXT4_FUZZ_MAX_FILES; Index++) {
+    Length = EXT4_FUZZ_FILE_INFO_SIZE;
+    Status = Root->Read (Root, &Length, Info);
+
+    if (EFI_ERROR (Status) || (Length == 0)) {
+      break;
+    }
+
+    Status = Root->Open (Root, &Child, Info->FileName, EFI_FILE_MODE_READ, 0);
+
+    if (!EFI_ERROR (Status)) {
+      Ext4FuzzExtents (Partition, EXT4_FILE_FROM_THIS (Child));
+      Child->Close (Child);
+    }
+  }
+
+  if (Info != NULL) {
+    FreePool (Info);
+  }
+
+  Root->Close (Root);
+  Ext4UnmountAndFreePartition (Partition);
+  return 0;
+}
+
+#ifndef EXT4_LIBFUZZER
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  FILE    *File;
+  UINT8   *Buffer;
+  size_t  Size;
+  int     Arg;
+
+  Buffer = AllocatePool (EXT4_FUZZ_MAX_INPUT);
+
+  if (Buffer == NULL) {
+    return 1;
+  }
+
+  for (Arg = 1; Arg < argc; Arg++) {
+    File = fopen (argv[Arg], "rb");
+
+    if (File == NULL) {
+      fprintf (stderr, "%s: could not open input\n", argv[Arg]);
+      return 1;
+    }
+
+    Size = fread (Buffer, 1, EXT4_FUZZ_MAX_INPUT, File);
+    fclose (File);
+
+    printf ("%s: %zu bytes\n", argv[Arg], Size);
+    LLVMFuzzerTestOneInput (Buffer, Size);
+  }
+
+  FreePool (Buffer);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,332 @@
+/** @file
+  Fake disk used to mount ext2/3/4 images in host-based tests of Ext4Dxe.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+
+#include "Ext4HostDisk.h"
+
+#if defined (_MSC_VER)
+#define fseeko  _fseeki64
+#define ftello  _ftelli64
+typedef __int64 off_t;
+#endif
+
+#define EXT4_HOST_DISK_FROM_DISK_IO(This)   BASE_CR (This, EXT4_HOST_DISK, DiskIo)
+#define EXT4_HOST_DISK_FROM_BLOCK_IO(This)  BASE_CR (This, EXT4_HOST_DISK, BlockIo)
+
+/**
+   Reads bytes from the disk.
+
+   @param[in]      This          Pointer to the EFI_DISK_IO_PROTOCOL of the disk.
+   @param[in]      MediaId       Id of the media.
+   @param[in]      Offset        Offset of the read, in bytes.
+   @param[in]      BufferSize    Size of the read, in bytes.
+   @param[out]     Buffer        Pointer to the destination buffer.
+
+   @retval EFI_SUCCESS           The data was read.
+   @retval EFI_MEDIA_CHANGED     MediaId is not the disk's media.
+   @retval EFI_INVALID_PARAMETER The read goes past the end of the disk.
+   @retval EFI_DEVICE_ERROR      The image file could not be read.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+Ext4HostDiskRead (
+  IN  EFI_DISK_IO_PROTOCOL  *This,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  EXT4_HOST_DISK  *Disk;
+
+  Disk = EXT4_HOST_DISK_FROM_DISK_IO (This);
+
+  Disk->Requests++;
+
+  if (MediaId != Disk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if ((Offset > Disk->Size) || (BufferSize > Disk->Size - Offset)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Disk->BytesRead += BufferSize;
+
+  if (Disk->Buffer != NULL) {
+    CopyMem (Buffer, Disk->Buffer + Offset, BufferSize);
+    return EFI_SUCCESS;
+  }
+
+  if ((fseeko (Disk->File, (off_t)Offset, SEEK_SET) != 0) ||
+      (fread (Buffer, 1, BufferSize, Disk->File) != BufferSize))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Writes bytes to the disk. Images in memory are always read-only.
+
+   @param[in]      This          Pointer to the EFI_DISK_IO_PROTOCOL of the disk.
+   @param[in]      MediaId       Id of the media.
+   @param[in]      Offset        Offset of the write, in bytes.
+   @param[in]      BufferSize    Size of the write, in bytes.
+   @param[in]      Buffer        Pointer to the source buffer.
+
+   @retval EFI_SUCCESS           The data was written.
+   @retval EFI_WRITE_PROTECTED   The disk is read-only.
+   @retval EFI_MEDIA_CHANGED     MediaId is not the disk's media.
+   @retval EFI_INVALID_PARAMETER The write goes past the end of the disk.
+   @retval EFI_DEVICE_ERROR      The image file could not be written.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+Ext4HostDiskWrite (
+  IN EFI_DISK_IO_PROTOCOL  *This,
+  IN UINT32                MediaId,
+  IN UINT64                Offset,
+  IN UINTN                 BufferSize,
+  IN VOID                  *Buffer
+  )
+{
+  EXT4_HOST_DISK  *Disk;
+
+  Disk = EXT4_HOST_DISK_FROM_DISK_IO (This);
+
+  Disk->Requests++;
+
+  if (Disk->Media.ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  if (MediaId != Disk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if ((Offset > Disk->Size) || (BufferSize > Disk->Size - Offset)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Disk->BytesWritten += BufferSize;
+
+  if ((fseeko (Disk->File, (off_t)Offset, SEEK_SET) != 0) ||
+      (fwrite (Buffer, 1, BufferSize, Disk->File) != BufferSize))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Flushes the writes to the disk to the image file.
+
+   @param[in]      This          Pointer to the EFI_BLOCK_IO_PROTOCOL of the disk.
+
+   @retval EFI_SUCCESS           The writes were flushed.
+   @retval EFI_DEVICE_ERROR      The image file could not be written.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+Ext4HostDiskFlush (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  EXT4_HOST_DISK  *Disk;
+
+  Disk = EXT4_HOST_DISK_FROM_BLOCK_IO (This);
+
+  if ((Disk->File != NULL) && (fflush (Disk->File) != 0)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Sets up the protocols of a disk of a given size.
+
+   @param[out]     Disk          Pointer to the disk.
+   @param[in]      Size          Size of the image, in bytes.
+**/
+STATIC
+VOID
+Ext4HostDiskInit (
+  OUT EXT4_HOST_DISK  *Disk,
+  IN  UINT64          Size
+  )
+{
+  ZeroMem (Disk, sizeof (*Disk));
+
+  Disk->Size = Size;
+
+  Disk->DiskIo.Revision  = EFI_DISK_IO_PROTOCOL_REVISION;
+  Disk->DiskIo.ReadDisk  = Ext4HostDiskRead;
+  Disk->DiskIo.WriteDisk = Ext4HostDiskWrite;
+
+  Disk->Media.MediaId          = 1;
+  Disk->Media.MediaPresent     = TRUE;
+  Disk->Media.ReadOnly         = TRUE;
+  Disk->Media.LogicalPartition = TRUE;
+  Disk->Media.BlockSize        = EXT4_HOST_DISK_SECTOR_SIZE;
+  Disk->Media.IoAlign          = 1;
+  Disk->Media.LastBlock        = DivU64x32 (Size, EXT4_HOST_DISK_SECTOR_SIZE);
+
+  if (Disk->Media.LastBlock != 0) {
+    Disk->Media.LastBlock--;
+  }
+
+  Disk->BlockIo.Revision    = EFI_BLOCK_IO_PROTOCOL_REVISION;
+  Disk->BlockIo.Media       = &Disk->Media;
+  Disk->BlockIo.FlushBlocks = Ext4HostDiskFlush;
+}
+
+/**
+   Initialises a disk backed by an image in memory.
+
+   @param[out]     Disk          Pointer to the disk.
+   @param[in]      Buffer        Pointer to the image. It must remain valid while the disk is used.
+   @param[in]      Size          Size of the image, in bytes.
+**/
+VOID
+Ext4HostDiskInitBuffer (
+  OUT EXT4_HOST_DISK  *Disk,
+  IN  CONST VOID      *Buffer,
+  IN  UINT64          Size
+  )
+{
+  Ext4HostDiskInit (Disk, Size);
+  Disk->Buffer = Buffer;
+}
+
+/**
+   Initialises a disk backed by an image file on the host.
+
+   @param[out]     Disk          Pointer to the disk.
+   @param[in]      Path          Path of the image file.
+   @param[in]      Writable      TRUE if the image may be modified, else the media is read-only.
+
+   @retval EFI_SUCCESS           The image was opened.
+   @retval EFI_NOT_FOUND         The image could not be opened.
+**/
+EFI_STATUS
+Ext4HostDiskInitFile (
+  OUT EXT4_HOST_DISK  *Disk,
+  IN  CONST CHAR8     *Path,
+  IN  BOOLEAN         Writable
+  )
+{
+  FILE   *File;
+  off_t  Size;
+
+  File = fopen (Path, Writable ? "r+b" : "rb");
+
+  if (File == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if ((fseeko (File, 0, SEEK_END) != 0) || ((Size = ftello (File)) < 0)) {
+    fclose (File);
+    return EFI_NOT_FOUND;
+  }
+
+  Ext4HostDiskInit (Disk, (UINT64)Size);
+  Disk->File           = File;
+  Disk->Media.ReadOnly = !Writable;
+  return EFI_SUCCESS;
+}
+
+/**
+   Releases the resources of a disk.
+
+   @param[in out]  Disk          Pointer to the disk.
+**/
+VOID
+Ext4HostDiskClose (
+  IN OUT EXT4_HOST_DISK  *Disk
+  )
+{
+  if (Disk->File != NULL) {
+    fclose (Disk->File);
+    Disk->File = NULL;
+  }
+}
+
+/**
+   Mounts the filesystem in a disk, the same way Ext4OpenPartition does,
+   without installing any protocols.
+
+   @param[in]      Disk          Pointer to the disk.
+   @param[out]     Partition     Pointer to where the partition will be stored.
+
+   @return Result of Ext4OpenSuperblock.
+**/
+EFI_STATUS
+Ext4HostMount (
+  IN  EXT4_HOST_DISK  *Disk,
+  OUT EXT4_PARTITION  **Partition
+  )
+{
+  EXT4_PARTITION  *Part;
+  EFI_STATUS      Status;
+
+  Part = AllocateZeroPool (sizeof (*Part));
+
+  if (Part == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  InitializeListHead (&Part->OpenFiles);
+
+  Part->BlockIo = &Disk->BlockIo;
+  Part->DiskIo  = &Disk->DiskIo;
+
+  Status = Ext4OpenSuperblock (Part);
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Part);
+    return Status;
+  }
+
+  Part->Interface.Revision   = EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_REVISION;
+  Part->Interface.OpenVolume = Ext4OpenVolume;
+
+  *Partition = Part;
+  return EFI_SUCCESS;
+}
+
+/**
+   Does a case-insensitive string comparison. Collation.c needs the
+   EFI_UNICODE_COLLATION_PROTOCOL, so host builds use this ASCII-only version.
+
+   @param[in]      Str1   Pointer to a null terminated string.
+   @param[in]      Str2   Pointer to a null terminated string.
+
+   @retval 0   Str1 is equivalent to Str2.
+   @retval >0  Str1 is lexically greater than Str2.
+   @retval <0  Str1 is lexically less than Str2.
+**/
+INTN
+Ext4StrCmpInsensitive (
+  IN CHAR16  *Str1,
+  IN CHAR16  *Str2
+  )
+{
+  while ((*Str1 != L'\0') && (CharToUpper (*Str1) == CharToUpper (*Str2))) {
+    Str1++;
+    Str2++;
+  }
+
+  return (INTN)CharToUpper (*Str1) - (INTN)CharToUpper (*Str2);
+}
@@ -0,0 +1,90 @@
+/** @file
+  Fake disk used to mount ext2/3/4 images in host-based tests of Ext4Dxe.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef EXT4_HOST_DISK_H_
+#define EXT4_HOST_DISK_H_
+
+#include "../Ext4Dxe.h"
+
+#define EXT4_HOST_DISK_SECTOR_SIZE  512
+
+//
+// A raw filesystem image, either in memory or in a host file, exposed through
+// EFI_DISK_IO_PROTOCOL and EFI_BLOCK_IO_PROTOCOL. Every request is counted, so
+// tests can tell how much I/O the driver does. Only host files can be written to.
+//
+typedef struct {
+  EFI_DISK_IO_PROTOCOL     DiskIo;
+  EFI_BLOCK_IO_PROTOCOL    BlockIo;
+  EFI_BLOCK_IO_MEDIA       Media;
+
+  CONST UINT8              *Buffer;
+  VOID                     *File;
+  UINT64                   Size;
+
+  UINT64                   Requests;
+  UINT64                   BytesRead;
+  UINT64                   BytesWritten;
+} EXT4_HOST_DISK;
+
+/**
+   Initialises a disk backed by an image in memory.
+
+   @param[out]     Disk          Pointer to the disk.
+   @param[in]      Buffer        Pointer to the image. It must remain valid while the disk is used.
+   @param[in]      Size          Size of the image, in bytes.
+**/
+VOID
+Ext4HostDiskInitBuffer (
+  OUT EXT4_HOST_DISK  *Disk,
+  IN  CONST VOID      *Buffer,
+  IN  UINT64          Size
+  );
+
+/**
+   Initialises a disk backed by an image file on the host.
+
+   @param[out]     Disk          Pointer to the disk.
+   @param[in]      Path          Path of the image file.
+   @param[in]      Writable      TRUE if the image may be modified, else the media is read-only.
+
+   @retval EFI_SUCCESS           The image was opened.
+   @retval EFI_NOT_FOUND         The image could not be opened.
+**/
+EFI_STATUS
+Ext4HostDiskInitFile (
+  OUT EXT4_HOST_DISK  *Disk,
+  IN  CONST CHAR8     *Path,
+  IN  BOOLEAN         Writable
+  );
+
+/**
+   Releases the resources of a disk.
+
+   @param[in out]  Disk          Pointer to the disk.
+**/
+VOID
+Ext4HostDiskClose (
+  IN OUT EXT4_HOST_DISK  *Disk
+  );
+
+/**
+   Mounts the filesystem in a disk, the same way Ext4OpenPartition does,
+   without installing any protocols.
+
+   @param[in]      Disk          Pointer to the disk.
+   @param[out]     Partition     Pointer to where the partition will be stored.
+
+   @return Result of Ext4OpenSuperblock.
+**/
+EFI_STATUS
+Ext4HostMount (
+  IN  EXT4_HOST_DISK  *Disk,
+  OUT EXT4_PARTITION  **Partition
+  );
+
+#endif
@@ -0,0 +1,419 @@
+/** @file
+  Metadata writeback.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  File data is written to the disk as soon as it's written to the file, but metadata
+  (bitmaps, group descriptors, inode tables, extent tree, indirect and directory blocks)
+  is modified a lot more often, in small pieces. Modified metadata blocks are instead kept
+  in memory, sorted by block number, and written back in as few disk requests as possible
+  when a file is flushed or closed, or when there are too many of them.
+  Every disk read goes through the dirty blocks, so they take precedence over the disk.
+**/
+
+#include "Ext4Dxe.h"
+
+// Entry of the dirty block set, keyed by block number
+typedef struct {
+  EXT4_BLOCK_NR    Block;
+} EXT4_DIRTY_BLOCK;
+
+// Entries are followed by the block's contents
+#define EXT4_DIRTY_BLOCK_DATA(Entry)  ((UINT8 *)((Entry) + 1))
+
+// Maximum number of blocks written by a single writeback request
+#define EXT4_WRITEBACK_MAX_BLOCKS  32
+
+/**
+  Compare two EXT4_DIRTY_BLOCK structures.
+  Used in the dirty block set's ORDERED_COLLECTION.
+
+  @param[in] UserStruct1  Pointer to the first user structure.
+
+  @param[in] UserStruct2  Pointer to the second user structure.
+
+  @retval <0  If UserStruct1 compares less than UserStruct2.
+
+  @retval  0  If UserStruct1 compares equal to UserStruct2.
+
+  @retval >0  If UserStruct1 compares greater than UserStruct2.
+**/
+STATIC
+INTN
+EFIAPI
+Ext4DirtyBlockStructCompare (
+  IN CONST VOID  *UserStruct1,
+  IN CONST VOID  *UserStruct2
+  )
+{
+  CONST EXT4_DIRTY_BLOCK  *Block1;
+  CONST EXT4_DIRTY_BLOCK  *Block2;
+
+  Block1 = UserStruct1;
+  Block2 = UserStruct2;
+
+  return Block1->Block < Block2->Block ? -1 :
+         Block1->Block > Block2->Block ? 1 : 0;
+}
+
+/**
+  Compare a standalone key against a EXT4_DIRTY_BLOCK containing an embedded key.
+  Used in the dirty block set's ORDERED_COLLECTION.
+
+  @param[in] StandaloneKey  Pointer to the bare key, an EXT4_BLOCK_NR.
+
+  @param[in] UserStruct     Pointer to the user structure with the embedded
+                            key.
+
+  @retval <0  If StandaloneKey compares less than UserStruct's key.
+
+  @retval  0  If StandaloneKey compares equal to UserStruct's key.
+
+  @retval >0  If StandaloneKey compares greater than UserStruct's key.
+**/
+STATIC
+INTN
+EFIAPI
+Ext4DirtyBlockKeyCompare (
+  IN CONST VOID  *StandaloneKey,
+  IN CONST VOID  *UserStruct
+  )
+{
+  CONST EXT4_DIRTY_BLOCK  *Entry;
+  EXT4_BLOCK_NR           Block;
+
+  Entry = UserStruct;
+  Block = *(CONST EXT4_BLOCK_NR *)StandaloneKey;
+
+  return Block < Entry->Block ? -1 :
+         Block > Entry->Block ? 1 : 0;
+}
+
+/**
+   Replaces the contents of a metadata block. The block is kept in memory, and is only
+   written to the disk by Ext4FlushPartition.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Block         Block number.
+   @param[in]      Data          Pointer to the new contents, Partition->BlockSize bytes long.
+
+   @retval EFI_SUCCESS             The block was marked dirty.
+   @retval EFI_OUT_OF_RESOURCES    Failed to allocate memory.
+**/
+EFI_STATUS
+Ext4MarkBlockDirty (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_BLOCK_NR   Block,
+  IN CONST VOID      *Data
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *CollectionEntry;
+  EXT4_DIRTY_BLOCK          *Entry;
+  RETURN_STATUS             Status;
+
+  if (Partition->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  if (Partition->DirtyBlocks == NULL) {
+    Partition->DirtyBlocks = OrderedCollectionInit (Ext4DirtyBlockStructCompare, Ext4DirtyBlockKeyCompare);
+
+    if (Partition->DirtyBlocks == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  CollectionEntry = OrderedCollectionFind (Partition->DirtyBlocks, &Block);
+
+  if (CollectionEntry == NULL) {
+    Entry = AllocatePool (sizeof (EXT4_DIRTY_BLOCK) + Partition->BlockSize);
+
+    if (Entry == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Entry->Block = Block;
+
+    Status = OrderedCollectionInsert (Partition->DirtyBlocks, NULL, Entry);
+
+    if (EFI_ERROR (Status)) {
+      FreePool (Entry);
+      return Status;
+    }
+
+    Partition->NumberDirtyBlocks++;
+  }
+
+  // Fills in the dirty block, along with any cached copy of it
+  Ext4UpdateCachedCopies (Partition, Data, Partition->BlockSize, EXT4_BLOCK_TO_BYTES (Partition, Block));
+  return EFI_SUCCESS;
+}
+
+/**
+   Copies the part of a dirty block that overlaps a range of the disk, either from the
+   block into a buffer or the other way around.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Entry         Pointer to the dirty block.
+   @param[in out]  Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the buffer in the disk.
+   @param[in]      ToBuffer      TRUE to copy the dirty block into the buffer,
+                                 FALSE to copy the buffer into the dirty block.
+**/
+STATIC
+VOID
+Ext4CopyDirtyBlock (
+  IN     EXT4_PARTITION    *Partition,
+  IN     EXT4_DIRTY_BLOCK  *Entry,
+  IN OUT VOID              *Buffer,
+  IN     UINTN             Length,
+  IN     UINT64            Offset,
+  IN     BOOLEAN           ToBuffer
+  )
+{
+  UINT64  BlockOffset;
+
+  BlockOffset = EXT4_BLOCK_TO_BYTES (Partition, Entry->Block);
+
+  if (ToBuffer) {
+    Ext4CopyOverlap (Buffer, Length, Offset, EXT4_DIRTY_BLOCK_DATA (Entry), Partition->BlockSize, BlockOffset);
+  } else {
+    Ext4CopyOverlap (EXT4_DIRTY_BLOCK_DATA (Entry), Partition->BlockSize, BlockOffset, Buffer, Length, Offset);
+  }
+}
+
+/**
+   Copies every dirty block that overlaps a range of the disk into a buffer, or the
+   buffer into the dirty blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the buffer in the disk.
+   @param[in]      ToBuffer      TRUE to copy the dirty blocks into the buffer,
+                                 FALSE to copy the buffer into the dirty blocks.
+**/
+STATIC
+VOID
+Ext4CopyDirtyBlocks (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT VOID            *Buffer,
+  IN     UINTN           Length,
+  IN     UINT64          Offset,
+  IN     BOOLEAN         ToBuffer
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *CollectionEntry;
+  EXT4_DIRTY_BLOCK          *Entry;
+  EXT4_BLOCK_NR             FirstBlock;
+  EXT4_BLOCK_NR             LastBlock;
+  EXT4_BLOCK_NR             Block;
+
+  if ((Partition->DirtyBlocks == NULL) || (Length == 0)) {
+    return;
+  }
+
+  FirstBlock = DivU64x32 (Offset, Partition->BlockSize);
+  LastBlock  = DivU64x32 (Offset + Length - 1, Partition->BlockSize);
+
+  if (LastBlock - FirstBlock < Partition->NumberDirtyBlocks) {
+    // Small range, look up each of its blocks
+    for (Block = FirstBlock; Block <= LastBlock; Block++) {
+      CollectionEntry = OrderedCollectionFind (Partition->DirtyBlocks, &Block);
+
+      if (CollectionEntry != NULL) {
+        Ext4CopyDirtyBlock (Partition, OrderedCollectionUserStruct (CollectionEntry), Buffer, Length, Offset, ToBuffer);
+      }
+    }
+
+    return;
+  }
+
+  // Large range, walk the (sorted) set instead
+  for (CollectionEntry = OrderedCollectionMin (Partition->DirtyBlocks);
+       CollectionEntry != NULL;
+       CollectionEntry = OrderedCollectionNext (CollectionEntry))
+  {
+    Entry = OrderedCollectionUserStruct (CollectionEntry);
+
+    if (Entry->Block > LastBlock) {
+      break;
+    }
+
+    if (Entry->Block >= FirstBlock) {
+      Ext4CopyDirtyBlock (Partition, Entry, Buffer, Length, Offset, ToBuffer);
+    }
+  }
+}
+
+/**
+   Copies the dirty blocks that overlap a disk read into its buffer.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  Buffer        Pointer to the buffer, holding the data read from disk.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the data in the disk.
+**/
+VOID
+Ext4ApplyDirtyBlocks (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT VOID            *Buffer,
+  IN     UINTN           Length,
+  IN     UINT64          Offset
+  )
+{
+  Ext4CopyDirtyBlocks (Partition, Buffer, Length, Offset, TRUE);
+}
+
+/**
+   Updates the dirty blocks that overlap a range of the disk, after it was written to.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      Buffer        Pointer to the new data.
+   @param[in]      Length        Length of the new data, in bytes.
+   @param[in]      Offset        Offset, in bytes, of the new data in the disk.
+**/
+VOID
+Ext4UpdateDirtyBlocks (
+  IN EXT4_PARTITION  *Partition,
+  IN CONST VOID      *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  )
+{
+  Ext4CopyDirtyBlocks (Partition, (VOID *)Buffer, Length, Offset, FALSE);
+}
+
+/**
+   Writes every dirty metadata block (and the superblock, if it was modified) back to the
+   disk, and flushes the disk's write cache.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+
+   @return Status of the writeback. On failure, the blocks are kept dirty.
+**/
+EFI_STATUS
+Ext4FlushPartition (
+  IN EXT4_PARTITION  *Partition
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *CollectionEntry;
+  ORDERED_COLLECTION_ENTRY  *RunEnd;
+  EXT4_DIRTY_BLOCK          *Entry;
+  EXT4_DIRTY_BLOCK          *First;
+  UINT8                     *Buffer;
+  UINTN                     RunLength;
+  EFI_STATUS                Status;
+
+  Status = EFI_SUCCESS;
+
+  if (Partition->NumberDirtyBlocks != 0) {
+    Buffer = AllocatePool (EXT4_WRITEBACK_MAX_BLOCKS * Partition->BlockSize);
+
+    if (Buffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    // Coalesce runs of adjacent blocks into a single write
+    CollectionEntry = OrderedCollectionMin (Partition->DirtyBlocks);
+
+    while (CollectionEntry != NULL) {
+      First     = OrderedCollectionUserStruct (CollectionEntry);
+      RunEnd    = CollectionEntry;
+      RunLength = 0;
+
+      do {
+        Entry = OrderedCollectionUserStruct (RunEnd);
+
+        if ((Entry->Block != First->Block + RunLength) || (RunLength == EXT4_WRITEBACK_MAX_BLOCKS)) {
+          break;
+        }
+
+        CopyMem (Buffer + RunLength * Partition->BlockSize, EXT4_DIRTY_BLOCK_DATA (Entry), Partition->BlockSize);
+        RunLength++;
+        RunEnd = OrderedCollectionNext (RunEnd);
+      } while (RunEnd != NULL);
+
+      Status = EXT4_DISK_IO (Partition)->WriteDisk (
+                                           EXT4_DISK_IO (Partition),
+                                           EXT4_MEDIA_ID (Partition),
+                                           EXT4_BLOCK_TO_BYTES (Partition, First->Block),
+                                           RunLength * Partition->BlockSize,
+                                           Buffer
+                                           );
+
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "[ext4] Error writing back metadata blocks: %r\n", Status));
+        break;
+      }
+
+      CollectionEntry = RunEnd;
+    }
+
+    FreePool (Buffer);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Ext4FreeDirtyBlocks (Partition);
+  }
+
+  if (Partition->SuperBlockDirty) {
+    Status = Ext4WriteSuperblock (Partition);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EXT4_BLOCK_IO (Partition)->FlushBlocks (EXT4_BLOCK_IO (Partition));
+}
+
+/**
+   Writes the dirty metadata back if there are more than PcdExt4DirtyBlockLimit dirty blocks.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+
+   @return Status of the writeback.
+**/
+EFI_STATUS
+Ext4FlushPartitionIfNeeded (
+  IN EXT4_PARTITION  *Partition
+  )
+{
+  if (Partition->NumberDirtyBlocks < PcdGet32 (PcdExt4DirtyBlockLimit)) {
+    return EFI_SUCCESS;
+  }
+
+  return Ext4FlushPartition (Partition);
+}
+
+/**
+   Drops every dirty block, without writing it back.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeDirtyBlocks (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  ORDERED_COLLECTION_ENTRY  *MinEntry;
+  EXT4_DIRTY_BLOCK          *Entry;
+
+  if (Partition->DirtyBlocks == NULL) {
+    return;
+  }
+
+  while ((MinEntry = OrderedCollectionMin (Partition->DirtyBlocks)) != NULL) {
+    OrderedCollectionDelete (Partition->DirtyBlocks, MinEntry, (VOID **)&Entry);
+    FreePool (Entry);
+  }
+
+  OrderedCollectionUninit (Partition->DirtyBlocks);
+  Partition->DirtyBlocks       = NULL;
+  Partition->NumberDirtyBlocks = 0;
+}
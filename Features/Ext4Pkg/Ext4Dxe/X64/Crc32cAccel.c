@@ -0,0 +1,133 @@
+/** @file
+  CRC32C calculation with the SSE4.2 crc32 instruction.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "../Ext4Dxe.h"
+
+#define CPUID_VERSION_INFO_ECX_SSE4_2  BIT20
+
+#if defined (_MSC_VER)
+unsigned __int64
+_mm_crc32_u64 (
+  unsigned __int64  Crc,
+  unsigned __int64  Value
+  );
+
+unsigned int
+_mm_crc32_u8 (
+  unsigned int   Crc,
+  unsigned char  Value
+  );
+
+  #pragma intrinsic(_mm_crc32_u64, _mm_crc32_u8)
+#endif
+
+/**
+   Checks if the CPU supports SSE4.2, which has the crc32 instruction.
+
+   @retval TRUE    The CPU supports SSE4.2.
+   @retval FALSE   The CPU doesn't support SSE4.2.
+**/
+BOOLEAN
+Ext4Crc32cAccelSupported (
+  VOID
+  )
+{
+  UINT32  Ecx;
+
+  AsmCpuid (0x1, NULL, NULL, &Ecx, NULL);
+  return (Ecx & CPUID_VERSION_INFO_ECX_SSE4_2) != 0;
+}
+
+/**
+   Adds 8 bytes to a CRC32C.
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Value         Bytes to add.
+
+   @return The new value of the CRC.
+**/
+STATIC
+UINT32
+Ext4Crc32cU64 (
+  IN UINT32  Crc,
+  IN UINT64  Value
+  )
+{
+ #if defined (_MSC_VER)
+  return (UINT32)_mm_crc32_u64 (Crc, Value);
+ #else
+  UINT64  Result;
+
+  Result = Crc;
+  __asm__ ("crc32q %1, %0" : "+r" (Result) : "rm" (Value));
+  return (UINT32)Result;
+ #endif
+}
+
+/**
+   Adds a byte to a CRC32C.
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Value         Byte to add.
+
+   @return The new value of the CRC.
+**/
+STATIC
+UINT32
+Ext4Crc32cU8 (
+  IN UINT32  Crc,
+  IN UINT8   Value
+  )
+{
+ #if defined (_MSC_VER)
+  return _mm_crc32_u8 (Crc, Value);
+ #else
+  __asm__ ("crc32b %1, %0" : "+r" (Crc) : "rm" (Value));
+  return Crc;
+ #endif
+}
+
+/**
+   Calculates the CRC32C of a buffer with the crc32 instruction.
+   Ext4Crc32cAccelSupported must have returned TRUE.
+
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+   @param[in]      Crc           Initial value of the CRC.
+
+   @return The CRC, not inverted.
+**/
+UINT32
+Ext4Crc32cAccel (
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length,
+  IN UINT32      Crc
+  )
+{
+  CONST UINT8  *Bytes;
+
+  Bytes = Buffer;
+
+  // Get to an 8-byte boundary, then do 8 bytes at a time
+  while ((Length != 0) && (((UINTN)Bytes & (sizeof (UINT64) - 1)) != 0)) {
+    Crc = Ext4Crc32cU8 (Crc, *Bytes++);
+    Length--;
+  }
+
+  while (Length >= sizeof (UINT64)) {
+    Crc     = Ext4Crc32cU64 (Crc, *(CONST UINT64 *)Bytes);
+    Bytes  += sizeof (UINT64);
+    Length -= sizeof (UINT64);
+  }
+
+  while (Length != 0) {
+    Crc = Ext4Crc32cU8 (Crc, *Bytes++);
+    Length--;
+  }
+
+  return Crc;
+}
@@ -96,7 +96,8 @@ typedef UINT32 MANAGEABILITY_TRANSPORT_CAPABILITY;
 #define MANAGEABILITY_TRANSPORT_CAPABILITY_MULTIPLE_TRANSFER_TOKENS  0x00000001
 /// Bit 1
 #define MANAGEABILITY_TRANSPORT_CAPABILITY_ASYNCHRONOUS_TRANSFER  0x00000002
-/// Bit 2   - Reserved
+/// Bit 2
+#define MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER  0x00000004
 /// Bit 7:3 - Transport interface maximum payload size, which is (2 ^ bit[7:3] - 1)
 ///           bit[7:3] means no maximum payload.
 #define MANAGEABILITY_TRANSPORT_CAPABILITY_MAXIMUM_PAYLOAD_MASK           0x000000f8
@@ -127,13 +128,30 @@ typedef struct {
   CHAR16      *SpecificationName;
 } MANAGEABILITY_SPECIFICATION_NAME;
 
+///
+/// Definitions of a scatter-gather segment of the transmit package.
+///
+typedef struct {
+  UINT8     *Buffer;
+  UINT32    SizeInByte;
+} MANAGEABILITY_TRANSMIT_SEGMENT;
+
 ///
 /// Definitions of Transmit/Receive package
 ///
 typedef struct {
-  UINT8     *TransmitPayload;
-  UINT32    TransmitSizeInByte;
-  UINT32    TransmitTimeoutInMillisecond;
+  UINT8                             *TransmitPayload;
+  UINT32                            TransmitSizeInByte;
+  UINT32                            TransmitTimeoutInMillisecond;
+  MANAGEABILITY_TRANSMIT_SEGMENT    *TransmitSegments;        ///< Scatter-gather list of the payload.
+                                                              ///< If non-NULL, the payload is the
+                                                              ///< concatenation of the segments,
+                                                              ///< TransmitPayload is ignored and
+                                                              ///< TransmitSizeInByte is the total size.
+                                                              ///< Only used with transport interfaces
+                                                              ///< that report
+                                                              ///< MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER.
+  UINT16                            NumberOfTransmitSegments; ///< Number of entries in TransmitSegments.
 } MANAGEABILITY_TRANSMIT_PACKAGE;
 
 typedef struct {
@@ -0,0 +1,101 @@
+/** @file
+  Protocol of EDKII IPMI asynchronous command submission.
+
+  Commands are queued and sent to the BMC in the background, one at a time, over the
+  transport interface of the IPMI protocol. Each command is completed by signaling
+  the event of its token, so that drivers can go on while the BMC works.
+
+  A queued command is sent at TPL_CALLBACK. The commands submitted through
+  IPMI_PROTOCOL at or below TPL_CALLBACK wait for it to complete, and are sent
+  at TPL_CALLBACK too.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EDKII_IPMI_ASYNC_PROTOCOL_H_
+#define EDKII_IPMI_ASYNC_PROTOCOL_H_
+
+typedef struct _EDKII_IPMI_ASYNC_PROTOCOL EDKII_IPMI_ASYNC_PROTOCOL;
+
+#define EDKII_IPMI_ASYNC_PROTOCOL_GUID \
+  { \
+    0xADDA2AF7, 0x9C70, 0x47BF, { 0xA7, 0x2C, 0xCD, 0xDC, 0x2C, 0x63, 0x42, 0xCA } \
+  }
+
+///
+/// An asynchronous IPMI command. The token and its buffers belong to the caller,
+/// and must stay valid until Event is signaled.
+///
+typedef struct {
+  ///
+  /// Event signaled when the command is completed. It is required.
+  ///
+  EFI_EVENT     Event;
+  ///
+  /// Status of the command, EFI_NOT_READY while it is queued or sent. Once the
+  /// event is signaled, it holds the status IPMI_PROTOCOL.IpmiSubmitCommand()
+  /// would have returned, or EFI_ABORTED if the command was cancelled.
+  ///
+  EFI_STATUS    TransactionStatus;
+  UINT8         NetFunction;
+  UINT8         Command;
+  UINT8         *RequestData;
+  UINT32        RequestDataSize;
+  ///
+  /// Response data. The completion code is the first byte of response data.
+  ///
+  UINT8         *ResponseData;
+  ///
+  /// Size of the ResponseData buffer on input, size of the response once completed.
+  ///
+  UINT32        ResponseDataSize;
+} EDKII_IPMI_ASYNC_TOKEN;
+
+/**
+  This service queues an IPMI command and returns without waiting for the BMC.
+
+  @param[in]      This              EDKII_IPMI_ASYNC_PROTOCOL instance.
+  @param[in, out] Token             The command to submit.
+
+  @retval EFI_SUCCESS            The command is queued, and Token->Event will be
+                                 signaled when it is completed.
+  @retval EFI_INVALID_PARAMETER  Token or Token->Event is NULL, or one of the data
+                                 buffers is NULL while its size is not 0.
+  @retval EFI_OUT_OF_RESOURCES   The command can't be queued.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_ASYNC_SUBMIT_COMMAND)(
+  IN     EDKII_IPMI_ASYNC_PROTOCOL  *This,
+  IN OUT EDKII_IPMI_ASYNC_TOKEN     *Token
+  );
+
+/**
+  This service cancels a queued IPMI command. A command that is already being
+  sent to the BMC can't be cancelled.
+
+  @param[in]      This              EDKII_IPMI_ASYNC_PROTOCOL instance.
+  @param[in, out] Token             The command to cancel, or NULL to cancel all the
+                                    queued commands.
+
+  @retval EFI_SUCCESS            The command is cancelled: its status is EFI_ABORTED
+                                 and its event is signaled.
+  @retval EFI_NOT_FOUND          The command isn't queued.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_ASYNC_CANCEL)(
+  IN     EDKII_IPMI_ASYNC_PROTOCOL  *This,
+  IN OUT EDKII_IPMI_ASYNC_TOKEN     *Token OPTIONAL
+  );
+
+struct _EDKII_IPMI_ASYNC_PROTOCOL {
+  EDKII_IPMI_ASYNC_SUBMIT_COMMAND    SubmitCommand;
+  EDKII_IPMI_ASYNC_CANCEL            Cancel;
+};
+
+extern EFI_GUID  gEdkiiIpmiAsyncProtocolGuid;
+
+#endif // EDKII_IPMI_ASYNC_PROTOCOL_H_
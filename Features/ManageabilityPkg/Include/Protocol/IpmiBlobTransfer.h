@@ -31,7 +31,7 @@
 //
 // OpenBMC OEN code in little endian format
 //
-CONST UINT8  OpenBmcOen[] = { 0xCF, 0xC2, 0x00 };
+STATIC CONST UINT8  OpenBmcOen[] = { 0xCF, 0xC2, 0x00 };
 
 //
 //  Blob Transfer Function Prototypes
@@ -245,6 +245,76 @@ EFI_STATUS
   IN  UINT32      WriteLength
   );
 
+/**
+  This function is called by the streaming functions after each packet is transferred.
+
+  @param[in]         Context         The context passed to the streaming function
+  @param[in]         Transferred     The number of bytes transferred so far
+  @param[in]         Total           The total number of bytes to transfer
+**/
+typedef
+VOID
+(EFIAPI *EDKII_IPMI_BLOB_TRANSFER_PROGRESS)(
+  IN  VOID        *Context OPTIONAL,
+  IN  UINT32      Transferred,
+  IN  UINT32      Total
+  );
+
+/**
+  This function reads data of any size from a blob over the IPMI. The data is split
+  into BLOB_MAX_DATA_PER_PACKET sized reads, all sent from the same buffers.
+  Reading stops early if the BMC returns less data than requested, at the end of the blob.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start reading
+  @param[in, out]    DataSize        On input, the length of data to read.
+                                     On output, the length of data read.
+  @param[out]        Data            Data read from the blob
+  @param[in]         Progress        Function called after each packet. This is optional.
+  @param[in]         Context         Context passed to Progress. This is optional.
+
+  @retval EFI_SUCCESS                Successfully read from the blob.
+  @retval EFI_INVALID_PARAMETER      The read goes past the largest blob offset.
+  @retval Other                      An error occurred. DataSize is the length of data read
+                                     before the error.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_READ_STREAM)(
+  IN     UINT16                             SessionId,
+  IN     UINT32                             Offset,
+  IN OUT UINT32                             *DataSize,
+  OUT    UINT8                              *Data,
+  IN     EDKII_IPMI_BLOB_TRANSFER_PROGRESS  Progress OPTIONAL,
+  IN     VOID                               *Context OPTIONAL
+  );
+
+/**
+  This function writes data of any size to a blob over the IPMI. The data is split
+  into BLOB_MAX_DATA_PER_PACKET sized writes, all sent from the same buffers.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start writing
+  @param[in]         Data            A pointer to the data to write
+  @param[in]         WriteLength     The length to write
+  @param[in]         Progress        Function called after each packet. This is optional.
+  @param[in]         Context         Context passed to Progress. This is optional.
+
+  @retval EFI_SUCCESS                Successfully wrote to the blob.
+  @retval EFI_INVALID_PARAMETER      The write goes past the largest blob offset.
+  @retval Other                      An error occurred
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_STREAM)(
+  IN  UINT16                             SessionId,
+  IN  UINT32                             Offset,
+  IN  UINT8                              *Data,
+  IN  UINT32                             WriteLength,
+  IN  EDKII_IPMI_BLOB_TRANSFER_PROGRESS  Progress OPTIONAL,
+  IN  VOID                               *Context OPTIONAL
+  );
+
 //
 // Structure of EDKII_IPMI_BLOB_TRANSFER_PROTOCOL
 //
@@ -260,6 +330,8 @@ struct _EDKII_IPMI_BLOB_TRANSFER_PROTOCOL {
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_STAT            BlobStat;
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_SESSION_STAT    BlobSessionStat;
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_META      BlobWriteMeta;
+  EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_READ_STREAM     BlobReadStream;
+  EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_STREAM    BlobWriteStream;
 };
 
 typedef struct _EDKII_IPMI_BLOB_TRANSFER_PROTOCOL EDKII_IPMI_BLOB_TRANSFER_PROTOCOL;
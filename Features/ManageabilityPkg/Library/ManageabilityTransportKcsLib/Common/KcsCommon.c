@@ -9,12 +9,14 @@
 #include <Uefi.h>
 #include <IndustryStandard/IpmiKcs.h>
 #include <IndustryStandard/Mctp.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/IoLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ManageabilityTransportHelperLib.h>
 #include <Library/ManageabilityTransportMctpLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/TimerLib.h>
 
 #include "ManageabilityTransportKcs.h"
@@ -22,57 +24,217 @@
 extern MANAGEABILITY_TRANSPORT_KCS_HARDWARE_INFO  mKcsHardwareInfo;
 extern MANAGEABILITY_TRANSPORT_KCS                *mSingleSessionToken;
 
+STATIC KCS_POLL_HISTOGRAM  mKcsPollHistograms[KcsPollPhaseMax];
+STATIC UINT32              mKcsTransactionCount;
+
+STATIC CONST CHAR8  *mKcsPollPhaseNames[KcsPollPhaseMax] = {
+  "WriteStart",
+  "WriteData",
+  "WriteEnd",
+  "ReadIbf",
+  "ReadObf"
+};
+
 /**
-  This function waits for parameter Flag to set.
-  Checks status flag in every 1ms internal till 5 seconds elapses.
+  This function returns the time elapsed between two performance counter values.
+
+  @param[in]  Start       Performance counter value at the start.
+  @param[in]  End         Performance counter value at the end.
+
+  @retval     UINT64      The elapsed time, in nanoseconds.
+**/
+STATIC
+UINT64
+KcsPollElapsedNs (
+  IN  UINT64  Start,
+  IN  UINT64  End
+  )
+{
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+  UINT64  Ticks;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart < CounterEnd) {
+    Ticks = (End >= Start) ? End - Start : (CounterEnd - Start) + (End - CounterStart) + 1;
+  } else {
+    Ticks = (Start >= End) ? Start - End : (Start - CounterEnd) + (CounterStart - End) + 1;
+  }
+
+  return GetTimeInNanoSecond (Ticks);
+}
+
+/**
+  This function adds the latency of a wait to the histogram of its phase,
+  if PcdKcsPollHistogramEnable is set.
+
+  @param[in]  Phase       The phase of the KCS transaction.
+  @param[in]  Start       Performance counter value at the start of the wait.
+  @param[in]  TimedOut    TRUE if the wait timed out.
+**/
+STATIC
+VOID
+KcsPollRecord (
+  IN  KCS_POLL_PHASE  Phase,
+  IN  UINT64          Start,
+  IN  BOOLEAN         TimedOut
+  )
+{
+  KCS_POLL_HISTOGRAM  *Histogram;
+  UINT64              ElapsedNs;
+  UINT64              ElapsedUs;
+  UINTN               Bucket;
+
+  if (!FeaturePcdGet (PcdKcsPollHistogramEnable)) {
+    return;
+  }
+
+  Histogram = &mKcsPollHistograms[Phase];
+  ElapsedNs = KcsPollElapsedNs (Start, GetPerformanceCounter ());
+  ElapsedUs = DivU64x32 (ElapsedNs, 1000);
+  Bucket    = (ElapsedUs == 0) ? 0 : (UINTN)HighBitSet64 (ElapsedUs) + 1;
+
+  Histogram->Count++;
+  Histogram->TotalNs += ElapsedNs;
+  Histogram->MaxNs    = MAX (Histogram->MaxNs, ElapsedNs);
+  Histogram->Buckets[MIN (Bucket, KCS_POLL_HISTOGRAM_BUCKETS - 1)]++;
+  if (TimedOut) {
+    Histogram->Timeouts++;
+  }
+}
+
+/**
+  This function waits for parameter Flag to be set or cleared.
+  It reads the status register KCS_POLL_SPIN_COUNT times back to back, then
+  backs off exponentially up to 1ms between reads, till 5 seconds elapses.
 
   @param[in]  Flag        KCS Flag to test.
-  @retval     EFI_SUCCESS The KCS flag under test is set.
-  @retval     EFI_TIMEOUT The KCS flag didn't set in 5 second windows.
+  @param[in]  Set         TRUE to wait for the flag to set, FALSE to wait for it to clear.
+  @param[in]  Phase       The phase of the KCS transaction, for the latency histograms.
+
+  @retval     EFI_SUCCESS The KCS flag under test is in the expected state.
+  @retval     EFI_TIMEOUT The KCS flag didn't change in 5 second windows.
 **/
+STATIC
 EFI_STATUS
-WaitStatusSet (
-  IN  UINT8  Flag
+KcsWaitStatus (
+  IN  UINT8           Flag,
+  IN  BOOLEAN         Set,
+  IN  KCS_POLL_PHASE  Phase
   )
 {
-  UINT64  Timeout = 0;
+  UINT64  Start;
+  UINT64  Timeout;
+  UINTN   Delay;
+  UINTN   Spin;
+
+  Start   = FeaturePcdGet (PcdKcsPollHistogramEnable) ? GetPerformanceCounter () : 0;
+  Timeout = 0;
+  Delay   = 0;
+
+  for (Spin = 0; ((KcsRegisterRead8 (KCS_REG_STATUS) & Flag) != 0) != Set; Spin++) {
+    if (Spin < KCS_POLL_SPIN_COUNT) {
+      CpuPause ();
+      continue;
+    }
 
-  while (!(KcsRegisterRead8 (KCS_REG_STATUS) & Flag)) {
-    MicroSecondDelay (IPMI_KCS_TIMEOUT_1MS);
-    Timeout = Timeout + IPMI_KCS_TIMEOUT_1MS;
+    Delay = (Delay == 0) ? KCS_POLL_MIN_DELAY_US : MIN (Delay * 2, IPMI_KCS_TIMEOUT_1MS);
+    MicroSecondDelay (Delay);
+    Timeout = Timeout + Delay;
     if (Timeout >= IPMI_KCS_TIMEOUT_5_SEC) {
+      KcsPollRecord (Phase, Start, TRUE);
       return EFI_TIMEOUT;
     }
   }
 
+  KcsPollRecord (Phase, Start, FALSE);
   return EFI_SUCCESS;
 }
 
+/**
+  This function waits for parameter Flag to set.
+
+  @param[in]  Flag        KCS Flag to test.
+  @param[in]  Phase       The phase of the KCS transaction.
+
+  @retval     EFI_SUCCESS The KCS flag under test is set.
+  @retval     EFI_TIMEOUT The KCS flag didn't set in 5 second windows.
+**/
+EFI_STATUS
+WaitStatusSet (
+  IN  UINT8           Flag,
+  IN  KCS_POLL_PHASE  Phase
+  )
+{
+  return KcsWaitStatus (Flag, TRUE, Phase);
+}
+
 /**
   This function waits for parameter Flag to get cleared.
-  Checks status flag in every 1ms internal till 5 seconds elapses.
 
   @param[in]  Flag        KCS Flag to test.
+  @param[in]  Phase       The phase of the KCS transaction.
 
   @retval     EFI_SUCCESS The KCS flag under test is clear.
   @retval     EFI_TIMEOUT The KCS flag didn't cleared in 5 second windows.
 **/
 EFI_STATUS
 WaitStatusClear (
-  IN  UINT8  Flag
+  IN  UINT8           Flag,
+  IN  KCS_POLL_PHASE  Phase
   )
 {
-  UINT64  Timeout = 0;
+  return KcsWaitStatus (Flag, FALSE, Phase);
+}
 
-  while (KcsRegisterRead8 (KCS_REG_STATUS) & Flag) {
-    MicroSecondDelay (IPMI_KCS_TIMEOUT_1MS);
-    Timeout = Timeout + IPMI_KCS_TIMEOUT_1MS;
-    if (Timeout >= IPMI_KCS_TIMEOUT_5_SEC) {
-      return EFI_TIMEOUT;
-    }
+/**
+  This function prints the status register polling latency histograms
+  of each phase of the KCS transactions, if PcdKcsPollHistogramEnable is set.
+
+**/
+VOID
+KcsDumpPollHistograms (
+  VOID
+  )
+{
+  KCS_POLL_HISTOGRAM  *Histogram;
+  UINTN               Phase;
+  UINTN               Bucket;
+
+  if (!FeaturePcdGet (PcdKcsPollHistogramEnable)) {
+    return;
   }
 
-  return EFI_SUCCESS;
+  DEBUG ((DEBUG_MANAGEABILITY_INFO, "KCS status polling latency after %d transactions:\n", mKcsTransactionCount));
+  for (Phase = 0; Phase < KcsPollPhaseMax; Phase++) {
+    Histogram = &mKcsPollHistograms[Phase];
+    if (Histogram->Count == 0) {
+      continue;
+    }
+
+    DEBUG ((
+      DEBUG_MANAGEABILITY_INFO,
+      "  %-10a: %d waits, %d timeouts, average %ldns, max %ldns\n",
+      mKcsPollPhaseNames[Phase],
+      Histogram->Count,
+      Histogram->Timeouts,
+      DivU64x32 (Histogram->TotalNs, Histogram->Count),
+      Histogram->MaxNs
+      ));
+    for (Bucket = 0; Bucket < KCS_POLL_HISTOGRAM_BUCKETS; Bucket++) {
+      if (Histogram->Buckets[Bucket] == 0) {
+        continue;
+      }
+
+      if (Bucket == 0) {
+        DEBUG ((DEBUG_MANAGEABILITY_INFO, "    < 1us     : %d\n", Histogram->Buckets[Bucket]));
+      } else if (Bucket == KCS_POLL_HISTOGRAM_BUCKETS - 1) {
+        DEBUG ((DEBUG_MANAGEABILITY_INFO, "    >= %5dus: %d\n", 1 << (Bucket - 1), Histogram->Buckets[Bucket]));
+      } else {
+        DEBUG ((DEBUG_MANAGEABILITY_INFO, "    < %5dus : %d\n", 1 << Bucket, Histogram->Buckets[Bucket]));
+      }
+    }
+  }
 }
 
 /**
@@ -97,19 +259,44 @@ ClearOBF (
   return EFI_SUCCESS;
 }
 
+/**
+  This function returns the next byte of a list of transmit segments
+  and advances the cursor past it. Empty segments are skipped.
+
+  @param[in, out] Cursor                Position of the next byte.
+
+  @retval         UINT8                 The next byte.
+**/
+STATIC
+UINT8
+KcsTransmitNextByte (
+  IN OUT KCS_TRANSMIT_CURSOR  *Cursor
+  )
+{
+  UINT8  Byte;
+
+  while (Cursor->Offset >= Cursor->Segments[Cursor->Index].SizeInByte) {
+    Cursor->Index++;
+    Cursor->Offset = 0;
+    ASSERT (Cursor->Index < Cursor->NumberOfSegments);
+  }
+
+  Byte = Cursor->Segments[Cursor->Index].Buffer[Cursor->Offset];
+  Cursor->Offset++;
+  return Byte;
+}
+
 /**
   This function writes/sends data to the KCS port.
   Algorithm is based on flow chart provided in IPMI spec 2.0
   Figure 9-6, KCS Interface BMC to SMS Write Transfer Flow Chart
 
-  @param[in]      TransmitHeader        KCS packet header.
-  @param[in]      TransmitHeaderSize    KCS packet header size in byte.
-  @param[in]      TransmitTrailer       KCS packet trailer.
-  @param[in]      TransmitTrailerSize   KCS packet trailer size in byte.
-  @param[in]      RequestData           Command Request Data, could be NULL.
-                                        RequestDataSize must be zero, if RequestData
-                                        is NULL.
-  @param[in]      RequestDataSize       Size of Command Request Data.
+  The bytes are written straight from the segments, so the transmit
+  header, the request data and the transmit trailer don't have to be
+  copied into one buffer first.
+
+  @param[in]      Segments              The segments to write, in order.
+  @param[in]      NumberOfSegments      Number of entries in Segments.
 
   @retval     EFI_SUCCESS           The command byte stream was successfully
                                     submit to the device and a response was
@@ -123,94 +310,47 @@ ClearOBF (
   @retval     EFI_TIMEOUT           The command time out.
   @retval     EFI_UNSUPPORTED       The command was not successfully sent to
                                     the device.
-  @retval     EFI_OUT_OF_RESOURCES  The resource allocation is out of resource or
-                                    data size error.
+  @retval     EFI_INVALID_PARAMETER There is nothing to write.
 **/
 EFI_STATUS
 KcsTransportWrite (
-  IN  MANAGEABILITY_TRANSPORT_HEADER   TransmitHeader,
-  IN  UINT16                           TransmitHeaderSize,
-  IN  MANAGEABILITY_TRANSPORT_TRAILER  TransmitTrailer OPTIONAL,
-  IN  UINT16                           TransmitTrailerSize,
-  IN  UINT8                            *RequestData OPTIONAL,
-  IN  UINT32                           RequestDataSize
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN  UINT16                          NumberOfSegments
   )
 {
-  EFI_STATUS  Status;
-  UINT32      Length;
-  UINT8       *Buffer;
-  UINT8       *BufferPtr;
-
-  // Validation on RequestData and RequestDataSize.
-  if (((RequestData == NULL) && (RequestDataSize != 0)) ||
-      ((RequestData != NULL) && (RequestDataSize == 0))
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of RequestData or RequestDataSize.\n", __func__));
-    return EFI_INVALID_PARAMETER;
-  }
+  EFI_STATUS           Status;
+  UINT32               Length;
+  UINT16               Index;
+  KCS_TRANSMIT_CURSOR  Cursor;
+
+  Length = 0;
+  for (Index = 0; Index < NumberOfSegments; Index++) {
+    if ((Segments[Index].Buffer == NULL) && (Segments[Index].SizeInByte != 0)) {
+      DEBUG ((DEBUG_ERROR, "%a: Mismatched values of segment #%d.\n", __func__, Index));
+      return EFI_INVALID_PARAMETER;
+    }
 
-  // Validation on TransmitHeader and TransmitHeaderSize.
-  if (((TransmitHeader == NULL) && (TransmitHeaderSize != 0)) ||
-      ((TransmitHeader != NULL) && (TransmitHeaderSize == 0))
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitHeader or TransmitHeaderSize.\n", __func__));
-    return EFI_INVALID_PARAMETER;
+    Length += Segments[Index].SizeInByte;
   }
 
-  // Validation on TransmitHeader and TransmitHeaderSize.
-  if (((TransmitTrailer == NULL) && (TransmitTrailerSize != 0)) ||
-      ((TransmitTrailer != NULL) && (TransmitTrailerSize == 0))
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitTrailer or TransmitTrailerSize.\n", __func__));
+  if (Length == 0) {
+    DEBUG ((DEBUG_ERROR, "%a: Nothing to write.\n", __func__));
     return EFI_INVALID_PARAMETER;
   }
 
-  Length = TransmitHeaderSize;
-  if (RequestData != NULL) {
-    Length = Length + RequestDataSize;
-  }
-
-  if ((TransmitTrailer != NULL) && (TransmitTrailerSize != 0)) {
-    Length += TransmitTrailerSize;
-  }
-
-  Buffer = AllocateZeroPool (Length);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  //
-  // Buffer[0..(TransmitHeaderSize - 1)] = TransmitHeader
-  // Buffer [TransmitHeader..(TransmitHeader + RequestDataSize - 1)] = RequestData
-  // Buffer [(TransmitHeader + RequestDataSize)..(TransmitHeader + RequestDataSize + TransmitTrailerSize - 1)] = TransmitTrailer
-  //
-  BufferPtr = Buffer;
-  CopyMem ((VOID *)BufferPtr, (VOID *)TransmitHeader, TransmitHeaderSize);
-  BufferPtr += TransmitHeaderSize;
-  if (RequestData != NULL) {
-    CopyMem (BufferPtr, RequestData, RequestDataSize);
-  }
-
-  BufferPtr += RequestDataSize;
-  if (TransmitTrailer != NULL) {
-    CopyMem (BufferPtr, (VOID *)TransmitTrailer, TransmitTrailerSize);
-  }
-
-  BufferPtr = Buffer;
+  Cursor.Segments         = Segments;
+  Cursor.NumberOfSegments = NumberOfSegments;
+  Cursor.Index            = 0;
+  Cursor.Offset           = 0;
 
   // Step 1. wait for IBF to get clear
-  Status = WaitStatusClear (IPMI_KCS_IBF);
+  Status = WaitStatusClear (IPMI_KCS_IBF, KcsPollWriteStart);
   if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
     return Status;
   }
 
   // Step 2. clear OBF
   if (EFI_ERROR (ClearOBF ())) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
@@ -218,46 +358,39 @@ KcsTransportWrite (
   KcsRegisterWrite8 (KCS_REG_COMMAND, IPMI_KCS_CONTROL_CODE_WRITE_START);
 
   // Step 4. wait for IBF to get clear
-  Status = WaitStatusClear (IPMI_KCS_IBF);
+  Status = WaitStatusClear (IPMI_KCS_IBF, KcsPollWriteStart);
   if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
     return Status;
   }
 
   // Step 5. check state it should be WRITE_STATE, else exit with error
   if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) != IpmiKcsWriteState) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   // Step 6, Clear OBF
   if (EFI_ERROR (ClearOBF ())) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   while (Length > 1) {
     // Step 7, phase wr_data, write one byte of Data
-    KcsRegisterWrite8 (KCS_REG_DATA_OUT, *BufferPtr);
+    KcsRegisterWrite8 (KCS_REG_DATA_OUT, KcsTransmitNextByte (&Cursor));
     Length--;
-    BufferPtr++;
 
     // Step 8. wait for IBF clear
-    Status = WaitStatusClear (IPMI_KCS_IBF);
+    Status = WaitStatusClear (IPMI_KCS_IBF, KcsPollWriteData);
     if (EFI_ERROR (Status)) {
-      FreePool (Buffer);
       return Status;
     }
 
     // Step 9. check state it should be WRITE_STATE, else exit with error
     if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) != IpmiKcsWriteState) {
-      FreePool (Buffer);
       return EFI_NOT_READY;
     }
 
     // Step 10
     if (EFI_ERROR (ClearOBF ())) {
-      FreePool (Buffer);
       return EFI_NOT_READY;
     }
 
@@ -271,27 +404,23 @@ KcsTransportWrite (
   KcsRegisterWrite8 (KCS_REG_COMMAND, IPMI_KCS_CONTROL_CODE_WRITE_END);
 
   // Step 13. wait for IBF to get clear
-  Status = WaitStatusClear (IPMI_KCS_IBF);
+  Status = WaitStatusClear (IPMI_KCS_IBF, KcsPollWriteEnd);
   if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
     return Status;
   }
 
   // Step 14. check state it should be WRITE_STATE, else exit with error
   if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) != IpmiKcsWriteState) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   // Step 15
   if (EFI_ERROR (ClearOBF ())) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   // Step 16, write the last byte
-  KcsRegisterWrite8 (KCS_REG_DATA_OUT, *BufferPtr);
-  FreePool (Buffer);
+  KcsRegisterWrite8 (KCS_REG_DATA_OUT, KcsTransmitNextByte (&Cursor));
   return EFI_SUCCESS;
 }
 
@@ -335,7 +464,7 @@ KcsTransportRead (
   ReadLength = 0;
   while (ReadLength < *Length) {
     // Step 1. wait for IBF to get clear
-    Status = WaitStatusClear (IPMI_KCS_IBF);
+    Status = WaitStatusClear (IPMI_KCS_IBF, KcsPollReadIbf);
     if (EFI_ERROR (Status)) {
       *Length = ReadLength;
       return Status;
@@ -344,7 +473,7 @@ KcsTransportRead (
     // Step 2. check state it should be READ_STATE, else exit with error
     if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) == IpmiKcsReadState) {
       // Step 2.1.1 check of OBF to get clear
-      Status = WaitStatusSet (IPMI_KCS_OBF);
+      Status = WaitStatusSet (IPMI_KCS_OBF, KcsPollReadObf);
       if (EFI_ERROR (Status)) {
         *Length = ReadLength;
         return Status;
@@ -352,7 +481,7 @@ KcsTransportRead (
 
       // Step 2.1.2 read data from data out
       DataByte[ReadLength++] = KcsRegisterRead8 (KCS_REG_DATA_IN);
-      Status                 = WaitStatusClear (IPMI_KCS_IBF);
+      Status                 = WaitStatusClear (IPMI_KCS_IBF, KcsPollReadIbf);
       if (EFI_ERROR (Status)) {
         *Length = ReadLength;
         return Status;
@@ -362,7 +491,7 @@ KcsTransportRead (
       KcsRegisterWrite8 (KCS_REG_DATA_OUT, IPMI_KCS_CONTROL_CODE_READ);
     } else if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) == IpmiKcsIdleState) {
       // Step 2.2.1
-      Status = WaitStatusSet (IPMI_KCS_OBF);
+      Status = WaitStatusSet (IPMI_KCS_OBF, KcsPollReadObf);
       if (EFI_ERROR (Status)) {
         *Length = ReadLength;
         return Status;
@@ -601,7 +730,13 @@ KcsReadResponseHeader (
   @param[in]      TransmitTrailer       KCS packet trailer.
   @param[in]      TransmitTrailerSize   KCS packet trailer size in byte.
   @param[in]      RequestData           Command Request Data.
-  @param[in]      RequestDataSize       Size of Command Request Data.
+  @param[in]      RequestDataSize       Size of Command Request Data. This is the
+                                        total size of RequestSegments if
+                                        RequestSegments is not NULL.
+  @param[in]      RequestSegments       Scatter-gather list of the Command Request
+                                        Data, could be NULL. RequestData is ignored
+                                        if this is not NULL.
+  @param[in]      NumberOfRequestSegments  Number of entries in RequestSegments.
   @param[out]     ResponseData          Command Response Data. The completion
                                         code is the first byte of response
                                         data.
@@ -632,20 +767,44 @@ KcsTransportSendCommand (
   IN  UINT16                                      TransmitTrailerSize,
   IN  UINT8                                       *RequestData OPTIONAL,
   IN  UINT32                                      RequestDataSize,
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT              *RequestSegments OPTIONAL,
+  IN  UINT16                                      NumberOfRequestSegments,
   OUT UINT8                                       *ResponseData OPTIONAL,
   IN  OUT UINT32                                  *ResponseDataSize OPTIONAL,
   OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
   )
 {
-  EFI_STATUS  Status;
-  UINT8       *RspHeader;
-  UINT32      ExpectedResponseDataSize;
+  EFI_STATUS                      Status;
+  UINT8                           *RspHeader;
+  UINT32                          ExpectedResponseDataSize;
+  MANAGEABILITY_TRANSMIT_SEGMENT  Segments[KCS_MAX_TRANSMIT_SEGMENTS];
+  UINT16                          NumberOfSegments;
+  UINT16                          Index;
 
   if ((RequestData != NULL) && (RequestDataSize == 0)) {
     DEBUG ((DEBUG_ERROR, "%a: Mismatched values of RequestData and RequestDataSize\n", __func__));
     return EFI_INVALID_PARAMETER;
   }
 
+  if (((TransmitHeader == NULL) && (TransmitHeaderSize != 0)) ||
+      ((TransmitHeader != NULL) && (TransmitHeaderSize == 0)))
+  {
+    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitHeader or TransmitHeaderSize.\n", __func__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (((TransmitTrailer == NULL) && (TransmitTrailerSize != 0)) ||
+      ((TransmitTrailer != NULL) && (TransmitTrailerSize == 0)))
+  {
+    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitTrailer or TransmitTrailerSize.\n", __func__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((RequestSegments != NULL) && (NumberOfRequestSegments > KCS_MAX_TRANSMIT_SEGMENTS - 2)) {
+    DEBUG ((DEBUG_ERROR, "%a: Too many request segments (%d).\n", __func__, NumberOfRequestSegments));
+    return EFI_INVALID_PARAMETER;
+  }
+
   if ((ResponseData != NULL) && ((ResponseDataSize != NULL) && (*ResponseDataSize == 0))) {
     DEBUG ((DEBUG_ERROR, "%a: Mismatched values of ResponseData and ResponseDataSize\n", __func__));
     return EFI_INVALID_PARAMETER;
@@ -656,12 +815,25 @@ KcsTransportSendCommand (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (FeaturePcdGet (PcdKcsPollHistogramEnable)) {
+    mKcsTransactionCount++;
+    if ((mKcsTransactionCount % KCS_POLL_HISTOGRAM_DUMP_INTERVAL) == 0) {
+      KcsDumpPollHistograms ();
+    }
+  }
+
   // Print out the request payloads.
   if ((TransmitHeader != NULL) && (TransmitHeaderSize != 0)) {
     HelperManageabilityDebugPrint ((VOID *)TransmitHeader, (UINT32)TransmitHeaderSize, "KCS Transmit Header:\n");
   }
 
-  if (RequestData != NULL) {
+  if (RequestSegments != NULL) {
+    for (Index = 0; Index < NumberOfRequestSegments; Index++) {
+      if (RequestSegments[Index].SizeInByte != 0) {
+        HelperManageabilityDebugPrint ((VOID *)RequestSegments[Index].Buffer, RequestSegments[Index].SizeInByte, "KCS Request Data Segment:\n");
+      }
+    }
+  } else if (RequestData != NULL) {
     HelperManageabilityDebugPrint ((VOID *)RequestData, RequestDataSize, "KCS Request Data:\n");
   }
 
@@ -669,15 +841,29 @@ KcsTransportSendCommand (
     HelperManageabilityDebugPrint ((VOID *)TransmitTrailer, (UINT32)TransmitTrailerSize, "KCS Transmit Trailer:\n");
   }
 
-  if ((TransmitHeader != NULL) || (RequestData != NULL)) {
-    Status = KcsTransportWrite (
-               TransmitHeader,
-               TransmitHeaderSize,
-               TransmitTrailer,
-               TransmitTrailerSize,
-               RequestData,
-               RequestDataSize
-               );
+  if ((TransmitHeader != NULL) || (RequestData != NULL) || (RequestSegments != NULL)) {
+    //
+    // Header, request data and trailer are written in order
+    // without being copied into one buffer.
+    //
+    NumberOfSegments                      = 0;
+    Segments[NumberOfSegments].Buffer     = (UINT8 *)TransmitHeader;
+    Segments[NumberOfSegments].SizeInByte = TransmitHeaderSize;
+    NumberOfSegments++;
+    if (RequestSegments != NULL) {
+      CopyMem (&Segments[NumberOfSegments], RequestSegments, NumberOfRequestSegments * sizeof (MANAGEABILITY_TRANSMIT_SEGMENT));
+      NumberOfSegments += NumberOfRequestSegments;
+    } else {
+      Segments[NumberOfSegments].Buffer     = RequestData;
+      Segments[NumberOfSegments].SizeInByte = (RequestData != NULL) ? RequestDataSize : 0;
+      NumberOfSegments++;
+    }
+
+    Segments[NumberOfSegments].Buffer     = (UINT8 *)TransmitTrailer;
+    Segments[NumberOfSegments].SizeInByte = TransmitTrailerSize;
+    NumberOfSegments++;
+
+    Status = KcsTransportWrite (Segments, NumberOfSegments);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "KCS Write Failed with Status(%r)\n", Status));
       return Status;
@@ -34,10 +34,67 @@ typedef struct {
 
 #define MCTP_KCS_MTU_IN_POWER_OF_2  8
 
+///
+/// Maximum number of segments written in one KCS write transfer: the
+/// transmit header, the request payload segments and the transmit trailer.
+///
+#define KCS_MAX_TRANSMIT_SEGMENTS  8
+
+///
+/// Position of the next byte to write in a list of transmit segments.
+///
+typedef struct {
+  MANAGEABILITY_TRANSMIT_SEGMENT    *Segments;
+  UINT16                            NumberOfSegments;
+  UINT16                            Index;
+  UINT32                            Offset;
+} KCS_TRANSMIT_CURSOR;
+
 /// 5 sec, according to IPMI spec
 #define IPMI_KCS_TIMEOUT_5_SEC  5000*1000
 #define IPMI_KCS_TIMEOUT_1MS    1000
 
+///
+/// Status register polling. A wait first reads the status register back to back,
+/// which answers within microseconds when the BMC is quick, and then sleeps between
+/// reads, doubling the delay from KCS_POLL_MIN_DELAY_US up to IPMI_KCS_TIMEOUT_1MS.
+///
+#define KCS_POLL_SPIN_COUNT    64
+#define KCS_POLL_MIN_DELAY_US  2
+
+///
+/// Latency histogram buckets: bucket 0 counts waits under 1us, and
+/// bucket N counts waits of [2^(N-1), 2^N) us. The last bucket also
+/// counts all the longer waits.
+///
+#define KCS_POLL_HISTOGRAM_BUCKETS  16
+
+/// Number of KCS transactions between two dumps of the histograms.
+#define KCS_POLL_HISTOGRAM_DUMP_INTERVAL  256
+
+///
+/// The phases of a KCS transaction that wait on the status register.
+///
+typedef enum {
+  KcsPollWriteStart,    ///< IBF clear before and after WRITE_START.
+  KcsPollWriteData,     ///< IBF clear after each request byte.
+  KcsPollWriteEnd,      ///< IBF clear after WRITE_END.
+  KcsPollReadIbf,       ///< IBF clear before and after each response byte.
+  KcsPollReadObf,       ///< OBF set for each response byte.
+  KcsPollPhaseMax
+} KCS_POLL_PHASE;
+
+///
+/// Latency statistics of one phase.
+///
+typedef struct {
+  UINT32    Count;
+  UINT32    Timeouts;
+  UINT64    TotalNs;
+  UINT64    MaxNs;
+  UINT32    Buckets[KCS_POLL_HISTOGRAM_BUCKETS];
+} KCS_POLL_HISTOGRAM;
+
 /**
   This service communicates with BMC using KCS protocol.
 
@@ -46,7 +103,13 @@ typedef struct {
   @param[in]      TransmitTrailer       KCS packet trailer.
   @param[in]      TransmitTrailerSize   KCS packet trailer size in byte.
   @param[in]      RequestData           Command Request Data.
-  @param[in]      RequestDataSize       Size of Command Request Data.
+  @param[in]      RequestDataSize       Size of Command Request Data. This is the
+                                        total size of RequestSegments if
+                                        RequestSegments is not NULL.
+  @param[in]      RequestSegments       Scatter-gather list of the Command Request
+                                        Data, could be NULL. RequestData is ignored
+                                        if this is not NULL.
+  @param[in]      NumberOfRequestSegments  Number of entries in RequestSegments.
   @param[out]     ResponseData          Command Response Data. The completion
                                         code is the first byte of response
                                         data.
@@ -78,6 +141,8 @@ KcsTransportSendCommand (
   IN  UINT16                                      TransmitTrailerSize,
   IN  UINT8                                       *RequestData OPTIONAL,
   IN  UINT32                                      RequestDataSize,
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT              *RequestSegments OPTIONAL,
+  IN  UINT16                                      NumberOfRequestSegments,
   OUT UINT8                                       *ResponseData OPTIONAL,
   IN  OUT UINT32                                  *ResponseDataSize OPTIONAL,
   OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
@@ -110,4 +175,14 @@ KcsRegisterWrite8 (
   UINT8                                Value
   );
 
+/**
+  This function prints the status register polling latency histograms
+  of each phase of the KCS transactions.
+
+**/
+VOID
+KcsDumpPollHistograms (
+  VOID
+  );
+
 #endif
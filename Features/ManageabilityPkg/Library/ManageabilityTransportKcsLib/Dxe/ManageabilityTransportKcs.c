@@ -234,6 +234,8 @@ KcsTransportTransmitReceive (
              TransferToken->TransmitTrailerSize,
              TransferToken->TransmitPackage.TransmitPayload,
              TransferToken->TransmitPackage.TransmitSizeInByte,
+             TransferToken->TransmitPackage.TransmitSegments,
+             TransferToken->TransmitPackage.NumberOfTransmitSegments,
              TransferToken->ReceivePackage.ReceiveBuffer,
              &TransferToken->ReceivePackage.ReceiveSizeInByte,
              &AdditionalStatus
@@ -367,6 +369,8 @@ GetTransportCapability (
       (MCTP_KCS_MTU_IN_POWER_OF_2 << MANAGEABILITY_TRANSPORT_CAPABILITY_MAXIMUM_PAYLOAD_BIT_POSITION);
   }
 
+  *TransportCapability |= MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER;
+
   return EFI_SUCCESS;
 }
 
@@ -398,6 +402,7 @@ ReleaseTransportSession (
   }
 
   if (KcsTransportToken != NULL) {
+    KcsDumpPollHistograms ();
     FreePool (KcsTransportToken->Token.Transport->Function.Version1_0);
     FreePool (KcsTransportToken->Token.Transport);
     FreePool (KcsTransportToken);
@@ -8,6 +8,7 @@
 **/
 #include <Uefi.h>
 #include <IndustryStandard/IpmiSsif.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
@@ -30,6 +31,21 @@ extern MANAGEABILITY_TRANSPORT_SSIF_HARDWARE_INFO  mSsifHardwareInfo;
 #define IPMI_SSIF_RESPONSE_RETRY_COUNT     (FixedPcdGet8 (PcdIpmiSsifResponseRetryCount))
 #define IPMI_SSIF_RESPONSE_RETRY_INTERVAL  (FixedPcdGet32 (PcdIpmiSsifResponseRetryIntervalMicrosecond))
 
+//
+// The response is polled with a delay that starts at IPMI_SSIF_POLL_MIN_DELAY
+// microseconds and doubles up to IPMI_SSIF_RESPONSE_RETRY_INTERVAL.
+//
+#define IPMI_SSIF_POLL_MIN_DELAY  100
+
+//
+// Retries of a middle or end block of a multi-part read, before the whole
+// response read is restarted.
+//
+#define IPMI_SSIF_BLOCK_READ_RETRY_COUNT  5
+
+// SMBus Alert Response Address, excluding read/write bit.
+#define IPMI_SSIF_SMBUS_ALERT_RESPONSE_ADDR_7BIT  0x0C
+
 //
 // SSIF Interface capabilities
 //
@@ -140,8 +156,89 @@ Exit:
   return Status;
 }
 
+/**
+  This function checks if the BMC asserted SMBALERT# to signal that the
+  response is ready, by reading the SMBus Alert Response Address.
+
+  @retval TRUE    The BMC has the response ready.
+  @retval FALSE   No alert, or the alert is from another device.
+**/
+STATIC
+BOOLEAN
+SsifResponseAlerted (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       AlertAddress;
+
+  AlertAddress = SmBusReceiveByte (
+                   SMBUS_LIB_ADDRESS (
+                     IPMI_SSIF_SMBUS_ALERT_RESPONSE_ADDR_7BIT,
+                     0,
+                     0,
+                     FALSE
+                     ),
+                   &Status
+                   );
+
+  return (BOOLEAN)(!EFI_ERROR (Status) && ((AlertAddress >> 1) == IPMI_SSIF_BMC_SLAVE_ADDR_7BIT));
+}
+
+/**
+  Read a middle or end block of a multi-part SSIF response.
+  A NAKed read is issued again, and a block failing PEC check is requested
+  again with the Multi-part Read Retry command, without restarting the whole
+  response read.
+
+  @param[out]   Block     Buffer of IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES bytes
+                          to receive the block.
+  @param[out]   Status    Return status of the last read.
+
+  @return The number of bytes read, including the block number.
+**/
+STATIC
+UINT8
+SsifReadMiddleBlock (
+  OUT UINT8       *Block,
+  OUT EFI_STATUS  *Status
+  )
+{
+  UINT8   SsifCmd;
+  UINT8   ReadLen;
+  UINT8   RetryCount;
+  UINT32  Delay;
+
+  SsifCmd = IPMI_SSIF_SMBUS_CMD_MULTI_PART_READ_MIDDLE;
+  Delay   = 0;
+
+  for (RetryCount = 0; ; RetryCount++) {
+    ReadLen = (UINT8)SmBusReadBlock (
+                       SMBUS_LIB_ADDRESS (
+                         IPMI_SSIF_BMC_SLAVE_ADDR_7BIT,
+                         SsifCmd,
+                         0,
+                         mPecSupport
+                         ),
+                       Block,
+                       Status
+                       );
+
+    if ((!EFI_ERROR (*Status) && (ReadLen != 0)) || (RetryCount >= IPMI_SSIF_BLOCK_READ_RETRY_COUNT)) {
+      return ReadLen;
+    }
+
+    SsifCmd = (*Status == EFI_CRC_ERROR) ? IPMI_SSIF_SMBUS_CMD_MULTI_PART_READ_RETRY
+                                         : IPMI_SSIF_SMBUS_CMD_MULTI_PART_READ_MIDDLE;
+    Delay = (Delay == 0) ? IPMI_SSIF_POLL_MIN_DELAY : Delay * 2;
+    MicroSecondDelay (Delay);
+  }
+}
+
 /**
   Read SSIF response from BMC.
+  The middle and end blocks of a multi-part response are read back to back,
+  straight into ResponseData while it has room for a whole block.
 
   @param[out]        ResponseData      Command Response Data. The completion code is the first byte of response data.
   @param[in, out]    ResponseDataSize  Size of Command Response Data.
@@ -161,8 +258,11 @@ SsifReadResponse (
   BOOLEAN     IsMultiPartRead;
   UINT32      CopiedLen;
   UINT8       BlockNumber;
+  UINT8       ReceivedBlockNumber;
   UINT8       Offset;
   UINT8       ReadLen;
+  UINT8       *Block;
+  UINT8       SavedByte;
   UINT8       ResponseTemp[IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES];
 
   if ((ResponseData == NULL) || (ResponseDataSize == NULL)) {
@@ -216,16 +316,24 @@ SsifReadResponse (
 
   Offset = 1;  // Ignore block number
   while (IsMultiPartRead) {
-    ReadLen = SmBusReadBlock (
-                SMBUS_LIB_ADDRESS (
-                  IPMI_SSIF_BMC_SLAVE_ADDR_7BIT,
-                  IPMI_SSIF_SMBUS_CMD_MULTI_PART_READ_MIDDLE,
-                  0,
-                  mPecSupport
-                  ),
-                ResponseTemp,
-                &Status
-                );
+    //
+    // Read the block in place when the rest of ResponseData can hold a whole
+    // block. The block number then lands on the last byte copied so far, which
+    // is restored right after the read.
+    //
+    if ((CopiedLen > 0) && (*ResponseDataSize - CopiedLen + Offset >= IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES)) {
+      Block     = &ResponseData[CopiedLen - Offset];
+      SavedByte = *Block;
+    } else {
+      Block     = ResponseTemp;
+      SavedByte = 0;
+    }
+
+    ReadLen             = SsifReadMiddleBlock (Block, &Status);
+    ReceivedBlockNumber = Block[0];
+    if (Block != ResponseTemp) {
+      *Block = SavedByte;
+    }
 
     if (EFI_ERROR (Status)) {
       goto Exit;
@@ -245,19 +353,20 @@ SsifReadResponse (
     //
     // Copy to ResponseData if space is sufficient
     //
-    if (ReadLen > 0) {
+    if ((ReadLen > 0) && (Block == ResponseTemp)) {
       CopyMem (&ResponseData[CopiedLen], &ResponseTemp[Offset], ReadLen);
-      CopiedLen += ReadLen;
     }
 
-    if (ResponseTemp[0] == IPMI_SSIF_MULTI_PART_READ_END_PATTERN) {
+    CopiedLen += ReadLen;
+
+    if (ReceivedBlockNumber == IPMI_SSIF_MULTI_PART_READ_END_PATTERN) {
       break;
     }
 
     //
     // Verify BlockNumber
     //
-    if (ResponseTemp[0] != BlockNumber++) {
+    if (ReceivedBlockNumber != BlockNumber++) {
       DEBUG ((DEBUG_ERROR, "%a: Block number is incorrect\n", __func__));
       Status = EFI_NOT_FOUND;
       goto Exit;
@@ -301,7 +410,10 @@ SsifCommonSendCommand (
   EFI_STATUS  Status;
   UINT32      TempLength;
   UINT8       *RequestTemp;
-  UINT8       RetryCount;
+  UINT32      RetryCount;
+  UINT32      Delay;
+  UINT64      Waited;
+  BOOLEAN     Alerted;
 
   RequestTemp = AllocateZeroPool (RequestDataSize + sizeof (IPMI_SSIF_REQUEST_HEADER));
   if (RequestTemp == NULL) {
@@ -359,26 +471,49 @@ SsifCommonSendCommand (
   }
 
   //
-  // Read Response
+  // Read Response. The BMC is polled with an exponential backoff, for at most
+  // IPMI_SSIF_RESPONSE_RETRY_COUNT response retry intervals in total. When the
+  // BMC signals the response with SMBALERT#, the cheaper Alert Response Address
+  // read is polled instead, and the response is read once the BMC answers it.
+  // The BMC deasserts SMBALERT# once it has answered, so after that the response
+  // is read directly until it succeeds.
   //
   TempLength = *ResponseDataSize; // Keep original DataSize
 
   RetryCount = 0;
+  Delay      = 0;
+  Waited     = 0;
+  Alerted    = !FixedPcdGetBool (PcdIpmiSsifSmbusAlertEnable);
   while (TRUE) {
-    Status = SsifReadResponse (ResponseData, ResponseDataSize);
-    if (!EFI_ERROR (Status)) {
-      break;
+    if (!Alerted) {
+      Alerted = SsifResponseAlerted ();
+    }
+
+    if (Alerted) {
+      Status = SsifReadResponse (ResponseData, ResponseDataSize);
+      if (!EFI_ERROR (Status)) {
+        break;
+      }
+
+      *ResponseDataSize = TempLength;
+    } else {
+      Status = EFI_NOT_READY;
     }
 
-    if (++RetryCount > IPMI_SSIF_RESPONSE_RETRY_COUNT) {
+    if (Waited >= MultU64x32 (IPMI_SSIF_RESPONSE_RETRY_COUNT, IPMI_SSIF_RESPONSE_RETRY_INTERVAL)) {
       DEBUG ((DEBUG_ERROR, "%a: Read response error %r\n", __func__, Status));
       *ResponseDataSize = 0;
       goto Cleanup;
     }
 
-    *ResponseDataSize = TempLength;
-    MicroSecondDelay (IPMI_SSIF_RESPONSE_RETRY_INTERVAL);
-    DEBUG ((DEBUG_INFO, "%a: Read response retry %d\n", __func__, RetryCount));
+    Delay = MIN ((Delay == 0) ? IPMI_SSIF_POLL_MIN_DELAY : Delay * 2, IPMI_SSIF_RESPONSE_RETRY_INTERVAL);
+    MicroSecondDelay (Delay);
+    Waited += Delay;
+    RetryCount++;
+  }
+
+  if (RetryCount > 0) {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Response read after %d polls, %ldus\n", __func__, RetryCount, Waited));
   }
 
 Cleanup:
@@ -0,0 +1,101 @@
+/** @file
+  Host-based BMC simulator used by the ManageabilityPkg host tests and benchmarks.
+
+  The simulator is linked in place of IoLib, SmbusLib, SerialPortLib and TimerLib,
+  so the KCS, SSIF and serial instances of ManageabilityTransportLib talk to it
+  exactly as they would talk to a BMC. It answers IPMI commands, the OpenBMC blob
+  transfer OEM command, and PLDM messages sent as MCTP over KCS, and keeps a
+  simulated clock that advances with the cost of each bus access and with every
+  delay the transport libraries take.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef BMC_SIMULATOR_LIB_H_
+#define BMC_SIMULATOR_LIB_H_
+
+///
+/// Costs of the simulated hardware, in nanoseconds.
+///
+typedef struct {
+  UINT32    KcsIoAccessNs;         ///< One KCS register access over LPC/eSPI.
+  UINT32    KcsByteLatencyNs;      ///< Time the BMC takes to clear IBF after a KCS write.
+  UINT32    SmbusByteNs;           ///< One byte on the SMBus, including the ACK bit.
+  UINT32    SerialByteNs;          ///< One character on the serial port.
+  UINT32    ProcessingNs;          ///< Time the BMC takes to handle a request.
+} BMC_SIMULATOR_TIMING;
+
+///
+/// Default costs: a 1us LPC I/O cycle, a 100kHz SMBus, a 115200 baud serial
+/// port and a BMC that takes 100us to handle a request.
+///
+#define BMC_SIMULATOR_DEFAULT_KCS_IO_ACCESS_NS     1000
+#define BMC_SIMULATOR_DEFAULT_KCS_BYTE_LATENCY_NS  5000
+#define BMC_SIMULATOR_DEFAULT_SMBUS_BYTE_NS        90000
+#define BMC_SIMULATOR_DEFAULT_SERIAL_BYTE_NS       86806
+#define BMC_SIMULATOR_DEFAULT_PROCESSING_NS        100000
+
+///
+/// What the simulated BMC saw since the last BmcSimulatorReset.
+///
+typedef struct {
+  UINT64    RoundTrips;            ///< Requests handled: IPMI commands and complete MCTP messages.
+  UINT64    BusTransactions;       ///< KCS register accesses, SMBus block transfers or serial writes.
+  UINT64    BytesToBmc;            ///< Bytes received by the BMC, including framing.
+  UINT64    BytesFromBmc;          ///< Bytes sent by the BMC, including framing.
+  UINT64    ProtocolErrors;        ///< Malformed requests, bad checksums and bad PECs.
+} BMC_SIMULATOR_STATISTICS;
+
+/**
+  Resets the simulated BMC: clears its statistics, blobs and interface state,
+  and sets the simulated clock back to zero.
+
+  @param[in]  Timing        Costs of the simulated hardware. NULL for the defaults.
+**/
+VOID
+EFIAPI
+BmcSimulatorReset (
+  IN CONST BMC_SIMULATOR_TIMING  *Timing OPTIONAL
+  );
+
+/**
+  Gets the statistics of the simulated BMC.
+
+  @param[out] Statistics    Pointer to receive the statistics.
+**/
+VOID
+EFIAPI
+BmcSimulatorGetStatistics (
+  OUT BMC_SIMULATOR_STATISTICS  *Statistics
+  );
+
+/**
+  Gets the simulated time elapsed since the last BmcSimulatorReset.
+
+  @return The simulated time, in nanoseconds.
+**/
+UINT64
+EFIAPI
+BmcSimulatorGetTime (
+  VOID
+  );
+
+/**
+  Adds a blob to the OpenBMC blob transfer service of the simulated BMC.
+
+  @param[in]  BlobId        NUL-terminated ID of the blob.
+  @param[in]  Size          Maximum size of the blob, in bytes. It's zero-filled.
+
+  @retval EFI_SUCCESS            The blob was added.
+  @retval EFI_INVALID_PARAMETER  BlobId is NULL or too long.
+  @retval EFI_OUT_OF_RESOURCES   There are too many blobs, or not enough memory.
+**/
+EFI_STATUS
+EFIAPI
+BmcSimulatorAddBlob (
+  IN CONST CHAR8  *BlobId,
+  IN UINT32       Size
+  );
+
+#endif
@@ -0,0 +1,110 @@
+/** @file
+  Internal definitions of the host-based BMC simulator.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef BMC_SIMULATOR_INTERNAL_H_
+#define BMC_SIMULATOR_INTERNAL_H_
+
+#include <Uefi.h>
+#include <IndustryStandard/Ipmi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BmcSimulatorLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+
+///
+/// Largest IPMI or MCTP message the simulated BMC accepts or returns,
+/// including the interface framing.
+///
+#define BMC_SIM_MAX_MESSAGE_SIZE  SIZE_4KB
+
+///
+/// IPMI request and response framing shared by the interfaces: the first byte
+/// is NetFn << 2 | LUN, followed by the command, then the request data or the
+/// completion code and the response data.
+///
+#define BMC_SIM_IPMI_HEADER_SIZE      2
+#define BMC_SIM_IPMI_NETFN(a)         ((UINT8)((a) >> 2))
+#define BMC_SIM_IPMI_LUN(a)           ((UINT8)((a) & 0x3))
+#define BMC_SIM_IPMI_NETFN_LUN(n, l)  ((UINT8)(((n) << 2) | ((l) & 0x3)))
+
+extern BMC_SIMULATOR_TIMING      mBmcSimTiming;
+extern BMC_SIMULATOR_STATISTICS  mBmcSimStatistics;
+extern UINT64                    mBmcSimNow;
+
+/**
+  Advances the simulated clock.
+
+  @param[in]  Nanoseconds   Time to add to the clock.
+**/
+VOID
+BmcSimAdvance (
+  IN UINT64  Nanoseconds
+  );
+
+/**
+  Handles an IPMI request and builds its response, with the same framing as the
+  request: NetFn << 2 | LUN and command, then the completion code and the data.
+
+  @param[in]  Request       The request, starting with NetFn << 2 | LUN.
+  @param[in]  RequestSize   Size of the request, in bytes.
+  @param[out] Response      Buffer of BMC_SIM_MAX_MESSAGE_SIZE bytes to receive the response.
+
+  @return The size of the response, in bytes. Zero if the request is malformed.
+**/
+UINT32
+BmcSimHandleIpmiRequest (
+  IN  CONST UINT8  *Request,
+  IN  UINT32       RequestSize,
+  OUT UINT8        *Response
+  );
+
+/**
+  Handles an MCTP over KCS packet. Packets are reassembled until the one with
+  the end of message bit, which gets the response.
+
+  @param[in]  Packet        The packet, starting with the MCTP KCS header.
+  @param[in]  PacketSize    Size of the packet, in bytes.
+  @param[out] Response      Buffer of BMC_SIM_MAX_MESSAGE_SIZE bytes to receive the
+                            response packet, starting with the MCTP KCS header.
+
+  @return The size of the response packet, in bytes. Zero if the packet isn't the
+          last one of the message or is malformed.
+**/
+UINT32
+BmcSimHandleMctpKcsPacket (
+  IN  CONST UINT8  *Packet,
+  IN  UINT32       PacketSize,
+  OUT UINT8        *Response
+  );
+
+/**
+  Resets the state of the simulated KCS interface.
+**/
+VOID
+BmcSimKcsReset (
+  VOID
+  );
+
+/**
+  Resets the state of the simulated SSIF interface.
+**/
+VOID
+BmcSimSsifReset (
+  VOID
+  );
+
+/**
+  Resets the state of the simulated serial interface.
+**/
+VOID
+BmcSimSerialReset (
+  VOID
+  );
+
+#endif
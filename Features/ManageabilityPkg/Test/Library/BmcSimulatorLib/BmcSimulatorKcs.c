@@ -0,0 +1,353 @@
+/** @file
+  KCS interface of the host-based BMC simulator.
+
+  Implements IoRead8, IoWrite8, MmioRead8 and MmioWrite8 on top of a BMC-side
+  KCS state machine. The registers are decoded at the IPMI KCS I/O base, and at
+  the MCTP KCS base, I/O or memory mapped with a 4 bytes stride. Every register
+  access costs KcsIoAccessNs of simulated time.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <IndustryStandard/IpmiKcs.h>
+#include <Library/IoLib.h>
+#include <Library/ManageabilityTransportMctpLib.h>
+
+#include "BmcSimulatorInternal.h"
+
+#define BMC_SIM_KCS_STATE_SHIFT  6
+#define BMC_SIM_KCS_CD           BIT3
+#define BMC_SIM_KCS_DUMMY_BYTE   0x00
+
+typedef struct {
+  IPMI_KCS_STATE    State;
+  BOOLEAN           WriteEnd;
+  BOOLEAN           CommandWritten;
+  BOOLEAN           OutputFull;
+  UINT8             Output;
+  UINT64            BusyUntil;
+  UINT8             Request[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT32            RequestSize;
+  UINT8             Response[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT32            ResponseSize;
+  UINT32            ResponseCursor;
+} BMC_SIM_KCS;
+
+STATIC BMC_SIM_KCS  mBmcSimKcs;
+
+/**
+  Resets the state of the simulated KCS interface.
+**/
+VOID
+BmcSimKcsReset (
+  VOID
+  )
+{
+  ZeroMem (&mBmcSimKcs, sizeof (mBmcSimKcs));
+  mBmcSimKcs.State = IpmiKcsIdleState;
+}
+
+/**
+  Decodes a KCS register address.
+
+  @param[in]  Address       The I/O port or memory address.
+  @param[in]  MemoryMapped  TRUE for a memory mapped access.
+  @param[out] Offset        The register offset, IPMI_KCS_*_REGISTER_OFFSET.
+
+  @retval TRUE   Address is a KCS register.
+  @retval FALSE  Address isn't decoded by the simulated BMC.
+**/
+STATIC
+BOOLEAN
+BmcSimKcsDecode (
+  IN  UINTN    Address,
+  IN  BOOLEAN  MemoryMapped,
+  OUT UINTN    *Offset
+  )
+{
+  UINTN  Base;
+
+  mBmcSimStatistics.BusTransactions++;
+  BmcSimAdvance (mBmcSimTiming.KcsIoAccessNs);
+
+  if (MemoryMapped) {
+    Base = PcdGet32 (PcdMctpKcsBaseAddress);
+    if ((Address >= Base) && (((Address - Base) % 4) == 0)) {
+      *Offset = (Address - Base) / 4;
+      return *Offset <= IPMI_KCS_STATUS_REGISTER_OFFSET;
+    }
+
+    return FALSE;
+  }
+
+  Base = PcdGet16 (PcdIpmiKcsIoBaseAddress);
+  if ((Address >= Base) && (Address - Base <= IPMI_KCS_STATUS_REGISTER_OFFSET)) {
+    *Offset = Address - Base;
+    return TRUE;
+  }
+
+  Base = PcdGet32 (PcdMctpKcsBaseAddress);
+  if ((Address >= Base) && (Address - Base <= IPMI_KCS_STATUS_REGISTER_OFFSET)) {
+    *Offset = Address - Base;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  Puts the interface in the error state after a host protocol violation.
+**/
+STATIC
+VOID
+BmcSimKcsError (
+  VOID
+  )
+{
+  mBmcSimStatistics.ProtocolErrors++;
+  mBmcSimKcs.State = IpmiKcsErrorState;
+}
+
+/**
+  Handles the complete request in the request buffer, and moves to the read
+  state with the first response byte in the output register, or back to the
+  idle state if there's no response.
+**/
+STATIC
+VOID
+BmcSimKcsProcessRequest (
+  VOID
+  )
+{
+  if ((mBmcSimKcs.RequestSize > 0) && (mBmcSimKcs.Request[0] == MCTP_KCS_NETFN_LUN)) {
+    mBmcSimKcs.ResponseSize = BmcSimHandleMctpKcsPacket (mBmcSimKcs.Request, mBmcSimKcs.RequestSize, mBmcSimKcs.Response);
+  } else {
+    mBmcSimKcs.ResponseSize = BmcSimHandleIpmiRequest (mBmcSimKcs.Request, mBmcSimKcs.RequestSize, mBmcSimKcs.Response);
+  }
+
+  mBmcSimKcs.ResponseCursor = 0;
+  if (mBmcSimKcs.ResponseSize == 0) {
+    mBmcSimKcs.State = IpmiKcsIdleState;
+    return;
+  }
+
+  mBmcSimKcs.BusyUntil  = mBmcSimNow + mBmcSimTiming.ProcessingNs;
+  mBmcSimKcs.State      = IpmiKcsReadState;
+  mBmcSimKcs.OutputFull = TRUE;
+  mBmcSimKcs.Output     = mBmcSimKcs.Response[0];
+}
+
+/**
+  Reads a KCS register.
+
+  @param[in]  Offset        The register offset.
+
+  @return The register value.
+**/
+STATIC
+UINT8
+BmcSimKcsRead (
+  IN UINTN  Offset
+  )
+{
+  UINT8  Status;
+
+  if (Offset == IPMI_KCS_STATUS_REGISTER_OFFSET) {
+    Status = (UINT8)(mBmcSimKcs.State << BMC_SIM_KCS_STATE_SHIFT);
+    if (mBmcSimNow < mBmcSimKcs.BusyUntil) {
+      //
+      // Still consuming the last write: IBF set, and no new output yet.
+      //
+      return Status | IPMI_KCS_IBF | (mBmcSimKcs.CommandWritten ? BMC_SIM_KCS_CD : 0);
+    }
+
+    return Status | (mBmcSimKcs.OutputFull ? IPMI_KCS_OBF : 0) | (mBmcSimKcs.CommandWritten ? BMC_SIM_KCS_CD : 0);
+  }
+
+  if (!mBmcSimKcs.OutputFull || (mBmcSimNow < mBmcSimKcs.BusyUntil)) {
+    return BMC_SIM_KCS_DUMMY_BYTE;
+  }
+
+  mBmcSimKcs.OutputFull = FALSE;
+  mBmcSimStatistics.BytesFromBmc++;
+  return mBmcSimKcs.Output;
+}
+
+/**
+  Writes a KCS register.
+
+  @param[in]  Offset        The register offset.
+  @param[in]  Value         The value to write.
+**/
+STATIC
+VOID
+BmcSimKcsWrite (
+  IN UINTN  Offset,
+  IN UINT8  Value
+  )
+{
+  if (mBmcSimNow < mBmcSimKcs.BusyUntil) {
+    //
+    // The host overwrote the input register before IBF cleared.
+    //
+    BmcSimKcsError ();
+    return;
+  }
+
+  mBmcSimKcs.CommandWritten = (BOOLEAN)(Offset == IPMI_KCS_COMMAND_REGISTER_OFFSET);
+  mBmcSimKcs.BusyUntil      = mBmcSimNow + mBmcSimTiming.KcsByteLatencyNs;
+
+  if (Offset == IPMI_KCS_COMMAND_REGISTER_OFFSET) {
+    switch (Value) {
+      case IPMI_KCS_CONTROL_CODE_WRITE_START:
+        mBmcSimKcs.State       = IpmiKcsWriteState;
+        mBmcSimKcs.WriteEnd    = FALSE;
+        mBmcSimKcs.RequestSize = 0;
+        break;
+
+      case IPMI_KCS_CONTROL_CODE_WRITE_END:
+        if (mBmcSimKcs.State != IpmiKcsWriteState) {
+          BmcSimKcsError ();
+          break;
+        }
+
+        mBmcSimKcs.WriteEnd = TRUE;
+        break;
+
+      default:
+        BmcSimKcsError ();
+        break;
+    }
+
+    return;
+  }
+
+  switch (mBmcSimKcs.State) {
+    case IpmiKcsWriteState:
+      if (mBmcSimKcs.RequestSize == sizeof (mBmcSimKcs.Request)) {
+        BmcSimKcsError ();
+        break;
+      }
+
+      mBmcSimStatistics.BytesToBmc++;
+      mBmcSimKcs.Request[mBmcSimKcs.RequestSize++] = Value;
+      if (mBmcSimKcs.WriteEnd) {
+        BmcSimKcsProcessRequest ();
+      }
+
+      break;
+
+    case IpmiKcsReadState:
+      if (Value != IPMI_KCS_CONTROL_CODE_READ) {
+        BmcSimKcsError ();
+        break;
+      }
+
+      mBmcSimKcs.OutputFull = TRUE;
+      if (++mBmcSimKcs.ResponseCursor < mBmcSimKcs.ResponseSize) {
+        mBmcSimKcs.Output = mBmcSimKcs.Response[mBmcSimKcs.ResponseCursor];
+      } else {
+        mBmcSimKcs.State  = IpmiKcsIdleState;
+        mBmcSimKcs.Output = BMC_SIM_KCS_DUMMY_BYTE;
+      }
+
+      break;
+
+    default:
+      BmcSimKcsError ();
+      break;
+  }
+}
+
+/**
+  Reads an 8-bit I/O port.
+
+  @param[in]  Port  The I/O port to read.
+
+  @return The value read.
+**/
+UINT8
+EFIAPI
+IoRead8 (
+  IN UINTN  Port
+  )
+{
+  UINTN  Offset;
+
+  if (!BmcSimKcsDecode (Port, FALSE, &Offset)) {
+    return MAX_UINT8;
+  }
+
+  return BmcSimKcsRead (Offset);
+}
+
+/**
+  Writes an 8-bit I/O port.
+
+  @param[in]  Port   The I/O port to write.
+  @param[in]  Value  The value to write to the I/O port.
+
+  @return The value written the I/O port.
+**/
+UINT8
+EFIAPI
+IoWrite8 (
+  IN UINTN  Port,
+  IN UINT8  Value
+  )
+{
+  UINTN  Offset;
+
+  if (BmcSimKcsDecode (Port, FALSE, &Offset)) {
+    BmcSimKcsWrite (Offset, Value);
+  }
+
+  return Value;
+}
+
+/**
+  Reads an 8-bit MMIO register.
+
+  @param[in]  Address The MMIO register to read.
+
+  @return The value read.
+**/
+UINT8
+EFIAPI
+MmioRead8 (
+  IN UINTN  Address
+  )
+{
+  UINTN  Offset;
+
+  if (!BmcSimKcsDecode (Address, TRUE, &Offset)) {
+    return MAX_UINT8;
+  }
+
+  return BmcSimKcsRead (Offset);
+}
+
+/**
+  Writes an 8-bit MMIO register.
+
+  @param[in]  Address The MMIO register to write.
+  @param[in]  Value   The value to write to the MMIO register.
+
+  @return Value.
+**/
+UINT8
+EFIAPI
+MmioWrite8 (
+  IN UINTN  Address,
+  IN UINT8  Value
+  )
+{
+  UINTN  Offset;
+
+  if (BmcSimKcsDecode (Address, TRUE, &Offset)) {
+    BmcSimKcsWrite (Offset, Value);
+  }
+
+  return Value;
+}
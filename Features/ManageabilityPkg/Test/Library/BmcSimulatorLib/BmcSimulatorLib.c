@@ -0,0 +1,839 @@
+/** @file
+  Host-based BMC simulator: simulated clock, statistics, and the IPMI, OpenBMC
+  blob transfer and PLDM over MCTP services shared by the simulated interfaces.
+
+  The simulator is also the TimerLib of the host applications it's linked into,
+  so the delays and the performance counter of the transport libraries use the
+  simulated clock.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <IndustryStandard/Mctp.h>
+#include <IndustryStandard/Pldm.h>
+#include <Library/ManageabilityTransportMctpLib.h>
+#include <Library/TimerLib.h>
+
+#include "BmcSimulatorInternal.h"
+
+//
+// OpenBMC blob transfer OEM command, see
+// https://github.com/openbmc/phosphor-ipmi-blobs/blob/master/README.md
+//
+#define BMC_SIM_BLOB_COMMAND          0x80
+#define BMC_SIM_BLOB_ID_SIZE          64
+#define BMC_SIM_BLOB_MAX_DATA_PER_PACKET  64
+#define BMC_SIM_BLOB_MAX_BLOBS        8
+#define BMC_SIM_BLOB_MAX_SESSIONS     16
+#define BMC_SIM_BLOB_HEADER_SIZE      4  // OEN and subcommand
+#define BMC_SIM_BLOB_DATA_OFFSET      6  // Header and CRC of the send data
+#define BMC_SIM_BLOB_CRC16_POLY       0x1021
+#define BMC_SIM_BLOB_CRC16_INITIAL    0xFFFF
+#define BMC_SIM_BLOB_OPEN_SIZE        2  // Flags
+#define BMC_SIM_BLOB_RW_HEADER_SIZE   6  // Session and offset
+#define BMC_SIM_BLOB_READ_SIZE        10 // Session, offset and size
+#define BMC_SIM_BLOB_SESSION_SIZE     2  // Session
+
+typedef enum {
+  BmcSimBlobGetCount = 0,
+  BmcSimBlobEnumerate,
+  BmcSimBlobOpen,
+  BmcSimBlobRead,
+  BmcSimBlobWrite,
+  BmcSimBlobCommit,
+  BmcSimBlobClose
+} BMC_SIM_BLOB_SUBCOMMAND;
+
+typedef struct {
+  CHAR8     Id[BMC_SIM_BLOB_ID_SIZE];
+  UINT8     *Data;
+  UINT32    Size;
+} BMC_SIM_BLOB;
+
+typedef struct {
+  BOOLEAN    InUse;
+  UINT32     Blob;
+} BMC_SIM_BLOB_SESSION;
+
+STATIC CONST UINT8  mBmcSimOpenBmcOen[] = { 0xCF, 0xC2, 0x00 };
+
+STATIC CONST EFI_GUID  mBmcSimSystemGuid = {
+  0x5d7e3a1b, 0x8c41, 0x4f0e, { 0x9a, 0x62, 0x3b, 0x17, 0xc4, 0xd8, 0x05, 0xe9 }
+};
+
+BMC_SIMULATOR_TIMING      mBmcSimTiming = {
+  BMC_SIMULATOR_DEFAULT_KCS_IO_ACCESS_NS,
+  BMC_SIMULATOR_DEFAULT_KCS_BYTE_LATENCY_NS,
+  BMC_SIMULATOR_DEFAULT_SMBUS_BYTE_NS,
+  BMC_SIMULATOR_DEFAULT_SERIAL_BYTE_NS,
+  BMC_SIMULATOR_DEFAULT_PROCESSING_NS
+};
+BMC_SIMULATOR_STATISTICS  mBmcSimStatistics;
+UINT64                    mBmcSimNow;
+
+STATIC BMC_SIM_BLOB          mBmcSimBlobs[BMC_SIM_BLOB_MAX_BLOBS];
+STATIC UINT32                mBmcSimBlobCount;
+STATIC BMC_SIM_BLOB_SESSION  mBmcSimBlobSessions[BMC_SIM_BLOB_MAX_SESSIONS];
+
+//
+// MCTP message being reassembled from MCTP over KCS packets.
+//
+STATIC BOOLEAN                mBmcSimMctpInMessage;
+STATIC UINT8                  mBmcSimMctpNextSequence;
+STATIC MCTP_TRANSPORT_HEADER  mBmcSimMctpTransportHeader;
+STATIC MCTP_MESSAGE_HEADER    mBmcSimMctpMessageHeader;
+STATIC UINT8                  mBmcSimMctpMessage[BMC_SIM_MAX_MESSAGE_SIZE];
+STATIC UINT32                 mBmcSimMctpMessageSize;
+
+/**
+  Advances the simulated clock.
+
+  @param[in]  Nanoseconds   Time to add to the clock.
+**/
+VOID
+BmcSimAdvance (
+  IN UINT64  Nanoseconds
+  )
+{
+  mBmcSimNow += Nanoseconds;
+}
+
+/**
+  Resets the simulated BMC: clears its statistics, blobs and interface state,
+  and sets the simulated clock back to zero.
+
+  @param[in]  Timing        Costs of the simulated hardware. NULL for the defaults.
+**/
+VOID
+EFIAPI
+BmcSimulatorReset (
+  IN CONST BMC_SIMULATOR_TIMING  *Timing OPTIONAL
+  )
+{
+  UINT32  Index;
+
+  if (Timing != NULL) {
+    CopyMem (&mBmcSimTiming, Timing, sizeof (mBmcSimTiming));
+  } else {
+    mBmcSimTiming.KcsIoAccessNs    = BMC_SIMULATOR_DEFAULT_KCS_IO_ACCESS_NS;
+    mBmcSimTiming.KcsByteLatencyNs = BMC_SIMULATOR_DEFAULT_KCS_BYTE_LATENCY_NS;
+    mBmcSimTiming.SmbusByteNs      = BMC_SIMULATOR_DEFAULT_SMBUS_BYTE_NS;
+    mBmcSimTiming.SerialByteNs     = BMC_SIMULATOR_DEFAULT_SERIAL_BYTE_NS;
+    mBmcSimTiming.ProcessingNs     = BMC_SIMULATOR_DEFAULT_PROCESSING_NS;
+  }
+
+  for (Index = 0; Index < mBmcSimBlobCount; Index++) {
+    FreePool (mBmcSimBlobs[Index].Data);
+  }
+
+  ZeroMem (mBmcSimBlobs, sizeof (mBmcSimBlobs));
+  ZeroMem (mBmcSimBlobSessions, sizeof (mBmcSimBlobSessions));
+  ZeroMem (&mBmcSimStatistics, sizeof (mBmcSimStatistics));
+  mBmcSimBlobCount     = 0;
+  mBmcSimMctpInMessage = FALSE;
+  mBmcSimNow           = 0;
+
+  BmcSimKcsReset ();
+  BmcSimSsifReset ();
+  BmcSimSerialReset ();
+}
+
+/**
+  Gets the statistics of the simulated BMC.
+
+  @param[out] Statistics    Pointer to receive the statistics.
+**/
+VOID
+EFIAPI
+BmcSimulatorGetStatistics (
+  OUT BMC_SIMULATOR_STATISTICS  *Statistics
+  )
+{
+  CopyMem (Statistics, &mBmcSimStatistics, sizeof (*Statistics));
+}
+
+/**
+  Gets the simulated time elapsed since the last BmcSimulatorReset.
+
+  @return The simulated time, in nanoseconds.
+**/
+UINT64
+EFIAPI
+BmcSimulatorGetTime (
+  VOID
+  )
+{
+  return mBmcSimNow;
+}
+
+/**
+  Adds a blob to the OpenBMC blob transfer service of the simulated BMC.
+
+  @param[in]  BlobId        NUL-terminated ID of the blob.
+  @param[in]  Size          Maximum size of the blob, in bytes. It's zero-filled.
+
+  @retval EFI_SUCCESS            The blob was added.
+  @retval EFI_INVALID_PARAMETER  BlobId is NULL or too long.
+  @retval EFI_OUT_OF_RESOURCES   There are too many blobs, or not enough memory.
+**/
+EFI_STATUS
+EFIAPI
+BmcSimulatorAddBlob (
+  IN CONST CHAR8  *BlobId,
+  IN UINT32       Size
+  )
+{
+  BMC_SIM_BLOB  *Blob;
+
+  if ((BlobId == NULL) || (AsciiStrSize (BlobId) > BMC_SIM_BLOB_ID_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mBmcSimBlobCount == BMC_SIM_BLOB_MAX_BLOBS) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Blob       = &mBmcSimBlobs[mBmcSimBlobCount];
+  Blob->Data = AllocateZeroPool (MAX (Size, 1));
+  if (Blob->Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  AsciiStrCpyS (Blob->Id, BMC_SIM_BLOB_ID_SIZE, BlobId);
+  Blob->Size = Size;
+  mBmcSimBlobCount++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stalls the CPU for at least the given number of microseconds. The simulated
+  clock is advanced instead.
+
+  @param[in]  MicroSeconds  The minimum number of microseconds to delay.
+
+  @return The value of MicroSeconds inputted.
+**/
+UINTN
+EFIAPI
+MicroSecondDelay (
+  IN UINTN  MicroSeconds
+  )
+{
+  BmcSimAdvance (MultU64x32 (MicroSeconds, 1000));
+  return MicroSeconds;
+}
+
+/**
+  Stalls the CPU for at least the given number of nanoseconds. The simulated
+  clock is advanced instead.
+
+  @param[in]  NanoSeconds   The minimum number of nanoseconds to delay.
+
+  @return The value of NanoSeconds inputted.
+**/
+UINTN
+EFIAPI
+NanoSecondDelay (
+  IN UINTN  NanoSeconds
+  )
+{
+  BmcSimAdvance (NanoSeconds);
+  return NanoSeconds;
+}
+
+/**
+  Retrieves the current value of the performance counter, which is the simulated
+  clock in nanoseconds.
+
+  @return The current value of the performance counter.
+**/
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  return mBmcSimNow;
+}
+
+/**
+  Retrieves the 64-bit frequency in Hz and the range of the performance counter.
+
+  @param[out] StartValue    The value the performance counter starts with.
+  @param[out] EndValue      The value that the performance counter ends with.
+
+  @return The frequency in Hz.
+**/
+UINT64
+EFIAPI
+GetPerformanceCounterProperties (
+  OUT UINT64  *StartValue OPTIONAL,
+  OUT UINT64  *EndValue OPTIONAL
+  )
+{
+  if (StartValue != NULL) {
+    *StartValue = 0;
+  }
+
+  if (EndValue != NULL) {
+    *EndValue = MAX_UINT64;
+  }
+
+  return 1000000000ULL;
+}
+
+/**
+  Converts elapsed ticks of the performance counter to time in nanoseconds.
+
+  @param[in]  Ticks         The number of elapsed ticks.
+
+  @return The elapsed time in nanoseconds.
+**/
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  IN UINT64  Ticks
+  )
+{
+  return Ticks;
+}
+
+/**
+  Calculates the CRC-16-CCITT of the blob transfer protocol, bit by bit as the
+  protocol defines it: an initial value of 0xFFFF, and the data followed by two
+  zero bytes.
+
+  @param[in]  Data          The data.
+  @param[in]  DataSize      Size of the data, in bytes.
+
+  @return The CRC.
+**/
+STATIC
+UINT16
+BmcSimBlobCrc16 (
+  IN CONST UINT8  *Data,
+  IN UINT32       DataSize
+  )
+{
+  UINT16  Crc;
+  UINT32  Index;
+  UINT8   Byte;
+  UINT8   Bit;
+  BOOLEAN Carry;
+
+  Crc = BMC_SIM_BLOB_CRC16_INITIAL;
+  for (Index = 0; Index < DataSize + 2; Index++) {
+    Byte = (Index < DataSize) ? Data[Index] : 0;
+    for (Bit = 0; Bit < 8; Bit++) {
+      Carry = (Crc & BIT15) != 0;
+      Crc   = (UINT16)((Crc << 1) | ((Byte >> (7 - Bit)) & 1));
+      if (Carry) {
+        Crc ^= BMC_SIM_BLOB_CRC16_POLY;
+      }
+    }
+  }
+
+  return Crc;
+}
+
+/**
+  Finds the blob of an open session.
+
+  @param[in]  Data          Send data starting with the session ID.
+
+  @return The blob, or NULL if the session isn't open.
+**/
+STATIC
+BMC_SIM_BLOB *
+BmcSimBlobFromSession (
+  IN CONST UINT8  *Data
+  )
+{
+  UINT16  SessionId;
+
+  SessionId = ReadUnaligned16 ((CONST UINT16 *)Data);
+  if ((SessionId >= BMC_SIM_BLOB_MAX_SESSIONS) || !mBmcSimBlobSessions[SessionId].InUse) {
+    return NULL;
+  }
+
+  return &mBmcSimBlobs[mBmcSimBlobSessions[SessionId].Blob];
+}
+
+/**
+  Handles an OpenBMC blob transfer request.
+
+  @param[in]  Request       The request data, starting with the OEN.
+  @param[in]  RequestSize   Size of the request data, in bytes.
+  @param[out] Response      Buffer to receive the completion code and response data.
+
+  @return The size of the response, in bytes.
+**/
+STATIC
+UINT32
+BmcSimHandleBlobRequest (
+  IN  CONST UINT8  *Request,
+  IN  UINT32       RequestSize,
+  OUT UINT8        *Response
+  )
+{
+  CONST UINT8   *SendData;
+  UINT32        SendDataSize;
+  UINT8         *ResponseData;
+  UINT32        ResponseDataSize;
+  BMC_SIM_BLOB  *Blob;
+  UINT32        Offset;
+  UINT32        Length;
+  UINT32        Index;
+
+  if ((RequestSize < BMC_SIM_BLOB_HEADER_SIZE) ||
+      (CompareMem (Request, mBmcSimOpenBmcOen, sizeof (mBmcSimOpenBmcOen)) != 0))
+  {
+    mBmcSimStatistics.ProtocolErrors++;
+    Response[0] = IPMI_COMP_CODE_INVALID_COMMAND;
+    return 1;
+  }
+
+  SendData     = Request + BMC_SIM_BLOB_DATA_OFFSET;
+  SendDataSize = 0;
+  if (RequestSize > BMC_SIM_BLOB_HEADER_SIZE) {
+    if ((RequestSize < BMC_SIM_BLOB_DATA_OFFSET) ||
+        (ReadUnaligned16 ((CONST UINT16 *)(Request + BMC_SIM_BLOB_HEADER_SIZE)) !=
+         BmcSimBlobCrc16 (SendData, RequestSize - BMC_SIM_BLOB_DATA_OFFSET)))
+    {
+      mBmcSimStatistics.ProtocolErrors++;
+      Response[0] = IPMI_COMP_CODE_UNSPECIFIED;
+      return 1;
+    }
+
+    SendDataSize = RequestSize - BMC_SIM_BLOB_DATA_OFFSET;
+  }
+
+  //
+  // The response data follows the completion code, the OEN and the CRC.
+  //
+  Response[0] = IPMI_COMP_CODE_NORMAL;
+  CopyMem (&Response[1], mBmcSimOpenBmcOen, sizeof (mBmcSimOpenBmcOen));
+  ResponseData     = Response + 1 + sizeof (mBmcSimOpenBmcOen) + sizeof (UINT16);
+  ResponseDataSize = 0;
+
+  switch (Request[BMC_SIM_BLOB_HEADER_SIZE - 1]) {
+    case BmcSimBlobGetCount:
+      WriteUnaligned32 ((UINT32 *)ResponseData, mBmcSimBlobCount);
+      ResponseDataSize = sizeof (UINT32);
+      break;
+
+    case BmcSimBlobEnumerate:
+      if ((SendDataSize < sizeof (UINT32)) || (ReadUnaligned32 ((CONST UINT32 *)SendData) >= mBmcSimBlobCount)) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_RANGE;
+        break;
+      }
+
+      //
+      // The blob transfer driver expects the whole ID buffer back, NUL-padded.
+      //
+      CopyMem (ResponseData, mBmcSimBlobs[ReadUnaligned32 ((CONST UINT32 *)SendData)].Id, BMC_SIM_BLOB_ID_SIZE);
+      ResponseDataSize = BMC_SIM_BLOB_ID_SIZE;
+      break;
+
+    case BmcSimBlobOpen:
+      Response[0] = IPMI_COMP_CODE_OUT_OF_RANGE;
+      if ((SendDataSize <= BMC_SIM_BLOB_OPEN_SIZE) || (SendData[SendDataSize - 1] != '\0')) {
+        break;
+      }
+
+      for (Index = 0; Index < mBmcSimBlobCount; Index++) {
+        if (AsciiStrCmp (mBmcSimBlobs[Index].Id, (CONST CHAR8 *)SendData + BMC_SIM_BLOB_OPEN_SIZE) == 0) {
+          break;
+        }
+      }
+
+      if (Index == mBmcSimBlobCount) {
+        break;
+      }
+
+      for (Offset = 0; Offset < BMC_SIM_BLOB_MAX_SESSIONS; Offset++) {
+        if (!mBmcSimBlobSessions[Offset].InUse) {
+          mBmcSimBlobSessions[Offset].InUse = TRUE;
+          mBmcSimBlobSessions[Offset].Blob  = Index;
+          WriteUnaligned16 ((UINT16 *)ResponseData, (UINT16)Offset);
+          ResponseDataSize = sizeof (UINT16);
+          Response[0]      = IPMI_COMP_CODE_NORMAL;
+          break;
+        }
+      }
+
+      if (Offset == BMC_SIM_BLOB_MAX_SESSIONS) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_SPACE;
+      }
+
+      break;
+
+    case BmcSimBlobRead:
+      Blob = (SendDataSize == BMC_SIM_BLOB_READ_SIZE) ? BmcSimBlobFromSession (SendData) : NULL;
+      if (Blob == NULL) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_RANGE;
+        break;
+      }
+
+      Offset = ReadUnaligned32 ((CONST UINT32 *)(SendData + sizeof (UINT16)));
+      Length = ReadUnaligned32 ((CONST UINT32 *)(SendData + sizeof (UINT16) + sizeof (UINT32)));
+      Length = (Offset >= Blob->Size) ? 0 : MIN (Length, Blob->Size - Offset);
+      Length = MIN (Length, BMC_SIM_BLOB_MAX_DATA_PER_PACKET);
+      CopyMem (ResponseData, Blob->Data + Offset, Length);
+      ResponseDataSize = Length;
+      break;
+
+    case BmcSimBlobWrite:
+      Blob = (SendDataSize >= BMC_SIM_BLOB_RW_HEADER_SIZE) ? BmcSimBlobFromSession (SendData) : NULL;
+      if (Blob == NULL) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_RANGE;
+        break;
+      }
+
+      Offset = ReadUnaligned32 ((CONST UINT32 *)(SendData + sizeof (UINT16)));
+      Length = SendDataSize - BMC_SIM_BLOB_RW_HEADER_SIZE;
+      if ((Offset > Blob->Size) || (Length > Blob->Size - Offset)) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_SPACE;
+        break;
+      }
+
+      CopyMem (Blob->Data + Offset, SendData + BMC_SIM_BLOB_RW_HEADER_SIZE, Length);
+      break;
+
+    case BmcSimBlobCommit:
+      if ((SendDataSize < BMC_SIM_BLOB_SESSION_SIZE) || (BmcSimBlobFromSession (SendData) == NULL)) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_RANGE;
+      }
+
+      break;
+
+    case BmcSimBlobClose:
+      if ((SendDataSize < BMC_SIM_BLOB_SESSION_SIZE) || (BmcSimBlobFromSession (SendData) == NULL)) {
+        Response[0] = IPMI_COMP_CODE_OUT_OF_RANGE;
+        break;
+      }
+
+      mBmcSimBlobSessions[ReadUnaligned16 ((CONST UINT16 *)SendData)].InUse = FALSE;
+      break;
+
+    default:
+      Response[0] = IPMI_COMP_CODE_INVALID_COMMAND;
+      break;
+  }
+
+  if (Response[0] != IPMI_COMP_CODE_NORMAL) {
+    return 1;
+  }
+
+  if (ResponseDataSize == 0) {
+    return 1 + sizeof (mBmcSimOpenBmcOen);
+  }
+
+  WriteUnaligned16 ((UINT16 *)(Response + 1 + sizeof (mBmcSimOpenBmcOen)), BmcSimBlobCrc16 (ResponseData, ResponseDataSize));
+  return 1 + sizeof (mBmcSimOpenBmcOen) + sizeof (UINT16) + ResponseDataSize;
+}
+
+/**
+  Handles an IPMI request of the App network function.
+
+  @param[in]  Command       The command.
+  @param[in]  Request       The request data.
+  @param[in]  RequestSize   Size of the request data, in bytes.
+  @param[out] Response      Buffer to receive the completion code and response data.
+
+  @return The size of the response, in bytes.
+**/
+STATIC
+UINT32
+BmcSimHandleAppRequest (
+  IN  UINT8        Command,
+  IN  CONST UINT8  *Request,
+  IN  UINT32       RequestSize,
+  OUT UINT8        *Response
+  )
+{
+  IPMI_GET_DEVICE_ID_RESPONSE                           *DeviceId;
+  IPMI_SELF_TEST_RESULT_RESPONSE                        *SelfTest;
+  IPMI_GET_SYSTEM_UUID_RESPONSE                         *SystemUuid;
+  IPMI_GET_SYSTEM_INTERFACE_SSIF_CAPABILITIES_RESPONSE  *SsifCapabilities;
+
+  switch (Command) {
+    case IPMI_APP_GET_DEVICE_ID:
+      DeviceId = (IPMI_GET_DEVICE_ID_RESPONSE *)Response;
+      ZeroMem (DeviceId, sizeof (*DeviceId));
+      DeviceId->CompletionCode       = IPMI_COMP_CODE_NORMAL;
+      DeviceId->DeviceId             = 0x20;
+      DeviceId->SpecificationVersion = 0x02;
+      return sizeof (*DeviceId);
+
+    case IPMI_APP_GET_SELFTEST_RESULTS:
+      SelfTest = (IPMI_SELF_TEST_RESULT_RESPONSE *)Response;
+      ZeroMem (SelfTest, sizeof (*SelfTest));
+      SelfTest->CompletionCode = IPMI_COMP_CODE_NORMAL;
+      SelfTest->Result         = IPMI_APP_SELFTEST_NO_ERROR;
+      return sizeof (*SelfTest);
+
+    case IPMI_APP_GET_SYSTEM_GUID:
+      SystemUuid                 = (IPMI_GET_SYSTEM_UUID_RESPONSE *)Response;
+      SystemUuid->CompletionCode = IPMI_COMP_CODE_NORMAL;
+      CopyGuid (&SystemUuid->SystemUuid, &mBmcSimSystemGuid);
+      return sizeof (*SystemUuid);
+
+    case IPMI_APP_RESET_WATCHDOG_TIMER:
+      Response[0] = IPMI_COMP_CODE_NORMAL;
+      return 1;
+
+    case IPMI_APP_GET_SYSTEM_INTERFACE_CAPABILITIES:
+      if ((RequestSize < 1) || (Request[0] != IPMI_GET_SYSTEM_INTERFACE_CAPABILITIES_INTERFACE_TYPE_SSIF)) {
+        Response[0] = IPMI_COMP_CODE_INVALID_COMMAND;
+        return 1;
+      }
+
+      //
+      // Multi-part reads and writes with middle blocks, so that requests and
+      // responses of up to 255 bytes go through SSIF.
+      //
+      SsifCapabilities = (IPMI_GET_SYSTEM_INTERFACE_SSIF_CAPABILITIES_RESPONSE *)Response;
+      ZeroMem (SsifCapabilities, sizeof (*SsifCapabilities));
+      SsifCapabilities->CompletionCode                       = IPMI_COMP_CODE_NORMAL;
+      SsifCapabilities->InterfaceCap.Bits.TransactionSupport = IPMI_GET_SYSTEM_INTERFACE_CAPABILITIES_SSIF_TRANSACTION_SUPPORT_MULTI_PARTITION_RW_WITH_MIDDLE;
+      SsifCapabilities->InputMsgSize                         = MAX_UINT8;
+      SsifCapabilities->OutputMsgSize                        = MAX_UINT8;
+      return sizeof (*SsifCapabilities);
+
+    default:
+      Response[0] = IPMI_COMP_CODE_INVALID_COMMAND;
+      return 1;
+  }
+}
+
+/**
+  Handles an IPMI request and builds its response, with the same framing as the
+  request: NetFn << 2 | LUN and command, then the completion code and the data.
+
+  @param[in]  Request       The request, starting with NetFn << 2 | LUN.
+  @param[in]  RequestSize   Size of the request, in bytes.
+  @param[out] Response      Buffer of BMC_SIM_MAX_MESSAGE_SIZE bytes to receive the response.
+
+  @return The size of the response, in bytes. Zero if the request is malformed.
+**/
+UINT32
+BmcSimHandleIpmiRequest (
+  IN  CONST UINT8  *Request,
+  IN  UINT32       RequestSize,
+  OUT UINT8        *Response
+  )
+{
+  UINT8   NetFunction;
+  UINT8   Command;
+  UINT32  ResponseSize;
+
+  if (RequestSize < BMC_SIM_IPMI_HEADER_SIZE) {
+    mBmcSimStatistics.ProtocolErrors++;
+    return 0;
+  }
+
+  NetFunction = BMC_SIM_IPMI_NETFN (Request[0]);
+  Command     = Request[1];
+  Request    += BMC_SIM_IPMI_HEADER_SIZE;
+  RequestSize = RequestSize - BMC_SIM_IPMI_HEADER_SIZE;
+
+  mBmcSimStatistics.RoundTrips++;
+
+  if (NetFunction == IPMI_NETFN_APP) {
+    ResponseSize = BmcSimHandleAppRequest (Command, Request, RequestSize, Response + BMC_SIM_IPMI_HEADER_SIZE);
+  } else if ((NetFunction == IPMI_NETFN_OEM) && (Command == BMC_SIM_BLOB_COMMAND)) {
+    ResponseSize = BmcSimHandleBlobRequest (Request, RequestSize, Response + BMC_SIM_IPMI_HEADER_SIZE);
+  } else {
+    Response[BMC_SIM_IPMI_HEADER_SIZE] = IPMI_COMP_CODE_INVALID_COMMAND;
+    ResponseSize                       = 1;
+  }
+
+  //
+  // The response network function is the request one plus one.
+  //
+  Response[0] = BMC_SIM_IPMI_NETFN_LUN (NetFunction + 1, BMC_SIM_IPMI_LUN (Request[-BMC_SIM_IPMI_HEADER_SIZE]));
+  Response[1] = Command;
+  return BMC_SIM_IPMI_HEADER_SIZE + ResponseSize;
+}
+
+/**
+  Calculates the SMBus packet error code of MCTP over KCS.
+
+  @param[in]  Data          The data.
+  @param[in]  DataSize      Size of the data, in bytes.
+
+  @return The PEC.
+**/
+STATIC
+UINT8
+BmcSimMctpPec (
+  IN CONST UINT8  *Data,
+  IN UINT32       DataSize
+  )
+{
+  UINT8   Crc;
+  UINT32  Index;
+  UINT8   Bit;
+
+  Crc = 0;
+  for (Index = 0; Index < DataSize; Index++) {
+    Crc ^= Data[Index];
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (Crc & BIT7) ? (UINT8)((Crc << 1) ^ MCTP_KCS_PACKET_ERROR_CODE_POLY) : (UINT8)(Crc << 1);
+    }
+  }
+
+  return Crc;
+}
+
+/**
+  Handles a PLDM request. The simulated BMC accepts every SMBIOS request, and
+  rejects the requests of other PLDM types.
+
+  @param[in]  Request       The PLDM request, starting with the PLDM header.
+  @param[in]  RequestSize   Size of the request, in bytes.
+  @param[out] Response      Buffer to receive the PLDM response.
+
+  @return The size of the response, in bytes. Zero if the request is malformed.
+**/
+STATIC
+UINT32
+BmcSimHandlePldmRequest (
+  IN  CONST UINT8  *Request,
+  IN  UINT32       RequestSize,
+  OUT UINT8        *Response
+  )
+{
+  CONST PLDM_REQUEST_HEADER  *RequestHeader;
+  PLDM_RESPONSE_HEADER       *ResponseHeader;
+
+  RequestHeader = (CONST PLDM_REQUEST_HEADER *)Request;
+  if ((RequestSize < sizeof (PLDM_REQUEST_HEADER)) || (RequestHeader->RequestBit != PLDM_MESSAGE_HEADER_IS_REQUEST)) {
+    mBmcSimStatistics.ProtocolErrors++;
+    return 0;
+  }
+
+  ResponseHeader = (PLDM_RESPONSE_HEADER *)Response;
+  ZeroMem (ResponseHeader, sizeof (*ResponseHeader));
+  CopyMem (&ResponseHeader->PldmHeader, RequestHeader, sizeof (ResponseHeader->PldmHeader));
+  ResponseHeader->PldmHeader.RequestBit  = PLDM_MESSAGE_HEADER_IS_RESPONSE;
+  ResponseHeader->PldmHeader.DatagramBit = 0;
+  ResponseHeader->PldmCompletionCode     = (RequestHeader->PldmType == PLDM_TYPE_SMBIOS) ?
+                                           PLDM_COMPLETION_CODE_SUCCESS : PLDM_COMPLETION_CODE_ERROR;
+  return sizeof (*ResponseHeader);
+}
+
+/**
+  Handles an MCTP over KCS packet. Packets are reassembled until the one with
+  the end of message bit, which gets the response.
+
+  @param[in]  Packet        The packet, starting with the MCTP KCS header.
+  @param[in]  PacketSize    Size of the packet, in bytes.
+  @param[out] Response      Buffer of BMC_SIM_MAX_MESSAGE_SIZE bytes to receive the
+                            response packet, starting with the MCTP KCS header.
+
+  @return The size of the response packet, in bytes. Zero if the packet isn't the
+          last one of the message or is malformed.
+**/
+UINT32
+BmcSimHandleMctpKcsPacket (
+  IN  CONST UINT8  *Packet,
+  IN  UINT32       PacketSize,
+  OUT UINT8        *Response
+  )
+{
+  CONST MANAGEABILITY_MCTP_KCS_HEADER  *KcsHeader;
+  MCTP_TRANSPORT_HEADER                TransportHeader;
+  MANAGEABILITY_MCTP_KCS_HEADER        *ResponseKcsHeader;
+  MCTP_TRANSPORT_HEADER                *ResponseTransportHeader;
+  UINT32                               BodySize;
+  UINT32                               PayloadSize;
+  UINT32                               ByteCount;
+
+  KcsHeader = (CONST MANAGEABILITY_MCTP_KCS_HEADER *)Packet;
+  if ((PacketSize < sizeof (MANAGEABILITY_MCTP_KCS_HEADER) + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER) + sizeof (MANAGEABILITY_MCTP_KCS_TRAILER)) ||
+      (KcsHeader->DefiningBody != DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP) ||
+      (KcsHeader->ByteCount != PacketSize - sizeof (MANAGEABILITY_MCTP_KCS_HEADER) - sizeof (MANAGEABILITY_MCTP_KCS_TRAILER)) ||
+      (BmcSimMctpPec (Packet + sizeof (MANAGEABILITY_MCTP_KCS_HEADER), KcsHeader->ByteCount) != Packet[PacketSize - 1]))
+  {
+    mBmcSimStatistics.ProtocolErrors++;
+    mBmcSimMctpInMessage = FALSE;
+    return 0;
+  }
+
+  CopyMem (&TransportHeader, Packet + sizeof (MANAGEABILITY_MCTP_KCS_HEADER), sizeof (TransportHeader));
+  if (TransportHeader.Bits.StartOfMessage != 0) {
+    mBmcSimMctpInMessage    = TRUE;
+    mBmcSimMctpNextSequence = 0;
+    mBmcSimMctpMessageSize  = 0;
+    CopyMem (&mBmcSimMctpTransportHeader, &TransportHeader, sizeof (TransportHeader));
+    CopyMem (&mBmcSimMctpMessageHeader, Packet + sizeof (MANAGEABILITY_MCTP_KCS_HEADER) + sizeof (MCTP_TRANSPORT_HEADER), sizeof (MCTP_MESSAGE_HEADER));
+  }
+
+  //
+  // The MCTP protocol driver repeats the message header in every packet of a
+  // message, so the body of each packet follows it.
+  //
+  BodySize = KcsHeader->ByteCount - sizeof (MCTP_TRANSPORT_HEADER) - sizeof (MCTP_MESSAGE_HEADER);
+  if (!mBmcSimMctpInMessage ||
+      (TransportHeader.Bits.PacketSequence != mBmcSimMctpNextSequence) ||
+      (mBmcSimMctpMessageSize + BodySize > sizeof (mBmcSimMctpMessage)))
+  {
+    mBmcSimStatistics.ProtocolErrors++;
+    mBmcSimMctpInMessage = FALSE;
+    return 0;
+  }
+
+  CopyMem (
+    mBmcSimMctpMessage + mBmcSimMctpMessageSize,
+    Packet + sizeof (MANAGEABILITY_MCTP_KCS_HEADER) + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER),
+    BodySize
+    );
+  mBmcSimMctpMessageSize += BodySize;
+  mBmcSimMctpNextSequence = (mBmcSimMctpNextSequence + 1) & MCTP_PACKET_SEQUENCE_MASK;
+
+  if (TransportHeader.Bits.EndOfMessage == 0) {
+    return 0;
+  }
+
+  mBmcSimMctpInMessage = FALSE;
+  mBmcSimStatistics.RoundTrips++;
+
+  //
+  // Single-packet response, with the endpoint IDs swapped.
+  //
+  ResponseKcsHeader       = (MANAGEABILITY_MCTP_KCS_HEADER *)Response;
+  ResponseTransportHeader = (MCTP_TRANSPORT_HEADER *)(ResponseKcsHeader + 1);
+  ZeroMem (ResponseTransportHeader, sizeof (*ResponseTransportHeader));
+  ResponseTransportHeader->Bits.HeaderVersion         = MCTP_KCS_HEADER_VERSION;
+  ResponseTransportHeader->Bits.DestinationEndpointId = mBmcSimMctpTransportHeader.Bits.SourceEndpointId;
+  ResponseTransportHeader->Bits.SourceEndpointId      = mBmcSimMctpTransportHeader.Bits.DestinationEndpointId;
+  ResponseTransportHeader->Bits.MessageTag            = mBmcSimMctpTransportHeader.Bits.MessageTag;
+  ResponseTransportHeader->Bits.TagOwner              = MCTP_MESSAGE_TAG_OWNER_RESPONSE;
+  ResponseTransportHeader->Bits.StartOfMessage        = 1;
+  ResponseTransportHeader->Bits.EndOfMessage          = 1;
+  CopyMem (ResponseTransportHeader + 1, &mBmcSimMctpMessageHeader, sizeof (MCTP_MESSAGE_HEADER));
+
+  if (mBmcSimMctpMessageHeader.Bits.MessageType == MCTP_MESSAGE_TYPE_PLDM) {
+    PayloadSize = BmcSimHandlePldmRequest (
+                    mBmcSimMctpMessage,
+                    mBmcSimMctpMessageSize,
+                    (UINT8 *)(ResponseTransportHeader + 1) + sizeof (MCTP_MESSAGE_HEADER)
+                    );
+    if (PayloadSize == 0) {
+      return 0;
+    }
+  } else {
+    mBmcSimStatistics.ProtocolErrors++;
+    return 0;
+  }
+
+  ByteCount                       = sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER) + PayloadSize;
+  ResponseKcsHeader->NetFunc      = MCTP_KCS_NETFN_LUN;
+  ResponseKcsHeader->DefiningBody = DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP;
+  ResponseKcsHeader->ByteCount    = (UINT8)ByteCount;
+  Response[sizeof (MANAGEABILITY_MCTP_KCS_HEADER) + ByteCount] = BmcSimMctpPec (Response + sizeof (MANAGEABILITY_MCTP_KCS_HEADER), ByteCount);
+  return sizeof (MANAGEABILITY_MCTP_KCS_HEADER) + ByteCount + sizeof (MANAGEABILITY_MCTP_KCS_TRAILER);
+}
@@ -0,0 +1,369 @@
+/** @file
+  Serial interface of the host-based BMC simulator.
+
+  Implements SerialPortLib as the IPMI serial basic mode link to the BMC. Every
+  character costs SerialByteNs, both ways: the request characters when they are
+  written, and the response characters as they arrive after the BMC has handled
+  the request.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <IndustryStandard/IpmiSerial.h>
+#include <Library/SerialPortLib.h>
+
+#include "BmcSimulatorInternal.h"
+
+//
+// Largest response packet: serial header, response and data checksum. Every
+// character may be escaped, and the packet is framed by START and STOP.
+//
+#define BMC_SIM_SERIAL_MAX_PACKET_SIZE    (sizeof (IPMI_SERIAL_HEADER) + BMC_SIM_MAX_MESSAGE_SIZE + 1)
+#define BMC_SIM_SERIAL_MAX_TRANSMIT_SIZE  (2 * BMC_SIM_SERIAL_MAX_PACKET_SIZE + 2)
+
+typedef struct {
+  UINT8    Character;
+  UINT8    Escape;
+} BMC_SIM_SERIAL_ESCAPE;
+
+typedef struct {
+  BOOLEAN    InFrame;
+  BOOLEAN    Escaped;
+  UINT8      Frame[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT32     FrameSize;
+  UINT8      Transmit[BMC_SIM_SERIAL_MAX_TRANSMIT_SIZE];
+  UINT32     TransmitSize;
+  UINT32     TransmitCursor;
+  UINT64     TransmitStart;
+} BMC_SIM_SERIAL;
+
+STATIC CONST BMC_SIM_SERIAL_ESCAPE  mBmcSimSerialEscapes[] = {
+  { BASIC_MODE_START,     BASIC_MODE_START_ENCODED_BYTE     },
+  { BASIC_MODE_STOP,      BASIC_MODE_STOP_ENCODED_BYTE      },
+  { BASIC_MODE_HANDSHAKE, BASIC_MODE_HANDSHAKE_ENCODED_BYTE },
+  { BASIC_MODE_ESCAPE,    BASIC_MODE_ESCAPE_ENCODED_BYTE    },
+  { BASIC_MODE_ESC_CHAR,  BASIC_MODE_ESC_CHAR_ENCODED_BYTE  }
+};
+
+STATIC BMC_SIM_SERIAL  mBmcSimSerial;
+
+/**
+  Resets the state of the simulated serial interface.
+**/
+VOID
+BmcSimSerialReset (
+  VOID
+  )
+{
+  ZeroMem (&mBmcSimSerial, sizeof (mBmcSimSerial));
+}
+
+/**
+  Appends a character of a response frame to the transmit buffer, escaped if
+  it's one of the special characters of the basic mode.
+
+  @param[in]  Character     The character.
+**/
+STATIC
+VOID
+BmcSimSerialTransmitEscaped (
+  IN UINT8  Character
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mBmcSimSerialEscapes); Index++) {
+    if (mBmcSimSerialEscapes[Index].Character == Character) {
+      mBmcSimSerial.Transmit[mBmcSimSerial.TransmitSize++] = BASIC_MODE_ESCAPE;
+      Character                                            = mBmcSimSerialEscapes[Index].Escape;
+      break;
+    }
+  }
+
+  mBmcSimSerial.Transmit[mBmcSimSerial.TransmitSize++] = Character;
+}
+
+/**
+  Handles the received request frame, and queues the response frame.
+**/
+STATIC
+VOID
+BmcSimSerialProcessFrame (
+  VOID
+  )
+{
+  IPMI_SERIAL_HEADER  *Header;
+  IPMI_SERIAL_HEADER  *ResponseHeader;
+  UINT8               Request[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT8               Response[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT32              ResponseSize;
+  UINT8               Packet[BMC_SIM_SERIAL_MAX_PACKET_SIZE];
+  UINT32              PacketSize;
+  UINT32              Index;
+
+  Header = (IPMI_SERIAL_HEADER *)mBmcSimSerial.Frame;
+  if ((mBmcSimSerial.FrameSize < IPMI_SERIAL_MIN_REQUEST_LENGTH) ||
+      (CalculateSum8 (mBmcSimSerial.Frame, IPMI_SERIAL_CONNECTION_HEADER_LENGTH) != 0) ||
+      (CalculateSum8 (
+         mBmcSimSerial.Frame + IPMI_SERIAL_CONNECTION_HEADER_LENGTH,
+         mBmcSimSerial.FrameSize - IPMI_SERIAL_CONNECTION_HEADER_LENGTH
+         ) != 0))
+  {
+    mBmcSimStatistics.ProtocolErrors++;
+    return;
+  }
+
+  //
+  // NetFn/LUN, command and data, without the addresses, sequence and checksums.
+  //
+  Request[0] = Header->ResponderNetFnLun;
+  Request[1] = Header->Command;
+  CopyMem (
+    Request + BMC_SIM_IPMI_HEADER_SIZE,
+    Header->Data,
+    mBmcSimSerial.FrameSize - IPMI_SERIAL_MIN_REQUEST_LENGTH
+    );
+  ResponseSize = BmcSimHandleIpmiRequest (
+                   Request,
+                   mBmcSimSerial.FrameSize - IPMI_SERIAL_MIN_REQUEST_LENGTH + BMC_SIM_IPMI_HEADER_SIZE,
+                   Response
+                   );
+  if (ResponseSize == 0) {
+    return;
+  }
+
+  //
+  // The response goes back to the requester, with the completion code and the
+  // response data in place of the request data.
+  //
+  ResponseHeader                    = (IPMI_SERIAL_HEADER *)Packet;
+  ResponseHeader->ResponderAddress  = Header->RequesterAddress;
+  ResponseHeader->ResponderNetFnLun = BMC_SIM_IPMI_NETFN_LUN (BMC_SIM_IPMI_NETFN (Response[0]), BMC_SIM_IPMI_LUN (Header->RequesterSeqLun));
+  ResponseHeader->CheckSum          = CalculateCheckSum8 (Packet, IPMI_SERIAL_CONNECTION_HEADER_LENGTH - 1);
+  ResponseHeader->RequesterAddress  = Header->ResponderAddress;
+  ResponseHeader->RequesterSeqLun   = (UINT8)((Header->RequesterSeqLun & ~IPMI_MAX_LUN) | BMC_SIM_IPMI_LUN (Header->ResponderNetFnLun));
+  ResponseHeader->Command           = Header->Command;
+  CopyMem (ResponseHeader->Data, Response + BMC_SIM_IPMI_HEADER_SIZE, ResponseSize - BMC_SIM_IPMI_HEADER_SIZE);
+  PacketSize         = sizeof (IPMI_SERIAL_HEADER) + ResponseSize - BMC_SIM_IPMI_HEADER_SIZE;
+  Packet[PacketSize] = CalculateCheckSum8 (
+                         Packet + IPMI_SERIAL_CONNECTION_HEADER_LENGTH,
+                         PacketSize - IPMI_SERIAL_CONNECTION_HEADER_LENGTH
+                         );
+  PacketSize++;
+
+  mBmcSimSerial.TransmitSize   = 0;
+  mBmcSimSerial.TransmitCursor = 0;
+  mBmcSimSerial.TransmitStart  = mBmcSimNow + mBmcSimTiming.ProcessingNs;
+  mBmcSimSerial.Transmit[mBmcSimSerial.TransmitSize++] = BASIC_MODE_START;
+  for (Index = 0; Index < PacketSize; Index++) {
+    BmcSimSerialTransmitEscaped (Packet[Index]);
+  }
+
+  mBmcSimSerial.Transmit[mBmcSimSerial.TransmitSize++] = BASIC_MODE_STOP;
+}
+
+/**
+  Initializes the serial device hardware.
+
+  @retval RETURN_SUCCESS  The serial device was initialized.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortInitialize (
+  VOID
+  )
+{
+  return RETURN_SUCCESS;
+}
+
+/**
+  Writes data from buffer to the BMC.
+
+  @param  Buffer           Pointer to the data buffer to be written.
+  @param  NumberOfBytes    Number of bytes to written to the serial device.
+
+  @retval 0                NumberOfBytes is 0.
+  @retval >0               The number of bytes written to the serial device.
+**/
+UINTN
+EFIAPI
+SerialPortWrite (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  UINTN  Index;
+  UINTN  Escape;
+  UINT8  Character;
+
+  if ((Buffer == NULL) || (NumberOfBytes == 0)) {
+    return 0;
+  }
+
+  mBmcSimStatistics.BusTransactions++;
+  mBmcSimStatistics.BytesToBmc += NumberOfBytes;
+  BmcSimAdvance (MultU64x32 (NumberOfBytes, mBmcSimTiming.SerialByteNs));
+
+  for (Index = 0; Index < NumberOfBytes; Index++) {
+    Character = Buffer[Index];
+    if (Character == BASIC_MODE_START) {
+      mBmcSimSerial.InFrame   = TRUE;
+      mBmcSimSerial.Escaped   = FALSE;
+      mBmcSimSerial.FrameSize = 0;
+      continue;
+    }
+
+    if (!mBmcSimSerial.InFrame || (Character == BASIC_MODE_HANDSHAKE)) {
+      continue;
+    }
+
+    if (Character == BASIC_MODE_STOP) {
+      mBmcSimSerial.InFrame = FALSE;
+      BmcSimSerialProcessFrame ();
+      continue;
+    }
+
+    if (Character == BASIC_MODE_ESCAPE) {
+      mBmcSimSerial.Escaped = TRUE;
+      continue;
+    }
+
+    if (mBmcSimSerial.Escaped) {
+      mBmcSimSerial.Escaped = FALSE;
+      for (Escape = 0; Escape < ARRAY_SIZE (mBmcSimSerialEscapes); Escape++) {
+        if (mBmcSimSerialEscapes[Escape].Escape == Character) {
+          Character = mBmcSimSerialEscapes[Escape].Character;
+          break;
+        }
+      }
+    }
+
+    if (mBmcSimSerial.FrameSize == sizeof (mBmcSimSerial.Frame)) {
+      mBmcSimStatistics.ProtocolErrors++;
+      mBmcSimSerial.InFrame = FALSE;
+      continue;
+    }
+
+    mBmcSimSerial.Frame[mBmcSimSerial.FrameSize++] = Character;
+  }
+
+  return NumberOfBytes;
+}
+
+/**
+  Reads data the BMC has sent so far.
+
+  @param  Buffer           Pointer to the data buffer to store the data read from the serial device.
+  @param  NumberOfBytes    Number of bytes to read from the serial device.
+
+  @retval 0                NumberOfBytes is 0.
+  @retval >0               The number of bytes read from the serial device.
+**/
+UINTN
+EFIAPI
+SerialPortRead (
+  OUT UINT8  *Buffer,
+  IN  UINTN  NumberOfBytes
+  )
+{
+  UINTN  Count;
+
+  for (Count = 0; Count < NumberOfBytes; Count++) {
+    if (!SerialPortPoll ()) {
+      break;
+    }
+
+    Buffer[Count] = mBmcSimSerial.Transmit[mBmcSimSerial.TransmitCursor++];
+    mBmcSimStatistics.BytesFromBmc++;
+  }
+
+  return Count;
+}
+
+/**
+  Polls the serial device for a character sent by the BMC.
+
+  @retval TRUE             Data is waiting to be read from the serial device.
+  @retval FALSE            There is no data waiting to be read from the serial device.
+**/
+BOOLEAN
+EFIAPI
+SerialPortPoll (
+  VOID
+  )
+{
+  if (mBmcSimSerial.TransmitCursor >= mBmcSimSerial.TransmitSize) {
+    return FALSE;
+  }
+
+  //
+  // Characters arrive one SerialByteNs after another once the BMC starts sending.
+  //
+  return (BOOLEAN)(mBmcSimNow >= mBmcSimSerial.TransmitStart +
+                   MultU64x32 (mBmcSimSerial.TransmitCursor + 1, mBmcSimTiming.SerialByteNs));
+}
+
+/**
+  Sets the control bits on a serial device.
+
+  @param Control                Sets the bits of Control that are settable.
+
+  @retval RETURN_SUCCESS        The new control bits were set on the serial device.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortSetControl (
+  IN UINT32  Control
+  )
+{
+  return RETURN_SUCCESS;
+}
+
+/**
+  Retrieve the status of the control bits on a serial device.
+
+  @param Control                A pointer to return the current control signals from the serial device.
+
+  @retval RETURN_SUCCESS        The control bits were read from the serial device.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortGetControl (
+  OUT UINT32  *Control
+  )
+{
+  *Control = 0;
+  if (!SerialPortPoll ()) {
+    *Control |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Sets the baud rate, receive FIFO depth, transmit/receice time out, parity,
+  data bits, and stop bits on a serial device. The simulated link ignores them.
+
+  @param BaudRate           The requested baud rate.
+  @param ReceiveFifoDepth   The requested depth of the FIFO on the receive side.
+  @param Timeout            The requested time out for a single character in microseconds.
+  @param Parity             The type of parity to use on this serial device.
+  @param DataBits           The number of data bits to use on the serial device.
+  @param StopBits           The number of stop bits to use on this serial device.
+
+  @retval RETURN_SUCCESS            The new attributes were set on the serial device.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortSetAttributes (
+  IN OUT UINT64              *BaudRate,
+  IN OUT UINT32              *ReceiveFifoDepth,
+  IN OUT UINT32              *Timeout,
+  IN OUT EFI_PARITY_TYPE     *Parity,
+  IN OUT UINT8               *DataBits,
+  IN OUT EFI_STOP_BITS_TYPE  *StopBits
+  )
+{
+  return RETURN_SUCCESS;
+}
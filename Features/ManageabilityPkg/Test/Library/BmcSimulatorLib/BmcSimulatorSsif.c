@@ -0,0 +1,292 @@
+/** @file
+  SSIF interface of the host-based BMC simulator.
+
+  Implements SmBusWriteBlock and SmBusReadBlock for the SSIF slave address of
+  the BMC. Each block transfer costs SmbusByteNs per byte on the bus, and a read
+  of the response before the BMC has it ready is NAKed. SmBusReceiveByte from
+  the SMBus Alert Response Address returns the BMC address once the response
+  is ready, as if the BMC asserted SMBALERT#.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <IndustryStandard/IpmiSsif.h>
+#include <Library/SmbusLib.h>
+
+#include "BmcSimulatorInternal.h"
+
+//
+// Bytes on the bus around the data of a block write (address, command and byte
+// count) and of a block read (address, command, repeated address and byte count).
+//
+#define BMC_SIM_SSIF_WRITE_OVERHEAD  3
+#define BMC_SIM_SSIF_READ_OVERHEAD   4
+
+// SMBus Alert Response Address, excluding read/write bit.
+#define BMC_SIM_SMBUS_ALERT_RESPONSE_ADDR  0x0C
+
+typedef struct {
+  UINT8     Request[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT32    RequestSize;
+  BOOLEAN   InMultiPartWrite;
+  UINT8     Response[BMC_SIM_MAX_MESSAGE_SIZE];
+  UINT32    ResponseSize;
+  UINT32    ResponseCursor;
+  UINT8     BlockNumber;
+  UINT64    ReadyAt;
+  BOOLEAN   AlertAsserted;
+} BMC_SIM_SSIF;
+
+STATIC BMC_SIM_SSIF  mBmcSimSsif;
+
+/**
+  Resets the state of the simulated SSIF interface.
+**/
+VOID
+BmcSimSsifReset (
+  VOID
+  )
+{
+  ZeroMem (&mBmcSimSsif, sizeof (mBmcSimSsif));
+}
+
+/**
+  Accounts one block transfer on the SMBus.
+
+  @param[in]  BusBytes      Bytes on the bus, including the framing.
+**/
+STATIC
+VOID
+BmcSimSsifTransfer (
+  IN UINTN  BusBytes
+  )
+{
+  mBmcSimStatistics.BusTransactions++;
+  BmcSimAdvance (MultU64x32 (BusBytes, mBmcSimTiming.SmbusByteNs));
+}
+
+/**
+  Executes an SMBus block write to the BMC.
+
+  @param[in]  SmBusAddress  Address that encodes the SMBUS Slave Address,
+                            SMBUS Command, SMBUS Data Length, and PEC.
+  @param[in]  Buffer        Pointer to the buffer of bytes to write to the SMBUS.
+  @param[out] Status        Return status for the executed command.
+
+  @return The number of bytes written.
+**/
+UINTN
+EFIAPI
+SmBusWriteBlock (
+  IN  UINTN          SmBusAddress,
+  OUT VOID           *Buffer,
+  OUT RETURN_STATUS  *Status        OPTIONAL
+  )
+{
+  UINTN  Length;
+  UINT8  Command;
+
+  Length  = SMBUS_LIB_LENGTH (SmBusAddress);
+  Command = (UINT8)SMBUS_LIB_COMMAND (SmBusAddress);
+
+  if ((SMBUS_LIB_SLAVE_ADDRESS (SmBusAddress) != SMBUS_LIB_SLAVE_ADDRESS (FixedPcdGet8 (PcdIpmiSsifSmbusSlaveAddr))) ||
+      (Length == 0) || (Length > IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES))
+  {
+    BmcSimSsifTransfer (1);
+    if (Status != NULL) {
+      *Status = RETURN_DEVICE_ERROR;
+    }
+
+    return 0;
+  }
+
+  BmcSimSsifTransfer (Length + BMC_SIM_SSIF_WRITE_OVERHEAD + (SMBUS_LIB_PEC (SmBusAddress) ? 1 : 0));
+  mBmcSimStatistics.BytesToBmc += Length;
+
+  switch (Command) {
+    case IPMI_SSIF_SMBUS_CMD_SINGLE_PART_WRITE:
+    case IPMI_SSIF_SMBUS_CMD_MULTI_PART_WRITE_START:
+      mBmcSimSsif.RequestSize      = 0;
+      mBmcSimSsif.InMultiPartWrite = (BOOLEAN)(Command == IPMI_SSIF_SMBUS_CMD_MULTI_PART_WRITE_START);
+      break;
+
+    case IPMI_SSIF_SMBUS_CMD_MULTI_PART_WRITE_MIDDLE:
+    case IPMI_SSIF_SMBUS_CMD_MULTI_PART_WRITE_END:
+      if (mBmcSimSsif.InMultiPartWrite) {
+        break;
+      }
+
+    //
+    // Fall through, a middle or end block needs a start block first.
+    //
+    default:
+      mBmcSimStatistics.ProtocolErrors++;
+      mBmcSimSsif.InMultiPartWrite = FALSE;
+      if (Status != NULL) {
+        *Status = RETURN_DEVICE_ERROR;
+      }
+
+      return 0;
+  }
+
+  if (mBmcSimSsif.RequestSize + Length > sizeof (mBmcSimSsif.Request)) {
+    mBmcSimStatistics.ProtocolErrors++;
+    mBmcSimSsif.InMultiPartWrite = FALSE;
+    if (Status != NULL) {
+      *Status = RETURN_DEVICE_ERROR;
+    }
+
+    return 0;
+  }
+
+  CopyMem (mBmcSimSsif.Request + mBmcSimSsif.RequestSize, Buffer, Length);
+  mBmcSimSsif.RequestSize += (UINT32)Length;
+
+  if ((Command == IPMI_SSIF_SMBUS_CMD_SINGLE_PART_WRITE) || (Command == IPMI_SSIF_SMBUS_CMD_MULTI_PART_WRITE_END)) {
+    mBmcSimSsif.InMultiPartWrite = FALSE;
+    mBmcSimSsif.ResponseSize     = BmcSimHandleIpmiRequest (mBmcSimSsif.Request, mBmcSimSsif.RequestSize, mBmcSimSsif.Response);
+    mBmcSimSsif.ResponseCursor   = 0;
+    mBmcSimSsif.BlockNumber      = 0;
+    mBmcSimSsif.ReadyAt          = mBmcSimNow + mBmcSimTiming.ProcessingNs;
+    mBmcSimSsif.AlertAsserted    = TRUE;
+  }
+
+  if (Status != NULL) {
+    *Status = RETURN_SUCCESS;
+  }
+
+  return Length;
+}
+
+/**
+  Executes an SMBus block read from the BMC.
+
+  @param[in]  SmBusAddress  Address that encodes the SMBUS Slave Address,
+                            SMBUS Command, SMBUS Data Length, and PEC.
+  @param[out] Buffer        Pointer to the buffer to store the bytes read from the SMBUS.
+  @param[out] Status        Return status for the executed command.
+
+  @return The number of bytes read. Zero if the BMC NAKed the read.
+**/
+UINTN
+EFIAPI
+SmBusReadBlock (
+  IN  UINTN          SmBusAddress,
+  OUT VOID           *Buffer,
+  OUT RETURN_STATUS  *Status        OPTIONAL
+  )
+{
+  UINT8    *Block;
+  UINTN    Length;
+  UINT32   Remaining;
+  UINT8    Command;
+  BOOLEAN  LastBlock;
+
+  Block   = (UINT8 *)Buffer;
+  Command = (UINT8)SMBUS_LIB_COMMAND (SmBusAddress);
+
+  //
+  // The BMC NAKs its address while it has no response ready.
+  //
+  if ((SMBUS_LIB_SLAVE_ADDRESS (SmBusAddress) != SMBUS_LIB_SLAVE_ADDRESS (FixedPcdGet8 (PcdIpmiSsifSmbusSlaveAddr))) ||
+      (mBmcSimSsif.ResponseSize == 0) || (mBmcSimNow < mBmcSimSsif.ReadyAt))
+  {
+    BmcSimSsifTransfer (1);
+    if (Status != NULL) {
+      *Status = RETURN_DEVICE_ERROR;
+    }
+
+    return 0;
+  }
+
+  mBmcSimSsif.AlertAsserted = FALSE;
+  Remaining                 = mBmcSimSsif.ResponseSize - mBmcSimSsif.ResponseCursor;
+  if ((Command == IPMI_SSIF_SMBUS_CMD_SINGLE_PART_READ) && (mBmcSimSsif.ResponseCursor == 0)) {
+    if (Remaining <= IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES) {
+      Length    = Remaining;
+      LastBlock = TRUE;
+      CopyMem (Block, mBmcSimSsif.Response, Length);
+    } else {
+      Block[0]  = IPMI_SSIF_MULTI_PART_READ_START_PATTERN1;
+      Block[1]  = IPMI_SSIF_MULTI_PART_READ_START_PATTERN2;
+      Length    = IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES;
+      LastBlock = FALSE;
+      CopyMem (Block + 2, mBmcSimSsif.Response, Length - 2);
+      mBmcSimSsif.ResponseCursor = (UINT32)(Length - 2);
+    }
+  } else if ((Command == IPMI_SSIF_SMBUS_CMD_MULTI_PART_READ_MIDDLE) && (mBmcSimSsif.ResponseCursor != 0)) {
+    LastBlock = (BOOLEAN)(Remaining < IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES);
+    if (LastBlock) {
+      Block[0] = IPMI_SSIF_MULTI_PART_READ_END_PATTERN;
+      Length   = Remaining + 1;
+    } else {
+      Block[0] = mBmcSimSsif.BlockNumber++;
+      Length   = IPMI_SSIF_MAXIMUM_PACKET_SIZE_IN_BYTES;
+    }
+
+    CopyMem (Block + 1, mBmcSimSsif.Response + mBmcSimSsif.ResponseCursor, Length - 1);
+    mBmcSimSsif.ResponseCursor += (UINT32)(Length - 1);
+  } else {
+    mBmcSimStatistics.ProtocolErrors++;
+    BmcSimSsifTransfer (1);
+    if (Status != NULL) {
+      *Status = RETURN_DEVICE_ERROR;
+    }
+
+    return 0;
+  }
+
+  //
+  // The response is gone once its last block is read.
+  //
+  if (LastBlock) {
+    mBmcSimSsif.ResponseSize = 0;
+  }
+
+  BmcSimSsifTransfer (Length + BMC_SIM_SSIF_READ_OVERHEAD + (SMBUS_LIB_PEC (SmBusAddress) ? 1 : 0));
+  mBmcSimStatistics.BytesFromBmc += Length;
+  if (Status != NULL) {
+    *Status = RETURN_SUCCESS;
+  }
+
+  return Length;
+}
+
+/**
+  Executes an SMBus receive byte from the SMBus Alert Response Address.
+  The BMC answers with its address once the response is ready, and stops
+  asserting SMBALERT#.
+
+  @param[in]  SmBusAddress  Address that encodes the SMBUS Slave Address,
+                            SMBUS Command, SMBUS Data Length, and PEC.
+  @param[out] Status        Return status for the executed command.
+
+  @return The address of the alerting device. Zero if no device answered.
+**/
+UINT8
+EFIAPI
+SmBusReceiveByte (
+  IN  UINTN          SmBusAddress,
+  OUT RETURN_STATUS  *Status        OPTIONAL
+  )
+{
+  if ((SMBUS_LIB_SLAVE_ADDRESS (SmBusAddress) != BMC_SIM_SMBUS_ALERT_RESPONSE_ADDR) ||
+      !mBmcSimSsif.AlertAsserted || (mBmcSimNow < mBmcSimSsif.ReadyAt))
+  {
+    BmcSimSsifTransfer (1);
+    if (Status != NULL) {
+      *Status = RETURN_DEVICE_ERROR;
+    }
+
+    return 0;
+  }
+
+  mBmcSimSsif.AlertAsserted = FALSE;
+  BmcSimSsifTransfer (2);
+  if (Status != NULL) {
+    *Status = RETURN_SUCCESS;
+  }
+
+  return (UINT8)(SMBUS_LIB_SLAVE_ADDRESS (FixedPcdGet8 (PcdIpmiSsifSmbusSlaveAddr)) << 1);
+}
@@ -0,0 +1,564 @@
+/** @file
+  Benchmark of the IPMI, blob transfer and MCTP paths of ManageabilityPkg.
+
+  The application is built once per transport library (KCS, SSIF or serial),
+  which talks to the host-based BMC simulator of BmcSimulatorLib. The numbers
+  printed are the bus traffic and the simulated time of each operation, so they
+  can be compared between transports and before and after a change to one of
+  them, independently of the speed of the host.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <Uefi.h>
+#include <IndustryStandard/Ipmi.h>
+#include <IndustryStandard/Mctp.h>
+#include <IndustryStandard/Pldm.h>
+#include <IndustryStandard/PldmSmbiosTransfer.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BmcSimulatorLib.h>
+#include <Library/DebugLib.h>
+#include <Library/IpmiCommandLib.h>
+#include <Library/IpmiLib.h>
+#include <Library/ManageabilityTransportHelperLib.h>
+#include <Library/ManageabilityTransportLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Protocol/IpmiBlobTransfer.h>
+
+#include "../../Universal/IpmiProtocol/Common/IpmiProtocolCommon.h"
+#include "../../Universal/MctpProtocol/Common/MctpProtocolCommon.h"
+#include "../../Universal/IpmiBlobTransferDxe/InternalIpmiBlobTransfer.h"
+
+#define MANAGEABILITY_BENCH_DEFAULT_ITERATIONS  100
+#define MANAGEABILITY_BENCH_BLOB_ID             "/smbios"
+#define MANAGEABILITY_BENCH_BLOB_SIZE           SIZE_4KB
+
+typedef
+EFI_STATUS
+(*MANAGEABILITY_BENCH_FUNCTION)(
+  IN UINTN  Size
+  );
+
+typedef struct {
+  CONST CHAR8                     *Name;
+  MANAGEABILITY_BENCH_FUNCTION    Function;
+  UINTN                           Size;
+} MANAGEABILITY_BENCH_CASE;
+
+extern MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
+
+//
+// Globals of the MCTP protocol common code, owned by the MCTP DXE driver in firmware.
+//
+CHAR16                              *mTransportName;
+UINT32                              mTransportMaximumPayload;
+MANAGEABILITY_TRANSPORT_CAPABILITY  mTransportCapability;
+
+STATIC MANAGEABILITY_TRANSPORT_TOKEN                 *mBenchIpmiToken = NULL;
+STATIC MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mBenchIpmiHardwareInformation;
+STATIC MANAGEABILITY_TRANSPORT_TOKEN                 *mBenchMctpToken = NULL;
+STATIC UINT8                                         mBenchBlobData[MANAGEABILITY_BENCH_BLOB_SIZE];
+
+/**
+  IpmiLib instance of the benchmark, sending the IPMI commands of IpmiCommandLib
+  and of the blob transfer driver over the IPMI transport token.
+
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+  @param[in]         RequestData       Command Request Data.
+  @param[in]         RequestDataSize   Size of Command Request Data.
+  @param[out]        ResponseData      Command Response Data. The completion code is the first byte of response data.
+  @param[in, out]    ResponseDataSize  Size of Command Response Data.
+
+  @retval EFI_SUCCESS            The command byte stream was successfully submit to the device and a response was successfully received.
+  @retval EFI_NOT_READY          The IPMI transport isn't acquired.
+  @retval Others                 See CommonIpmiSubmitCommand().
+**/
+EFI_STATUS
+EFIAPI
+IpmiSubmitCommand (
+  IN     UINT8   NetFunction,
+  IN     UINT8   Command,
+  IN     UINT8   *RequestData,
+  IN     UINT32  RequestDataSize,
+  OUT    UINT8   *ResponseData,
+  IN OUT UINT32  *ResponseDataSize
+  )
+{
+  if (mBenchIpmiToken == NULL) {
+    return EFI_NOT_READY;
+  }
+
+  return CommonIpmiSubmitCommand (
+           mBenchIpmiToken,
+           NetFunction,
+           Command,
+           RequestData,
+           RequestDataSize,
+           ResponseData,
+           ResponseDataSize
+           );
+}
+
+/**
+  Acquires and initializes the transport interface for IPMI, the way the IPMI
+  DXE driver does.
+
+  @retval EFI_SUCCESS            The IPMI transport is ready.
+  @retval Others                 The transport can't be acquired or initialized.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchIpmiInit (
+  VOID
+  )
+{
+  EFI_STATUS                                 Status;
+  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  TransportAdditionalStatus;
+
+  Status = HelperAcquireManageabilityTransport (&gManageabilityProtocolIpmiGuid, &mBenchIpmiToken);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = SetupIpmiTransportHardwareInformation (mBenchIpmiToken, &mBenchIpmiHardwareInformation);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return HelperInitManageabilityTransport (mBenchIpmiToken, mBenchIpmiHardwareInformation, &TransportAdditionalStatus);
+}
+
+/**
+  Releases the IPMI transport, so that MCTP can acquire the interface.
+**/
+STATIC
+VOID
+ManageabilityBenchIpmiRelease (
+  VOID
+  )
+{
+  if (mBenchIpmiToken != NULL) {
+    ReleaseTransportSession (mBenchIpmiToken);
+    mBenchIpmiToken = NULL;
+  }
+
+  if (mBenchIpmiHardwareInformation.Pointer != NULL) {
+    FreePool (mBenchIpmiHardwareInformation.Pointer);
+    mBenchIpmiHardwareInformation.Pointer = NULL;
+  }
+}
+
+/**
+  Acquires and initializes the transport interface for MCTP, the way the MCTP
+  DXE driver does.
+
+  @retval EFI_SUCCESS            The MCTP transport is ready.
+  @retval EFI_UNSUPPORTED        MCTP isn't supported over the transport.
+  @retval Others                 The transport can't be acquired or initialized.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchMctpInit (
+  VOID
+  )
+{
+  EFI_STATUS                                 Status;
+  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  TransportAdditionalStatus;
+
+  Status = HelperAcquireManageabilityTransport (&gManageabilityProtocolMctpGuid, &mBenchMctpToken);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = GetTransportCapability (mBenchMctpToken, &mTransportCapability);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mTransportMaximumPayload = MANAGEABILITY_TRANSPORT_PAYLOAD_SIZE_FROM_CAPABILITY (mTransportCapability);
+  if (mTransportMaximumPayload != (1 << MANAGEABILITY_TRANSPORT_CAPABILITY_MAXIMUM_PAYLOAD_NOT_AVAILABLE)) {
+    mTransportMaximumPayload -= 1;
+  }
+
+  mTransportName = HelperManageabilitySpecName (mBenchMctpToken->Transport->ManageabilityTransportSpecification);
+
+  Status = SetupMctpTransportHardwareInformation (mBenchMctpToken, &mHardwareInformation);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HelperInitManageabilityTransport (mBenchMctpToken, mHardwareInformation, &TransportAdditionalStatus);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Releases the MCTP transport.
+**/
+STATIC
+VOID
+ManageabilityBenchMctpRelease (
+  VOID
+  )
+{
+  if (mBenchMctpToken != NULL) {
+    ReleaseTransportSession (mBenchMctpToken);
+    mBenchMctpToken = NULL;
+  }
+
+  if (mHardwareInformation.Pointer != NULL) {
+    FreePool (mHardwareInformation.Pointer);
+    mHardwareInformation.Pointer = NULL;
+  }
+}
+
+/**
+  Gets the device ID of the BMC.
+
+  @param[in]  Size          Unused.
+
+  @retval EFI_SUCCESS            The BMC returned its device ID.
+  @retval Others                 The command failed.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchGetDeviceId (
+  IN UINTN  Size
+  )
+{
+  EFI_STATUS                   Status;
+  IPMI_GET_DEVICE_ID_RESPONSE  DeviceId;
+
+  Status = IpmiGetDeviceId (&DeviceId);
+  if (!EFI_ERROR (Status) && (DeviceId.CompletionCode != IPMI_COMP_CODE_NORMAL)) {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
+/**
+  Gets the self test result of the BMC.
+
+  @param[in]  Size          Unused.
+
+  @retval EFI_SUCCESS            The BMC passed its self test.
+  @retval Others                 The command failed.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchGetSelfTestResult (
+  IN UINTN  Size
+  )
+{
+  EFI_STATUS                      Status;
+  IPMI_SELF_TEST_RESULT_RESPONSE  SelfTestResult;
+
+  Status = IpmiGetSelfTestResult (&SelfTestResult);
+  if (!EFI_ERROR (Status) &&
+      ((SelfTestResult.CompletionCode != IPMI_COMP_CODE_NORMAL) || (SelfTestResult.Result != IPMI_APP_SELFTEST_NO_ERROR)))
+  {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
+/**
+  Gets the system GUID from the BMC.
+
+  @param[in]  Size          Unused.
+
+  @retval EFI_SUCCESS            The BMC returned the system GUID.
+  @retval Others                 The command failed.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchGetSystemUuid (
+  IN UINTN  Size
+  )
+{
+  EFI_GUID  SystemUuid;
+
+  return IpmiGetSystemUuid (&SystemUuid);
+}
+
+/**
+  Writes the benchmark blob, from its start.
+
+  @param[in]  Size          Number of bytes to write.
+
+  @retval EFI_SUCCESS            The data was written.
+  @retval Others                 The blob transfer failed.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchBlobWrite (
+  IN UINTN  Size
+  )
+{
+  EFI_STATUS  Status;
+  UINT16      SessionId;
+
+  Status = IpmiBlobTransferOpen (MANAGEABILITY_BENCH_BLOB_ID, BLOB_OPEN_FLAG_WRITE, &SessionId);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = IpmiBlobTransferWriteStream (SessionId, 0, mBenchBlobData, (UINT32)Size, NULL, NULL);
+  IpmiBlobTransferClose (SessionId);
+  return Status;
+}
+
+/**
+  Reads the benchmark blob, from its start, and checks what was written.
+
+  @param[in]  Size          Number of bytes to read.
+
+  @retval EFI_SUCCESS            The data was read.
+  @retval EFI_CRC_ERROR          The data read isn't the data written.
+  @retval Others                 The blob transfer failed.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchBlobRead (
+  IN UINTN  Size
+  )
+{
+  EFI_STATUS  Status;
+  UINT16      SessionId;
+  UINT32      DataSize;
+  UINT8       Data[MANAGEABILITY_BENCH_BLOB_SIZE];
+
+  Status = IpmiBlobTransferOpen (MANAGEABILITY_BENCH_BLOB_ID, BLOB_OPEN_FLAG_READ, &SessionId);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  DataSize = (UINT32)Size;
+  Status   = IpmiBlobTransferReadStream (SessionId, 0, &DataSize, Data, NULL, NULL);
+  IpmiBlobTransferClose (SessionId);
+  if (!EFI_ERROR (Status) && ((DataSize != Size) || (CompareMem (Data, mBenchBlobData, Size) != 0))) {
+    Status = EFI_CRC_ERROR;
+  }
+
+  return Status;
+}
+
+/**
+  Sends a PLDM Set SMBIOS Structure Table request over MCTP.
+
+  @param[in]  Size          Size of the SMBIOS structure table data, in bytes.
+
+  @retval EFI_SUCCESS            The BMC accepted the table.
+  @retval Others                 The message failed.
+**/
+STATIC
+EFI_STATUS
+ManageabilityBenchPldmSetSmbiosStructureTable (
+  IN UINTN  Size
+  )
+{
+  EFI_STATUS                                 Status;
+  PLDM_REQUEST_HEADER                        *RequestHeader;
+  PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST    *SetSmbiosStructureTable;
+  UINT32                                     RequestSize;
+  PLDM_RESPONSE_HEADER                       Response;
+  UINT32                                     ResponseSize;
+  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  AdditionalTransferError;
+
+  RequestSize   = (UINT32)(sizeof (PLDM_REQUEST_HEADER) + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST) + Size);
+  RequestHeader = AllocateZeroPool (RequestSize);
+  if (RequestHeader == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  RequestHeader->RequestBit                       = PLDM_MESSAGE_HEADER_IS_REQUEST;
+  RequestHeader->HeaderVersion                    = PLDM_MESSAGE_HEADER_VERSION;
+  RequestHeader->PldmType                         = PLDM_TYPE_SMBIOS;
+  RequestHeader->PldmTypeCommandCode              = PLDM_SET_SMBIOS_STRUCTURE_TABLE_COMMAND_CODE;
+  SetSmbiosStructureTable                         = (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST *)(RequestHeader + 1);
+  SetSmbiosStructureTable->DataTransferHandle     = 0;
+  SetSmbiosStructureTable->TransferFlag           = PLDM_TRANSFER_FLAG_START_AND_END;
+  CopyMem (SetSmbiosStructureTable + 1, mBenchBlobData, Size);
+
+  ResponseSize = sizeof (Response);
+  Status       = CommonMctpSubmitMessage (
+                   mBenchMctpToken,
+                   MCTP_MESSAGE_TYPE_PLDM,
+                   PcdGet8 (PcdMctpSourceEndpointId),
+                   PcdGet8 (PcdMctpDestinationEndpointId),
+                   FALSE,
+                   (UINT8 *)RequestHeader,
+                   RequestSize,
+                   MANAGEABILITY_TRANSPORT_NO_TIMEOUT,
+                   (UINT8 *)&Response,
+                   &ResponseSize,
+                   MANAGEABILITY_TRANSPORT_NO_TIMEOUT,
+                   &AdditionalTransferError
+                   );
+  FreePool (RequestHeader);
+  if (!EFI_ERROR (Status) &&
+      ((ResponseSize < sizeof (Response)) || (Response.PldmCompletionCode != PLDM_COMPLETION_CODE_SUCCESS)))
+  {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
+STATIC CONST MANAGEABILITY_BENCH_CASE  mBenchIpmiCases[] = {
+  { "IPMI Get Device ID",          ManageabilityBenchGetDeviceId,       0                             },
+  { "IPMI Get Self Test Results",  ManageabilityBenchGetSelfTestResult, 0                             },
+  { "IPMI Get System GUID",        ManageabilityBenchGetSystemUuid,     0                             },
+  { "Blob write 256 B",            ManageabilityBenchBlobWrite,         256                           },
+  { "Blob write 4 KB",             ManageabilityBenchBlobWrite,         MANAGEABILITY_BENCH_BLOB_SIZE },
+  { "Blob read 256 B",             ManageabilityBenchBlobRead,          256                           },
+  { "Blob read 4 KB",              ManageabilityBenchBlobRead,          MANAGEABILITY_BENCH_BLOB_SIZE }
+};
+
+STATIC CONST MANAGEABILITY_BENCH_CASE  mBenchMctpCases[] = {
+  { "PLDM SMBIOS table 32 B",      ManageabilityBenchPldmSetSmbiosStructureTable, 32   },
+  { "PLDM SMBIOS table 256 B",     ManageabilityBenchPldmSetSmbiosStructureTable, 256  },
+  { "PLDM SMBIOS table 1 KB",      ManageabilityBenchPldmSetSmbiosStructureTable, 1024 }
+};
+
+/**
+  Runs the cases of a benchmark, and prints the average cost of an operation.
+
+  @param[in]  Cases         The benchmark cases.
+  @param[in]  CaseCount     Number of cases.
+  @param[in]  Iterations    Number of times each case is run.
+
+  @return The number of cases that failed.
+**/
+STATIC
+UINTN
+ManageabilityBenchRun (
+  IN CONST MANAGEABILITY_BENCH_CASE  *Cases,
+  IN UINTN                           CaseCount,
+  IN UINT64                          Iterations
+  )
+{
+  UINTN                     Index;
+  UINT64                    Iteration;
+  EFI_STATUS                Status;
+  BMC_SIMULATOR_STATISTICS  Before;
+  BMC_SIMULATOR_STATISTICS  After;
+  UINT64                    Start;
+  double                    Microseconds;
+  UINTN                     Failures;
+
+  Failures = 0;
+  for (Index = 0; Index < CaseCount; Index++) {
+    BmcSimulatorGetStatistics (&Before);
+    Start  = BmcSimulatorGetTime ();
+    Status = EFI_SUCCESS;
+
+    for (Iteration = 0; Iteration < Iterations && !EFI_ERROR (Status); Iteration++) {
+      Status = Cases[Index].Function (Cases[Index].Size);
+    }
+
+    Microseconds = (double)(BmcSimulatorGetTime () - Start) / 1000.0 / (double)Iteration;
+    BmcSimulatorGetStatistics (&After);
+
+    if (EFI_ERROR (Status)) {
+      printf ("%-28s failed at iteration %u, status 0x%llx\n", Cases[Index].Name, (unsigned)Iteration, (unsigned long long)Status);
+      Failures++;
+      continue;
+    }
+
+    printf (
+      "%-28s %8.1f %8.1f %8.1f %8.1f %6u %12.1f\n",
+      Cases[Index].Name,
+      (double)(After.RoundTrips - Before.RoundTrips) / (double)Iterations,
+      (double)(After.BusTransactions - Before.BusTransactions) / (double)Iterations,
+      (double)(After.BytesToBmc - Before.BytesToBmc) / (double)Iterations,
+      (double)(After.BytesFromBmc - Before.BytesFromBmc) / (double)Iterations,
+      (unsigned)(After.ProtocolErrors - Before.ProtocolErrors),
+      Microseconds
+      );
+    if (After.ProtocolErrors != Before.ProtocolErrors) {
+      Failures++;
+    }
+  }
+
+  return Failures;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  UINT64      Iterations;
+  UINTN       Index;
+  UINTN       Failures;
+  EFI_STATUS  Status;
+
+  Iterations = MANAGEABILITY_BENCH_DEFAULT_ITERATIONS;
+
+  if ((argc == 3) && (AsciiStrCmp (argv[1], "-n") == 0) && (atoi (argv[2]) > 0)) {
+    Iterations = (UINT64)atoi (argv[2]);
+  } else if (argc != 1) {
+    fprintf (stderr, "Usage: %s [-n Iterations]\n", argv[0]);
+    return 2;
+  }
+
+  for (Index = 0; Index < sizeof (mBenchBlobData); Index++) {
+    mBenchBlobData[Index] = (UINT8)(Index * 7 + 1);
+  }
+
+  BmcSimulatorReset (NULL);
+  Status = BmcSimulatorAddBlob (MANAGEABILITY_BENCH_BLOB_ID, MANAGEABILITY_BENCH_BLOB_SIZE);
+  if (EFI_ERROR (Status)) {
+    return 2;
+  }
+
+  Status = ManageabilityBenchIpmiInit ();
+  if (EFI_ERROR (Status)) {
+    fprintf (stderr, "Failed to initialize the IPMI transport.\n");
+    ManageabilityBenchIpmiRelease ();
+    return 2;
+  }
+
+  printf (
+    "%-28s %8s %8s %8s %8s %6s %12s\n",
+    "operation",
+    "trips",
+    "bus",
+    "to BMC",
+    "from BMC",
+    "errors",
+    "simulated us"
+    );
+
+  Failures = ManageabilityBenchRun (mBenchIpmiCases, ARRAY_SIZE (mBenchIpmiCases), Iterations);
+
+  //
+  // The transport interface has a single session, like it has in firmware.
+  //
+  ManageabilityBenchIpmiRelease ();
+
+  Status = ManageabilityBenchMctpInit ();
+  if (EFI_ERROR (Status)) {
+    printf ("%-28s not supported over this transport\n", "MCTP");
+  } else {
+    Failures += ManageabilityBenchRun (mBenchMctpCases, ARRAY_SIZE (mBenchMctpCases), Iterations);
+  }
+
+  ManageabilityBenchMctpRelease ();
+
+  return (Failures == 0) ? 0 : 1;
+}
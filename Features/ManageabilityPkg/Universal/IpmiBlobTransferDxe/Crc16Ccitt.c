@@ -0,0 +1,113 @@
+/** @file
+
+  CRC-16-CCITT calculation for the IPMI Blob Transfer driver
+
+  Copyright (c) 2022-2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.<BR>
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Base.h>
+#include <Library/DebugLib.h>
+
+#define CRC16_CCITT_POLY  0x1021
+
+//
+// The blob protocol CRC is the bitwise CRC-16-CCITT with an initial value of 0xFFFF,
+// followed by two zero bytes. This is the same as the non-augmented CRC with this
+// initial value, which does not need the zero bytes.
+//
+#define CRC16_CCITT_INITIAL_VALUE  0x1D0F
+
+#define CRC16_CCITT_SLICES  8
+
+//
+// mCrc16CcittTable[0][N] is the CRC of the byte N, and mCrc16CcittTable[S][N] is the
+// CRC of the byte N followed by S zero bytes, so that CRC16_CCITT_SLICES bytes can be
+// processed with independent table lookups.
+//
+STATIC UINT16   mCrc16CcittTable[CRC16_CCITT_SLICES][256];
+STATIC BOOLEAN  mCrc16CcittTableReady;
+
+/**
+  Build the CRC-16-CCITT lookup tables.
+
+**/
+STATIC
+VOID
+InitializeCrc16CcittTable (
+  VOID
+  )
+{
+  UINTN   Index;
+  UINTN   Slice;
+  UINTN   BitIndex;
+  UINT16  Crc;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = (UINT16)(Index << 8);
+    for (BitIndex = 0; BitIndex < 8; BitIndex++) {
+      Crc = (Crc & 0x8000) ? (UINT16)((Crc << 1) ^ CRC16_CCITT_POLY) : (UINT16)(Crc << 1);
+    }
+
+    mCrc16CcittTable[0][Index] = Crc;
+  }
+
+  for (Slice = 1; Slice < CRC16_CCITT_SLICES; Slice++) {
+    for (Index = 0; Index < 256; Index++) {
+      Crc                            = mCrc16CcittTable[Slice - 1][Index];
+      mCrc16CcittTable[Slice][Index] = (UINT16)(Crc << 8) ^ mCrc16CcittTable[0][Crc >> 8];
+    }
+  }
+
+  mCrc16CcittTableReady = TRUE;
+}
+
+/**
+  Calculate CRC-16-CCITT with poly of 0x1021
+
+  @param[in]  Data              The target data.
+  @param[in]  DataSize          The target data size.
+
+  @return UINT16     The CRC16 value.
+
+**/
+UINT16
+CalculateCrc16Ccitt (
+  IN UINT8  *Data,
+  IN UINTN  DataSize
+  )
+{
+  UINT16  Crc;
+
+  if (!mCrc16CcittTableReady) {
+    InitializeCrc16CcittTable ();
+  }
+
+  Crc = CRC16_CCITT_INITIAL_VALUE;
+
+  while (DataSize >= CRC16_CCITT_SLICES) {
+    Crc = mCrc16CcittTable[7][Data[0] ^ (Crc >> 8)] ^
+          mCrc16CcittTable[6][Data[1] ^ (Crc & 0xFF)] ^
+          mCrc16CcittTable[5][Data[2]] ^
+          mCrc16CcittTable[4][Data[3]] ^
+          mCrc16CcittTable[3][Data[4]] ^
+          mCrc16CcittTable[2][Data[5]] ^
+          mCrc16CcittTable[1][Data[6]] ^
+          mCrc16CcittTable[0][Data[7]];
+
+    Data     += CRC16_CCITT_SLICES;
+    DataSize -= CRC16_CCITT_SLICES;
+  }
+
+  while (DataSize > 0) {
+    Crc = (UINT16)(Crc << 8) ^ mCrc16CcittTable[0][(Crc >> 8) ^ *Data];
+    Data++;
+    DataSize--;
+  }
+
+  DEBUG ((DEBUG_MANAGEABILITY, "%a: CRC-16-CCITT %x\n", __func__, Crc));
+
+  return Crc;
+}
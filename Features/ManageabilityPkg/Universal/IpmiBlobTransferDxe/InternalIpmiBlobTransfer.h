@@ -178,6 +178,20 @@ typedef struct {
 
   #pragma pack()
 
+//
+// The send data of a request follows the header and its CRC
+//
+#define BLOB_TRANSFER_REQUEST_DATA_OFFSET  (sizeof (IPMI_BLOB_TRANSFER_HEADER) + sizeof (UINT16))
+
+//
+// Request and response buffers for a read or write packet. The streaming functions
+// allocate one for the whole transfer, and build the send data of each packet in place.
+//
+typedef struct {
+  UINT8    Request[BLOB_TRANSFER_REQUEST_DATA_OFFSET + sizeof (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA)];
+  UINT8    Response[PROTOCOL_RESPONSE_OVERHEAD + sizeof (UINT16) + BLOB_MAX_DATA_PER_PACKET];
+} IPMI_BLOB_TRANSFER_PACKET;
+
 /**
   Calculate CRC-16-CCITT with poly of 0x1021
 
@@ -221,6 +235,33 @@ IpmiBlobTransferSendIpmi (
   OUT UINT32  *ResponseDataSize
   );
 
+/**
+  This function does blob transfer over IPMI command, using the buffers of a packet.
+  The send data must already be at BLOB_TRANSFER_REQUEST_DATA_OFFSET in the request.
+
+  @param[in]      SubCommand        The specific sub-command to be executed as part of
+                                    the blob transfer operation.
+  @param[in, out] Packet            The buffers of the packet.
+  @param[in]      SendDataSize      The size of the data to be sent, in bytes.
+  @param[out]     ResponseData      On success, a pointer to the response data in the packet.
+  @param[in, out] ResponseDataSize  On input, the size of the expected response data.
+                                    On output, the size of the response data received.
+
+  @retval EFI_SUCCESS            Successfully sends blob data.
+  @retval EFI_PROTOCOL_ERROR     Communication errors.
+  @retval EFI_CRC_ERROR          Data integrity checks fail.
+  @retval Other                  An error occurred
+
+**/
+EFI_STATUS
+IpmiBlobTransferSendPacket (
+  IN      UINT8                      SubCommand,
+  IN OUT  IPMI_BLOB_TRANSFER_PACKET  *Packet,
+  IN      UINT32                     SendDataSize,
+  OUT     UINT8                      **ResponseData,
+  IN OUT  UINT32                     *ResponseDataSize
+  );
+
 /**
   This function retrieves the count of blob transfers available through the IPMI.
 
@@ -417,4 +458,61 @@ IpmiBlobTransferWriteMeta (
   IN  UINT32  WriteLength
   );
 
+/**
+  This function reads data of any size from a blob over the IPMI. The data is split
+  into BLOB_MAX_DATA_PER_PACKET sized reads, all sent from the same buffers.
+  Reading stops early if the BMC returns less data than requested, at the end of the blob.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start reading
+  @param[in, out]    DataSize        On input, the length of data to read.
+                                     On output, the length of data read.
+  @param[out]        Data            Data read from the blob
+  @param[in]         Progress        Function called after each packet. This is optional.
+  @param[in]         Context         Context passed to Progress. This is optional.
+
+  @retval EFI_SUCCESS                Successfully read from the blob.
+  @retval EFI_INVALID_PARAMETER      The read goes past the largest blob offset.
+  @retval EFI_OUT_OF_RESOURCES       Memory allocation fails.
+  @retval Other                      An error occurred. DataSize is the length of data read
+                                     before the error.
+**/
+EFI_STATUS
+EFIAPI
+IpmiBlobTransferReadStream (
+  IN     UINT16                             SessionId,
+  IN     UINT32                             Offset,
+  IN OUT UINT32                             *DataSize,
+  OUT    UINT8                              *Data,
+  IN     EDKII_IPMI_BLOB_TRANSFER_PROGRESS  Progress OPTIONAL,
+  IN     VOID                               *Context OPTIONAL
+  );
+
+/**
+  This function writes data of any size to a blob over the IPMI. The data is split
+  into BLOB_MAX_DATA_PER_PACKET sized writes, all sent from the same buffers.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start writing
+  @param[in]         Data            A pointer to the data to write
+  @param[in]         WriteLength     The length to write
+  @param[in]         Progress        Function called after each packet. This is optional.
+  @param[in]         Context         Context passed to Progress. This is optional.
+
+  @retval EFI_SUCCESS                Successfully wrote to the blob.
+  @retval EFI_INVALID_PARAMETER      The write goes past the largest blob offset.
+  @retval EFI_OUT_OF_RESOURCES       Memory allocation fails.
+  @retval Other                      An error occurred
+**/
+EFI_STATUS
+EFIAPI
+IpmiBlobTransferWriteStream (
+  IN  UINT16                             SessionId,
+  IN  UINT32                             Offset,
+  IN  UINT8                              *Data,
+  IN  UINT32                             WriteLength,
+  IN  EDKII_IPMI_BLOB_TRANSFER_PROGRESS  Progress OPTIONAL,
+  IN  VOID                               *Context OPTIONAL
+  );
+
 #endif
@@ -24,51 +24,128 @@ STATIC CONST EDKII_IPMI_BLOB_TRANSFER_PROTOCOL  mIpmiBlobTransfer = {
   (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_DELETE)*IpmiBlobTransferDelete,
   (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_STAT)*IpmiBlobTransferStat,
   (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_SESSION_STAT)*IpmiBlobTransferSessionStat,
-  (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_META)*IpmiBlobTransferWriteMeta
+  (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_META)*IpmiBlobTransferWriteMeta,
+  IpmiBlobTransferReadStream,
+  IpmiBlobTransferWriteStream
 };
 
 /**
-  Calculate CRC-16-CCITT with poly of 0x1021
+  This function fills in the header of a request and the CRC of its send data.
+  The send data must already be at BLOB_TRANSFER_REQUEST_DATA_OFFSET in the request.
 
-  @param[in]  Data              The target data.
-  @param[in]  DataSize          The target data size.
+  @param[in]      SubCommand        The specific sub-command to be executed as part of
+                                    the blob transfer operation.
+  @param[in, out] Request           A pointer to the request.
+  @param[in]      SendDataSize      The size of the send data, in bytes.
 
-  @return UINT16     The CRC16 value.
+  @return UINT32     The size of the request, in bytes.
 
 **/
-UINT16
-CalculateCrc16Ccitt (
-  IN UINT8  *Data,
-  IN UINTN  DataSize
+STATIC
+UINT32
+IpmiBlobTransferFillRequest (
+  IN      UINT8   SubCommand,
+  IN OUT  UINT8   *Request,
+  IN      UINT32  SendDataSize
   )
 {
-  UINTN    Index;
-  UINTN    BitIndex;
-  UINT16   Crc;
-  UINT16   Poly;
-  BOOLEAN  XorFlag;
-
-  Crc     = 0xFFFF;
-  Poly    = 0x1021;
-  XorFlag = FALSE;
-
-  for (Index = 0; Index < (DataSize + 2); ++Index) {
-    for (BitIndex = 0; BitIndex < 8; ++BitIndex) {
-      XorFlag = (Crc & 0x8000) ? TRUE : FALSE;
-      Crc   <<= 1;
-      if ((Index < DataSize) && (Data[Index] & (1 << (7 - BitIndex)))) {
-        Crc++;
-      }
-
-      if (XorFlag == TRUE) {
-        Crc ^= Poly;
-      }
-    }
+  IPMI_BLOB_TRANSFER_HEADER  Header;
+  UINT16                     Crc;
+
+  Header.OEN[0]     = OpenBmcOen[0];
+  Header.OEN[1]     = OpenBmcOen[1];
+  Header.OEN[2]     = OpenBmcOen[2];
+  Header.SubCommand = SubCommand;
+  CopyMem (Request, &Header, sizeof (IPMI_BLOB_TRANSFER_HEADER));
+
+  if (SendDataSize == 0) {
+    return sizeof (IPMI_BLOB_TRANSFER_HEADER);
   }
 
-  DEBUG ((BLOB_TRANSFER_DEBUG, "%a: CRC-16-CCITT %x\n", __func__, Crc));
+  //
+  // Calculate the Crc of the send data
+  //
+  Crc = CalculateCrc16Ccitt (Request + BLOB_TRANSFER_REQUEST_DATA_OFFSET, SendDataSize);
+  CopyMem (Request + sizeof (IPMI_BLOB_TRANSFER_HEADER), &Crc, sizeof (UINT16));
 
-  return Crc;
+  return BLOB_TRANSFER_REQUEST_DATA_OFFSET + SendDataSize;
+}
+
+/**
+  This function checks the completion code, OEN and CRC of a response, and finds its data.
+
+  @param[in]      IpmiResponseData      A pointer to the response.
+  @param[in]      IpmiResponseDataSize  The size of the response, in bytes.
+  @param[out]     ResponseData          A pointer to the response data, in the response.
+  @param[out]     ResponseDataSize      The size of the response data, in bytes. It's zero
+                                        for responses without data.
+
+  @retval EFI_SUCCESS            The response is valid.
+  @retval EFI_PROTOCOL_ERROR     The response failed or isn't a blob transfer response.
+  @retval EFI_CRC_ERROR          Data integrity checks fail.
+
+**/
+STATIC
+EFI_STATUS
+IpmiBlobTransferParseResponse (
+  IN  UINT8   *IpmiResponseData,
+  IN  UINT32  IpmiResponseDataSize,
+  OUT UINT8   **ResponseData,
+  OUT UINT32  *ResponseDataSize
+  )
+{
+  UINT8   CompletionCode;
+  UINT16  Crc;
+
+  if (IpmiResponseDataSize < sizeof (CompletionCode)) {
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  CompletionCode = *IpmiResponseData;
+  if (CompletionCode != IPMI_COMP_CODE_NORMAL) {
+    DEBUG ((DEBUG_ERROR, "%a: Returning because CompletionCode = 0x%x\n", __func__, CompletionCode));
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  // Strip completion code, we are done with it
+  IpmiResponseData     += sizeof (CompletionCode);
+  IpmiResponseDataSize -= sizeof (CompletionCode);
+
+  // Check OEN code and verify it matches the OpenBMC OEN
+  if ((IpmiResponseDataSize < sizeof (OpenBmcOen)) || (CompareMem (IpmiResponseData, OpenBmcOen, sizeof (OpenBmcOen)) != 0)) {
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  // Strip the OEN, we are done with it now
+  IpmiResponseData     += sizeof (OpenBmcOen);
+  IpmiResponseDataSize -= sizeof (OpenBmcOen);
+
+  if (IpmiResponseDataSize == 0) {
+    //
+    // In this case, there was no response data sent. This is not an error.
+    // Some messages do not require a response.
+    //
+    *ResponseData     = IpmiResponseData;
+    *ResponseDataSize = 0;
+    return EFI_SUCCESS;
+  }
+
+  // Now we need to validate the CRC then send the Response body back
+  if (IpmiResponseDataSize < sizeof (Crc)) {
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  CopyMem (&Crc, IpmiResponseData, sizeof (Crc));
+  IpmiResponseData     += sizeof (Crc);
+  IpmiResponseDataSize -= sizeof (Crc);
+
+  if (Crc != CalculateCrc16Ccitt (IpmiResponseData, IpmiResponseDataSize)) {
+    return EFI_CRC_ERROR;
+  }
+
+  *ResponseData     = IpmiResponseData;
+  *ResponseDataSize = IpmiResponseDataSize;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -100,29 +177,24 @@ IpmiBlobTransferSendIpmi (
   IN OUT  UINT32  *ResponseDataSize
   )
 {
-  EFI_STATUS                 Status;
-  UINT8                      CompletionCode;
-  UINT16                     Crc;
-  UINT8                      Oen[3];
-  UINT8                      *IpmiSendData;
-  UINT32                     IpmiSendDataSize;
-  UINT8                      *IpmiResponseData;
-  UINT8                      *ModifiedResponseData;
-  UINT32                     IpmiResponseDataSize;
-  IPMI_BLOB_TRANSFER_HEADER  Header;
+  EFI_STATUS  Status;
+  UINT8       *IpmiSendData;
+  UINT32      IpmiSendDataSize;
+  UINT8       *IpmiResponseData;
+  UINT32      IpmiResponseDataSize;
+  UINT8       *ResponseBody;
+  UINT32      ResponseBodySize;
 
   if (((SendDataSize > 0) && (SendData == NULL)) || ((ResponseData == NULL) && (((ResponseDataSize != NULL) && (*ResponseDataSize > 0))))) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Crc = 0;
-
   //
   // Prepend the proper header to the SendData
   //
   IpmiSendDataSize = (sizeof (IPMI_BLOB_TRANSFER_HEADER));
   if (SendDataSize > 0) {
-    IpmiSendDataSize += sizeof (Crc) + (sizeof (UINT8) * SendDataSize);
+    IpmiSendDataSize = BLOB_TRANSFER_REQUEST_DATA_OFFSET + (sizeof (UINT8) * SendDataSize);
   }
 
   IpmiSendData = AllocateZeroPool (IpmiSendDataSize);
@@ -130,20 +202,12 @@ IpmiBlobTransferSendIpmi (
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Header.OEN[0]     = OpenBmcOen[0];
-  Header.OEN[1]     = OpenBmcOen[1];
-  Header.OEN[2]     = OpenBmcOen[2];
-  Header.SubCommand = SubCommand;
-  CopyMem (IpmiSendData, &Header, sizeof (IPMI_BLOB_TRANSFER_HEADER));
   if (SendDataSize > 0) {
-    //
-    // Calculate the Crc of the send data
-    //
-    Crc = CalculateCrc16Ccitt (SendData, SendDataSize);
-    CopyMem (IpmiSendData + sizeof (IPMI_BLOB_TRANSFER_HEADER), &Crc, sizeof (UINT16));
-    CopyMem (IpmiSendData + sizeof (IPMI_BLOB_TRANSFER_HEADER) + sizeof (UINT16), SendData, SendDataSize);
+    CopyMem (IpmiSendData + BLOB_TRANSFER_REQUEST_DATA_OFFSET, SendData, SendDataSize);
   }
 
+  IpmiBlobTransferFillRequest (SubCommand, IpmiSendData, SendDataSize);
+
   DEBUG_CODE_BEGIN ();
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: Inputs:\n", __func__));
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: SendDataSize: %02x\nData: ", __func__, SendDataSize));
@@ -167,11 +231,12 @@ IpmiBlobTransferSendIpmi (
   // If expecting data to be returned, we have to also account for the 16 bit CRC
   //
   if ((ResponseDataSize != NULL) && (*ResponseDataSize > 0)) {
-    IpmiResponseDataSize += (*ResponseDataSize + sizeof (Crc));
+    IpmiResponseDataSize += (*ResponseDataSize + sizeof (UINT16));
   }
 
   IpmiResponseData = AllocateZeroPool (IpmiResponseDataSize);
   if (IpmiResponseData == NULL) {
+    FreePool (IpmiSendData);
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -185,7 +250,6 @@ IpmiBlobTransferSendIpmi (
              );
 
   FreePool (IpmiSendData);
-  ModifiedResponseData = IpmiResponseData;
 
   DEBUG_CODE_BEGIN ();
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: IPMI Response:\n", __func__));
@@ -193,68 +257,82 @@ IpmiBlobTransferSendIpmi (
   UINT8  i;
 
   for (i = 0; i < IpmiResponseDataSize; i++) {
-    DEBUG ((BLOB_TRANSFER_DEBUG, "%02x", *(ModifiedResponseData + i)));
+    DEBUG ((BLOB_TRANSFER_DEBUG, "%02x", *(IpmiResponseData + i)));
   }
 
   DEBUG ((BLOB_TRANSFER_DEBUG, "\n"));
   DEBUG_CODE_END ();
 
-  if (EFI_ERROR (Status)) {
-    return Status;
+  if (!EFI_ERROR (Status)) {
+    Status = IpmiBlobTransferParseResponse (IpmiResponseData, IpmiResponseDataSize, &ResponseBody, &ResponseBodySize);
   }
 
-  CompletionCode = *ModifiedResponseData;
-  if (CompletionCode != IPMI_COMP_CODE_NORMAL) {
-    DEBUG ((DEBUG_ERROR, "%a: Returning because CompletionCode = 0x%x\n", __func__, CompletionCode));
-    FreePool (IpmiResponseData);
-    return EFI_PROTOCOL_ERROR;
+  if (!EFI_ERROR (Status) && (ResponseDataSize != NULL)) {
+    if ((ResponseData != NULL) && (ResponseBodySize > 0)) {
+      CopyMem (ResponseData, ResponseBody, ResponseBodySize);
+    }
+
+    *ResponseDataSize = ResponseBodySize;
   }
 
-  // Strip completion code, we are done with it
-  ModifiedResponseData  = ModifiedResponseData + sizeof (CompletionCode);
-  IpmiResponseDataSize -= sizeof (CompletionCode);
+  FreePool (IpmiResponseData);
+  return Status;
+}
 
-  // Check OEN code and verify it matches the OpenBMC OEN
-  CopyMem (Oen, ModifiedResponseData, sizeof (OpenBmcOen));
-  if (CompareMem (Oen, OpenBmcOen, sizeof (OpenBmcOen)) != 0) {
-    FreePool (IpmiResponseData);
-    return EFI_PROTOCOL_ERROR;
-  }
+/**
+  This function does blob transfer over IPMI command, using the buffers of a packet.
+  The send data must already be at BLOB_TRANSFER_REQUEST_DATA_OFFSET in the request.
 
-  if (IpmiResponseDataSize == sizeof (OpenBmcOen)) {
-    //
-    // In this case, there was no response data sent. This is not an error.
-    // Some messages do not require a response.
-    //
-    if (ResponseDataSize != NULL) {
-      *ResponseDataSize = 0;
-    }
+  @param[in]      SubCommand        The specific sub-command to be executed as part of
+                                    the blob transfer operation.
+  @param[in, out] Packet            The buffers of the packet.
+  @param[in]      SendDataSize      The size of the data to be sent, in bytes.
+  @param[out]     ResponseData      On success, a pointer to the response data in the packet.
+  @param[in, out] ResponseDataSize  On input, the size of the expected response data.
+                                    On output, the size of the response data received.
+
+  @retval EFI_SUCCESS            Successfully sends blob data.
+  @retval EFI_PROTOCOL_ERROR     Communication errors.
+  @retval EFI_CRC_ERROR          Data integrity checks fail.
+  @retval Other                  An error occurred
+
+**/
+EFI_STATUS
+IpmiBlobTransferSendPacket (
+  IN      UINT8                      SubCommand,
+  IN OUT  IPMI_BLOB_TRANSFER_PACKET  *Packet,
+  IN      UINT32                     SendDataSize,
+  OUT     UINT8                      **ResponseData,
+  IN OUT  UINT32                     *ResponseDataSize
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      IpmiSendDataSize;
+  UINT32      IpmiResponseDataSize;
 
-    FreePool (IpmiResponseData);
+  ASSERT (BLOB_TRANSFER_REQUEST_DATA_OFFSET + SendDataSize <= sizeof (Packet->Request));
+  ASSERT (*ResponseDataSize <= BLOB_MAX_DATA_PER_PACKET);
+
+  IpmiSendDataSize = IpmiBlobTransferFillRequest (SubCommand, Packet->Request, SendDataSize);
+
+  IpmiResponseDataSize = PROTOCOL_RESPONSE_OVERHEAD;
+  if (*ResponseDataSize > 0) {
+    IpmiResponseDataSize += *ResponseDataSize + sizeof (UINT16);
+  }
+
+  Status = IpmiSubmitCommand (
+             IPMI_NETFN_OEM,
+             IPMI_OEM_BLOB_TRANSFER_CMD,
+             Packet->Request,
+             IpmiSendDataSize,
+             Packet->Response,
+             &IpmiResponseDataSize
+             );
+  if (EFI_ERROR (Status)) {
     return Status;
-    // Now we need to validate the CRC then send the Response body back
-  } else {
-    // Strip the OEN, we are done with it now
-    ModifiedResponseData  = ModifiedResponseData + sizeof (Oen);
-    IpmiResponseDataSize -= sizeof (Oen);
-    // Then validate the Crc
-    CopyMem (&Crc, ModifiedResponseData, sizeof (Crc));
-    ModifiedResponseData  = ModifiedResponseData + sizeof (Crc);
-    IpmiResponseDataSize -= sizeof (Crc);
-
-    if (Crc == CalculateCrc16Ccitt (ModifiedResponseData, IpmiResponseDataSize)) {
-      if ((ResponseData != NULL) && (ResponseDataSize != NULL)) {
-        CopyMem (ResponseData, ModifiedResponseData, IpmiResponseDataSize);
-        CopyMem (ResponseDataSize, &IpmiResponseDataSize, sizeof (IpmiResponseDataSize));
-      }
-
-      FreePool (IpmiResponseData);
-      return EFI_SUCCESS;
-    } else {
-      FreePool (IpmiResponseData);
-      return EFI_CRC_ERROR;
-    }
   }
+
+  return IpmiBlobTransferParseResponse (Packet->Response, IpmiResponseDataSize, ResponseData, ResponseDataSize);
 }
 
 /**
@@ -471,12 +549,6 @@ IpmiBlobTransferRead (
   OUT UINT8   *Data
   )
 {
-  EFI_STATUS  Status;
-  UINT8       *SendData;
-  UINT8       *ResponseData;
-  UINT32      SendDataSize;
-  UINT32      ResponseDataSize;
-
   if (Data == NULL) {
     ASSERT (FALSE);
     return EFI_INVALID_PARAMETER;
@@ -486,34 +558,7 @@ IpmiBlobTransferRead (
     return EFI_BAD_BUFFER_SIZE;
   }
 
-  ResponseDataSize = RequestedSize * sizeof (UINT8);
-  ResponseData     = AllocateZeroPool (ResponseDataSize);
-  if (ResponseData == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  //
-  // Format send data
-  //
-  SendDataSize = sizeof (IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA);
-  SendData     = AllocateZeroPool (SendDataSize);
-  if (SendData == NULL) {
-    FreePool (ResponseData);
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  ((IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA *)SendData)->SessionId     = SessionId;
-  ((IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA *)SendData)->Offset        = Offset;
-  ((IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA *)SendData)->RequestedSize = RequestedSize;
-
-  Status = IpmiBlobTransferSendIpmi (IpmiBlobTransferSubcommandRead, SendData, SendDataSize, (UINT8 *)ResponseData, &ResponseDataSize);
-  if (!EFI_ERROR (Status)) {
-    CopyMem (Data, ((IPMI_BLOB_TRANSFER_BLOB_READ_RESPONSE *)ResponseData)->Data, ResponseDataSize * sizeof (UINT8));
-  }
-
-  FreePool (ResponseData);
-  FreePool (SendData);
-  return Status;
+  return IpmiBlobTransferReadStream (SessionId, Offset, &RequestedSize, Data, NULL, NULL);
 }
 
 /**
@@ -536,11 +581,6 @@ IpmiBlobTransferWrite (
   IN  UINT32  WriteLength
   )
 {
-  EFI_STATUS  Status;
-  UINT8       *SendData;
-  UINT32      SendDataSize;
-  UINT32      ResponseDataSize;
-
   if ((Data == NULL) || (WriteLength == 0)) {
     return EFI_INVALID_PARAMETER;
   }
@@ -549,24 +589,7 @@ IpmiBlobTransferWrite (
     return EFI_BAD_BUFFER_SIZE;
   }
 
-  //
-  // Format send data
-  //
-  SendDataSize = sizeof (SessionId) + sizeof (Offset) + WriteLength;
-  SendData     = AllocateZeroPool (SendDataSize);
-  if (SendData == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  ((IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA *)SendData)->SessionId = SessionId;
-  ((IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA *)SendData)->Offset    = Offset;
-  CopyMem (((IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA *)SendData)->Data, Data, sizeof (UINT8) * WriteLength);
-
-  ResponseDataSize = 0;
-  Status           = IpmiBlobTransferSendIpmi (IpmiBlobTransferSubcommandWrite, SendData, SendDataSize, NULL, &ResponseDataSize);
-
-  FreePool (SendData);
-  return Status;
+  return IpmiBlobTransferWriteStream (SessionId, Offset, Data, WriteLength, NULL, NULL);
 }
 
 /**
@@ -890,6 +913,190 @@ IpmiBlobTransferWriteMeta (
   return Status;
 }
 
+/**
+  This function reads data of any size from a blob over the IPMI. The data is split
+  into BLOB_MAX_DATA_PER_PACKET sized reads, all sent from the same buffers.
+  Reading stops early if the BMC returns less data than requested, at the end of the blob.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start reading
+  @param[in, out]    DataSize        On input, the length of data to read.
+                                     On output, the length of data read.
+  @param[out]        Data            Data read from the blob
+  @param[in]         Progress        Function called after each packet. This is optional.
+  @param[in]         Context         Context passed to Progress. This is optional.
+
+  @retval EFI_SUCCESS                Successfully read from the blob.
+  @retval EFI_INVALID_PARAMETER      The read goes past the largest blob offset.
+  @retval EFI_OUT_OF_RESOURCES       Memory allocation fails.
+  @retval Other                      An error occurred. DataSize is the length of data read
+                                     before the error.
+**/
+EFI_STATUS
+EFIAPI
+IpmiBlobTransferReadStream (
+  IN     UINT16                             SessionId,
+  IN     UINT32                             Offset,
+  IN OUT UINT32                             *DataSize,
+  OUT    UINT8                              *Data,
+  IN     EDKII_IPMI_BLOB_TRANSFER_PROGRESS  Progress OPTIONAL,
+  IN     VOID                               *Context OPTIONAL
+  )
+{
+  EFI_STATUS                              Status;
+  IPMI_BLOB_TRANSFER_PACKET               *Packet;
+  IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA  *SendData;
+  UINT8                                   *ResponseData;
+  UINT32                                  ResponseDataSize;
+  UINT32                                  Total;
+  UINT32                                  Transferred;
+  UINT32                                  PacketSize;
+
+  if ((DataSize == NULL) || ((Data == NULL) && (*DataSize > 0))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Total     = *DataSize;
+  *DataSize = 0;
+
+  if ((UINT64)Offset + Total > (UINT64)MAX_UINT32 + 1) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Total == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Packet = AllocatePool (sizeof (IPMI_BLOB_TRANSFER_PACKET));
+  if (Packet == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SendData            = (IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA *)(Packet->Request + BLOB_TRANSFER_REQUEST_DATA_OFFSET);
+  SendData->SessionId = SessionId;
+
+  Status = EFI_SUCCESS;
+  for (Transferred = 0; Transferred < Total; Transferred += ResponseDataSize) {
+    PacketSize = MIN (Total - Transferred, BLOB_MAX_DATA_PER_PACKET);
+
+    SendData->Offset        = Offset + Transferred;
+    SendData->RequestedSize = PacketSize;
+
+    ResponseDataSize = PacketSize;
+    Status           = IpmiBlobTransferSendPacket (IpmiBlobTransferSubcommandRead, Packet, sizeof (*SendData), &ResponseData, &ResponseDataSize);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (ResponseDataSize > PacketSize) {
+      Status = EFI_PROTOCOL_ERROR;
+      break;
+    }
+
+    CopyMem (Data + Transferred, ResponseData, ResponseDataSize);
+
+    if (Progress != NULL) {
+      Progress (Context, Transferred + ResponseDataSize, Total);
+    }
+
+    //
+    // A short read means the end of the blob was reached
+    //
+    if (ResponseDataSize < PacketSize) {
+      Transferred += ResponseDataSize;
+      break;
+    }
+  }
+
+  *DataSize = Transferred;
+
+  FreePool (Packet);
+  return Status;
+}
+
+/**
+  This function writes data of any size to a blob over the IPMI. The data is split
+  into BLOB_MAX_DATA_PER_PACKET sized writes, all sent from the same buffers.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start writing
+  @param[in]         Data            A pointer to the data to write
+  @param[in]         WriteLength     The length to write
+  @param[in]         Progress        Function called after each packet. This is optional.
+  @param[in]         Context         Context passed to Progress. This is optional.
+
+  @retval EFI_SUCCESS                Successfully wrote to the blob.
+  @retval EFI_INVALID_PARAMETER      The write goes past the largest blob offset.
+  @retval EFI_OUT_OF_RESOURCES       Memory allocation fails.
+  @retval Other                      An error occurred
+**/
+EFI_STATUS
+EFIAPI
+IpmiBlobTransferWriteStream (
+  IN  UINT16                             SessionId,
+  IN  UINT32                             Offset,
+  IN  UINT8                              *Data,
+  IN  UINT32                             WriteLength,
+  IN  EDKII_IPMI_BLOB_TRANSFER_PROGRESS  Progress OPTIONAL,
+  IN  VOID                               *Context OPTIONAL
+  )
+{
+  EFI_STATUS                               Status;
+  IPMI_BLOB_TRANSFER_PACKET                *Packet;
+  IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA  *SendData;
+  UINT8                                    *ResponseData;
+  UINT32                                   ResponseDataSize;
+  UINT32                                   Transferred;
+  UINT32                                   PacketSize;
+
+  if ((Data == NULL) && (WriteLength > 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((UINT64)Offset + WriteLength > (UINT64)MAX_UINT32 + 1) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (WriteLength == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Packet = AllocatePool (sizeof (IPMI_BLOB_TRANSFER_PACKET));
+  if (Packet == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SendData            = (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA *)(Packet->Request + BLOB_TRANSFER_REQUEST_DATA_OFFSET);
+  SendData->SessionId = SessionId;
+
+  Status = EFI_SUCCESS;
+  for (Transferred = 0; Transferred < WriteLength; Transferred += PacketSize) {
+    PacketSize = MIN (WriteLength - Transferred, BLOB_MAX_DATA_PER_PACKET);
+
+    SendData->Offset = Offset + Transferred;
+    CopyMem (SendData->Data, Data + Transferred, PacketSize);
+
+    ResponseDataSize = 0;
+    Status           = IpmiBlobTransferSendPacket (
+                         IpmiBlobTransferSubcommandWrite,
+                         Packet,
+                         OFFSET_OF (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA, Data) + PacketSize,
+                         &ResponseData,
+                         &ResponseDataSize
+                         );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (Progress != NULL) {
+      Progress (Context, Transferred + PacketSize, WriteLength);
+    }
+  }
+
+  FreePool (Packet);
+  return Status;
+}
+
 /**
   This is the declaration of an EFI image entry point. This entry point is
   the same for UEFI Applications, UEFI OS Loaders, and UEFI Drivers including
@@ -0,0 +1,246 @@
+/** @file
+  Host-based microbenchmark of the IPMI Blob Transfer driver's CRC-16-CCITT.
+
+  First checks that CalculateCrc16Ccitt returns the same CRCs as the bitwise
+  implementation the protocol is specified with, for many lengths, and then measures
+  the throughput of both on the send data and responses of read and write packets.
+
+  Usage: IpmiBlobTransferCrcBenchmarkHost [-n Iterations]
+
+  Exits with 1 if the implementations don't match.
+
+  Copyright (c) 2026, agent. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <Protocol/IpmiBlobTransfer.h>
+#include "../InternalIpmiBlobTransfer.h"
+
+#define CRC_BENCH_BUFFER_SIZE         SIZE_4KB
+#define CRC_BENCH_DEFAULT_ITERATIONS  1000000
+#define CRC_BENCH_MAX_CHECKED_LENGTH  1024
+
+typedef UINT16 (*CRC_BENCH_FUNCTION)(
+  IN UINT8  *Data,
+  IN UINTN  DataSize
+  );
+
+//
+// A read request, a full write request, a full read response and a larger buffer
+//
+STATIC CONST UINTN  mCrcBenchSizes[] = {
+  sizeof (IPMI_BLOB_TRANSFER_BLOB_READ_SEND_DATA),
+  OFFSET_OF (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA, Data) + BLOB_MAX_DATA_PER_PACKET,
+  BLOB_MAX_DATA_PER_PACKET,
+  CRC_BENCH_BUFFER_SIZE
+};
+
+/**
+  Calculate CRC-16-CCITT with poly of 0x1021, one bit at a time.
+
+  @param[in]  Data              The target data.
+  @param[in]  DataSize          The target data size.
+
+  @return UINT16     The CRC16 value.
+
+**/
+STATIC
+UINT16
+CalculateCrc16CcittBitwise (
+  IN UINT8  *Data,
+  IN UINTN  DataSize
+  )
+{
+  UINTN    Index;
+  UINTN    BitIndex;
+  UINT16   Crc;
+  UINT16   Poly;
+  BOOLEAN  XorFlag;
+
+  Crc  = 0xFFFF;
+  Poly = 0x1021;
+
+  for (Index = 0; Index < (DataSize + 2); ++Index) {
+    for (BitIndex = 0; BitIndex < 8; ++BitIndex) {
+      XorFlag = (Crc & 0x8000) ? TRUE : FALSE;
+      Crc   <<= 1;
+      if ((Index < DataSize) && (Data[Index] & (1 << (7 - BitIndex)))) {
+        Crc++;
+      }
+
+      if (XorFlag == TRUE) {
+        Crc ^= Poly;
+      }
+    }
+  }
+
+  return Crc;
+}
+
+/**
+  Gets the current time, in nanoseconds.
+
+  @return The current time.
+**/
+STATIC
+UINT64
+CrcBenchNow (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  timespec_get (&Time, TIME_UTC);
+  return (UINT64)Time.tv_sec * 1000000000ULL + (UINT64)Time.tv_nsec;
+}
+
+/**
+  Checks that CalculateCrc16Ccitt matches the bitwise implementation.
+
+  @param[in]  Buffer    Pointer to a buffer of CRC_BENCH_BUFFER_SIZE random bytes.
+
+  @retval TRUE    The implementations match.
+  @retval FALSE   The implementations don't match.
+**/
+STATIC
+BOOLEAN
+CrcBenchCheck (
+  IN UINT8  *Buffer
+  )
+{
+  UINTN   Offset;
+  UINTN   Length;
+  UINT16  Expected;
+  UINT16  Actual;
+
+  //
+  // Known answer: the CRC of "123456789" is 0xE5CC
+  //
+  Actual = CalculateCrc16Ccitt ((UINT8 *)"123456789", 9);
+  if (Actual != 0xE5CC) {
+    fprintf (stderr, "CRC of \"123456789\" is %04x, expected e5cc\n", Actual);
+    return FALSE;
+  }
+
+  for (Offset = 0; Offset < 8; Offset++) {
+    for (Length = 0; Length <= CRC_BENCH_MAX_CHECKED_LENGTH; Length++) {
+      Expected = CalculateCrc16CcittBitwise (Buffer + Offset, Length);
+      Actual   = CalculateCrc16Ccitt (Buffer + Offset, Length);
+      if (Actual != Expected) {
+        fprintf (
+          stderr,
+          "CRC mismatch: offset %u, length %u: %04x, expected %04x\n",
+          (unsigned)Offset,
+          (unsigned)Length,
+          Actual,
+          Expected
+          );
+        return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Measures the throughput of an implementation.
+
+  @param[in]  Function      Implementation to measure.
+  @param[in]  Buffer        Pointer to a buffer of CRC_BENCH_BUFFER_SIZE bytes.
+  @param[in]  Size          Size of each checksummed buffer, in bytes.
+  @param[in]  Iterations    Number of buffers to checksum.
+
+  @return The time per buffer, in nanoseconds.
+**/
+STATIC
+double
+CrcBenchRun (
+  IN CRC_BENCH_FUNCTION  Function,
+  IN UINT8               *Buffer,
+  IN UINTN               Size,
+  IN UINT64              Iterations
+  )
+{
+  UINT64           Index;
+  UINT64           Start;
+  UINT64           Nanoseconds;
+  volatile UINT16  Sink;
+  UINT16           Crc;
+
+  Crc   = 0;
+  Start = CrcBenchNow ();
+
+  for (Index = 0; Index < Iterations; Index++) {
+    //
+    // Feed each CRC into the next buffer so the calls can't be optimised away or overlapped
+    //
+    Buffer[0] ^= (UINT8)Crc;
+    Crc        = Function (Buffer, Size);
+  }
+
+  Nanoseconds = CrcBenchNow () - Start;
+  Sink        = Crc;
+  (VOID)Sink;
+
+  return (double)Nanoseconds / (double)Iterations;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  UINT8   *Buffer;
+  UINT64  Iterations;
+  UINT64  SizeIterations;
+  UINTN   Index;
+  double  Bitwise;
+  double  Table;
+
+  Iterations = CRC_BENCH_DEFAULT_ITERATIONS;
+
+  if ((argc == 3) && (AsciiStrCmp (argv[1], "-n") == 0) && (atoi (argv[2]) > 0)) {
+    Iterations = (UINT64)atoi (argv[2]);
+  } else if (argc != 1) {
+    fprintf (stderr, "Usage: %s [-n Iterations]\n", argv[0]);
+    return 2;
+  }
+
+  Buffer = AllocatePool (CRC_BENCH_BUFFER_SIZE + 8);
+  if (Buffer == NULL) {
+    return 2;
+  }
+
+  srand (0);
+
+  for (Index = 0; Index < CRC_BENCH_BUFFER_SIZE + 8; Index++) {
+    Buffer[Index] = (UINT8)rand ();
+  }
+
+  if (!CrcBenchCheck (Buffer)) {
+    FreePool (Buffer);
+    return 1;
+  }
+
+  printf ("%8s %14s %14s %8s\n", "size", "bitwise ns", "table ns", "speedup");
+
+  for (Index = 0; Index < ARRAY_SIZE (mCrcBenchSizes); Index++) {
+    //
+    // Checksum roughly the same number of bytes for every size
+    //
+    SizeIterations = MAX (Iterations * BLOB_MAX_DATA_PER_PACKET / mCrcBenchSizes[Index] / 10, 1);
+
+    Bitwise = CrcBenchRun (CalculateCrc16CcittBitwise, Buffer, mCrcBenchSizes[Index], SizeIterations);
+    Table   = CrcBenchRun (CalculateCrc16Ccitt, Buffer, mCrcBenchSizes[Index], SizeIterations);
+    printf ("%8u %14.1f %14.1f %7.1fx\n", (unsigned)mCrcBenchSizes[Index], Bitwise, Table, Bitwise / Table);
+  }
+
+  FreePool (Buffer);
+  return 0;
+}
@@ -118,6 +118,90 @@ BadCrc (
   return UNIT_TEST_PASSED;
 }
 
+/**
+  Calculate CRC-16-CCITT with poly of 0x1021, one bit at a time, as the protocol
+  specifies it.
+
+  @param[in]  Data              The target data.
+  @param[in]  DataSize          The target data size.
+
+  @return UINT16     The CRC16 value.
+
+**/
+UINT16
+CalculateCrc16CcittBitwise (
+  IN UINT8  *Data,
+  IN UINTN  DataSize
+  )
+{
+  UINTN    Index;
+  UINTN    BitIndex;
+  UINT16   Crc;
+  BOOLEAN  XorFlag;
+
+  Crc = 0xFFFF;
+
+  for (Index = 0; Index < (DataSize + 2); ++Index) {
+    for (BitIndex = 0; BitIndex < 8; ++BitIndex) {
+      XorFlag = (Crc & 0x8000) ? TRUE : FALSE;
+      Crc   <<= 1;
+      if ((Index < DataSize) && (Data[Index] & (1 << (7 - BitIndex)))) {
+        Crc++;
+      }
+
+      if (XorFlag == TRUE) {
+        Crc ^= 0x1021;
+      }
+    }
+  }
+
+  return Crc;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+
+UNIT_TEST_STATUS
+EFIAPI
+CrcMatchesBitwise (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   Data[300];
+  UINTN   Index;
+  UINTN   DataSize;
+  UINT32  Seed;
+
+  Seed = 1;
+  for (Index = 0; Index < sizeof (Data); Index++) {
+    Seed        = Seed * 1103515245 + 12345;
+    Data[Index] = (UINT8)(Seed >> 16);
+  }
+
+  for (DataSize = 0; DataSize <= sizeof (Data); DataSize++) {
+    UT_ASSERT_EQUAL (CalculateCrc16Ccitt (Data, DataSize), CalculateCrc16CcittBitwise (Data, DataSize));
+  }
+
+  //
+  // Every start offset within a slice
+  //
+  for (Index = 1; Index < 8; Index++) {
+    UT_ASSERT_EQUAL (CalculateCrc16Ccitt (Data + Index, 100), CalculateCrc16CcittBitwise (Data + Index, 100));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
   @param[in]  Context    [Optional] An optional parameter that enables:
                          1) test-case reuse with varied parameters and
@@ -1008,6 +1092,292 @@ WriteMetaValidResponse (
   return UNIT_TEST_PASSED;
 }
 
+#define STREAM_TEST_SIZE  (BLOB_MAX_DATA_PER_PACKET + 36)
+
+UINT32  StreamProgressCalls;
+UINT32  StreamProgressTransferred;
+
+/**
+  Progress callback of the streaming tests, which records its last call.
+
+  @param[in]  Context      Unused.
+  @param[in]  Transferred  The number of bytes transferred so far.
+  @param[in]  Total        The total number of bytes to transfer.
+**/
+VOID
+EFIAPI
+StreamProgress (
+  IN VOID    *Context OPTIONAL,
+  IN UINT32  Transferred,
+  IN UINT32  Total
+  )
+{
+  StreamProgressCalls++;
+  StreamProgressTransferred = Transferred;
+}
+
+/**
+  Builds a valid read response holding the given data.
+
+  @param[in]  Data      The data of the response.
+  @param[in]  DataSize  The size of the data.
+
+  @return  The response, of NO_DATA_RESPONSE_SIZE + sizeof (UINT16) + DataSize bytes.
+**/
+UINT8 *
+BuildReadResponse (
+  IN UINT8   *Data,
+  IN UINT32  DataSize
+  )
+{
+  UINT8   *Response;
+  UINT16  Crc;
+
+  Response = AllocateZeroPool (NO_DATA_RESPONSE_SIZE + sizeof (Crc) + DataSize);
+  Crc      = CalculateCrc16Ccitt (Data, DataSize);
+  CopyMem (Response, &ValidNoDataResponse, NO_DATA_RESPONSE_SIZE);
+  CopyMem (Response + NO_DATA_RESPONSE_SIZE, &Crc, sizeof (Crc));
+  CopyMem (Response + NO_DATA_RESPONSE_SIZE + sizeof (Crc), Data, DataSize);
+  return Response;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadStreamValidResponse (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       ExpectedData[STREAM_TEST_SIZE];
+  UINT8       Data[STREAM_TEST_SIZE];
+  UINT32      DataSize;
+  UINT32      Index;
+  UINT8       *MockResponseResults;
+  UINT8       *MockResponseResults2;
+
+  for (Index = 0; Index < STREAM_TEST_SIZE; Index++) {
+    ExpectedData[Index] = (UINT8)Index;
+  }
+
+  //
+  // The read is split in two packets, a full one and the rest.
+  // Responses are popped in reverse order, so push the last one first.
+  //
+  MockResponseResults2 = BuildReadResponse (ExpectedData + BLOB_MAX_DATA_PER_PACKET, STREAM_TEST_SIZE - BLOB_MAX_DATA_PER_PACKET);
+  Status               = MockIpmiSubmitCommand (MockResponseResults2, NO_DATA_RESPONSE_SIZE + sizeof (UINT16) + STREAM_TEST_SIZE - BLOB_MAX_DATA_PER_PACKET, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  MockResponseResults = BuildReadResponse (ExpectedData, BLOB_MAX_DATA_PER_PACKET);
+  Status              = MockIpmiSubmitCommand (MockResponseResults, NO_DATA_RESPONSE_SIZE + sizeof (UINT16) + BLOB_MAX_DATA_PER_PACKET, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  StreamProgressCalls = 0;
+  DataSize            = STREAM_TEST_SIZE;
+  ZeroMem (Data, sizeof (Data));
+
+  Status = IpmiBlobTransferReadStream (0, 0, &DataSize, Data, StreamProgress, NULL);
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (DataSize, STREAM_TEST_SIZE);
+  UT_ASSERT_MEM_EQUAL (Data, ExpectedData, STREAM_TEST_SIZE);
+  UT_ASSERT_EQUAL (StreamProgressCalls, 2);
+  UT_ASSERT_EQUAL (StreamProgressTransferred, STREAM_TEST_SIZE);
+  FreePool (MockResponseResults);
+  FreePool (MockResponseResults2);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadStreamEndOfBlob (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       ExpectedData[STREAM_TEST_SIZE];
+  UINT8       Data[STREAM_TEST_SIZE];
+  UINT32      DataSize;
+  UINT32      Index;
+  UINT8       *MockResponseResults;
+
+  for (Index = 0; Index < STREAM_TEST_SIZE; Index++) {
+    ExpectedData[Index] = (UINT8)Index;
+  }
+
+  //
+  // The blob only has 10 bytes left, so the first packet is short and ends the read
+  //
+  MockResponseResults = BuildReadResponse (ExpectedData, 10);
+  Status              = MockIpmiSubmitCommand (MockResponseResults, NO_DATA_RESPONSE_SIZE + sizeof (UINT16) + 10, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  DataSize = STREAM_TEST_SIZE;
+
+  Status = IpmiBlobTransferReadStream (0, 0, &DataSize, Data, NULL, NULL);
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (DataSize, 10);
+  UT_ASSERT_MEM_EQUAL (Data, ExpectedData, 10);
+  FreePool (MockResponseResults);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadStreamInvalidOffset (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       Data[STREAM_TEST_SIZE];
+  UINT32      DataSize;
+
+  DataSize = STREAM_TEST_SIZE;
+
+  Status = IpmiBlobTransferReadStream (0, MAX_UINT32, &DataSize, Data, NULL, NULL);
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (DataSize, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+WriteStreamValidResponse (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[STREAM_TEST_SIZE];
+  VOID        *MockResponseResults  = NULL;
+  VOID        *MockResponseResults2 = NULL;
+
+  ZeroMem (SendData, sizeof (SendData));
+
+  MockResponseResults = (UINT8 *)AllocateZeroPool (VALID_NODATA_RESPONSE_SIZE);
+  CopyMem (MockResponseResults, &ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE);
+  Status = MockIpmiSubmitCommand ((UINT8 *)MockResponseResults, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  MockResponseResults2 = (UINT8 *)AllocateZeroPool (VALID_NODATA_RESPONSE_SIZE);
+  CopyMem (MockResponseResults2, &ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE);
+  Status = MockIpmiSubmitCommand ((UINT8 *)MockResponseResults2, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  StreamProgressCalls = 0;
+
+  Status = IpmiBlobTransferWriteStream (0, 0, SendData, STREAM_TEST_SIZE, StreamProgress, NULL);
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (StreamProgressCalls, 2);
+  UT_ASSERT_EQUAL (StreamProgressTransferred, STREAM_TEST_SIZE);
+  FreePool (MockResponseResults);
+  FreePool (MockResponseResults2);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+WriteStreamBadCompletion (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[STREAM_TEST_SIZE];
+  VOID        *MockResponseResults = NULL;
+
+  ZeroMem (SendData, sizeof (SendData));
+
+  //
+  // The first packet fails, so the second one must not be sent
+  //
+  MockResponseResults = (UINT8 *)AllocateZeroPool (INVALID_COMPLETION_SIZE);
+  CopyMem (MockResponseResults, &InvalidCompletion, INVALID_COMPLETION_SIZE);
+  Status = MockIpmiSubmitCommand ((UINT8 *)MockResponseResults, INVALID_COMPLETION_SIZE, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  StreamProgressCalls = 0;
+
+  Status = IpmiBlobTransferWriteStream (0, 0, SendData, STREAM_TEST_SIZE, StreamProgress, NULL);
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_PROTOCOL_ERROR);
+  UT_ASSERT_EQUAL (StreamProgressCalls, 0);
+  FreePool (MockResponseResults);
+  return UNIT_TEST_PASSED;
+}
+
 /**
   Initialize the unit test framework, suite, and unit tests for the
   sample unit tests and run the unit tests.
@@ -1048,6 +1418,7 @@ SetupAndRunUnitTests (
   // CalculateCrc16Ccitt
   Status = AddTestCase (IpmiBlobTransfer, "Test CRC Calculation", "GoodCrc", GoodCrc, NULL, NULL, NULL);
   Status = AddTestCase (IpmiBlobTransfer, "Test Bad CRC Calculation", "BadCrc", BadCrc, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "Test CRC matches the bitwise calculation", "CrcMatchesBitwise", CrcMatchesBitwise, NULL, NULL, NULL);
   // IpmiBlobTransferSendIpmi
   Status = AddTestCase (IpmiBlobTransfer, "Send IPMI returns bad completion", "SendIpmiBadCompletion", SendIpmiBadCompletion, NULL, NULL, NULL);
   Status = AddTestCase (IpmiBlobTransfer, "Send IPMI returns successfully with no data", "SendIpmiNoDataResponse", SendIpmiNoDataResponse, NULL, NULL, NULL);
@@ -1080,6 +1451,13 @@ SetupAndRunUnitTests (
   Status = AddTestCase (IpmiBlobTransfer, "Session Stat call with invalid buffer", "SessionStatInvalidBuffer", SessionStatInvalidBuffer, NULL, NULL, NULL);
   // IpmiBlobTransferWriteMeta
   Status = AddTestCase (IpmiBlobTransfer, "WriteMeta call with valid data", "WriteMetaValidResponse", WriteMetaValidResponse, NULL, NULL, NULL);
+  // IpmiBlobTransferReadStream
+  Status = AddTestCase (IpmiBlobTransfer, "ReadStream call with valid data", "ReadStreamValidResponse", ReadStreamValidResponse, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "ReadStream call reaching the end of the blob", "ReadStreamEndOfBlob", ReadStreamEndOfBlob, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "ReadStream call with invalid offset", "ReadStreamInvalidOffset", ReadStreamInvalidOffset, NULL, NULL, NULL);
+  // IpmiBlobTransferWriteStream
+  Status = AddTestCase (IpmiBlobTransfer, "WriteStream call with valid data", "WriteStreamValidResponse", WriteStreamValidResponse, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "WriteStream call returns bad completion", "WriteStreamBadCompletion", WriteStreamBadCompletion, NULL, NULL, NULL);
 
   // Execute the tests.
   Status = RunAllTestSuites (Framework);
@@ -8,14 +8,95 @@
 
 **/
 #include <Uefi.h>
+#include <IndustryStandard/Ipmi.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/ManageabilityTransportHelperLib.h>
 #include <Library/ManageabilityTransportIpmiLib.h>
 #include <Library/ManageabilityTransportLib.h>
 
 #include "IpmiProtocolCommon.h"
 
+#define IPMI_RESPONSE_CACHE_ENTRY_SIGNATURE  SIGNATURE_32 ('I', 'P', 'R', 'C')
+
+///
+/// A cached response. Data holds the request data followed by the response data.
+/// The transport interfaces truncate the responses to the size of the buffer
+/// without telling, so a response that filled the buffer may be truncated.
+///
+typedef struct {
+  UINT32        Signature;
+  LIST_ENTRY    Link;
+  UINT8         NetFunction;
+  UINT8         Command;
+  UINT32        RequestDataSize;
+  UINT32        ResponseDataSize;
+  BOOLEAN       MayBeTruncated;
+  UINT32        Hits;
+  UINT8         Data[];
+} IPMI_RESPONSE_CACHE_ENTRY;
+
+#define IPMI_RESPONSE_CACHE_ENTRY_FROM_LINK(a)  CR (a, IPMI_RESPONSE_CACHE_ENTRY, Link, IPMI_RESPONSE_CACHE_ENTRY_SIGNATURE)
+
+///
+/// The parts of the BMC state the cached responses come from.
+///
+#define IPMI_CACHE_AREA_NONE     0x00
+#define IPMI_CACHE_AREA_DEVICE   BIT0
+#define IPMI_CACHE_AREA_CHANNEL  BIT1
+#define IPMI_CACHE_AREA_FRU      BIT2
+#define IPMI_CACHE_AREA_SDR      BIT3
+#define IPMI_CACHE_AREA_SEL      BIT4
+#define IPMI_CACHE_AREA_ALL      0xFF
+
+typedef struct {
+  UINT8    NetFunction;
+  UINT8    Command;
+  UINT8    Areas;
+} IPMI_CACHE_COMMAND;
+
+///
+/// The read-only commands whose responses don't change while booting, and the
+/// area each response comes from.
+///
+STATIC CONST IPMI_CACHE_COMMAND  mIpmiCacheableCommands[] = {
+  { IPMI_NETFN_APP,     IPMI_APP_GET_DEVICE_ID,                  IPMI_CACHE_AREA_DEVICE  },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_SELFTEST_RESULTS,           IPMI_CACHE_AREA_DEVICE  },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_SYSTEM_GUID,                IPMI_CACHE_AREA_DEVICE  },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_CHANNEL_INFO,               IPMI_CACHE_AREA_CHANNEL },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_GET_FRU_INVENTORY_AREAINFO, IPMI_CACHE_AREA_FRU     },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_READ_FRU_DATA,              IPMI_CACHE_AREA_FRU     },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_GET_SDR_REPOSITORY_INFO,    IPMI_CACHE_AREA_SDR     },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_GET_SEL_INFO,               IPMI_CACHE_AREA_SEL     }
+};
+
+///
+/// The other commands of the cached NetFunctions, and the areas they may change.
+/// A command that isn't listed here may change any area of its NetFunction.
+///
+STATIC CONST IPMI_CACHE_COMMAND  mIpmiCacheInvalidatingCommands[] = {
+  { IPMI_NETFN_APP,     IPMI_APP_SET_WATCHDOG_TIMER,        IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_WATCHDOG_TIMER,        IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_RESET_WATCHDOG_TIMER,      IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_SET_BMC_GLOBAL_ENABLES,    IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_BMC_GLOBAL_ENABLES,    IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_CLEAR_MESSAGE_FLAGS,       IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_MESSAGE_FLAGS,         IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_APP,     IPMI_APP_GET_MESSAGE,               IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_WRITE_FRU_DATA,        IPMI_CACHE_AREA_FRU  },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_GET_SDR,               IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_RESERVE_SEL,           IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_GET_SEL_ENTRY,         IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_ADD_SEL_ENTRY,         IPMI_CACHE_AREA_SEL  },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_PARTIAL_ADD_SEL_ENTRY, IPMI_CACHE_AREA_SEL  },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_DELETE_SEL_ENTRY,      IPMI_CACHE_AREA_SEL  },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_CLEAR_SEL,             IPMI_CACHE_AREA_SEL  },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_GET_SEL_TIME,          IPMI_CACHE_AREA_NONE },
+  { IPMI_NETFN_STORAGE, IPMI_STORAGE_SET_SEL_TIME,          IPMI_CACHE_AREA_SEL  }
+};
+
 /**
   This functions setup the IPMI transport hardware information according
   to the specification of transport token acquired from transport library.
@@ -297,3 +378,398 @@ CommonIpmiSubmitCommand (
 
   return Status;
 }
+
+/**
+  This function finds a command in a table of IPMI_CACHE_COMMAND.
+
+  @param[in]         Table             The table.
+  @param[in]         Count             Number of commands in the table.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+
+  @retval            The command in the table, or NULL if it isn't there.
+**/
+STATIC
+CONST IPMI_CACHE_COMMAND *
+IpmiFindCacheCommand (
+  IN CONST IPMI_CACHE_COMMAND  *Table,
+  IN UINTN                     Count,
+  IN UINT8                     NetFunction,
+  IN UINT8                     Command
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    if ((Table[Index].NetFunction == NetFunction) &&
+        (Table[Index].Command == Command))
+    {
+      return &Table[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  This function checks whether the response of a command can be cached.
+
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+
+  @retval TRUE       The command is in mIpmiCacheableCommands.
+  @retval FALSE      The command may change the state of the BMC.
+**/
+STATIC
+BOOLEAN
+IpmiIsCacheableCommand (
+  IN UINT8  NetFunction,
+  IN UINT8  Command
+  )
+{
+  return (BOOLEAN)(IpmiFindCacheCommand (mIpmiCacheableCommands, ARRAY_SIZE (mIpmiCacheableCommands), NetFunction, Command) != NULL);
+}
+
+/**
+  This function removes a response from an IPMI response cache.
+
+  @param[in, out]    Cache             The response cache.
+  @param[in]         Entry             The cached response to remove.
+**/
+STATIC
+VOID
+IpmiResponseCacheRemove (
+  IN OUT IPMI_RESPONSE_CACHE        *Cache,
+  IN     IPMI_RESPONSE_CACHE_ENTRY  *Entry
+  )
+{
+  RemoveEntryList (&Entry->Link);
+  Cache->EntryCount--;
+  FreePool (Entry);
+}
+
+/**
+  This function initializes an IPMI response cache.
+
+  @param[out]        Cache             The response cache.
+**/
+VOID
+IpmiResponseCacheInit (
+  OUT IPMI_RESPONSE_CACHE  *Cache
+  )
+{
+  ZeroMem (Cache, sizeof (IPMI_RESPONSE_CACHE));
+  InitializeListHead (&Cache->Entries);
+}
+
+/**
+  This function frees the responses of an IPMI response cache.
+
+  @param[in, out]    Cache             The response cache.
+**/
+VOID
+IpmiResponseCacheFlush (
+  IN OUT IPMI_RESPONSE_CACHE  *Cache
+  )
+{
+  while (!IsListEmpty (&Cache->Entries)) {
+    IpmiResponseCacheRemove (Cache, IPMI_RESPONSE_CACHE_ENTRY_FROM_LINK (GetFirstNode (&Cache->Entries)));
+  }
+}
+
+/**
+  This function prints the statistics of an IPMI response cache.
+
+  @param[in]         Cache             The response cache.
+**/
+VOID
+IpmiResponseCachePrintStatistics (
+  IN IPMI_RESPONSE_CACHE  *Cache
+  )
+{
+  LIST_ENTRY                 *Link;
+  IPMI_RESPONSE_CACHE_ENTRY  *Entry;
+
+  DEBUG ((
+    DEBUG_MANAGEABILITY_INFO,
+    "IPMI response cache: %d hits, %d misses, %d invalidations, %d responses cached.\n",
+    Cache->Hits,
+    Cache->Misses,
+    Cache->Invalidations,
+    Cache->EntryCount
+    ));
+  for (Link = GetFirstNode (&Cache->Entries); !IsNull (&Cache->Entries, Link); Link = GetNextNode (&Cache->Entries, Link)) {
+    Entry = IPMI_RESPONSE_CACHE_ENTRY_FROM_LINK (Link);
+    DEBUG ((
+      DEBUG_MANAGEABILITY_INFO,
+      "  NetFn 0x%02x Cmd 0x%02x, %d request bytes: %d hits\n",
+      Entry->NetFunction,
+      Entry->Command,
+      Entry->RequestDataSize,
+      Entry->Hits
+      ));
+  }
+}
+
+/**
+  This function removes from an IPMI response cache the cached responses a
+  command may change.
+
+  @param[in, out]    Cache             The response cache.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+**/
+STATIC
+VOID
+IpmiResponseCacheInvalidate (
+  IN OUT IPMI_RESPONSE_CACHE  *Cache,
+  IN     UINT8                NetFunction,
+  IN     UINT8                Command
+  )
+{
+  LIST_ENTRY                 *Link;
+  LIST_ENTRY                 *NextLink;
+  IPMI_RESPONSE_CACHE_ENTRY  *Entry;
+  CONST IPMI_CACHE_COMMAND   *CacheCommand;
+  UINT8                      Areas;
+
+  CacheCommand = IpmiFindCacheCommand (mIpmiCacheInvalidatingCommands, ARRAY_SIZE (mIpmiCacheInvalidatingCommands), NetFunction, Command);
+  Areas        = (CacheCommand != NULL) ? CacheCommand->Areas : IPMI_CACHE_AREA_ALL;
+  if (Areas == IPMI_CACHE_AREA_NONE) {
+    return;
+  }
+
+  for (Link = GetFirstNode (&Cache->Entries); !IsNull (&Cache->Entries, Link); Link = NextLink) {
+    NextLink     = GetNextNode (&Cache->Entries, Link);
+    Entry        = IPMI_RESPONSE_CACHE_ENTRY_FROM_LINK (Link);
+    CacheCommand = IpmiFindCacheCommand (mIpmiCacheableCommands, ARRAY_SIZE (mIpmiCacheableCommands), Entry->NetFunction, Entry->Command);
+    ASSERT (CacheCommand != NULL);
+    if ((Entry->NetFunction == NetFunction) && ((CacheCommand->Areas & Areas) != 0)) {
+      IpmiResponseCacheRemove (Cache, Entry);
+      Cache->Invalidations++;
+    }
+  }
+}
+
+/**
+  This function finds the cached response of a command in an IPMI response cache.
+
+  @param[in]         Cache             The response cache.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+  @param[in]         RequestData       Command Request Data.
+  @param[in]         RequestDataSize   Size of Command Request Data.
+
+  @retval            The cached response, or NULL if the command isn't cached.
+**/
+STATIC
+IPMI_RESPONSE_CACHE_ENTRY *
+IpmiResponseCacheFind (
+  IN     IPMI_RESPONSE_CACHE  *Cache,
+  IN     UINT8                NetFunction,
+  IN     UINT8                Command,
+  IN     UINT8                *RequestData,
+  IN     UINT32               RequestDataSize
+  )
+{
+  LIST_ENTRY                 *Link;
+  IPMI_RESPONSE_CACHE_ENTRY  *Entry;
+
+  for (Link = GetFirstNode (&Cache->Entries); !IsNull (&Cache->Entries, Link); Link = GetNextNode (&Cache->Entries, Link)) {
+    Entry = IPMI_RESPONSE_CACHE_ENTRY_FROM_LINK (Link);
+    if ((Entry->NetFunction == NetFunction) &&
+        (Entry->Command == Command) &&
+        (Entry->RequestDataSize == RequestDataSize) &&
+        (CompareMem (Entry->Data, RequestData, RequestDataSize) == 0))
+    {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  This function looks up the response of a cacheable command in an IPMI response cache.
+
+  @param[in, out]    Cache             The response cache.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+  @param[in]         RequestData       Command Request Data.
+  @param[in]         RequestDataSize   Size of Command Request Data.
+  @param[out]        ResponseData      Command Response Data.
+  @param[in, out]    ResponseDataSize  Size of Command Response Data.
+
+  @retval EFI_SUCCESS            The cached response is returned. Like the transport
+                                 interfaces do, a response that doesn't fit in
+                                 ResponseData is truncated to its size.
+  @retval EFI_NOT_FOUND          The command has to be sent to the BMC: it isn't
+                                 cached, or the cached response may be truncated
+                                 and ResponseData is larger.
+**/
+STATIC
+EFI_STATUS
+IpmiResponseCacheLookup (
+  IN OUT IPMI_RESPONSE_CACHE  *Cache,
+  IN     UINT8                NetFunction,
+  IN     UINT8                Command,
+  IN     UINT8                *RequestData,
+  IN     UINT32               RequestDataSize,
+  OUT    UINT8                *ResponseData,
+  IN OUT UINT32               *ResponseDataSize
+  )
+{
+  IPMI_RESPONSE_CACHE_ENTRY  *Entry;
+
+  Entry = IpmiResponseCacheFind (Cache, NetFunction, Command, RequestData, RequestDataSize);
+  if ((Entry == NULL) || (Entry->MayBeTruncated && (Entry->ResponseDataSize < *ResponseDataSize))) {
+    Cache->Misses++;
+    return EFI_NOT_FOUND;
+  }
+
+  Entry->Hits++;
+  Cache->Hits++;
+  *ResponseDataSize = MIN (Entry->ResponseDataSize, *ResponseDataSize);
+  CopyMem (ResponseData, Entry->Data + RequestDataSize, *ResponseDataSize);
+  DEBUG ((
+    DEBUG_MANAGEABILITY_INFO,
+    "%a: NetFn 0x%02x Cmd 0x%02x answered from cache (%d hits).\n",
+    __func__,
+    NetFunction,
+    Command,
+    Cache->Hits
+    ));
+  return EFI_SUCCESS;
+}
+
+/**
+  This function adds the successful response of a cacheable command to an
+  IPMI response cache, replacing the one already cached.
+
+  @param[in, out]    Cache             The response cache.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+  @param[in]         RequestData       Command Request Data.
+  @param[in]         RequestDataSize   Size of Command Request Data.
+  @param[in]         ResponseData      Command Response Data.
+  @param[in]         ResponseDataSize  Size of Command Response Data.
+  @param[in]         BufferSize        Size of the buffer the response was received in.
+**/
+STATIC
+VOID
+IpmiResponseCacheAdd (
+  IN OUT IPMI_RESPONSE_CACHE  *Cache,
+  IN     UINT8                NetFunction,
+  IN     UINT8                Command,
+  IN     UINT8                *RequestData,
+  IN     UINT32               RequestDataSize,
+  IN     UINT8                *ResponseData,
+  IN     UINT32               ResponseDataSize,
+  IN     UINT32               BufferSize
+  )
+{
+  IPMI_RESPONSE_CACHE_ENTRY  *Entry;
+
+  if ((ResponseDataSize == 0) || (ResponseData[0] != IPMI_COMP_CODE_NORMAL)) {
+    return;
+  }
+
+  Entry = IpmiResponseCacheFind (Cache, NetFunction, Command, RequestData, RequestDataSize);
+  if (Entry != NULL) {
+    IpmiResponseCacheRemove (Cache, Entry);
+  }
+
+  Entry = AllocatePool (sizeof (IPMI_RESPONSE_CACHE_ENTRY) + RequestDataSize + ResponseDataSize);
+  if (Entry == NULL) {
+    return;
+  }
+
+  Entry->Signature        = IPMI_RESPONSE_CACHE_ENTRY_SIGNATURE;
+  Entry->NetFunction      = NetFunction;
+  Entry->Command          = Command;
+  Entry->RequestDataSize  = RequestDataSize;
+  Entry->ResponseDataSize = ResponseDataSize;
+  Entry->MayBeTruncated   = (BOOLEAN)(ResponseDataSize >= BufferSize);
+  Entry->Hits             = 0;
+  CopyMem (Entry->Data, RequestData, RequestDataSize);
+  CopyMem (Entry->Data + RequestDataSize, ResponseData, ResponseDataSize);
+
+  if (Cache->EntryCount == IPMI_RESPONSE_CACHE_MAX_ENTRIES) {
+    IpmiResponseCacheRemove (Cache, IPMI_RESPONSE_CACHE_ENTRY_FROM_LINK (GetFirstNode (&Cache->Entries)));
+  }
+
+  InsertTailList (&Cache->Entries, &Entry->Link);
+  Cache->EntryCount++;
+}
+
+/**
+  Common code to submit IPMI commands, returning the cached response of the
+  read-only commands that were already sent.
+
+  @param[in, out]    Cache             The response cache, or NULL to always send the command.
+  @param[in]         TransportToken    TRansport token.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+  @param[in]         RequestData       Command Request Data.
+  @param[in]         RequestDataSize   Size of Command Request Data.
+  @param[out]        ResponseData      Command Response Data. The completion code is the first byte of response data.
+  @param[in, out]    ResponseDataSize  Size of Command Response Data.
+
+  @retval EFI_SUCCESS            The command byte stream was successfully submit to the device and a response was successfully received,
+                                 or the response was found in the cache.
+  @retval Others                 See CommonIpmiSubmitCommand().
+**/
+EFI_STATUS
+CommonIpmiSubmitCommandCached (
+  IN OUT IPMI_RESPONSE_CACHE            *Cache OPTIONAL,
+  IN     MANAGEABILITY_TRANSPORT_TOKEN  *TransportToken,
+  IN     UINT8                          NetFunction,
+  IN     UINT8                          Command,
+  IN     UINT8                          *RequestData OPTIONAL,
+  IN     UINT32                         RequestDataSize,
+  OUT    UINT8                          *ResponseData OPTIONAL,
+  IN OUT UINT32                         *ResponseDataSize OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Cacheable;
+  UINT32      BufferSize;
+
+  Cacheable = FALSE;
+  if (Cache != NULL) {
+    if (!IpmiIsCacheableCommand (NetFunction, Command)) {
+      //
+      // The command may change what some cached commands of its NetFunction return.
+      //
+      IpmiResponseCacheInvalidate (Cache, NetFunction, Command);
+    } else {
+      Cacheable = (ResponseData != NULL) && (ResponseDataSize != NULL) &&
+                  ((RequestData != NULL) || (RequestDataSize == 0));
+    }
+  }
+
+  BufferSize = 0;
+  if (Cacheable) {
+    Status = IpmiResponseCacheLookup (Cache, NetFunction, Command, RequestData, RequestDataSize, ResponseData, ResponseDataSize);
+    if (Status != EFI_NOT_FOUND) {
+      return Status;
+    }
+
+    BufferSize = *ResponseDataSize;
+  }
+
+  Status = CommonIpmiSubmitCommand (
+             TransportToken,
+             NetFunction,
+             Command,
+             RequestData,
+             RequestDataSize,
+             ResponseData,
+             ResponseDataSize
+             );
+  if (!EFI_ERROR (Status) && Cacheable) {
+    IpmiResponseCacheAdd (Cache, NetFunction, Command, RequestData, RequestDataSize, ResponseData, *ResponseDataSize, BufferSize);
+  }
+
+  return Status;
+}
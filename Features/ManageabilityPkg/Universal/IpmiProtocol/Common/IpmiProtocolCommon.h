@@ -35,6 +35,26 @@
 #define IPMI_SERIAL_REQUESTER_LUN      FixedPcdGet8 (PcdIpmiSerialRequesterLun)
 #define IPMI_SERIAL_RESPONDER_LUN      FixedPcdGet8 (PcdIpmiSerialResponderLun)
 
+///
+/// Maximum number of responses in the IPMI response cache. Once it is full,
+/// the oldest response is dropped.
+///
+#define IPMI_RESPONSE_CACHE_MAX_ENTRIES  64
+
+///
+/// IPMI response cache. The responses of the read-only commands in
+/// mIpmiCacheableCommands are kept, and returned instead of asking the BMC again.
+/// The other commands invalidate the cached responses they may change, listed in
+/// mIpmiCacheInvalidatingCommands, or all those of their NetFunction if unknown.
+///
+typedef struct {
+  LIST_ENTRY    Entries;
+  UINT32        EntryCount;
+  UINT32        Hits;
+  UINT32        Misses;
+  UINT32        Invalidations;
+} IPMI_RESPONSE_CACHE;
+
 /**
   This functions setup the IPMI transport hardware information according
   to the specification of transport token acquired from transport library.
@@ -123,4 +143,63 @@ CommonIpmiSubmitCommand (
   IN OUT UINT32                         *ResponseDataSize OPTIONAL
   );
 
+/**
+  This function initializes an IPMI response cache.
+
+  @param[out]        Cache             The response cache.
+**/
+VOID
+IpmiResponseCacheInit (
+  OUT IPMI_RESPONSE_CACHE  *Cache
+  );
+
+/**
+  This function frees the responses of an IPMI response cache.
+
+  @param[in, out]    Cache             The response cache.
+**/
+VOID
+IpmiResponseCacheFlush (
+  IN OUT IPMI_RESPONSE_CACHE  *Cache
+  );
+
+/**
+  This function prints the statistics of an IPMI response cache.
+
+  @param[in]         Cache             The response cache.
+**/
+VOID
+IpmiResponseCachePrintStatistics (
+  IN IPMI_RESPONSE_CACHE  *Cache
+  );
+
+/**
+  Common code to submit IPMI commands, returning the cached response of the
+  read-only commands that were already sent.
+
+  @param[in, out]    Cache             The response cache, or NULL to always send the command.
+  @param[in]         TransportToken    TRansport token.
+  @param[in]         NetFunction       Net function of the command.
+  @param[in]         Command           IPMI Command.
+  @param[in]         RequestData       Command Request Data.
+  @param[in]         RequestDataSize   Size of Command Request Data.
+  @param[out]        ResponseData      Command Response Data. The completion code is the first byte of response data.
+  @param[in, out]    ResponseDataSize  Size of Command Response Data.
+
+  @retval EFI_SUCCESS            The command byte stream was successfully submit to the device and a response was successfully received,
+                                 or the response was found in the cache.
+  @retval Others                 See CommonIpmiSubmitCommand().
+**/
+EFI_STATUS
+CommonIpmiSubmitCommandCached (
+  IN OUT IPMI_RESPONSE_CACHE            *Cache OPTIONAL,
+  IN     MANAGEABILITY_TRANSPORT_TOKEN  *TransportToken,
+  IN     UINT8                          NetFunction,
+  IN     UINT8                          Command,
+  IN     UINT8                          *RequestData OPTIONAL,
+  IN     UINT32                         RequestDataSize,
+  OUT    UINT8                          *ResponseData OPTIONAL,
+  IN OUT UINT32                         *ResponseDataSize OPTIONAL
+  );
+
 #endif
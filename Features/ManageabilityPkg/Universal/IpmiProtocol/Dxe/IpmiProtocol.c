@@ -6,22 +6,69 @@
 **/
 
 #include <PiDxe.h>
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/ManageabilityTransportLib.h>
+#include <Library/PcdLib.h>
 #include <Library/ManageabilityTransportIpmiLib.h>
 #include <Library/ManageabilityTransportHelperLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Guid/EventGroup.h>
+#include <Protocol/IpmiAsync.h>
 #include <Protocol/IpmiProtocol.h>
 
 #include "IpmiProtocolCommon.h"
 
+#define IPMI_ASYNC_REQUEST_SIGNATURE  SIGNATURE_32 ('I', 'P', 'A', 'R')
+
+///
+/// The queued asynchronous commands are sent one per period of the timer,
+/// in 100ns units.
+///
+#define IPMI_ASYNC_TIMER_PERIOD  10000
+
+///
+/// The TPL the commands are sent at. The queued commands are sent from a timer
+/// event of this TPL, and the synchronous commands submitted below it are sent
+/// at it, so the callers up to this TPL can't interleave on the transport
+/// interface.
+///
+#define IPMI_SEND_TPL  TPL_CALLBACK
+
+///
+/// A queued asynchronous command.
+///
+typedef struct {
+  UINT32                    Signature;
+  LIST_ENTRY                Link;
+  EDKII_IPMI_ASYNC_TOKEN    *Token;
+} IPMI_ASYNC_REQUEST;
+
+#define IPMI_ASYNC_REQUEST_FROM_LINK(a)  CR (a, IPMI_ASYNC_REQUEST, Link, IPMI_ASYNC_REQUEST_SIGNATURE)
+
 MANAGEABILITY_TRANSPORT_TOKEN                 *mTransportToken = NULL;
 CHAR16                                        *mTransportName;
 UINT32                                        TransportMaximumPayload;
 MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
 
+///
+/// The response cache, when PcdIpmiResponseCacheEnable is TRUE.
+///
+IPMI_RESPONSE_CACHE  mIpmiResponseCacheInstance;
+IPMI_RESPONSE_CACHE  *mIpmiResponseCache = NULL;
+
+LIST_ENTRY  mIpmiAsyncQueue = INITIALIZE_LIST_HEAD_VARIABLE (mIpmiAsyncQueue);
+EFI_EVENT   mIpmiAsyncTimer = NULL;
+
+///
+/// TRUE while a command is being sent over the transport interface. Commands are
+/// sent at IPMI_SEND_TPL, so only a caller above it can find the transport
+/// interface busy.
+///
+BOOLEAN  mIpmiTransportBusy = FALSE;
+
 /**
   This service enables submitting commands via Ipmi.
 
@@ -35,7 +82,9 @@ MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
 
   @retval EFI_SUCCESS            The command byte stream was successfully submit to the device and a response was successfully received.
   @retval EFI_NOT_FOUND          The command was not successfully sent to the device or a response was not successfully received from the device.
-  @retval EFI_NOT_READY          Ipmi Device is not ready for Ipmi command access.
+  @retval EFI_NOT_READY          Ipmi Device is not ready for Ipmi command access, or
+                                 the command is submitted above TPL_CALLBACK while
+                                 another one is being sent.
   @retval EFI_DEVICE_ERROR       Ipmi Device hardware error.
   @retval EFI_TIMEOUT            The command time out.
   @retval EFI_UNSUPPORTED        The command was not successfully sent to the device.
@@ -54,23 +103,273 @@ DxeIpmiSubmitCommand (
   )
 {
   EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+
+  //
+  // Send the command at IPMI_SEND_TPL, so that the queued commands and the
+  // commands submitted by the events up to that TPL wait for it to complete.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (OldTpl);
+  if (OldTpl < IPMI_SEND_TPL) {
+    gBS->RaiseTPL (IPMI_SEND_TPL);
+  }
+
+  //
+  // Only an event above IPMI_SEND_TPL can preempt a command being sent, and
+  // it can't wait for that command to complete.
+  //
+  if (mIpmiTransportBusy) {
+    DEBUG ((DEBUG_ERROR, "%a: IPMI command submitted at TPL %d while another one is being sent.\n", __func__, (UINT32)OldTpl));
+    if (OldTpl < IPMI_SEND_TPL) {
+      gBS->RestoreTPL (OldTpl);
+    }
+
+    return EFI_NOT_READY;
+  }
+
+  mIpmiTransportBusy = TRUE;
+  Status             = CommonIpmiSubmitCommandCached (
+                         mIpmiResponseCache,
+                         mTransportToken,
+                         NetFunction,
+                         Command,
+                         RequestData,
+                         RequestDataSize,
+                         ResponseData,
+                         ResponseDataSize
+                         );
+  mIpmiTransportBusy = FALSE;
+
+  if (OldTpl < IPMI_SEND_TPL) {
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  return Status;
+}
+
+/**
+  This function completes an asynchronous command and signals its event.
+
+  @param[in]  Request           The command to complete.
+  @param[in]  Status            The status of the command.
+
+**/
+VOID
+IpmiAsyncComplete (
+  IN IPMI_ASYNC_REQUEST  *Request,
+  IN EFI_STATUS          Status
+  )
+{
+  EDKII_IPMI_ASYNC_TOKEN  *Token;
+
+  Token                    = Request->Token;
+  Token->TransactionStatus = Status;
+  FreePool (Request);
+  gBS->SignalEvent (Token->Event);
+}
+
+/**
+  Timer handler sending the first queued asynchronous command.
+
+  @param[in]  Event             The timer event.
+  @param[in]  Context           Not used.
+
+**/
+VOID
+EFIAPI
+IpmiAsyncTimerHandler (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS              Status;
+  EFI_TPL                 OldTpl;
+  IPMI_ASYNC_REQUEST      *Request;
+  EDKII_IPMI_ASYNC_TOKEN  *Token;
+
+  //
+  // A synchronous command submitted above IPMI_SEND_TPL is being sent, try
+  // again on the next tick.
+  //
+  if (mIpmiTransportBusy) {
+    return;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (IsListEmpty (&mIpmiAsyncQueue)) {
+    gBS->SetTimer (mIpmiAsyncTimer, TimerCancel, 0);
+    gBS->RestoreTPL (OldTpl);
+    return;
+  }
+
+  Request = IPMI_ASYNC_REQUEST_FROM_LINK (GetFirstNode (&mIpmiAsyncQueue));
+  RemoveEntryList (&Request->Link);
+  gBS->RestoreTPL (OldTpl);
+
+  //
+  // This handler runs at IPMI_SEND_TPL, so a synchronous command submitted
+  // while this one is being sent waits for it.
+  //
+  Token              = Request->Token;
+  mIpmiTransportBusy = TRUE;
+  Status             = CommonIpmiSubmitCommandCached (
+                         mIpmiResponseCache,
+                         mTransportToken,
+                         Token->NetFunction,
+                         Token->Command,
+                         Token->RequestData,
+                         Token->RequestDataSize,
+                         Token->ResponseData,
+                         &Token->ResponseDataSize
+                         );
+  mIpmiTransportBusy = FALSE;
+
+  IpmiAsyncComplete (Request, Status);
+}
+
+/**
+  This service queues an IPMI command and returns without waiting for the BMC.
+
+  @param[in]      This              EDKII_IPMI_ASYNC_PROTOCOL instance.
+  @param[in, out] Token             The command to submit.
+
+  @retval EFI_SUCCESS            The command is queued, and Token->Event will be
+                                 signaled when it is completed.
+  @retval EFI_INVALID_PARAMETER  Token or Token->Event is NULL, or one of the data
+                                 buffers is NULL while its size is not 0.
+  @retval EFI_OUT_OF_RESOURCES   The command can't be queued.
+**/
+EFI_STATUS
+EFIAPI
+DxeIpmiAsyncSubmitCommand (
+  IN     EDKII_IPMI_ASYNC_PROTOCOL  *This,
+  IN OUT EDKII_IPMI_ASYNC_TOKEN     *Token
+  )
+{
+  EFI_STATUS          Status;
+  EFI_TPL             OldTpl;
+  IPMI_ASYNC_REQUEST  *Request;
+
+  if ((Token == NULL) || (Token->Event == NULL) ||
+      ((Token->RequestData == NULL) && (Token->RequestDataSize != 0)) ||
+      ((Token->ResponseData == NULL) && (Token->ResponseDataSize != 0)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Request = AllocatePool (sizeof (IPMI_ASYNC_REQUEST));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request->Signature       = IPMI_ASYNC_REQUEST_SIGNATURE;
+  Request->Token           = Token;
+  Token->TransactionStatus = EFI_NOT_READY;
+
+  Status = EFI_SUCCESS;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (IsListEmpty (&mIpmiAsyncQueue)) {
+    Status = gBS->SetTimer (mIpmiAsyncTimer, TimerPeriodic, IPMI_ASYNC_TIMER_PERIOD);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    InsertTailList (&mIpmiAsyncQueue, &Request->Link);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to start the IPMI queue timer - %r\n", __func__, Status));
+    FreePool (Request);
+  }
 
-  Status = CommonIpmiSubmitCommand (
-             mTransportToken,
-             NetFunction,
-             Command,
-             RequestData,
-             RequestDataSize,
-             ResponseData,
-             ResponseDataSize
-             );
   return Status;
 }
 
+/**
+  This service cancels a queued IPMI command. A command that is already being
+  sent to the BMC can't be cancelled.
+
+  @param[in]      This              EDKII_IPMI_ASYNC_PROTOCOL instance.
+  @param[in, out] Token             The command to cancel, or NULL to cancel all the
+                                    queued commands.
+
+  @retval EFI_SUCCESS            The command is cancelled: its status is EFI_ABORTED
+                                 and its event is signaled.
+  @retval EFI_NOT_FOUND          The command isn't queued.
+**/
+EFI_STATUS
+EFIAPI
+DxeIpmiAsyncCancel (
+  IN     EDKII_IPMI_ASYNC_PROTOCOL  *This,
+  IN OUT EDKII_IPMI_ASYNC_TOKEN     *Token OPTIONAL
+  )
+{
+  EFI_TPL             OldTpl;
+  LIST_ENTRY          Cancelled;
+  LIST_ENTRY          *Link;
+  LIST_ENTRY          *NextLink;
+  IPMI_ASYNC_REQUEST  *Request;
+
+  InitializeListHead (&Cancelled);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  for (Link = GetFirstNode (&mIpmiAsyncQueue); !IsNull (&mIpmiAsyncQueue, Link); Link = NextLink) {
+    NextLink = GetNextNode (&mIpmiAsyncQueue, Link);
+    Request  = IPMI_ASYNC_REQUEST_FROM_LINK (Link);
+    if ((Token == NULL) || (Request->Token == Token)) {
+      RemoveEntryList (Link);
+      InsertTailList (&Cancelled, Link);
+    }
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (IsListEmpty (&Cancelled)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Signal the events at the caller's TPL.
+  //
+  while (!IsListEmpty (&Cancelled)) {
+    Request = IPMI_ASYNC_REQUEST_FROM_LINK (GetFirstNode (&Cancelled));
+    RemoveEntryList (&Request->Link);
+    IpmiAsyncComplete (Request, EFI_ABORTED);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Notification function of the ReadyToBoot event group, which prints the
+  statistics of the response cache.
+
+  @param[in]  Event             The event.
+  @param[in]  Context           Not used.
+
+**/
+VOID
+EFIAPI
+IpmiResponseCacheReadyToBoot (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  gBS->CloseEvent (Event);
+  IpmiResponseCachePrintStatistics (mIpmiResponseCache);
+}
+
 static IPMI_PROTOCOL  mIpmiProtocol = {
   DxeIpmiSubmitCommand
 };
 
+static EDKII_IPMI_ASYNC_PROTOCOL  mIpmiAsyncProtocol = {
+  DxeIpmiAsyncSubmitCommand,
+  DxeIpmiAsyncCancel
+};
+
 /**
   The entry point of the Ipmi DXE driver.
 
@@ -89,6 +388,7 @@ DxeIpmiEntry (
 {
   EFI_STATUS                                 Status;
   EFI_HANDLE                                 Handle;
+  EFI_EVENT                                  ReadyToBootEvent;
   MANAGEABILITY_TRANSPORT_CAPABILITY         TransportCapability;
   MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  TransportAdditionalStatus;
 
@@ -143,12 +443,39 @@ DxeIpmiEntry (
     return Status;
   }
 
+  if (FeaturePcdGet (PcdIpmiResponseCacheEnable)) {
+    IpmiResponseCacheInit (&mIpmiResponseCacheInstance);
+    mIpmiResponseCache = &mIpmiResponseCacheInstance;
+    gBS->CreateEventEx (
+           EVT_NOTIFY_SIGNAL,
+           TPL_CALLBACK,
+           IpmiResponseCacheReadyToBoot,
+           NULL,
+           &gEfiEventReadyToBootGuid,
+           &ReadyToBootEvent
+           );
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  IPMI_SEND_TPL,
+                  IpmiAsyncTimerHandler,
+                  NULL,
+                  &mIpmiAsyncTimer
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to create the IPMI queue timer - %r\n", __func__, Status));
+    return Status;
+  }
+
   Handle = NULL;
-  Status = gBS->InstallProtocolInterface (
+  Status = gBS->InstallMultipleProtocolInterfaces (
                   &Handle,
                   &gIpmiProtocolGuid,
-                  EFI_NATIVE_INTERFACE,
-                  (VOID **)&mIpmiProtocol
+                  (VOID **)&mIpmiProtocol,
+                  &gEdkiiIpmiAsyncProtocolGuid,
+                  (VOID **)&mIpmiAsyncProtocol,
+                  NULL
                   );
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: Failed to install IPMI protocol - %r\n", __func__, Status));
@@ -177,6 +504,11 @@ IpmiUnloadImage (
   EFI_STATUS  Status;
 
   Status = EFI_SUCCESS;
+  if (mIpmiAsyncTimer != NULL) {
+    DxeIpmiAsyncCancel (&mIpmiAsyncProtocol, NULL);
+    gBS->CloseEvent (mIpmiAsyncTimer);
+  }
+
   if (mTransportToken != NULL) {
     Status = ReleaseTransportSession (mTransportToken);
   }
@@ -185,5 +517,9 @@ IpmiUnloadImage (
     FreePool (mHardwareInformation.Pointer);
   }
 
+  if (mIpmiResponseCache != NULL) {
+    IpmiResponseCacheFlush (mIpmiResponseCache);
+  }
+
   return Status;
 }
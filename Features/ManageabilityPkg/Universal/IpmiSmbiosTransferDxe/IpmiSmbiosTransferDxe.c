@@ -130,11 +130,10 @@ IpmiSmbiosTransferSendTables (
   SMBIOS_TABLE_3_0_ENTRY_POINT       *Smbios30Table;
   SMBIOS_TABLE_3_0_ENTRY_POINT       *Smbios30TableModified;
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL  *IpmiBlobTransfer;
-  UINT16                             Index;
+  UINT32                             Index;
   UINT16                             SessionId;
   UINT8                              *SendData;
   UINT32                             SendDataSize;
-  UINT32                             RemainingDataSize;
   BOOLEAN                            SmbiosTransferRequired;
   UINTN                              RetryIndex;
   UINT16                             BlobState;
@@ -179,8 +178,7 @@ IpmiSmbiosTransferSendTables (
   SendData = AllocateZeroPool (sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT) + Smbios30Table->TableMaximumSize);
   CopyMem (SendData, Smbios30TableModified, sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT));
   CopyMem (SendData + sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT), (UINT8 *)Smbios30Table->TableAddress, Smbios30Table->TableMaximumSize);
-  SendDataSize      = sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT) + Smbios30Table->TableMaximumSize;
-  RemainingDataSize = SendDataSize;
+  SendDataSize = sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT) + Smbios30Table->TableMaximumSize;
 
   if (PcdGetBool (PcdSendSmbiosOnChanged)) {
     SmbiosTransferRequired = DetectSmbiosChange (SendData, SendDataSize);
@@ -216,24 +214,10 @@ IpmiSmbiosTransferSendTables (
     goto ErrorExit;
   }
 
-  for (Index = 0; Index < (SendDataSize / BLOB_MAX_DATA_PER_PACKET); Index++) {
-    Status = IpmiBlobTransfer->BlobWrite (SessionId, Index * BLOB_MAX_DATA_PER_PACKET, SendData, BLOB_MAX_DATA_PER_PACKET);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failure writing to blob: %r\n", __func__, Status));
-      goto ErrorExit;
-    }
-
-    SendData           = (UINT8 *)SendData + BLOB_MAX_DATA_PER_PACKET;
-    RemainingDataSize -= BLOB_MAX_DATA_PER_PACKET;
-  }
-
-  ASSERT (RemainingDataSize < BLOB_MAX_DATA_PER_PACKET);
-  if (RemainingDataSize) {
-    Status = IpmiBlobTransfer->BlobWrite (SessionId, Index * BLOB_MAX_DATA_PER_PACKET, SendData, RemainingDataSize);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failure writing final block to blob: %r\n", __func__, Status));
-      goto ErrorExit;
-    }
+  Status = IpmiBlobTransfer->BlobWriteStream (SessionId, 0, SendData, SendDataSize, NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failure writing to blob: %r\n", __func__, Status));
+    goto ErrorExit;
   }
 
   Status = IpmiBlobTransfer->BlobCommit (SessionId, 0, NULL);
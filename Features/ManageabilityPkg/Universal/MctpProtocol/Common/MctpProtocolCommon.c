@@ -21,6 +21,8 @@
 extern CHAR16  *mTransportName;
 extern UINT32  mTransportMaximumPayload;
 
+extern MANAGEABILITY_TRANSPORT_CAPABILITY  mTransportCapability;
+
 MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
 UINT8                                         mMctpPacketSequence;
 BOOLEAN                                       mStartOfMessage;
@@ -87,57 +89,50 @@ SetupMctpTransportHardwareInformation (
   This functions setup the final header/body/trailer packets for
   the acquired transport interface.
 
+  The MCTP headers are built in Packet. If the transport interface reports
+  MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER, the request is described
+  to it as a scatter-gather list and the payload slice is sent from the
+  caller's buffer. Otherwise the headers and the payload slice are copied
+  to Packet->Body.
+
   @param[in]         TransportToken             The transport interface.
   @param[in]         MctpType                   MCTP message type.
   @param[in]         MctpSourceEndpointId       MCTP source endpoint ID.
   @param[in]         MctpDestinationEndpointId  MCTP source endpoint ID.
   @param[in]         RequestDataIntegrityCheck  Indicates whether MCTP message has
                                                 integrity check byte.
-  @param[out]        PacketHeader               The pointer to receive header of request.
-  @param[out]        PacketHeaderSize           Packet header size.
-  @param[in, out]    PacketBody                 The request body.
-                                                When IN, it is the caller's request body.
-                                                When OUT and NULL, the request body is not
-                                                changed.
-                                                Whee out and non-NULL, the request body is
-                                                changed to comfort the transport interface.
-  @param[in, out]    PacketBodySize             The request body size.
-                                                When IN and non-zero, it is the new data
-                                                length of request body.
-                                                When IN and zero, the request body is unchanged.
-  @param[out]        PacketTrailer              The pointer to receive trailer of request.
-  @param[out]        PacketTrailerSize          Packet trailer size.
+  @param[in]         PacketBody                 The payload of this packet.
+  @param[in]         PacketBodySize             The payload size.
+  @param[out]        Packet                     The storage of the headers and the
+                                                trailer of this packet. It must stay
+                                                valid until the packet is sent.
+  @param[out]        TransferToken              The transfer token to set up with the
+                                                request packet.
 
   @retval EFI_SUCCESS            Request packet is returned.
-  @retval EFI_OUT_OF_RESOURCE    Not enough resource to create the request
-                                 transport packets.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is invalid, or the packet
+                                 is too big for the transport interface.
   @retval EFI_UNSUPPORTED        Request packet is not returned because
                                  the unsupported transport interface.
 **/
 EFI_STATUS
 SetupMctpRequestTransportPacket (
-  IN   MANAGEABILITY_TRANSPORT_TOKEN    *TransportToken,
-  IN   UINT8                            MctpType,
-  IN   UINT8                            MctpSourceEndpointId,
-  IN   UINT8                            MctpDestinationEndpointId,
-  IN   BOOLEAN                          RequestDataIntegrityCheck,
-  OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader,
-  OUT  UINT16                           *PacketHeaderSize,
-  IN   OUT UINT8                        **PacketBody,
-  IN   OUT UINT32                       *PacketBodySize,
-  OUT  MANAGEABILITY_TRANSPORT_TRAILER  *PacketTrailer,
-  OUT  UINT16                           *PacketTrailerSize
+  IN   MANAGEABILITY_TRANSPORT_TOKEN  *TransportToken,
+  IN   UINT8                          MctpType,
+  IN   UINT8                          MctpSourceEndpointId,
+  IN   UINT8                          MctpDestinationEndpointId,
+  IN   BOOLEAN                        RequestDataIntegrityCheck,
+  IN   UINT8                          *PacketBody,
+  IN   UINT32                         PacketBodySize,
+  OUT  MCTP_REQUEST_TRANSPORT_PACKET  *Packet,
+  OUT  MANAGEABILITY_TRANSFER_TOKEN   *TransferToken
   )
 {
-  MANAGEABILITY_MCTP_KCS_HEADER   *MctpKcsHeader;
-  MCTP_TRANSPORT_HEADER           *MctpTransportHeader;
-  MCTP_MESSAGE_HEADER             *MctpMessageHeader;
-  MANAGEABILITY_MCTP_KCS_TRAILER  *MctpKcsTrailer;
-  UINT8                           *ThisPackage;
-
-  if ((PacketHeader == NULL) || (PacketHeaderSize == NULL) ||
-      (PacketBody == NULL) || (PacketBodySize == NULL) ||
-      (PacketTrailer == NULL) || (PacketTrailerSize == NULL)
+  UINT32  ByteCount;
+  UINT8   Pec;
+
+  if ((Packet == NULL) || (TransferToken == NULL) ||
+      ((PacketBody == NULL) && (PacketBodySize != 0))
       )
   {
     DEBUG ((DEBUG_ERROR, "%a: One or more than one of the input parameter is invalid.\n", __func__));
@@ -145,69 +140,85 @@ SetupMctpRequestTransportPacket (
   }
 
   if (CompareGuid (&gManageabilityTransportKcsGuid, TransportToken->Transport->ManageabilityTransportSpecification)) {
-    MctpKcsHeader = (MANAGEABILITY_MCTP_KCS_HEADER *)AllocateZeroPool (sizeof (MANAGEABILITY_MCTP_KCS_HEADER));
-    if (MctpKcsHeader == NULL) {
-      DEBUG ((DEBUG_ERROR, "%a: Not enough resource for MANAGEABILITY_MCTP_KCS_HEADER.\n", __func__));
-      return EFI_OUT_OF_RESOURCES;
+    ByteCount = PacketBodySize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER);
+    if (ByteCount > MCTP_KCS_MAXIMUM_PACKET_SIZE) {
+      DEBUG ((DEBUG_ERROR, "%a: Packet size 0x%x is too big for MCTP over KCS.\n", __func__, ByteCount));
+      return EFI_INVALID_PARAMETER;
     }
 
-    MctpKcsTrailer = (MANAGEABILITY_MCTP_KCS_TRAILER *)AllocateZeroPool (sizeof (MANAGEABILITY_MCTP_KCS_TRAILER));
-    if (MctpKcsTrailer == NULL) {
-      DEBUG ((DEBUG_ERROR, "%a: Not enough resource for PEC.\n", __func__));
-      FreePool (MctpKcsHeader);
-      return EFI_OUT_OF_RESOURCES;
-    }
+    ZeroMem (Packet, sizeof (MCTP_REQUEST_TRANSPORT_PACKET));
 
     // Generate MCTP KCS transport header
-    MctpKcsHeader->DefiningBody = DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP;
-    MctpKcsHeader->NetFunc      = MCTP_KCS_NETFN_LUN;
-    MctpKcsHeader->ByteCount    = (UINT8)(MIN (mTransportMaximumPayload, *PacketBodySize + (UINT8)sizeof (MCTP_MESSAGE_HEADER) + (UINT8)sizeof (MCTP_TRANSPORT_HEADER)));
-
-    ThisPackage = (UINT8 *)AllocateZeroPool (MctpKcsHeader->ByteCount);
-    if (ThisPackage == NULL) {
-      DEBUG ((DEBUG_ERROR, "%a: Not enough resource for package.\n", __func__));
-      FreePool (MctpKcsHeader);
-      FreePool (MctpKcsTrailer);
-      return EFI_OUT_OF_RESOURCES;
-    }
+    Packet->KcsHeader.DefiningBody = DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP;
+    Packet->KcsHeader.NetFunc      = MCTP_KCS_NETFN_LUN;
+    Packet->KcsHeader.ByteCount    = (UINT8)ByteCount;
 
     // Setup MCTP transport header
-    MctpTransportHeader                             = (MCTP_TRANSPORT_HEADER *)ThisPackage;
-    MctpTransportHeader->Bits.Reserved              = 0;
-    MctpTransportHeader->Bits.HeaderVersion         = MCTP_KCS_HEADER_VERSION;
-    MctpTransportHeader->Bits.DestinationEndpointId = MctpDestinationEndpointId;
-    MctpTransportHeader->Bits.SourceEndpointId      = MctpSourceEndpointId;
-    MctpTransportHeader->Bits.MessageTag            = MCTP_MESSAGE_TAG;
-    MctpTransportHeader->Bits.TagOwner              = MCTP_MESSAGE_TAG_OWNER_REQUEST;
-    MctpTransportHeader->Bits.PacketSequence        = mMctpPacketSequence & MCTP_PACKET_SEQUENCE_MASK;
-    MctpTransportHeader->Bits.StartOfMessage        = mStartOfMessage ? 1 : 0;
-    MctpTransportHeader->Bits.EndOfMessage          = mEndOfMessage ? 1 : 0;
+    Packet->TransportHeader.Bits.Reserved              = 0;
+    Packet->TransportHeader.Bits.HeaderVersion         = MCTP_KCS_HEADER_VERSION;
+    Packet->TransportHeader.Bits.DestinationEndpointId = MctpDestinationEndpointId;
+    Packet->TransportHeader.Bits.SourceEndpointId      = MctpSourceEndpointId;
+    Packet->TransportHeader.Bits.MessageTag            = MCTP_MESSAGE_TAG;
+    Packet->TransportHeader.Bits.TagOwner              = MCTP_MESSAGE_TAG_OWNER_REQUEST;
+    Packet->TransportHeader.Bits.PacketSequence        = mMctpPacketSequence & MCTP_PACKET_SEQUENCE_MASK;
+    Packet->TransportHeader.Bits.StartOfMessage        = mStartOfMessage ? 1 : 0;
+    Packet->TransportHeader.Bits.EndOfMessage          = mEndOfMessage ? 1 : 0;
 
     // Setup MCTP message header
-    MctpMessageHeader                      = (MCTP_MESSAGE_HEADER *)(MctpTransportHeader + 1);
-    MctpMessageHeader->Bits.MessageType    = MctpType;
-    MctpMessageHeader->Bits.IntegrityCheck = RequestDataIntegrityCheck ? 1 : 0;
-
-    // Copy payload
-    CopyMem ((VOID *)(MctpMessageHeader + 1), (VOID *)*PacketBody, *PacketBodySize);
+    Packet->MessageHeader.Bits.MessageType    = MctpType;
+    Packet->MessageHeader.Bits.IntegrityCheck = RequestDataIntegrityCheck ? 1 : 0;
 
     //
-    // Generate PEC follow SMBUS 2.0 specification.
-    MctpKcsTrailer->Pec = HelperManageabilityGenerateCrc8 (MCTP_KCS_PACKET_ERROR_CODE_POLY, 0, ThisPackage, MctpKcsHeader->ByteCount);
-
-    *PacketBody        = (UINT8 *)ThisPackage;
-    *PacketBodySize    = MctpKcsHeader->ByteCount;
-    *PacketTrailer     = (MANAGEABILITY_TRANSPORT_TRAILER)MctpKcsTrailer;
-    *PacketHeader      = (MANAGEABILITY_TRANSPORT_HEADER)MctpKcsHeader;
-    *PacketHeaderSize  = sizeof (MANAGEABILITY_MCTP_KCS_HEADER);
-    *PacketTrailerSize = sizeof (MANAGEABILITY_MCTP_KCS_TRAILER);
+    // Generate PEC follow SMBUS 2.0 specification, over the
+    // segments in the order they are sent.
+    //
+    Pec = HelperManageabilityGenerateCrc8 (MCTP_KCS_PACKET_ERROR_CODE_POLY, 0, (UINT8 *)&Packet->TransportHeader, sizeof (MCTP_TRANSPORT_HEADER));
+    Pec = HelperManageabilityGenerateCrc8 (MCTP_KCS_PACKET_ERROR_CODE_POLY, Pec, (UINT8 *)&Packet->MessageHeader, sizeof (MCTP_MESSAGE_HEADER));
+    if (PacketBodySize != 0) {
+      Pec = HelperManageabilityGenerateCrc8 (MCTP_KCS_PACKET_ERROR_CODE_POLY, Pec, PacketBody, PacketBodySize);
+    }
+
+    Packet->KcsTrailer.Pec = Pec;
+
+    TransferToken->TransmitHeader                     = (MANAGEABILITY_TRANSPORT_HEADER)&Packet->KcsHeader;
+    TransferToken->TransmitHeaderSize                 = sizeof (MANAGEABILITY_MCTP_KCS_HEADER);
+    TransferToken->TransmitTrailer                    = (MANAGEABILITY_TRANSPORT_TRAILER)&Packet->KcsTrailer;
+    TransferToken->TransmitTrailerSize                = sizeof (MANAGEABILITY_MCTP_KCS_TRAILER);
+    TransferToken->TransmitPackage.TransmitSizeInByte = ByteCount;
+
+    if ((mTransportCapability & MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER) != 0) {
+      Packet->Segments[0].Buffer     = (UINT8 *)&Packet->TransportHeader;
+      Packet->Segments[0].SizeInByte = sizeof (MCTP_TRANSPORT_HEADER);
+      Packet->Segments[1].Buffer     = (UINT8 *)&Packet->MessageHeader;
+      Packet->Segments[1].SizeInByte = sizeof (MCTP_MESSAGE_HEADER);
+      Packet->Segments[2].Buffer     = PacketBody;
+      Packet->Segments[2].SizeInByte = PacketBodySize;
+
+      TransferToken->TransmitPackage.TransmitPayload          = NULL;
+      TransferToken->TransmitPackage.TransmitSegments         = Packet->Segments;
+      TransferToken->TransmitPackage.NumberOfTransmitSegments = MCTP_REQUEST_PACKET_SEGMENTS;
+    } else {
+      //
+      // The transport interface takes the payload in a single buffer.
+      //
+      CopyMem (Packet->Body, &Packet->TransportHeader, sizeof (MCTP_TRANSPORT_HEADER));
+      CopyMem (Packet->Body + sizeof (MCTP_TRANSPORT_HEADER), &Packet->MessageHeader, sizeof (MCTP_MESSAGE_HEADER));
+      if (PacketBodySize != 0) {
+        CopyMem (Packet->Body + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER), PacketBody, PacketBodySize);
+      }
+
+      TransferToken->TransmitPackage.TransmitPayload          = Packet->Body;
+      TransferToken->TransmitPackage.TransmitSegments         = NULL;
+      TransferToken->TransmitPackage.NumberOfTransmitSegments = 0;
+    }
+
     return EFI_SUCCESS;
   } else {
     DEBUG ((DEBUG_ERROR, "%a: No implementation of building up packet.", __func__));
     ASSERT (FALSE);
   }
 
-  return EFI_SUCCESS;
+  return EFI_UNSUPPORTED;
 }
 
 /**
@@ -258,16 +269,14 @@ CommonMctpSubmitMessage (
 {
   EFI_STATUS                                 Status;
   UINT16                                     IndexOfPackage;
-  UINT8                                      *ThisRequestData;
-  UINT32                                     ThisRequestDataSize;
-  UINT16                                     MctpTransportHeaderSize;
-  UINT16                                     MctpTransportTrailerSize;
+  UINT16                                     IndexOfSegment;
+  MCTP_REQUEST_TRANSPORT_PACKET              RequestPacket;
   MANAGEABILITY_TRANSFER_TOKEN               TransferToken;
-  MANAGEABILITY_TRANSPORT_HEADER             MctpTransportHeader;
-  MANAGEABILITY_TRANSPORT_TRAILER            MctpTransportTrailer;
   MANAGEABILITY_TRANSMISSION_MULTI_PACKAGES  *MultiPackages;
   MANAGEABILITY_TRANSMISSION_PACKAGE_ATTR    *ThisPackage;
+  UINT8                                      ResponsePacket[MCTP_KCS_MAXIMUM_PACKET_SIZE];
   UINT8                                      *ResponseBuffer;
+  UINT32                                     ResponseBufferSize;
   MCTP_TRANSPORT_HEADER                      *MctpTransportResponseHeader;
   MCTP_MESSAGE_HEADER                        *MctpMessageResponseHeader;
 
@@ -311,11 +320,6 @@ CommonMctpSubmitMessage (
   ThisPackage         = (MANAGEABILITY_TRANSMISSION_PACKAGE_ATTR *)(MultiPackages + 1);
   mMctpPacketSequence = 0;
   for (IndexOfPackage = 0; IndexOfPackage < MultiPackages->NumberOfPackages; IndexOfPackage++) {
-    MctpTransportHeader  = NULL;
-    MctpTransportTrailer = NULL;
-    ThisRequestData      = ThisPackage->PayloadPointer;
-    ThisRequestDataSize  = ThisPackage->PayloadSize;
-
     // Setup Start of Message bit and End of Message bit.
     if (MultiPackages->NumberOfPackages == 1) {
       mStartOfMessage = TRUE;
@@ -331,40 +335,24 @@ CommonMctpSubmitMessage (
       mEndOfMessage   = FALSE;
     }
 
+    ZeroMem (&TransferToken, sizeof (MANAGEABILITY_TRANSFER_TOKEN));
     Status = SetupMctpRequestTransportPacket (
                TransportToken,
                MctpType,
                MctpSourceEndpointId,
                MctpDestinationEndpointId,
                RequestDataIntegrityCheck,
-               &MctpTransportHeader,
-               &MctpTransportHeaderSize,
-               &ThisRequestData,
-               &ThisRequestDataSize,
-               &MctpTransportTrailer,
-               &MctpTransportTrailerSize
+               ThisPackage->PayloadPointer,
+               ThisPackage->PayloadSize,
+               &RequestPacket,
+               &TransferToken
                );
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: Fail to build packets - (%r)\n", __func__, Status));
+      FreePool (MultiPackages);
       return Status;
     }
 
-    ZeroMem (&TransferToken, sizeof (MANAGEABILITY_TRANSFER_TOKEN));
-    TransferToken.TransmitHeader      = MctpTransportHeader;
-    TransferToken.TransmitHeaderSize  = MctpTransportHeaderSize;
-    TransferToken.TransmitTrailer     = MctpTransportTrailer;
-    TransferToken.TransmitTrailerSize = MctpTransportTrailerSize;
-
-    // Transmit packet.
-    if ((ThisRequestData == NULL) || (ThisRequestDataSize == 0)) {
-      // Transmit parameter were not changed by SetupMctpRequestTransportPacket().
-      TransferToken.TransmitPackage.TransmitPayload    = ThisPackage->PayloadPointer;
-      TransferToken.TransmitPackage.TransmitSizeInByte = ThisPackage->PayloadSize;
-    } else {
-      TransferToken.TransmitPackage.TransmitPayload    = ThisRequestData;
-      TransferToken.TransmitPackage.TransmitSizeInByte = ThisRequestDataSize;
-    }
-
     TransferToken.TransmitPackage.TransmitTimeoutInMillisecond = MANAGEABILITY_TRANSPORT_NO_TIMEOUT;
 
     // Receive packet.
@@ -384,44 +372,32 @@ CommonMctpSubmitMessage (
       TransferToken.ReceivePackage.ReceiveSizeInByte
       ));
 
-    if ((MctpTransportHeader != NULL) && (MctpTransportHeaderSize != 0)) {
-      HelperManageabilityDebugPrint (
-        (VOID *)TransferToken.TransmitHeader,
-        (UINT32)TransferToken.TransmitHeaderSize,
-        "MCTP transport header.\n"
-        );
-    }
-
     HelperManageabilityDebugPrint (
-      (VOID *)TransferToken.TransmitPackage.TransmitPayload,
-      TransferToken.TransmitPackage.TransmitSizeInByte,
-      "MCTP full request payload.\n"
+      (VOID *)TransferToken.TransmitHeader,
+      (UINT32)TransferToken.TransmitHeaderSize,
+      "MCTP transport header.\n"
       );
 
-    if ((MctpTransportTrailer != NULL) && (MctpTransportTrailerSize != 0)) {
-      HelperManageabilityDebugPrint (
-        (VOID *)TransferToken.TransmitTrailer,
-        (UINT32)TransferToken.TransmitTrailerSize,
-        "MCTP transport trailer.\n"
-        );
+    for (IndexOfSegment = 0; IndexOfSegment < TransferToken.TransmitPackage.NumberOfTransmitSegments; IndexOfSegment++) {
+      if (TransferToken.TransmitPackage.TransmitSegments[IndexOfSegment].SizeInByte != 0) {
+        HelperManageabilityDebugPrint (
+          (VOID *)TransferToken.TransmitPackage.TransmitSegments[IndexOfSegment].Buffer,
+          TransferToken.TransmitPackage.TransmitSegments[IndexOfSegment].SizeInByte,
+          "MCTP request payload segment.\n"
+          );
+      }
     }
 
+    HelperManageabilityDebugPrint (
+      (VOID *)TransferToken.TransmitTrailer,
+      (UINT32)TransferToken.TransmitTrailerSize,
+      "MCTP transport trailer.\n"
+      );
+
     TransportToken->Transport->Function.Version1_0->TransportTransmitReceive (
                                                       TransportToken,
                                                       &TransferToken
                                                       );
-    if (MctpTransportHeader != NULL) {
-      FreePool ((VOID *)MctpTransportHeader);
-    }
-
-    if (MctpTransportTrailer != NULL) {
-      FreePool ((VOID *)MctpTransportTrailer);
-    }
-
-    if (ThisRequestData != NULL) {
-      FreePool ((VOID *)ThisRequestData);
-      ThisRequestData = NULL;
-    }
 
     //
     // Return transfer status.
@@ -438,12 +414,34 @@ CommonMctpSubmitMessage (
     ThisPackage++;
   }
 
-  ResponseBuffer = (UINT8 *)AllocatePool (*ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER));
+  FreePool (MultiPackages);
+
+  //
+  // Multiple-packet responses are not supported, so the response is a single
+  // packet, received on the stack unless the caller expects a larger one.
+  //
+  if (*ResponseDataSize > MAX_UINT32 - sizeof (MCTP_TRANSPORT_HEADER) - sizeof (MCTP_MESSAGE_HEADER)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ResponseBufferSize = *ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER);
+  if (ResponseBufferSize <= sizeof (ResponsePacket)) {
+    ResponseBuffer = ResponsePacket;
+  } else {
+    ResponseBuffer = AllocatePool (ResponseBufferSize);
+    if (ResponseBuffer == NULL) {
+      DEBUG ((DEBUG_ERROR, "%a: Not enough memory for the MCTP response.\n", __func__));
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
   // Receive packet.
   TransferToken.TransmitPackage.TransmitPayload             = NULL;
   TransferToken.TransmitPackage.TransmitSizeInByte          = 0;
+  TransferToken.TransmitPackage.TransmitSegments            = NULL;
+  TransferToken.TransmitPackage.NumberOfTransmitSegments    = 0;
   TransferToken.ReceivePackage.ReceiveBuffer                = ResponseBuffer;
-  TransferToken.ReceivePackage.ReceiveSizeInByte            = *ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER);
+  TransferToken.ReceivePackage.ReceiveSizeInByte            = ResponseBufferSize;
   TransferToken.TransmitHeader                              = NULL;
   TransferToken.TransmitHeaderSize                          = 0;
   TransferToken.TransmitTrailer                             = NULL;
@@ -465,7 +463,18 @@ CommonMctpSubmitMessage (
   Status                   = TransferToken.TransferStatus;
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: Failed to send MCTP command over %s: %r\n", __func__, mTransportName, Status));
-    return Status;
+    goto Exit;
+  }
+
+  if (TransferToken.ReceivePackage.ReceiveSizeInByte < sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: Error! Response size (0x%x) is smaller than the MCTP headers\n",
+      __func__,
+      TransferToken.ReceivePackage.ReceiveSizeInByte
+      ));
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   MctpTransportResponseHeader = (MCTP_TRANSPORT_HEADER *)ResponseBuffer;
@@ -477,8 +486,8 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.HeaderVersion,
       MCTP_KCS_HEADER_VERSION
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   if (MctpTransportResponseHeader->Bits.MessageTag != MCTP_MESSAGE_TAG) {
@@ -489,8 +498,8 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.MessageTag,
       MCTP_MESSAGE_TAG
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   if (MctpTransportResponseHeader->Bits.TagOwner != MCTP_MESSAGE_TAG_OWNER_RESPONSE) {
@@ -501,8 +510,8 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.TagOwner,
       MCTP_MESSAGE_TAG_OWNER_RESPONSE
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   if (MctpTransportResponseHeader->Bits.SourceEndpointId != MctpDestinationEndpointId) {
@@ -513,8 +522,8 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.SourceEndpointId,
       MctpDestinationEndpointId
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   if (MctpTransportResponseHeader->Bits.DestinationEndpointId != MctpSourceEndpointId) {
@@ -525,8 +534,8 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.DestinationEndpointId,
       MctpSourceEndpointId
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   if ((MctpTransportResponseHeader->Bits.StartOfMessage != 1) ||
@@ -538,8 +547,8 @@ CommonMctpSubmitMessage (
       "%a: Error! Multiple-packet MCTP responses are not supported by the current driver\n",
       __func__
       ));
-    FreePool (ResponseBuffer);
-    return EFI_UNSUPPORTED;
+    Status = EFI_UNSUPPORTED;
+    goto Exit;
   }
 
   MctpMessageResponseHeader = (MCTP_MESSAGE_HEADER *)(MctpTransportResponseHeader + 1);
@@ -551,8 +560,8 @@ CommonMctpSubmitMessage (
       MctpMessageResponseHeader->Bits.MessageType,
       MctpType
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   if (MctpMessageResponseHeader->Bits.IntegrityCheck != (UINT8)RequestDataIntegrityCheck) {
@@ -563,13 +572,17 @@ CommonMctpSubmitMessage (
       MctpMessageResponseHeader->Bits.IntegrityCheck,
       (UINT8)RequestDataIntegrityCheck
       ));
-    FreePool (ResponseBuffer);
-    return EFI_DEVICE_ERROR;
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
   }
 
   *ResponseDataSize = TransferToken.ReceivePackage.ReceiveSizeInByte - sizeof (MCTP_TRANSPORT_HEADER) - sizeof (MCTP_MESSAGE_HEADER);
   CopyMem (ResponseData, ResponseBuffer + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER), *ResponseDataSize);
-  FreePool (ResponseBuffer);
+
+Exit:
+  if (ResponseBuffer != ResponsePacket) {
+    FreePool (ResponseBuffer);
+  }
 
   return Status;
 }
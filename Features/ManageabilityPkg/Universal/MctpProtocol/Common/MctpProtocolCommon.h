@@ -9,7 +9,9 @@
 #define MANAGEABILITY_MCTP_COMMON_H_
 
 #include <IndustryStandard/IpmiKcs.h>
+#include <IndustryStandard/Mctp.h>
 #include <Library/ManageabilityTransportLib.h>
+#include <Library/ManageabilityTransportMctpLib.h>
 
 #define MCTP_KCS_BASE_ADDRESS  PcdGet32(PcdMctpKcsBaseAddress)
 
@@ -25,6 +27,35 @@
 #define MCTP_KCS_REG_COMMAND_MEMMAP   MCTP_KCS_BASE_ADDRESS + (IPMI_KCS_COMMAND_REGISTER_OFFSET * 4)
 #define MCTP_KCS_REG_STATUS_MEMMAP    MCTP_KCS_BASE_ADDRESS + (IPMI_KCS_STATUS_REGISTER_OFFSET * 4)
 
+///
+/// Maximum size of an MCTP packet over KCS, whose byte count is 8-bit.
+///
+#define MCTP_KCS_MAXIMUM_PACKET_SIZE  MAX_UINT8
+
+///
+/// Segments of the payload of an MCTP request packet: the MCTP transport
+/// header, the MCTP message header and the slice of the message.
+///
+#define MCTP_REQUEST_PACKET_SEGMENTS  3
+
+///
+/// Headers, trailer and scatter-gather list of one MCTP request packet.
+/// The transfer token points into this structure, so it must stay valid
+/// until the packet is sent.
+///
+typedef struct {
+  MANAGEABILITY_MCTP_KCS_HEADER     KcsHeader;
+  MANAGEABILITY_MCTP_KCS_TRAILER    KcsTrailer;
+  MCTP_TRANSPORT_HEADER             TransportHeader;
+  MCTP_MESSAGE_HEADER               MessageHeader;
+  MANAGEABILITY_TRANSMIT_SEGMENT    Segments[MCTP_REQUEST_PACKET_SEGMENTS];
+  ///
+  /// The headers and the payload in a single buffer, for the transport
+  /// interfaces without MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER.
+  ///
+  UINT8                             Body[MCTP_KCS_MAXIMUM_PACKET_SIZE];
+} MCTP_REQUEST_TRANSPORT_PACKET;
+
 /**
   This functions setup the PLDM transport hardware information according
   to the specification of transport token acquired from transport library.
@@ -48,46 +79,43 @@ SetupMctpTransportHardwareInformation (
   This functions setup the final header/body/trailer packets for
   the acquired transport interface.
 
+  The MCTP headers are built in Packet. If the transport interface reports
+  MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER, the request is described
+  to it as a scatter-gather list and the payload slice is sent from the
+  caller's buffer. Otherwise the headers and the payload slice are copied
+  to Packet->Body.
+
   @param[in]         TransportToken             The transport interface.
   @param[in]         MctpType                   MCTP message type.
   @param[in]         MctpSourceEndpointId       MCTP source endpoint ID.
   @param[in]         MctpDestinationEndpointId  MCTP source endpoint ID.
   @param[in]         RequestDataIntegrityCheck  Indicates whether MCTP message has
                                                 integrity check byte.
-  @param[out]        PacketHeader               The pointer to receive header of request.
-  @param[out]        PacketHeaderSize           Packet header size.
-  @param[in, out]    PacketBody                 The request body.
-                                                When IN, it is the caller's request body.
-                                                When OUT and NULL, the request body is not
-                                                changed.
-                                                Whee out and non-NULL, the request body is
-                                                changed to comfort the transport interface.
-  @param[in, out]    PacketBodySize             The request body size.
-                                                When IN and non-zero, it is the new data
-                                                length of request body.
-                                                When IN and zero, the request body is unchanged.
-  @param[out]        PacketTrailer              The pointer to receive trailer of request.
-  @param[out]        PacketTrailerSize          Packet trailer size.
+  @param[in]         PacketBody                 The payload of this packet.
+  @param[in]         PacketBodySize             The payload size.
+  @param[out]        Packet                     The storage of the headers and the
+                                                trailer of this packet. It must stay
+                                                valid until the packet is sent.
+  @param[out]        TransferToken              The transfer token to set up with the
+                                                request packet.
 
   @retval EFI_SUCCESS            Request packet is returned.
-  @retval EFI_OUT_OF_RESOURCE    Not enough resource to create the request
-                                 transport packets.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is invalid, or the packet
+                                 is too big for the transport interface.
   @retval EFI_UNSUPPORTED        Request packet is not returned because
                                  the unsupported transport interface.
 **/
 EFI_STATUS
 SetupMctpRequestTransportPacket (
-  IN   MANAGEABILITY_TRANSPORT_TOKEN    *TransportToken,
-  IN   UINT8                            MctpType,
-  IN   UINT8                            MctpSourceEndpointId,
-  IN   UINT8                            MctpDestinationEndpointId,
-  IN   BOOLEAN                          RequestDataIntegrityCheck,
-  OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader,
-  OUT  UINT16                           *PacketHeaderSize,
-  IN OUT UINT8                          **PacketBody,
-  IN OUT UINT32                         *PacketBodySize,
-  OUT  MANAGEABILITY_TRANSPORT_TRAILER  *PacketTrailer,
-  OUT  UINT16                           *PacketTrailerSize
+  IN   MANAGEABILITY_TRANSPORT_TOKEN  *TransportToken,
+  IN   UINT8                          MctpType,
+  IN   UINT8                          MctpSourceEndpointId,
+  IN   UINT8                          MctpDestinationEndpointId,
+  IN   BOOLEAN                        RequestDataIntegrityCheck,
+  IN   UINT8                          *PacketBody,
+  IN   UINT32                         PacketBodySize,
+  OUT  MCTP_REQUEST_TRANSPORT_PACKET  *Packet,
+  OUT  MANAGEABILITY_TRANSFER_TOKEN   *TransferToken
   );
 
 /**
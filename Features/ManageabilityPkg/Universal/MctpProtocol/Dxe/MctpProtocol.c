@@ -20,9 +20,10 @@
 
 extern MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
 
-MANAGEABILITY_TRANSPORT_TOKEN  *mTransportToken = NULL;
-CHAR16                         *mTransportName;
-UINT32                         mTransportMaximumPayload;
+MANAGEABILITY_TRANSPORT_TOKEN       *mTransportToken = NULL;
+CHAR16                              *mTransportName;
+UINT32                              mTransportMaximumPayload;
+MANAGEABILITY_TRANSPORT_CAPABILITY  mTransportCapability;
 
 /**
   This service enables submitting message via EDKII MCTP protocol.
@@ -160,7 +161,6 @@ DxeMctpEntry (
 {
   EFI_STATUS                                 Status;
   EFI_HANDLE                                 Handle;
-  MANAGEABILITY_TRANSPORT_CAPABILITY         TransportCapability;
   MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  TransportAdditionalStatus;
 
   Status = HelperAcquireManageabilityTransport (
@@ -172,13 +172,13 @@ DxeMctpEntry (
     return Status;
   }
 
-  Status = GetTransportCapability (mTransportToken, &TransportCapability);
+  Status = GetTransportCapability (mTransportToken, &mTransportCapability);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: Failed to GetTransportCapability().\n", __func__));
     return Status;
   }
 
-  mTransportMaximumPayload = MANAGEABILITY_TRANSPORT_PAYLOAD_SIZE_FROM_CAPABILITY (TransportCapability);
+  mTransportMaximumPayload = MANAGEABILITY_TRANSPORT_PAYLOAD_SIZE_FROM_CAPABILITY (mTransportCapability);
   if (mTransportMaximumPayload == (1 << MANAGEABILITY_TRANSPORT_CAPABILITY_MAXIMUM_PAYLOAD_NOT_AVAILABLE)) {
     DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Transport interface maximum payload is undefined.\n", __func__));
   } else {
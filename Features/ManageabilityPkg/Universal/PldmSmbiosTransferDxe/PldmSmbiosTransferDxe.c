@@ -12,18 +12,50 @@
 **/
 
 #include <PiDxe.h>
+#include <Library/BaseCryptLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/BasePldmProtocolLib.h>
 #include <Library/ManageabilityTransportHelperLib.h>
 #include <IndustryStandard/PldmSmbiosTransfer.h>
 #include <IndustryStandard/SmBios.h>
+#include <Guid/VariableFormat.h>
 #include <Protocol/PldmSmbiosTransferProtocol.h>
 #include <Protocol/Smbios.h>
 
+#define PLDM_SMBIOS_MANIFEST_VARIABLE     L"PldmSmbiosManifest"
+#define PLDM_SMBIOS_MANIFEST_VERSION      2
+#define PLDM_SMBIOS_MANIFEST_DIGEST_SIZE  8
+
+#pragma pack(1)
+
+///
+/// Hash of one SMBIOS structure pushed to the BMC.
+///
+typedef struct {
+  UINT8     Type;
+  UINT16    Handle;
+  UINT8     Digest[PLDM_SMBIOS_MANIFEST_DIGEST_SIZE];   ///< SHA-256 of the structure, including the strings,
+                                                        ///< truncated to keep the variable small.
+} PLDM_SMBIOS_MANIFEST_ENTRY;
+
+///
+/// The manifest of the SMBIOS table last pushed to the BMC, persisted in
+/// the PLDM_SMBIOS_MANIFEST_VARIABLE variable.
+///
+typedef struct {
+  UINT32                                  Version;
+  UINT32                                  NumberOfEntries;
+  PLDM_SMBIOS_STRUCTURE_TABLE_METADATA    BmcMetadata;  ///< What the BMC reported after the push.
+  PLDM_SMBIOS_MANIFEST_ENTRY              Entries[];
+} PLDM_SMBIOS_MANIFEST;
+
+#pragma pack()
+
 UINT32  SetSmbiosStructureTableHandle;
 
 /**
@@ -270,9 +302,326 @@ GetSmbiosStructureTable (
   return EFI_UNSUPPORTED;
 }
 
+/**
+  This function sends SMBIOS structure data to the BMC, followed by the
+  padding and the CRC32 checksum required by SetSMBIOSStructureTable.
+
+  @param [in]   CommandCode  PLDM SMBIOS command code.
+  @param [in]   Data         SMBIOS structure data.
+  @param [in]   DataLength   Size of SMBIOS structure data.
+
+  @retval      EFI_SUCCESS            The data is sent successfully.
+  @retval      EFI_OUT_OF_RESOURCES   No memory for the request.
+  @retval      Other values           Fail to send the data.
+**/
+EFI_STATUS
+PldmSmbiosSendStructureData (
+  IN  UINT8   CommandCode,
+  IN  UINT8   *Data,
+  IN  UINT32  DataLength
+  )
+{
+  EFI_STATUS                               Status;
+  UINT32                                   PaddingSize;
+  UINT32                                   ResponseSize;
+  UINT32                                   RequestSize;
+  UINT8                                    *RequestBuffer;
+  UINT8                                    *DataPointer;
+  UINT32                                   Crc32;
+  PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST  *PldmSetSmbiosStructureTable;
+
+  // Padding requirement (0 ~ 3 bytes)
+  PaddingSize = (4 - (DataLength % 4)) % 4;
+
+  // Total request buffer size = PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST + SMBIOS tables + padding + checksum
+  RequestSize   = (UINT32)(sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST) + DataLength + PaddingSize + sizeof (Crc32));
+  RequestBuffer = (UINT8 *)AllocatePool (RequestSize);
+  if (RequestBuffer == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: No memory resource for sending SetSmbiosStructureTable.\n", __func__));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Fill in smbios tables
+  CopyMem (
+    (VOID *)((UINT8 *)RequestBuffer + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST)),
+    (VOID *)Data,
+    DataLength
+    );
+
+  // Fill in padding
+  DataPointer = RequestBuffer + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST) + DataLength;
+  ZeroMem ((VOID *)DataPointer, PaddingSize);
+
+  // Fill in checksum
+  gBS->CalculateCrc32 (
+         (VOID *)(RequestBuffer + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST)),
+         DataLength + PaddingSize,
+         &Crc32
+         );
+  DataPointer += PaddingSize;
+  CopyMem ((VOID *)DataPointer, (VOID *)&Crc32, 4);
+
+  PldmSetSmbiosStructureTable                     = (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST *)RequestBuffer;
+  PldmSetSmbiosStructureTable->DataTransferHandle = SetSmbiosStructureTableHandle;
+  PldmSetSmbiosStructureTable->TransferFlag       = PLDM_TRANSFER_FLAG_START_AND_END;
+  ResponseSize                                    = sizeof (SetSmbiosStructureTableHandle);
+
+  Status = PldmSubmitCommand (
+             PLDM_TYPE_SMBIOS,
+             CommandCode,
+             RequestBuffer,
+             RequestSize,
+             (UINT8 *)&SetSmbiosStructureTableHandle,
+             &ResponseSize
+             );
+  if (RequestBuffer != NULL) {
+    FreePool (RequestBuffer);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Set SMBIOS structure table.\n", __func__));
+  }
+
+  if ((ResponseSize != 0) && (ResponseSize <= sizeof (SetSmbiosStructureTableHandle))) {
+    HelperManageabilityDebugPrint (
+      (VOID *)&SetSmbiosStructureTableHandle,
+      ResponseSize,
+      "Set SMBIOS structure table response got from BMC.\n"
+      );
+  }
+
+  return Status;
+}
+
+/**
+  This function builds the manifest of SMBIOS table, which has the hash of
+  every SMBIOS structure.
+
+  @param [in]   TableAddress  SMBIOS table based address.
+  @param [in]   TableLength   SMBIOS table length.
+  @param [out]  Manifest      Pointer to the returned manifest. Caller has
+                              to free this memory block when it is no longer
+                              needed.
+  @param [out]  ManifestSize  Size of the returned manifest.
+
+  @retval      EFI_SUCCESS            The manifest is returned.
+  @retval      EFI_BUFFER_TOO_SMALL   The manifest doesn't fit in a UEFI variable.
+  @retval      EFI_OUT_OF_RESOURCES   No memory for the manifest.
+  @retval      EFI_ABORTED            Fail to hash a SMBIOS structure.
+**/
+EFI_STATUS
+PldmSmbiosBuildManifest (
+  IN  UINT8                 *TableAddress,
+  IN  UINTN                 TableLength,
+  OUT PLDM_SMBIOS_MANIFEST  **Manifest,
+  OUT UINTN                 *ManifestSize
+  )
+{
+  UINTN                       Offset;
+  UINTN                       StructureSize;
+  UINT32                      NumberOfEntries;
+  EFI_SMBIOS_TABLE_HEADER     *Structure;
+  PLDM_SMBIOS_MANIFEST        *ThisManifest;
+  PLDM_SMBIOS_MANIFEST_ENTRY  *Entry;
+  UINT8                       Digest[SHA256_DIGEST_SIZE];
+
+  NumberOfEntries = 0;
+  for (Offset = 0; Offset < TableLength; Offset += StructureSize) {
+    StructureSize = GetSmbiosStructureSize ((EFI_SMBIOS_TABLE_HEADER *)(TableAddress + Offset), NULL);
+    if (StructureSize == 0) {
+      break;
+    }
+
+    NumberOfEntries++;
+  }
+
+  *ManifestSize = sizeof (PLDM_SMBIOS_MANIFEST) + NumberOfEntries * sizeof (PLDM_SMBIOS_MANIFEST_ENTRY);
+  if (sizeof (AUTHENTICATED_VARIABLE_HEADER) + sizeof (PLDM_SMBIOS_MANIFEST_VARIABLE) + *ManifestSize > PcdGet32 (PcdMaxVariableSize)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "%a: The manifest of %d SMBIOS structures is larger than PcdMaxVariableSize, only full SMBIOS table transfers are done.\n",
+      __func__,
+      NumberOfEntries
+      ));
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  ThisManifest = AllocateZeroPool (*ManifestSize);
+  if (ThisManifest == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ThisManifest->Version         = PLDM_SMBIOS_MANIFEST_VERSION;
+  ThisManifest->NumberOfEntries = NumberOfEntries;
+
+  Entry = ThisManifest->Entries;
+  for (Offset = 0; Entry < ThisManifest->Entries + NumberOfEntries; Offset += StructureSize, Entry++) {
+    Structure     = (EFI_SMBIOS_TABLE_HEADER *)(TableAddress + Offset);
+    StructureSize = GetSmbiosStructureSize (Structure, NULL);
+    Entry->Type   = Structure->Type;
+    Entry->Handle = Structure->Handle;
+    if (!Sha256HashAll ((VOID *)Structure, StructureSize, Digest)) {
+      DEBUG ((DEBUG_ERROR, "%a: Fail to hash SMBIOS structure 0x%04x.\n", __func__, Structure->Handle));
+      FreePool (ThisManifest);
+      return EFI_ABORTED;
+    }
+
+    CopyMem (Entry->Digest, Digest, PLDM_SMBIOS_MANIFEST_DIGEST_SIZE);
+  }
+
+  *Manifest = ThisManifest;
+  return EFI_SUCCESS;
+}
+
+/**
+  This function pushes the SMBIOS structures which changed since the
+  manifest was saved, one by one.
+
+  Nothing is sent and an error is returned if the structures can't be
+  pushed one by one: there is no saved manifest, structures were added
+  or removed, or the BMC doesn't report the metadata it reported when
+  the manifest was saved (e.g. it lost the table). The caller then
+  falls back to a full table transfer.
+
+  @param [in]   This          EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL instance.
+  @param [in]   TableAddress  SMBIOS table based address.
+  @param [in]   Manifest      The manifest of the SMBIOS table, whose entries
+                              are in the order of the structures in the table.
+  @param [out]  Changed       Number of changed SMBIOS structures.
+
+  @retval      EFI_SUCCESS            The changed structures are pushed.
+  @retval      EFI_NOT_FOUND          The manifest is missing or doesn't match.
+  @retval      Other values           Fail to push a changed structure.
+**/
+EFI_STATUS
+PldmSmbiosPushChangedStructures (
+  IN  EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL  *This,
+  IN  UINT8                                *TableAddress,
+  IN  PLDM_SMBIOS_MANIFEST                 *Manifest,
+  OUT UINT32                               *Changed
+  )
+{
+  EFI_STATUS                            Status;
+  PLDM_SMBIOS_MANIFEST                  *Saved;
+  UINTN                                 SavedSize;
+  PLDM_SMBIOS_STRUCTURE_TABLE_METADATA  BmcMetadata;
+  UINT32                                Index;
+  PLDM_SMBIOS_MANIFEST_ENTRY            *Entry;
+  UINTN                                 Offset;
+  UINTN                                 StructureSize;
+
+  *Changed = 0;
+  Status   = GetVariable2 (
+               PLDM_SMBIOS_MANIFEST_VARIABLE,
+               &gManageabilityVariableGuid,
+               (VOID **)&Saved,
+               &SavedSize
+               );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: No SMBIOS manifest - %r\n", __func__, Status));
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  if ((SavedSize < sizeof (PLDM_SMBIOS_MANIFEST)) ||
+      (Saved->Version != PLDM_SMBIOS_MANIFEST_VERSION) ||
+      (Saved->NumberOfEntries != Manifest->NumberOfEntries) ||
+      (SavedSize != sizeof (PLDM_SMBIOS_MANIFEST) + Saved->NumberOfEntries * sizeof (PLDM_SMBIOS_MANIFEST_ENTRY)))
+  {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: SMBIOS manifest doesn't match the table.\n", __func__));
+    goto Exit;
+  }
+
+  for (Index = 0; Index < Manifest->NumberOfEntries; Index++) {
+    if ((Saved->Entries[Index].Type != Manifest->Entries[Index].Type) ||
+        (Saved->Entries[Index].Handle != Manifest->Entries[Index].Handle))
+    {
+      DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: SMBIOS structures were added or removed.\n", __func__));
+      goto Exit;
+    }
+  }
+
+  if (EFI_ERROR (GetSmbiosStructureTableMetaData (This, &BmcMetadata)) ||
+      (CompareMem (&BmcMetadata, &Saved->BmcMetadata, sizeof (PLDM_SMBIOS_STRUCTURE_TABLE_METADATA)) != 0))
+  {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: BMC doesn't have the SMBIOS table of the manifest.\n", __func__));
+    goto Exit;
+  }
+
+  Status = EFI_SUCCESS;
+  for (Index = 0, Offset = 0; Index < Manifest->NumberOfEntries; Index++, Offset += StructureSize) {
+    Entry         = &Manifest->Entries[Index];
+    StructureSize = GetSmbiosStructureSize ((EFI_SMBIOS_TABLE_HEADER *)(TableAddress + Offset), NULL);
+    if (CompareMem (Entry->Digest, Saved->Entries[Index].Digest, PLDM_SMBIOS_MANIFEST_DIGEST_SIZE) == 0) {
+      continue;
+    }
+
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "  SMBIOS type %d handle 0x%04x changed\n", Entry->Type, Entry->Handle));
+    Status = PldmSmbiosSendStructureData (
+               PcdGet8 (PcdPldmSmbiosSetStructureCommandCode),
+               TableAddress + Offset,
+               (UINT32)StructureSize
+               );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: Fail to set SMBIOS structure 0x%04x - %r\n", __func__, Entry->Handle, Status));
+      goto Exit;
+    }
+
+    (*Changed)++;
+  }
+
+Exit:
+  FreePool (Saved);
+  return Status;
+}
+
+/**
+  This function saves the manifest of the SMBIOS table just pushed to
+  the BMC, along with the metadata the BMC reports for it. The saved
+  manifest is deleted if the metadata can't be retrieved, so that the
+  next push is a full table transfer.
+
+  @param [in]   This          EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL instance.
+  @param [in]   Manifest      The manifest of the SMBIOS table, or NULL to
+                              delete the saved manifest.
+  @param [in]   ManifestSize  Size of the manifest.
+**/
+VOID
+PldmSmbiosSaveManifest (
+  IN  EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL  *This,
+  IN  PLDM_SMBIOS_MANIFEST                 *Manifest,
+  IN  UINTN                                ManifestSize
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Manifest != NULL) {
+    Status = GetSmbiosStructureTableMetaData (This, &Manifest->BmcMetadata);
+    if (EFI_ERROR (Status)) {
+      ManifestSize = 0;
+      Manifest     = NULL;
+    }
+  }
+
+  Status = gRT->SetVariable (
+                  PLDM_SMBIOS_MANIFEST_VARIABLE,
+                  &gManageabilityVariableGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  ManifestSize,
+                  (VOID *)Manifest
+                  );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to set UEFI Variable %s %r\n", __func__, PLDM_SMBIOS_MANIFEST_VARIABLE, Status));
+  }
+}
+
 /**
   This function sets SMBIOS structure table.
 
+  When PcdPldmSmbiosSetStructureCommandCode is not zero, only the SMBIOS
+  structures changed since the last push are sent, with the per-structure
+  Set command. Otherwise, or if that isn't possible, the whole table is sent.
+
   @param [in]   This        EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL instance.
 
   @retval      EFI_SUCCESS            Successful
@@ -287,19 +636,15 @@ SetSmbiosStructureTable (
   IN  EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL  *This
   )
 {
-  EFI_STATUS                               Status;
-  SMBIOS_TABLE_3_0_ENTRY_POINT             *SmbiosEntry;
-  EFI_SMBIOS_HANDLE                        SmbiosHandle;
-  EFI_SMBIOS_PROTOCOL                      *Smbios;
-  UINT32                                   PaddingSize;
-  UINT32                                   ResponseSize;
-  UINT32                                   RequestSize;
-  UINT8                                    *RequestBuffer;
-  UINT8                                    *DataPointer;
-  UINT32                                   Crc32;
-  UINT16                                   TableLength;
-  EFI_SMBIOS_TABLE_HEADER                  *Record;
-  PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST  *PldmSetSmbiosStructureTable;
+  EFI_STATUS                    Status;
+  SMBIOS_TABLE_3_0_ENTRY_POINT  *SmbiosEntry;
+  EFI_SMBIOS_HANDLE             SmbiosHandle;
+  EFI_SMBIOS_PROTOCOL           *Smbios;
+  UINT16                        TableLength;
+  EFI_SMBIOS_TABLE_HEADER       *Record;
+  PLDM_SMBIOS_MANIFEST          *Manifest;
+  UINTN                         ManifestSize;
+  UINT32                        Changed;
 
   DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Set SMBIOS structure table.\n", __func__));
 
@@ -362,64 +707,45 @@ SetSmbiosStructureTable (
 
   TableLength = (UINT16)GetSmbiosTableLength ((VOID *)(UINTN)SmbiosEntry->TableAddress, SmbiosEntry->TableMaximumSize);
 
-  // Padding requirement (0 ~ 3 bytes)
-  PaddingSize = (4 - (TableLength % 4)) % 4;
+  Manifest = NULL;
+  if (PcdGet8 (PcdPldmSmbiosSetStructureCommandCode) != 0) {
+    Status = PldmSmbiosBuildManifest ((UINT8 *)(UINTN)SmbiosEntry->TableAddress, TableLength, &Manifest, &ManifestSize);
+    if (EFI_ERROR (Status)) {
+      Manifest = NULL;
+      if (Status == EFI_BUFFER_TOO_SMALL) {
+        //
+        // Delete the manifest of an earlier, smaller table.
+        //
+        PldmSmbiosSaveManifest (This, NULL, 0);
+      }
+    } else {
+      Status = PldmSmbiosPushChangedStructures (This, (UINT8 *)(UINTN)SmbiosEntry->TableAddress, Manifest, &Changed);
+      if (!EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: %d of %d SMBIOS structures changed.\n", __func__, Changed, Manifest->NumberOfEntries));
+        if (Changed != 0) {
+          PldmSmbiosSaveManifest (This, Manifest, ManifestSize);
+        }
+
+        FreePool (Manifest);
+        return EFI_SUCCESS;
+      }
 
-  // Total request buffer size = PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST + SMBIOS tables + padding + checksum
-  RequestSize   = (UINT32)(sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST) + TableLength + PaddingSize + sizeof (Crc32));
-  RequestBuffer = (UINT8 *)AllocatePool (RequestSize);
-  if (RequestBuffer == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a: No memory resource for sending SetSmbiosStructureTable.\n"));
-    return EFI_OUT_OF_RESOURCES;
+      DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Fall back to full SMBIOS table transfer.\n", __func__));
+    }
   }
 
-  // Fill in smbios tables
-  CopyMem (
-    (VOID *)((UINT8 *)RequestBuffer + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST)),
-    (VOID *)(UINTN)SmbiosEntry->TableAddress,
-    TableLength
-    );
-
-  // Fill in padding
-  DataPointer = RequestBuffer + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST) + TableLength;
-  ZeroMem ((VOID *)DataPointer, PaddingSize);
-
-  // Fill in checksum
-  gBS->CalculateCrc32 (
-         (VOID *)(RequestBuffer + sizeof (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST)),
-         TableLength + PaddingSize,
-         &Crc32
-         );
-  DataPointer += PaddingSize;
-  CopyMem ((VOID *)DataPointer, (VOID *)&Crc32, 4);
-
-  PldmSetSmbiosStructureTable                     = (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST *)RequestBuffer;
-  PldmSetSmbiosStructureTable->DataTransferHandle = SetSmbiosStructureTableHandle;
-  PldmSetSmbiosStructureTable->TransferFlag       = PLDM_TRANSFER_FLAG_START_AND_END;
-  ResponseSize                                    = sizeof (SetSmbiosStructureTableHandle);
-
-  Status = PldmSubmitCommand (
-             PLDM_TYPE_SMBIOS,
+  Status = PldmSmbiosSendStructureData (
              PLDM_SET_SMBIOS_STRUCTURE_TABLE_COMMAND_CODE,
-             RequestBuffer,
-             RequestSize,
-             (UINT8 *)&SetSmbiosStructureTableHandle,
-             &ResponseSize
+             (UINT8 *)(UINTN)SmbiosEntry->TableAddress,
+             TableLength
              );
-  if (RequestBuffer != NULL) {
-    FreePool (RequestBuffer);
-  }
 
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: Set SMBIOS structure table.\n", __func__));
-  }
+  if (Manifest != NULL) {
+    if (!EFI_ERROR (Status)) {
+      PldmSmbiosSaveManifest (This, Manifest, ManifestSize);
+    }
 
-  if ((ResponseSize != 0) && (ResponseSize <= sizeof (SetSmbiosStructureTableHandle))) {
-    HelperManageabilityDebugPrint (
-      (VOID *)&SetSmbiosStructureTableHandle,
-      ResponseSize,
-      "Set SMBIOS structure table response got from BMC.\n"
-      );
+    FreePool (Manifest);
   }
 
   return Status;
@@ -98,7 +98,7 @@ EFI_SIMPLE_NETWORK_MODE Pp2SnpModeTemplate = {
   },                                                    // Permanent Address
   NET_IFTYPE_ETHERNET,                                  // IfType
   TRUE,                                                 // MacAddressChangeable
-  FALSE,                                                // MultipleTxSupported
+  TRUE,                                                 // MultipleTxSupported
   TRUE,                                                 // MediaPresentSupported
   FALSE                                                 // MediaPresent
 };
@@ -142,6 +142,86 @@ QueueRemove (
   return Buffer;
 }
 
+STATIC
+UINTN
+QueueCount (
+  IN PP2DXE_CONTEXT *Pp2Context
+  )
+{
+  return (Pp2Context->CompletionQueueTail + QUEUE_DEPTH -
+          Pp2Context->CompletionQueueHead) % QUEUE_DEPTH;
+}
+
+/*
+ * Move the buffers of the descriptors the hardware has sent, or all
+ * buffers in flight when Flush is set, to the completion queue.
+ */
+STATIC
+VOID
+Pp2DxeTxReap (
+  IN PP2DXE_CONTEXT *Pp2Context,
+  IN BOOLEAN Flush
+  )
+{
+  PP2DXE_PORT *Port = &Pp2Context->Port;
+  UINTN TxSent;
+
+  if (Pp2Context->TxInFlightCount == 0) {
+    return;
+  }
+
+  /* Reading the counter resets it, so every sent descriptor is seen once */
+  TxSent = Mvpp2TxqSentDescProc (Port, &Port->Txqs[0]);
+  if (Flush) {
+    TxSent = Pp2Context->TxInFlightCount;
+  }
+
+  while (TxSent > 0 && Pp2Context->TxInFlightCount > 0) {
+    /*
+     * Transmit keeps the buffers in flight and in the completion queue
+     * below QUEUE_DEPTH, so this cannot fail.
+     */
+    QueueInsert (Pp2Context, Pp2Context->TxInFlight[Pp2Context->TxInFlightHead]);
+    Pp2Context->TxInFlight[Pp2Context->TxInFlightHead] = NULL;
+    Pp2Context->TxInFlightHead = (Pp2Context->TxInFlightHead + 1) % MVPP2_MAX_TXD;
+    Pp2Context->TxInFlightCount--;
+    TxSent--;
+  }
+}
+
+/*
+ * Wait for the TXQ to send the descriptors handed to it, then move all
+ * buffers in flight to the completion queue. If the TXQ does not drain,
+ * only the buffers of the sent descriptors are moved, the others stay in
+ * flight as the hardware may still read them.
+ */
+STATIC
+VOID
+Pp2DxeTxReclaim (
+  IN PP2DXE_CONTEXT *Pp2Context
+  )
+{
+  PP2DXE_PORT *Port = &Pp2Context->Port;
+
+  if (Pp2Context->TxInFlightCount == 0) {
+    Pp2Context->TxInFlightHead = 0;
+    return;
+  }
+
+  Mvpp2TxpClean (Port, 0, &Port->Txqs[0]);
+  if (Mvpp2TxqPendDescNumGet (Port, &Port->Txqs[0]) != 0) {
+    Pp2DxeTxReap (Pp2Context, FALSE);
+    DEBUG ((DEBUG_ERROR,
+      "Pp2Dxe%d: TXQ not drained, %d buffers left in flight\n",
+      Pp2Context->Instance,
+      (UINT32)Pp2Context->TxInFlightCount));
+    return;
+  }
+
+  Pp2DxeTxReap (Pp2Context, TRUE);
+  Pp2Context->TxInFlightHead = 0;
+}
+
 STATIC
 EFI_STATUS
 Pp2DxeBmPoolInit (
@@ -636,6 +716,9 @@ Pp2SnpStop (
     }
   }
 
+  /* Hand back the buffers still in flight */
+  Pp2DxeTxReclaim (Pp2Context);
+
   This->Mode->State = EfiSimpleNetworkStopped;
   ReturnUnlock (SavedTpl, EFI_SUCCESS);
 }
@@ -648,6 +731,7 @@ Pp2SnpReset (
   )
 {
   PP2DXE_CONTEXT *Pp2Context;
+  EFI_TPL SavedTpl;
 
   /* Check This Instance. */
   if (This == NULL) {
@@ -674,6 +758,11 @@ Pp2SnpReset (
     }
   }
 
+  /* Hand back the buffers still in flight */
+  SavedTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Pp2DxeTxReclaim (Pp2Context);
+  gBS->RestoreTPL (SavedTpl);
+
   return EFI_SUCCESS;
 }
 
@@ -751,6 +840,9 @@ Pp2SnpShutdown (
     }
   }
 
+  /* Hand back the buffers still in flight before the port is halted */
+  Pp2DxeTxReclaim (Pp2Context);
+
   Pp2DxeHalt (Pp2Context);
 
   This->Mode->State = EfiSimpleNetworkStarted;
@@ -1064,6 +1156,7 @@ Pp2SnpGetStatus (
   Snp->Mode->MediaPresent = LinkUp;
 
   if (TxBuf != NULL) {
+    Pp2DxeTxReap (Pp2Context, FALSE);
     *TxBuf = QueueRemove (Pp2Context);
   }
 
@@ -1087,9 +1180,6 @@ Pp2SnpTransmit (
   MVPP2_SHARED *Mvpp2Shared = Pp2Context->Port.Priv;
   MVPP2_TX_QUEUE *AggrTxq = Mvpp2Shared->AggrTxqs;
   MVPP2_TX_DESC *TxDesc;
-  EFI_STATUS Status;
-  INTN PollingCount;
-  INTN TxSent;
   UINT8 *DataPtr = Buffer;
   UINT16 EtherType;
   UINT32 State = This->Mode->State;
@@ -1133,6 +1223,17 @@ Pp2SnpTransmit (
     ReturnUnlock(SavedTpl, EFI_NOT_READY);
   }
 
+  /*
+   * Back off while the TXQ is full, or while the completion queue could
+   * not take every buffer in flight. The caller recycles buffers with
+   * GetStatus() and retries.
+   */
+  Pp2DxeTxReap (Pp2Context, FALSE);
+  if (Pp2Context->TxInFlightCount >= Port->TxRingSize ||
+      QueueCount (Pp2Context) + Pp2Context->TxInFlightCount >= QUEUE_DEPTH - 1) {
+    ReturnUnlock(SavedTpl, EFI_NOT_READY);
+  }
+
   /* Fetch next descriptor */
   TxDesc = Mvpp2TxqNextDescGet(AggrTxq);
 
@@ -1164,41 +1265,17 @@ Pp2SnpTransmit (
 
   InvalidateDataCacheRange (DataPtr, BufferSize);
 
-  /* Issue send */
-  Mvpp2AggrTxqPendDescAdd(Port, 1);
-
   /*
-   * Egress processing:
-   * Wait until packet is passed from per-cpu aggregated queue
-   * to physical per-port TXQ.
+   * Issue send and return. The buffer stays in flight until
+   * Pp2DxeTxReap sees its descriptor sent and moves it to the
+   * completion queue.
    */
-  PollingCount = 0;
-  TxSent = Mvpp2AggrTxqPendDescNumGet(Mvpp2Shared, 0);
-  do {
-    if (PollingCount++ > MVPP2_TX_SEND_MAX_POLLING_COUNT) {
-      DEBUG((DEBUG_ERROR, "Pp2Dxe: transmit polling failed\n"));
-      ReturnUnlock(SavedTpl, EFI_TIMEOUT);
-    }
-    TxSent = Mvpp2AggrTxqPendDescNumGet(Mvpp2Shared, 0);
-  } while (TxSent);
-
-  /* Wait for packet to be transmitted by hardware. */
-  PollingCount = 0;
-  TxSent = Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
-  while (!TxSent) {
-    if (PollingCount++ > MVPP2_TX_SEND_MAX_POLLING_COUNT) {
-      DEBUG((DEBUG_ERROR, "Pp2Dxe: transmit polling failed\n"));
-      ReturnUnlock(SavedTpl, EFI_TIMEOUT);
-    }
-    TxSent = Mvpp2TxqSentDescProc(Port, &Port->Txqs[0]);
-  }
+  Pp2Context->TxInFlight[(Pp2Context->TxInFlightHead +
+                          Pp2Context->TxInFlightCount) % MVPP2_MAX_TXD] = Buffer;
+  Pp2Context->TxInFlightCount++;
+  Mvpp2AggrTxqPendDescAdd(Port, 1);
 
-  /*
-   * At this point TxSent has increased - HW sent the packet
-   * Add buffer to completion queue and return.
-   */
-  Status = QueueInsert (Pp2Context, Buffer);
-  ReturnUnlock (SavedTpl, Status);
+  ReturnUnlock (SavedTpl, EFI_SUCCESS);
 }
 
 EFI_STATUS
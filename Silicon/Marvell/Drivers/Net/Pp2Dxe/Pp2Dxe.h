@@ -142,12 +142,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define WRAP                              (2 + ETH_HLEN + 4 + 32)
 #define MTU                               1500
 
-/*
- * Maximum retries of checking, wheter HW really sent the packet
- * after it was done is software.
- */
-#define MVPP2_TX_SEND_MAX_POLLING_COUNT   10000
-
 /* Structures */
 typedef struct {
   /* Physical number of this Tx queue */
@@ -338,6 +332,10 @@ typedef struct {
   VOID                        *CompletionQueue[QUEUE_DEPTH];
   UINTN                       CompletionQueueHead;
   UINTN                       CompletionQueueTail;
+  /* Buffers handed to the TXQ, in the order the hardware sends them */
+  VOID                        *TxInFlight[MVPP2_MAX_TXD];
+  UINTN                       TxInFlightHead;
+  UINTN                       TxInFlightCount;
   EFI_EVENT                   EfiExitBootServicesEvent;
   PP2_DEVICE_PATH             *DevicePath;
   EFI_ADAPTER_INFORMATION_PROTOCOL Aip;